@@ -0,0 +1,845 @@
+/* main.c  -  Network benchmarks  -  Public Domain  -  2013 Mattias Jansson
+ *
+ * This library provides a network abstraction built on foundation streams. The latest source code is
+ * always available at
+ *
+ * https://github.com/mjansson/network_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any restrictions.
+ *
+ */
+
+#include <network/network.h>
+
+#include <foundation/foundation.h>
+
+#include <stdlib.h>
+#if FOUNDATION_PLATFORM_POSIX
+#include <netdb.h>
+#endif
+
+/* Loopback benchmarks of the network library. Each case runs for a fixed wall clock duration
+   (or a fixed operation count for connection setup) and the results of all cases are written
+   as a single JSON document, to stdout or to the file given with --output, so that runs on
+   different releases can be compared by a script. Socket system calls counted by the library
+   are reported per operation (see network_syscall_count) when the library is built with
+   BUILD_ENABLE_NETWORK_SYSCALL_COUNT. */
+
+#define BENCH_STREAM_CHUNK (64 * 1024)
+#define BENCH_DATAGRAM_MAX 2048
+
+typedef struct bench_config_t bench_config_t;
+typedef struct bench_report_t bench_report_t;
+typedef struct bench_thread_arg_t bench_thread_arg_t;
+
+typedef void (*bench_fn)(const bench_config_t* config, bench_report_t* report);
+
+struct bench_config_t {
+	//! Duration of timed cases in ticks
+	tick_t duration;
+	//! Message size of request/response cases
+	size_t message_size;
+	//! Payload size of datagram cases
+	size_t datagram_size;
+	//! Number of connections in accept case
+	unsigned int connections;
+};
+
+struct bench_report_t {
+	stream_t* stream;
+	//! Set once the first case has been written
+	bool started;
+	//! Set once a value has been written in the current case
+	bool values;
+	//! Syscall counters at start of current case
+	uint64_t syscalls;
+};
+
+struct bench_thread_arg_t {
+	const bench_config_t* config;
+	socket_t* sock;
+	uint64_t count;
+	uint64_t bytes;
+	tick_t end;
+};
+
+typedef struct {
+	const char* name;
+	size_t name_length;
+	bench_fn fn;
+} bench_case_t;
+
+static bool should_exit;
+
+static void
+bench_print_usage(void);
+
+int
+main_initialize(void) {
+	int ret = 0;
+	foundation_config_t config;
+	network_config_t network_config;
+	application_t application;
+
+	memset(&config, 0, sizeof(config));
+	memset(&network_config, 0, sizeof(network_config));
+
+	memset(&application, 0, sizeof(application));
+	application.name = string_const(STRING_CONST("bench-network"));
+	application.short_name = string_const(STRING_CONST("bench_network"));
+	application.company = string_const(STRING_CONST(""));
+	application.flags = APPLICATION_UTILITY;
+
+	log_enable_prefix(false);
+	log_set_suppress(0, ERRORLEVEL_INFO);
+
+	if ((ret = foundation_initialize(memory_system_malloc(), application, config)) < 0)
+		return ret;
+
+	log_set_suppress(HASH_NETWORK, ERRORLEVEL_WARNING);
+
+	if ((ret = network_module_initialize(network_config)) < 0)
+		return ret;
+
+	return 0;
+}
+
+void
+main_finalize(void) {
+	network_module_finalize();
+	foundation_finalize();
+}
+
+static void
+bench_process_system_events(void) {
+	event_block_t* block;
+	event_t* event = 0;
+
+	system_process_events();
+
+	block = event_stream_process(system_event_stream());
+
+	while ((event = event_next(block, event))) {
+		if (event->id == FOUNDATIONEVENT_TERMINATE)
+			should_exit = true;
+	}
+}
+
+static uint64_t
+bench_syscall_total(void) {
+	uint64_t total = 0;
+#if BUILD_ENABLE_NETWORK_SYSCALL_COUNT
+	for (int icall = 0; icall < NETWORK_SYSCALL_COUNT; ++icall)
+		total += network_syscall_count((network_syscall_t)icall);
+#endif
+	return total;
+}
+
+static void
+bench_report_begin(bench_report_t* report, const char* name, size_t length) {
+	stream_write_format(report->stream, STRING_CONST("%s\n    {\"name\": \"%.*s\""), report->started ? "," : "",
+	                    (int)length, name);
+	report->started = true;
+	report->values = true;
+	report->syscalls = bench_syscall_total();
+}
+
+static void
+bench_report_real(bench_report_t* report, const char* key, size_t length, real value) {
+	stream_write_format(report->stream, STRING_CONST(", \"%.*s\": %.3f"), (int)length, key, (double)value);
+}
+
+static void
+bench_report_uint(bench_report_t* report, const char* key, size_t length, uint64_t value) {
+	stream_write_format(report->stream, STRING_CONST(", \"%.*s\": %" PRIu64), (int)length, key, value);
+}
+
+static void
+bench_report_end(bench_report_t* report, uint64_t operations) {
+	bench_report_uint(report, STRING_CONST("operations"), operations);
+#if BUILD_ENABLE_NETWORK_SYSCALL_COUNT
+	uint64_t syscalls = bench_syscall_total() - report->syscalls;
+	bench_report_real(report, STRING_CONST("syscalls_per_op"),
+	                  operations ? (real)syscalls / (real)operations : REAL_C(0.0));
+#endif
+	stream_write_format(report->stream, STRING_CONST("}"));
+	stream_flush(report->stream);
+	report->values = false;
+}
+
+static void
+bench_report_failure(bench_report_t* report, const char* reason, size_t length) {
+	stream_write_format(report->stream, STRING_CONST(", \"error\": \"%.*s\"}"), (int)length, reason);
+	stream_flush(report->stream);
+	report->values = false;
+}
+
+static int
+bench_tick_compare(const void* lhs, const void* rhs) {
+	tick_t first = *(const tick_t*)lhs;
+	tick_t second = *(const tick_t*)rhs;
+	return (first < second) ? -1 : ((first > second) ? 1 : 0);
+}
+
+static real
+bench_ticks_to_us(tick_t ticks) {
+	return time_ticks_to_seconds(ticks) * REAL_C(1000000.0);
+}
+
+// Report min, mean, max and percentiles in microseconds of the given samples, sorting them
+static void
+bench_report_latency(bench_report_t* report, tick_t* samples) {
+	size_t count = array_size(samples);
+	tick_t total = 0;
+	if (!count)
+		return;
+	qsort(samples, count, sizeof(tick_t), bench_tick_compare);
+	for (size_t isample = 0; isample < count; ++isample)
+		total += samples[isample];
+	bench_report_real(report, STRING_CONST("min_us"), bench_ticks_to_us(samples[0]));
+	bench_report_real(report, STRING_CONST("mean_us"), bench_ticks_to_us(total) / (real)count);
+	bench_report_real(report, STRING_CONST("p50_us"), bench_ticks_to_us(samples[(count * 50) / 100]));
+	bench_report_real(report, STRING_CONST("p90_us"), bench_ticks_to_us(samples[(count * 90) / 100]));
+	bench_report_real(report, STRING_CONST("p99_us"), bench_ticks_to_us(samples[(count * 99) / 100]));
+	bench_report_real(report, STRING_CONST("p999_us"), bench_ticks_to_us(samples[(count * 999) / 1000]));
+	bench_report_real(report, STRING_CONST("max_us"), bench_ticks_to_us(samples[count - 1]));
+}
+
+static void
+bench_address_loopback(network_address_ipv4_t* address) {
+	network_address_ipv4_initialize(address);
+	network_address_ipv4_set_ip((network_address_t*)address, network_address_ipv4_make_ip(127, 0, 0, 1));
+}
+
+static socket_t*
+bench_tcp_listen(void) {
+	network_address_ipv4_t address;
+	socket_t* sock = tcp_socket_allocate();
+	bench_address_loopback(&address);
+	if (!socket_bind(sock, (network_address_t*)&address) || !tcp_socket_listen(sock)) {
+		socket_deallocate(sock);
+		return nullptr;
+	}
+	return sock;
+}
+
+static socket_t*
+bench_udp_bind(void) {
+	network_address_ipv4_t address;
+	socket_t* sock = udp_socket_allocate();
+	bench_address_loopback(&address);
+	if (!socket_bind(sock, (network_address_t*)&address)) {
+		socket_deallocate(sock);
+		return nullptr;
+	}
+	return sock;
+}
+
+// Connect a client to the listening socket and accept the server side of the connection
+static bool
+bench_tcp_pair(socket_t* sock_listen, socket_t** client, socket_t** server) {
+	*client = tcp_socket_allocate();
+	*server = nullptr;
+	if (socket_connect(*client, socket_address_local(sock_listen), 2000))
+		*server = tcp_socket_accept(sock_listen, 2000);
+	if (*server)
+		return true;
+	socket_deallocate(*client);
+	*client = nullptr;
+	return false;
+}
+
+static void*
+bench_stream_sink_thread(void* arg) {
+	bench_thread_arg_t* sink = arg;
+	stream_t* stream = socket_stream_allocate(sink->sock, BENCH_STREAM_CHUNK, BENCH_STREAM_CHUNK);
+	char* buffer = memory_allocate(HASH_NETWORK, BENCH_STREAM_CHUNK, 0, MEMORY_PERSISTENT);
+	size_t read;
+
+	while (!stream_eos(stream)) {
+		read = stream_read(stream, buffer, BENCH_STREAM_CHUNK);
+		if (!read)
+			break;
+		sink->bytes += read;
+		++sink->count;
+	}
+	sink->end = time_current();
+
+	memory_deallocate(buffer);
+	stream_deallocate(stream);
+	return 0;
+}
+
+/* Bulk transfer through socket streams, throughput measured at the receiving side from the
+   first write until the last byte has been read */
+static void
+bench_tcp_stream_throughput(const bench_config_t* config, bench_report_t* report) {
+	socket_t* sock_listen = bench_tcp_listen();
+	socket_t* sock_client = nullptr;
+	socket_t* sock_server = nullptr;
+	bench_thread_arg_t sink;
+	thread_t thread;
+	char* buffer;
+	stream_t* stream;
+	uint64_t written = 0;
+	tick_t start;
+
+	if (!sock_listen || !bench_tcp_pair(sock_listen, &sock_client, &sock_server)) {
+		bench_report_failure(report, STRING_CONST("unable to connect"));
+		socket_deallocate(sock_listen);
+		return;
+	}
+
+	memset(&sink, 0, sizeof(sink));
+	sink.config = config;
+	sink.sock = sock_server;
+	thread_initialize(&thread, bench_stream_sink_thread, &sink, STRING_CONST("stream_sink"), THREAD_PRIORITY_NORMAL,
+	                  0);
+	thread_start(&thread);
+
+	buffer = memory_allocate(HASH_NETWORK, BENCH_STREAM_CHUNK, 0, MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	stream = socket_stream_allocate(sock_client, BENCH_STREAM_CHUNK, BENCH_STREAM_CHUNK);
+
+	start = time_current();
+	while (time_diff(start, time_current()) < config->duration) {
+		size_t size = stream_write(stream, buffer, BENCH_STREAM_CHUNK);
+		if (!size)
+			break;
+		written += size;
+	}
+	stream_flush(stream);
+	stream_deallocate(stream);
+	socket_close(sock_client);
+
+	thread_join(&thread);
+	thread_finalize(&thread);
+
+	real elapsed = time_ticks_to_seconds(time_diff(start, sink.end));
+	bench_report_uint(report, STRING_CONST("bytes"), sink.bytes);
+	bench_report_real(report, STRING_CONST("seconds"), elapsed);
+	bench_report_real(report, STRING_CONST("mbit_per_second"),
+	                  (elapsed > 0) ? ((real)sink.bytes * REAL_C(8.0)) / (elapsed * REAL_C(1000000.0)) : 0);
+	bench_report_uint(report, STRING_CONST("lost_bytes"), written - sink.bytes);
+	bench_report_end(report, sink.count);
+
+	memory_deallocate(buffer);
+	socket_deallocate(sock_client);
+	socket_deallocate(sock_server);
+	socket_deallocate(sock_listen);
+}
+
+static void*
+bench_stream_echo_thread(void* arg) {
+	bench_thread_arg_t* echo = arg;
+	size_t size = echo->config->message_size;
+	stream_t* stream = socket_stream_allocate(echo->sock, size, size);
+	char* buffer = memory_allocate(HASH_NETWORK, size, 0, MEMORY_PERSISTENT);
+
+	while (stream_read(stream, buffer, size) == size) {
+		stream_write(stream, buffer, size);
+		stream_flush(stream);
+		++echo->count;
+	}
+
+	memory_deallocate(buffer);
+	stream_deallocate(stream);
+	return 0;
+}
+
+/* Request/response round trips of small messages through socket streams with Nagle disabled,
+   one message in flight at a time */
+static void
+bench_tcp_latency(const bench_config_t* config, bench_report_t* report) {
+	socket_t* sock_listen = bench_tcp_listen();
+	socket_t* sock_client = nullptr;
+	socket_t* sock_server = nullptr;
+	bench_thread_arg_t echo;
+	thread_t thread;
+	size_t size = config->message_size;
+	tick_t* samples = nullptr;
+	char* buffer;
+	stream_t* stream;
+	tick_t start, begin;
+
+	if (!sock_listen || !bench_tcp_pair(sock_listen, &sock_client, &sock_server)) {
+		bench_report_failure(report, STRING_CONST("unable to connect"));
+		socket_deallocate(sock_listen);
+		return;
+	}
+
+	tcp_socket_set_delay(sock_client, false);
+	tcp_socket_set_delay(sock_server, false);
+
+	memset(&echo, 0, sizeof(echo));
+	echo.config = config;
+	echo.sock = sock_server;
+	thread_initialize(&thread, bench_stream_echo_thread, &echo, STRING_CONST("stream_echo"), THREAD_PRIORITY_NORMAL,
+	                  0);
+	thread_start(&thread);
+
+	buffer = memory_allocate(HASH_NETWORK, size, 0, MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	stream = socket_stream_allocate(sock_client, size, size);
+	array_reserve(samples, 64 * 1024);
+
+	start = time_current();
+	while (time_diff(start, time_current()) < config->duration) {
+		begin = time_current();
+		stream_write(stream, buffer, size);
+		stream_flush(stream);
+		if (stream_read(stream, buffer, size) != size)
+			break;
+		array_push(samples, time_diff(begin, time_current()));
+	}
+	stream_deallocate(stream);
+	socket_close(sock_client);
+
+	thread_join(&thread);
+	thread_finalize(&thread);
+
+	bench_report_uint(report, STRING_CONST("message_size"), size);
+	bench_report_real(report, STRING_CONST("round_trips_per_second"),
+	                  (real)array_size(samples) / time_ticks_to_seconds(config->duration));
+	bench_report_latency(report, samples);
+	bench_report_end(report, array_size(samples));
+
+	array_deallocate(samples);
+	memory_deallocate(buffer);
+	socket_deallocate(sock_client);
+	socket_deallocate(sock_server);
+	socket_deallocate(sock_listen);
+}
+
+static void*
+bench_accept_thread(void* arg) {
+	bench_thread_arg_t* acceptor = arg;
+	while (acceptor->count < acceptor->config->connections) {
+		socket_t* sock = tcp_socket_accept(acceptor->sock, 2000);
+		if (!sock)
+			break;
+		socket_deallocate(sock);
+		++acceptor->count;
+	}
+	acceptor->end = time_current();
+	return 0;
+}
+
+/* Sequential connection setup and teardown, measuring connect latency at the client and
+   the rate of accepted connections at the server */
+static void
+bench_tcp_accept(const bench_config_t* config, bench_report_t* report) {
+	socket_t* sock_listen = bench_tcp_listen();
+	const network_address_t* address;
+	bench_thread_arg_t acceptor;
+	thread_t thread;
+	tick_t* samples = nullptr;
+	tick_t start, begin;
+
+	if (!sock_listen) {
+		bench_report_failure(report, STRING_CONST("unable to listen"));
+		return;
+	}
+	address = socket_address_local(sock_listen);
+
+	memset(&acceptor, 0, sizeof(acceptor));
+	acceptor.config = config;
+	acceptor.sock = sock_listen;
+	thread_initialize(&thread, bench_accept_thread, &acceptor, STRING_CONST("acceptor"), THREAD_PRIORITY_NORMAL, 0);
+	thread_start(&thread);
+
+	array_reserve(samples, config->connections);
+
+	start = time_current();
+	for (unsigned int iconn = 0; iconn < config->connections; ++iconn) {
+		socket_t* sock = tcp_socket_allocate();
+		begin = time_current();
+		bool connected = socket_connect(sock, address, 2000);
+		if (connected)
+			array_push(samples, time_diff(begin, time_current()));
+		socket_deallocate(sock);
+		if (!connected)
+			break;
+	}
+
+	thread_join(&thread);
+	thread_finalize(&thread);
+
+	real elapsed = time_ticks_to_seconds(time_diff(start, acceptor.end));
+	bench_report_uint(report, STRING_CONST("accepted"), acceptor.count);
+	bench_report_real(report, STRING_CONST("seconds"), elapsed);
+	bench_report_real(report, STRING_CONST("accepts_per_second"), (elapsed > 0) ? (real)acceptor.count / elapsed : 0);
+	bench_report_latency(report, samples);
+	bench_report_end(report, acceptor.count);
+
+	array_deallocate(samples);
+	socket_deallocate(sock_listen);
+}
+
+/* Drain datagrams from a non-blocking socket through a poll object until signalled and
+   no more datagrams arrive */
+static void*
+bench_datagram_sink_thread(void* arg) {
+	bench_thread_arg_t* sink = arg;
+	network_poll_t* poll = network_poll_allocate(1);
+	network_poll_event_t events[4];
+	const network_address_t* from;
+	char buffer[BENCH_DATAGRAM_MAX];
+	size_t read;
+
+	network_poll_add_socket(poll, sink->sock);
+	while (true) {
+		size_t count = network_poll(poll, events, sizeof(events) / sizeof(events[0]), 20);
+		if (!count && thread_try_wait(0))
+			break;
+		while ((read = udp_socket_recvfrom(sink->sock, buffer, sizeof(buffer), &from)) > 0) {
+			sink->bytes += read;
+			++sink->count;
+		}
+	}
+	network_poll_deallocate(poll);
+	return 0;
+}
+
+/* Datagram rate of a single sender blasting small datagrams at a single receiver */
+static void
+bench_udp_pps(const bench_config_t* config, bench_report_t* report) {
+	socket_t* sock_send = bench_udp_bind();
+	socket_t* sock_recv = bench_udp_bind();
+	bench_thread_arg_t sink;
+	thread_t thread;
+	char buffer[BENCH_DATAGRAM_MAX];
+	size_t size = (config->datagram_size < sizeof(buffer)) ? config->datagram_size : sizeof(buffer);
+	uint64_t sent = 0;
+	tick_t start;
+
+	if (!sock_send || !sock_recv) {
+		bench_report_failure(report, STRING_CONST("unable to bind"));
+		socket_deallocate(sock_send);
+		socket_deallocate(sock_recv);
+		return;
+	}
+
+	socket_set_blocking(sock_recv, false);
+	memset(buffer, 0, sizeof(buffer));
+	memset(&sink, 0, sizeof(sink));
+	sink.config = config;
+	sink.sock = sock_recv;
+	thread_initialize(&thread, bench_datagram_sink_thread, &sink, STRING_CONST("datagram_sink"),
+	                  THREAD_PRIORITY_NORMAL, 0);
+	thread_start(&thread);
+
+	start = time_current();
+	while (time_diff(start, time_current()) < config->duration) {
+		if (udp_socket_sendto(sock_send, buffer, size, socket_address_local(sock_recv)) == size)
+			++sent;
+	}
+	real elapsed = time_elapsed(start);
+
+	thread_signal(&thread);
+	thread_join(&thread);
+	thread_finalize(&thread);
+
+	bench_report_uint(report, STRING_CONST("datagram_size"), size);
+	bench_report_uint(report, STRING_CONST("sent"), sent);
+	bench_report_uint(report, STRING_CONST("received"), sink.count);
+	bench_report_real(report, STRING_CONST("sent_per_second"), (real)sent / elapsed);
+	bench_report_real(report, STRING_CONST("received_per_second"), (real)sink.count / elapsed);
+	bench_report_real(report, STRING_CONST("loss_percent"),
+	                  sent ? (REAL_C(100.0) * (real)(sent - sink.count)) / (real)sent : 0);
+	bench_report_end(report, sent);
+
+	socket_deallocate(sock_send);
+	socket_deallocate(sock_recv);
+}
+
+static void*
+bench_poll_reflect_thread(void* arg) {
+	bench_thread_arg_t* reflect = arg;
+	network_poll_t* poll = network_poll_allocate(1);
+	network_poll_event_t events[4];
+	const network_address_t* from;
+	char buffer[BENCH_DATAGRAM_MAX];
+	size_t read;
+
+	network_poll_add_socket(poll, reflect->sock);
+	while (!thread_try_wait(0)) {
+		network_poll(poll, events, sizeof(events) / sizeof(events[0]), 20);
+		while ((read = udp_socket_recvfrom(reflect->sock, buffer, sizeof(buffer), &from)) > 0) {
+			udp_socket_sendto(reflect->sock, buffer, read, from);
+			++reflect->count;
+		}
+	}
+	network_poll_deallocate(poll);
+	return 0;
+}
+
+/* Ping-pong of a single datagram between two threads both blocking in network_poll, each
+   round trip measures two poll wakeups */
+static void
+bench_poll_wakeup(const bench_config_t* config, bench_report_t* report) {
+	socket_t* sock_local = bench_udp_bind();
+	socket_t* sock_remote = bench_udp_bind();
+	network_poll_t* poll = network_poll_allocate(1);
+	network_poll_event_t events[4];
+	const network_address_t* from;
+	bench_thread_arg_t reflect;
+	thread_t thread;
+	tick_t* samples = nullptr;
+	char buffer[BENCH_DATAGRAM_MAX];
+	size_t size = (config->datagram_size < sizeof(buffer)) ? config->datagram_size : sizeof(buffer);
+	size_t lost = 0;
+	tick_t start, begin;
+
+	if (!sock_local || !sock_remote) {
+		bench_report_failure(report, STRING_CONST("unable to bind"));
+		socket_deallocate(sock_local);
+		socket_deallocate(sock_remote);
+		network_poll_deallocate(poll);
+		return;
+	}
+
+	socket_set_blocking(sock_local, false);
+	socket_set_blocking(sock_remote, false);
+	network_poll_add_socket(poll, sock_local);
+	memset(buffer, 0, sizeof(buffer));
+	memset(&reflect, 0, sizeof(reflect));
+	reflect.config = config;
+	reflect.sock = sock_remote;
+	thread_initialize(&thread, bench_poll_reflect_thread, &reflect, STRING_CONST("poll_reflect"),
+	                  THREAD_PRIORITY_NORMAL, 0);
+	thread_start(&thread);
+
+	array_reserve(samples, 64 * 1024);
+
+	start = time_current();
+	while (time_diff(start, time_current()) < config->duration) {
+		size_t read = 0;
+		begin = time_current();
+		udp_socket_sendto(sock_local, buffer, size, socket_address_local(sock_remote));
+		while (!read && network_poll(poll, events, sizeof(events) / sizeof(events[0]), 100))
+			read = udp_socket_recvfrom(sock_local, buffer, sizeof(buffer), &from);
+		if (read)
+			array_push(samples, time_diff(begin, time_current()));
+		else
+			++lost;
+	}
+
+	thread_signal(&thread);
+	thread_join(&thread);
+	thread_finalize(&thread);
+
+	bench_report_uint(report, STRING_CONST("lost"), lost);
+	bench_report_real(report, STRING_CONST("wakeups_per_second"),
+	                  (real)(array_size(samples) * 2) / time_ticks_to_seconds(config->duration));
+	bench_report_latency(report, samples);
+	bench_report_end(report, array_size(samples) * 2);
+
+	array_deallocate(samples);
+	network_poll_deallocate(poll);
+	socket_deallocate(sock_local);
+	socket_deallocate(sock_remote);
+}
+
+static const char* bench_numeric_address[][3] = {{"10.0.0.1:80", "10.0.0.1", "80"},
+                                                  {"[2001:db8::ff00:42:8329]:443", "2001:db8::ff00:42:8329", "443"}};
+
+static bool
+bench_address_system_parse(network_address_t* address, const char* host, const char* service) {
+	struct addrinfo hints;
+	struct addrinfo* result = 0;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = AI_NUMERICHOST;
+	if (getaddrinfo(host, service, &hints, &result) || !result)
+		return false;
+	memcpy(&((network_address_ip_t*)address)->saddr, result->ai_addr, (size_t)result->ai_addrlen);
+	freeaddrinfo(result);
+	return true;
+}
+
+//! Numeric address parsing compared to getaddrinfo with AI_NUMERICHOST, each run for the full duration
+static void
+bench_address_parse(const bench_config_t* config, bench_report_t* report) {
+	network_address_ipv6_t address;
+	size_t count = sizeof(bench_numeric_address) / sizeof(bench_numeric_address[0]);
+	uint64_t parsed = 0, system = 0;
+	tick_t start;
+
+	start = time_current();
+	while (time_diff(start, time_current()) < config->duration) {
+		for (size_t iaddr = 0; iaddr < count; ++iaddr, ++parsed)
+			network_address_parse((network_address_t*)&address, bench_numeric_address[iaddr][0],
+			                      string_length(bench_numeric_address[iaddr][0]));
+	}
+	real parse_elapsed = time_elapsed(start);
+
+	start = time_current();
+	while (time_diff(start, time_current()) < config->duration) {
+		for (size_t iaddr = 0; iaddr < count; ++iaddr, ++system)
+			bench_address_system_parse((network_address_t*)&address, bench_numeric_address[iaddr][1],
+			                           bench_numeric_address[iaddr][2]);
+	}
+	real system_elapsed = time_elapsed(start);
+
+	real parse_rate = (real)parsed / parse_elapsed;
+	real system_rate = (real)system / system_elapsed;
+	bench_report_real(report, STRING_CONST("parse_per_second"), parse_rate);
+	bench_report_real(report, STRING_CONST("getaddrinfo_per_second"), system_rate);
+	bench_report_real(report, STRING_CONST("speedup"), system_rate > 0 ? parse_rate / system_rate : 0);
+	bench_report_end(report, parsed);
+}
+
+//! Numeric address formatting compared to getnameinfo with NI_NUMERICHOST, each run for the full duration
+static void
+bench_address_format(const bench_config_t* config, bench_report_t* report) {
+	network_address_ipv6_t address;
+	const network_address_ip_t* address_ip = (const network_address_ip_t*)&address;
+	char buffer[64];
+	char host[NI_MAXHOST];
+	char service[NI_MAXSERV];
+	uint64_t formatted = 0, system = 0;
+	tick_t start;
+
+	network_address_parse((network_address_t*)&address, STRING_CONST("[2001:db8::ff00:42:8329]:443"));
+
+	start = time_current();
+	while (time_diff(start, time_current()) < config->duration) {
+		network_address_to_string(buffer, sizeof(buffer), (network_address_t*)&address, true);
+		++formatted;
+	}
+	real format_elapsed = time_elapsed(start);
+
+	start = time_current();
+	while (time_diff(start, time_current()) < config->duration) {
+		getnameinfo(&address_ip->saddr, address_ip->address_size, host, sizeof(host), service, sizeof(service),
+		            NI_NUMERICHOST | NI_NUMERICSERV);
+		++system;
+	}
+	real system_elapsed = time_elapsed(start);
+
+	real format_rate = (real)formatted / format_elapsed;
+	real system_rate = (real)system / system_elapsed;
+	bench_report_real(report, STRING_CONST("format_per_second"), format_rate);
+	bench_report_real(report, STRING_CONST("getnameinfo_per_second"), system_rate);
+	bench_report_real(report, STRING_CONST("speedup"), system_rate > 0 ? format_rate / system_rate : 0);
+	bench_report_end(report, formatted);
+}
+
+static const bench_case_t bench_cases[] = {
+    {STRING_CONST("tcp_stream_throughput"), bench_tcp_stream_throughput},
+    {STRING_CONST("tcp_latency"), bench_tcp_latency},
+    {STRING_CONST("tcp_accept"), bench_tcp_accept},
+    {STRING_CONST("udp_pps"), bench_udp_pps},
+    {STRING_CONST("poll_wakeup"), bench_poll_wakeup},
+    {STRING_CONST("address_parse"), bench_address_parse},
+    {STRING_CONST("address_format"), bench_address_format}};
+
+int
+main_run(void* main_arg) {
+	const string_const_t* cmdline = environment_command_line();
+	bench_config_t config;
+	bench_report_t report;
+	string_const_t* selected = nullptr;
+	string_const_t output = string_null();
+	version_t version = network_module_version();
+	size_t icase, ccase = sizeof(bench_cases) / sizeof(bench_cases[0]);
+
+	FOUNDATION_UNUSED(main_arg);
+
+	memset(&config, 0, sizeof(config));
+	config.duration = time_ticks_per_second() * 2;
+	config.message_size = 64;
+	config.datagram_size = 64;
+	config.connections = 1000;
+
+	for (size_t iarg = 1, asize = array_size(cmdline); iarg < asize; ++iarg) {
+		const string_const_t* value = (iarg + 1 < asize) ? cmdline + iarg + 1 : nullptr;
+		if (string_equal(STRING_ARGS(cmdline[iarg]), STRING_CONST("-h")) ||
+		    string_equal(STRING_ARGS(cmdline[iarg]), STRING_CONST("--help"))) {
+			bench_print_usage();
+			array_deallocate(selected);
+			return 0;
+		}
+		if (!value)
+			break;
+		if (string_equal(STRING_ARGS(cmdline[iarg]), STRING_CONST("-o")) ||
+		    string_equal(STRING_ARGS(cmdline[iarg]), STRING_CONST("--output")))
+			output = *value;
+		else if (string_equal(STRING_ARGS(cmdline[iarg]), STRING_CONST("--case")))
+			array_push(selected, *value);
+		else if (string_equal(STRING_ARGS(cmdline[iarg]), STRING_CONST("--duration")))
+			config.duration = (tick_t)(string_to_real(STRING_ARGS(*value)) * (real)time_ticks_per_second());
+		else if (string_equal(STRING_ARGS(cmdline[iarg]), STRING_CONST("--size")))
+			config.message_size = string_to_uint(STRING_ARGS(*value), false);
+		else if (string_equal(STRING_ARGS(cmdline[iarg]), STRING_CONST("--datagram")))
+			config.datagram_size = string_to_uint(STRING_ARGS(*value), false);
+		else if (string_equal(STRING_ARGS(cmdline[iarg]), STRING_CONST("--connections")))
+			config.connections = string_to_uint(STRING_ARGS(*value), false);
+		else
+			continue;
+		++iarg;
+	}
+	if (!config.message_size)
+		config.message_size = 1;
+
+	memset(&report, 0, sizeof(report));
+	if (output.length) {
+		report.stream = stream_open(STRING_ARGS(output), STREAM_OUT | STREAM_CREATE | STREAM_TRUNCATE);
+	} else {
+		// Keep log messages from interleaving with the results on stdout
+		log_enable_stdout(false);
+		report.stream = stream_open_stdout();
+	}
+	if (!report.stream) {
+		log_errorf(0, ERROR_SYSTEM_CALL_FAIL, STRING_CONST("Unable to open output: %.*s"), STRING_FORMAT(output));
+		array_deallocate(selected);
+		return -1;
+	}
+
+	stream_write_format(report.stream,
+	                    STRING_CONST("{\n  \"version\": \"%u.%u.%u\",\n  \"duration\": %.3f,\n  \"benchmarks\": ["),
+	                    version.sub.major, version.sub.minor, version.sub.revision,
+	                    (double)time_ticks_to_seconds(config.duration));
+
+	for (icase = 0; (icase < ccase) && !should_exit; ++icase) {
+		bool run = !array_size(selected);
+		for (size_t isel = 0, ssize = array_size(selected); isel < ssize; ++isel)
+			run |= string_equal(STRING_ARGS(selected[isel]), bench_cases[icase].name, bench_cases[icase].name_length);
+		if (!run)
+			continue;
+		log_infof(0, STRING_CONST("Running %.*s"), (int)bench_cases[icase].name_length, bench_cases[icase].name);
+		bench_report_begin(&report, bench_cases[icase].name, bench_cases[icase].name_length);
+		bench_cases[icase].fn(&config, &report);
+		if (report.values)
+			bench_report_end(&report, 0);
+		bench_process_system_events();
+	}
+
+	stream_write_format(report.stream, STRING_CONST("\n  ]\n}\n"));
+	stream_deallocate(report.stream);
+	array_deallocate(selected);
+
+	return 0;
+}
+
+void
+bench_print_usage(void) {
+	log_info(0, STRING_CONST("bench-network usage:\n"
+	                         "  bench-network [options]\n"
+	                         "    Runs loopback benchmarks and writes the results as JSON.\n"
+	                         "    Optional arguments:\n"
+	                         "      -o|--output file         Write results to file instead of stdout\n"
+	                         "      --case name              Only run the named case, can be repeated\n"
+	                         "      --duration seconds       Duration of each timed case (default 2)\n"
+	                         "      --size bytes             Message size of TCP request/response (default 64)\n"
+	                         "      --datagram bytes         Datagram payload size (default 64)\n"
+	                         "      --connections count      Connections in the accept case (default 1000)\n"
+	                         "    Cases:\n"
+	                         "      tcp_stream_throughput    Bulk transfer through socket streams\n"
+	                         "      tcp_latency              Request/response round trip percentiles\n"
+	                         "      tcp_accept               Connection setup rate and connect latency\n"
+	                         "      udp_pps                  Datagrams per second sent and received\n"
+	                         "      poll_wakeup              Round trip of two threads blocking in network_poll\n"
+	                         "      address_parse            Numeric address parsing compared to getaddrinfo\n"
+	                         "      address_format           Numeric address formatting compared to getnameinfo"));
+}
@@ -0,0 +1,579 @@
+/* main.c  -  Network poll benchmarks  -  Public Domain  -  2013 Mattias Jansson
+ *
+ * This library provides a network abstraction built on foundation streams. The latest source code is
+ * always available at
+ *
+ * https://github.com/mjansson/network_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any restrictions.
+ *
+ */
+
+#include <network/network.h>
+
+#include <foundation/foundation.h>
+
+#if FOUNDATION_PLATFORM_POSIX
+#include <sys/resource.h>
+#endif
+
+/* Scalability benchmarks of network_poll with large socket populations. For each backend
+   (the native system poll mechanism and the simulated network) and each population size a
+   set of UDP sockets is added to one poll object, and each mode drives a different activity
+   pattern against it for a fixed duration:
+
+   churn_random   Remove a random socket and add it back
+   churn_last     Remove the socket in the last slot and add it back, no slot is moved
+   churn_first    Remove the socket in the first slot and add it back, the last slot is moved
+                  into its place (on epoll an EPOLL_CTL_MOD per removal)
+   ready_sparse   One percent of the sockets have a pending datagram when polled
+   ready_full     All sockets have a pending datagram when polled
+
+   Results are written as a single JSON document with the cost per operation and, for the
+   ready modes, the number of events reported per second of time spent in network_poll. */
+
+#define BENCH_POLL_EVENTS 1024
+#define BENCH_SOCKETS_PER_HOST 16384
+#define BENCH_SIZES_MAX 8
+
+typedef struct bench_config_t bench_config_t;
+typedef struct bench_report_t bench_report_t;
+typedef struct bench_population_t bench_population_t;
+
+typedef void (*bench_fn)(const bench_config_t* config, bench_population_t* population, bench_report_t* report);
+
+struct bench_config_t {
+	//! Duration of each mode in ticks
+	tick_t duration;
+	//! Population sizes
+	unsigned int sizes[BENCH_SIZES_MAX];
+	//! Number of population sizes
+	size_t sizes_count;
+};
+
+struct bench_report_t {
+	stream_t* stream;
+	//! Set once the first result has been written
+	bool started;
+};
+
+struct bench_population_t {
+	//! Backend name
+	const char* backend;
+	//! Simulated network, null for the native backend
+	network_sim_t* sim;
+	//! Poll object holding all sockets of the population
+	network_poll_t* poll;
+	//! Sockets in the order they were added
+	socket_t** sockets;
+	//! Socket sending datagrams to the population, not in the poll object
+	socket_t* sender;
+};
+
+typedef struct {
+	const char* name;
+	size_t name_length;
+	bench_fn fn;
+} bench_case_t;
+
+static bool should_exit;
+
+static void
+bench_print_usage(void);
+
+int
+main_initialize(void) {
+	int ret = 0;
+	foundation_config_t config;
+	network_config_t network_config;
+	application_t application;
+
+	memset(&config, 0, sizeof(config));
+	memset(&network_config, 0, sizeof(network_config));
+
+	memset(&application, 0, sizeof(application));
+	application.name = string_const(STRING_CONST("bench-poll"));
+	application.short_name = string_const(STRING_CONST("bench_poll"));
+	application.company = string_const(STRING_CONST(""));
+	application.flags = APPLICATION_UTILITY;
+
+	log_enable_prefix(false);
+	log_set_suppress(0, ERRORLEVEL_INFO);
+
+	if ((ret = foundation_initialize(memory_system_malloc(), application, config)) < 0)
+		return ret;
+
+	log_set_suppress(HASH_NETWORK, ERRORLEVEL_WARNING);
+
+	if ((ret = network_module_initialize(network_config)) < 0)
+		return ret;
+
+	return 0;
+}
+
+void
+main_finalize(void) {
+	network_module_finalize();
+	foundation_finalize();
+}
+
+static void
+bench_process_system_events(void) {
+	event_block_t* block;
+	event_t* event = 0;
+
+	system_process_events();
+
+	block = event_stream_process(system_event_stream());
+
+	while ((event = event_next(block, event))) {
+		if (event->id == FOUNDATIONEVENT_TERMINATE)
+			should_exit = true;
+	}
+}
+
+static const char*
+bench_native_backend(void) {
+#if FOUNDATION_PLATFORM_APPLE
+	return "poll";
+#elif FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+	return "epoll";
+#elif FOUNDATION_PLATFORM_WINDOWS
+	return "select";
+#else
+	return "native";
+#endif
+}
+
+// Make room for the largest population in the process descriptor limit where possible
+static void
+bench_raise_descriptor_limit(unsigned int count) {
+#if FOUNDATION_PLATFORM_POSIX
+	struct rlimit limit;
+	rlim_t wanted = (rlim_t)count + 64;
+	if (!getrlimit(RLIMIT_NOFILE, &limit) && (limit.rlim_cur < wanted)) {
+		limit.rlim_cur = ((limit.rlim_max == RLIM_INFINITY) || (limit.rlim_max > wanted)) ? wanted : limit.rlim_max;
+		setrlimit(RLIMIT_NOFILE, &limit);
+	}
+#else
+	FOUNDATION_UNUSED(count);
+#endif
+}
+
+static void
+bench_report_begin(bench_report_t* report, const char* name, size_t length, const bench_population_t* population,
+                   unsigned int count) {
+	stream_write_format(report->stream,
+	                    STRING_CONST("%s\n    {\"name\": \"%.*s\", \"backend\": \"%s\", \"sockets\": %u"),
+	                    report->started ? "," : "", (int)length, name, population->backend, count);
+	report->started = true;
+}
+
+static void
+bench_report_real(bench_report_t* report, const char* key, size_t length, real value) {
+	stream_write_format(report->stream, STRING_CONST(", \"%.*s\": %.3f"), (int)length, key, (double)value);
+}
+
+static void
+bench_report_uint(bench_report_t* report, const char* key, size_t length, uint64_t value) {
+	stream_write_format(report->stream, STRING_CONST(", \"%.*s\": %" PRIu64), (int)length, key, value);
+}
+
+static void
+bench_report_end(bench_report_t* report) {
+	stream_write_format(report->stream, STRING_CONST("}"));
+	stream_flush(report->stream);
+}
+
+static real
+bench_ticks_to_ns(tick_t ticks, uint64_t count) {
+	return count ? (time_ticks_to_seconds(ticks) * REAL_C(1000000000.0)) / (real)count : 0;
+}
+
+static void
+bench_population_finalize(bench_population_t* population) {
+	// Removing sockets one by one is quadratic, discard the poll object first instead
+	if (population->poll)
+		network_poll_deallocate(population->poll);
+	for (size_t isock = 0, ssize = array_size(population->sockets); isock < ssize; ++isock)
+		socket_deallocate(population->sockets[isock]);
+	array_deallocate(population->sockets);
+	socket_deallocate(population->sender);
+	if (population->sim)
+		network_sim_deallocate(population->sim);
+	memset(population, 0, sizeof(bench_population_t));
+}
+
+/* Allocate count datagram sockets and add them to a new poll object. Sockets are spread over
+   loopback addresses 127.0.0.1, 127.0.0.2 and so on to stay within the port range of each
+   address. Returns false if not all sockets could be allocated. */
+static bool
+bench_population_initialize(bench_population_t* population, bool simulated, unsigned int count) {
+	network_address_ipv4_t address;
+
+	memset(population, 0, sizeof(bench_population_t));
+	population->backend = simulated ? "sim" : bench_native_backend();
+	population->poll = network_poll_allocate(count);
+	if (simulated) {
+		population->sim = network_sim_allocate(1);
+		network_sim_attach_poll(population->sim, population->poll);
+	}
+	array_reserve(population->sockets, count);
+
+	network_address_ipv4_initialize(&address);
+	for (unsigned int isock = 0; isock < count; ++isock) {
+		unsigned char host = (unsigned char)(1 + (isock / BENCH_SOCKETS_PER_HOST));
+		socket_t* sock;
+		network_address_ipv4_set_ip((network_address_t*)&address, network_address_ipv4_make_ip(127, 0, 0, host));
+		if (population->sim) {
+			sock = network_sim_socket_allocate(population->sim, (network_address_t*)&address);
+		} else {
+			sock = udp_socket_allocate();
+			if (!socket_bind(sock, (network_address_t*)&address)) {
+				socket_deallocate(sock);
+				sock = nullptr;
+			}
+		}
+		if (!sock)
+			return false;
+		socket_set_blocking(sock, false);
+		array_push(population->sockets, sock);
+		if (!network_poll_add_socket(population->poll, sock))
+			return false;
+	}
+
+	network_address_ipv4_set_ip((network_address_t*)&address, network_address_ipv4_make_ip(127, 0, 0, 254));
+	if (population->sim) {
+		population->sender = network_sim_socket_allocate(population->sim, (network_address_t*)&address);
+	} else {
+		population->sender = udp_socket_allocate();
+		if (!socket_bind(population->sender, (network_address_t*)&address)) {
+			socket_deallocate(population->sender);
+			population->sender = nullptr;
+		}
+	}
+	return population->sender != nullptr;
+}
+
+static void
+bench_churn_report(bench_report_t* report, uint64_t operations, tick_t remove_ticks, tick_t add_ticks) {
+	bench_report_uint(report, STRING_CONST("operations"), operations);
+	bench_report_real(report, STRING_CONST("remove_ns"), bench_ticks_to_ns(remove_ticks, operations));
+	bench_report_real(report, STRING_CONST("add_ns"), bench_ticks_to_ns(add_ticks, operations));
+	bench_report_real(report, STRING_CONST("operations_per_second"),
+	                  (remove_ticks + add_ticks) ?
+	                      (real)operations / time_ticks_to_seconds(remove_ticks + add_ticks) :
+	                      0);
+}
+
+static void
+bench_churn_random(const bench_config_t* config, bench_population_t* population, bench_report_t* report) {
+	size_t count = array_size(population->sockets);
+	uint64_t operations = 0;
+	tick_t remove_ticks = 0, add_ticks = 0;
+	tick_t start = time_current();
+
+	while (time_diff(start, time_current()) < config->duration) {
+		socket_t* sock = population->sockets[random32_range(0, (uint32_t)count)];
+		tick_t begin = time_current();
+		network_poll_remove_socket(population->poll, sock);
+		tick_t mid = time_current();
+		network_poll_add_socket(population->poll, sock);
+		add_ticks += time_diff(mid, time_current());
+		remove_ticks += time_diff(begin, mid);
+		++operations;
+	}
+	bench_churn_report(report, operations, remove_ticks, add_ticks);
+}
+
+// Get the sockets currently in the first and last slot of the poll object
+static void
+bench_population_ends(bench_population_t* population, socket_t** first, socket_t** last) {
+	size_t count = array_size(population->sockets);
+	socket_t** slots = memory_allocate(HASH_NETWORK, sizeof(socket_t*) * count, 0, MEMORY_PERSISTENT);
+	network_poll_sockets(population->poll, slots, count);
+	*first = slots[0];
+	*last = slots[count - 1];
+	memory_deallocate(slots);
+}
+
+static void
+bench_churn_last(const bench_config_t* config, bench_population_t* population, bench_report_t* report) {
+	socket_t* first;
+	socket_t* last;
+	uint64_t operations = 0;
+	tick_t remove_ticks = 0, add_ticks = 0;
+	tick_t start;
+
+	// Adding puts the removed socket back in the last slot
+	bench_population_ends(population, &first, &last);
+	start = time_current();
+	while (time_diff(start, time_current()) < config->duration) {
+		tick_t begin = time_current();
+		network_poll_remove_socket(population->poll, last);
+		tick_t mid = time_current();
+		network_poll_add_socket(population->poll, last);
+		add_ticks += time_diff(mid, time_current());
+		remove_ticks += time_diff(begin, mid);
+		++operations;
+	}
+	bench_churn_report(report, operations, remove_ticks, add_ticks);
+}
+
+static void
+bench_churn_first(const bench_config_t* config, bench_population_t* population, bench_report_t* report) {
+	socket_t* first;
+	socket_t* last;
+	uint64_t operations = 0;
+	tick_t remove_ticks = 0, add_ticks = 0;
+	tick_t start;
+
+	// Removing the first slot moves the last socket into it and adding puts the removed socket
+	// last, so the first and last socket swap places on every operation
+	bench_population_ends(population, &first, &last);
+	start = time_current();
+	while (time_diff(start, time_current()) < config->duration) {
+		socket_t* sock = first;
+		tick_t begin = time_current();
+		network_poll_remove_socket(population->poll, sock);
+		tick_t mid = time_current();
+		network_poll_add_socket(population->poll, sock);
+		add_ticks += time_diff(mid, time_current());
+		remove_ticks += time_diff(begin, mid);
+		first = last;
+		last = sock;
+		++operations;
+	}
+	bench_churn_report(report, operations, remove_ticks, add_ticks);
+}
+
+/* Send one datagram to each of ready sockets evenly spaced through the population, then
+   poll and drain until all have been reported. Only time spent in network_poll is measured. */
+static void
+bench_ready(const bench_config_t* config, bench_population_t* population, bench_report_t* report, size_t ready) {
+	size_t count = array_size(population->sockets);
+	size_t stride = count / ready;
+	network_poll_event_t* events;
+	const network_address_t* from;
+	char payload[32];
+	char buffer[64];
+	uint64_t polls = 0, rounds = 0, events_total = 0, missed = 0;
+	tick_t poll_ticks = 0;
+	tick_t start;
+
+	events = memory_allocate(HASH_NETWORK, sizeof(network_poll_event_t) * BENCH_POLL_EVENTS, 0, MEMORY_PERSISTENT);
+	memset(payload, 0, sizeof(payload));
+
+	start = time_current();
+	while (time_diff(start, time_current()) < config->duration) {
+		size_t offset = random32_range(0, (uint32_t)stride);
+		size_t pending = 0;
+		size_t empty = 0;
+
+		for (size_t iready = 0; iready < ready; ++iready) {
+			socket_t* sock = population->sockets[offset + (iready * stride)];
+			if (udp_socket_sendto(population->sender, payload, sizeof(payload), socket_address_local(sock)))
+				++pending;
+		}
+		if (population->sim)
+			network_sim_advance(population->sim, 0);
+
+		while (pending && (empty < 100)) {
+			tick_t begin = time_current();
+			size_t reported = network_poll(population->poll, events, BENCH_POLL_EVENTS, 0);
+			poll_ticks += time_diff(begin, time_current());
+			++polls;
+			events_total += reported;
+			empty = reported ? 0 : empty + 1;
+			for (size_t ievent = 0; ievent < reported; ++ievent) {
+				if (events[ievent].event != NETWORKEVENT_DATAIN)
+					continue;
+				while (udp_socket_recvfrom(events[ievent].socket, buffer, sizeof(buffer), &from) && pending)
+					--pending;
+			}
+		}
+		missed += pending;
+		++rounds;
+	}
+
+	bench_report_uint(report, STRING_CONST("ready"), ready);
+	bench_report_uint(report, STRING_CONST("rounds"), rounds);
+	bench_report_uint(report, STRING_CONST("polls"), polls);
+	bench_report_uint(report, STRING_CONST("events"), events_total);
+	bench_report_uint(report, STRING_CONST("missed"), missed);
+	bench_report_real(report, STRING_CONST("poll_ns"), bench_ticks_to_ns(poll_ticks, polls));
+	bench_report_real(report, STRING_CONST("event_ns"), bench_ticks_to_ns(poll_ticks, events_total));
+	bench_report_real(report, STRING_CONST("events_per_second"),
+	                  poll_ticks ? (real)events_total / time_ticks_to_seconds(poll_ticks) : 0);
+
+	memory_deallocate(events);
+}
+
+static void
+bench_ready_sparse(const bench_config_t* config, bench_population_t* population, bench_report_t* report) {
+	size_t ready = array_size(population->sockets) / 100;
+	bench_ready(config, population, report, ready ? ready : 1);
+}
+
+static void
+bench_ready_full(const bench_config_t* config, bench_population_t* population, bench_report_t* report) {
+	bench_ready(config, population, report, array_size(population->sockets));
+}
+
+static const bench_case_t bench_cases[] = {{STRING_CONST("churn_random"), bench_churn_random},
+                                           {STRING_CONST("churn_last"), bench_churn_last},
+                                           {STRING_CONST("churn_first"), bench_churn_first},
+                                           {STRING_CONST("ready_sparse"), bench_ready_sparse},
+                                           {STRING_CONST("ready_full"), bench_ready_full}};
+
+static bool
+bench_selected(string_const_t* selected, const char* name, size_t length) {
+	if (!array_size(selected))
+		return true;
+	for (size_t isel = 0, ssize = array_size(selected); isel < ssize; ++isel) {
+		if (string_equal(STRING_ARGS(selected[isel]), name, length))
+			return true;
+	}
+	return false;
+}
+
+// Parse a comma separated list of population sizes
+static void
+bench_parse_sizes(bench_config_t* config, string_const_t value) {
+	size_t offset = 0;
+	config->sizes_count = 0;
+	while ((offset < value.length) && (config->sizes_count < BENCH_SIZES_MAX)) {
+		size_t end = string_find(STRING_ARGS(value), ',', offset);
+		if (end == STRING_NPOS)
+			end = value.length;
+		unsigned int size = string_to_uint(value.str + offset, end - offset, false);
+		if (size)
+			config->sizes[config->sizes_count++] = size;
+		offset = end + 1;
+	}
+}
+
+int
+main_run(void* main_arg) {
+	const string_const_t* cmdline = environment_command_line();
+	bench_config_t config;
+	bench_report_t report;
+	string_const_t* selected = nullptr;
+	string_const_t* backends = nullptr;
+	string_const_t output = string_null();
+	unsigned int largest = 0;
+	size_t icase, ccase = sizeof(bench_cases) / sizeof(bench_cases[0]);
+
+	FOUNDATION_UNUSED(main_arg);
+
+	memset(&config, 0, sizeof(config));
+	config.duration = time_ticks_per_second();
+	config.sizes[0] = 1000;
+	config.sizes[1] = 10000;
+	config.sizes[2] = 100000;
+	config.sizes_count = 3;
+
+	for (size_t iarg = 1, asize = array_size(cmdline); iarg < asize; ++iarg) {
+		const string_const_t* value = (iarg + 1 < asize) ? cmdline + iarg + 1 : nullptr;
+		if (string_equal(STRING_ARGS(cmdline[iarg]), STRING_CONST("-h")) ||
+		    string_equal(STRING_ARGS(cmdline[iarg]), STRING_CONST("--help"))) {
+			bench_print_usage();
+			array_deallocate(selected);
+			array_deallocate(backends);
+			return 0;
+		}
+		if (!value)
+			break;
+		if (string_equal(STRING_ARGS(cmdline[iarg]), STRING_CONST("-o")) ||
+		    string_equal(STRING_ARGS(cmdline[iarg]), STRING_CONST("--output")))
+			output = *value;
+		else if (string_equal(STRING_ARGS(cmdline[iarg]), STRING_CONST("--case")))
+			array_push(selected, *value);
+		else if (string_equal(STRING_ARGS(cmdline[iarg]), STRING_CONST("--backend")))
+			array_push(backends, *value);
+		else if (string_equal(STRING_ARGS(cmdline[iarg]), STRING_CONST("--sockets")))
+			bench_parse_sizes(&config, *value);
+		else if (string_equal(STRING_ARGS(cmdline[iarg]), STRING_CONST("--duration")))
+			config.duration = (tick_t)(string_to_real(STRING_ARGS(*value)) * (real)time_ticks_per_second());
+		else
+			continue;
+		++iarg;
+	}
+
+	for (size_t isize = 0; isize < config.sizes_count; ++isize)
+		largest = (config.sizes[isize] > largest) ? config.sizes[isize] : largest;
+	bench_raise_descriptor_limit(largest);
+
+	memset(&report, 0, sizeof(report));
+	if (output.length) {
+		report.stream = stream_open(STRING_ARGS(output), STREAM_OUT | STREAM_CREATE | STREAM_TRUNCATE);
+	} else {
+		// Keep log messages from interleaving with the results on stdout
+		log_enable_stdout(false);
+		report.stream = stream_open_stdout();
+	}
+	if (!report.stream) {
+		log_errorf(0, ERROR_SYSTEM_CALL_FAIL, STRING_CONST("Unable to open output: %.*s"), STRING_FORMAT(output));
+		array_deallocate(selected);
+		array_deallocate(backends);
+		return -1;
+	}
+
+	stream_write_format(report.stream, STRING_CONST("{\n  \"duration\": %.3f,\n  \"benchmarks\": ["),
+	                    (double)time_ticks_to_seconds(config.duration));
+
+	for (int ibackend = 0; (ibackend < 2) && !should_exit; ++ibackend) {
+		bool simulated = (ibackend == 1);
+		const char* name = simulated ? "sim" : "native";
+		if (!bench_selected(backends, name, string_length(name)))
+			continue;
+		for (size_t isize = 0; (isize < config.sizes_count) && !should_exit; ++isize) {
+			bench_population_t population;
+			unsigned int count = config.sizes[isize];
+			bool valid = bench_population_initialize(&population, simulated, count);
+			log_infof(0, STRING_CONST("Running %s backend with %u sockets"), population.backend, count);
+			for (icase = 0; (icase < ccase) && !should_exit; ++icase) {
+				if (!bench_selected(selected, bench_cases[icase].name, bench_cases[icase].name_length))
+					continue;
+				bench_report_begin(&report, bench_cases[icase].name, bench_cases[icase].name_length, &population,
+				                   count);
+				if (valid) {
+					bench_cases[icase].fn(&config, &population, &report);
+				} else {
+					bench_report_uint(&report, STRING_CONST("allocated"), array_size(population.sockets));
+					stream_write_format(report.stream, STRING_CONST(", \"error\": \"unable to allocate sockets\""));
+				}
+				bench_report_end(&report);
+				bench_process_system_events();
+			}
+			bench_population_finalize(&population);
+		}
+	}
+
+	stream_write_format(report.stream, STRING_CONST("\n  ]\n}\n"));
+	stream_deallocate(report.stream);
+	array_deallocate(selected);
+	array_deallocate(backends);
+
+	return 0;
+}
+
+void
+bench_print_usage(void) {
+	log_info(0, STRING_CONST("bench-poll usage:\n"
+	                         "  bench-poll [options]\n"
+	                         "    Measures network_poll with large socket populations and writes the results as JSON.\n"
+	                         "    Optional arguments:\n"
+	                         "      -o|--output file         Write results to file instead of stdout\n"
+	                         "      --sockets list           Comma separated population sizes\n"
+	                         "                               (default 1000,10000,100000)\n"
+	                         "      --backend name           Only run the native or sim backend, can be repeated\n"
+	                         "      --case name              Only run the named mode, can be repeated\n"
+	                         "      --duration seconds       Duration of each mode (default 1)\n"
+	                         "    Modes:\n"
+	                         "      churn_random             Remove and add back a random socket\n"
+	                         "      churn_last               Remove and add back the socket in the last slot\n"
+	                         "      churn_first              Remove and add back the socket in the first slot\n"
+	                         "      ready_sparse             Poll with one percent of the sockets readable\n"
+	                         "      ready_full               Poll with all sockets readable"));
+}
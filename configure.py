@@ -17,7 +17,7 @@ writer = generator.writer
 toolchain = generator.toolchain
 
 network_lib = generator.lib(module = 'network', sources = [
-  'address.c', 'network.c', 'poll.c', 'socket.c', 'stream.c', 'tcp.c', 'udp.c', 'version.c'])
+  'address.c', 'addressmap.c', 'cidr.c', 'monitor.c', 'network.c', 'poll.c', 'resolver.c', 'sampler.c', 'shm.c', 'sim.c', 'socket.c', 'stream.c', 'tcp.c', 'udp.c', 'unix.c', 'version.c'])
 
 if generator.skip_tests():
   sys.exit()
@@ -33,6 +33,17 @@ if target.is_windows():
 #  if not configs == []:
 #    generator.bin('blast', ['main.c', 'client.c', 'reader.c', 'server.c', 'writer.c'], 'blast', basepath = 'tools', implicit_deps = [network_lib], dependlibs = dependlibs, libs = ['network'] + extralibs, configs = configs)
 
+if not target.is_ios() and not target.is_android() and not target.is_tizen():
+  #Network impairment relay tool
+  generator.bin(module = 'impair', sources = ['main.c', 'profile.c', 'relay.c'], binname = 'impair', basepath = 'tools', implicit_deps = [network_lib], libs = dependlibs + extralibs, dependlibs = dependlibs, includepaths = includepaths)
+
+  #Loopback benchmark binaries writing results as JSON
+  bench_cases = [
+    'network', 'poll'
+  ]
+  for bench in bench_cases:
+    generator.bin(module = bench, sources = ['main.c'], binname = 'bench-' + bench, basepath = 'bench', implicit_deps = [network_lib], libs = dependlibs + extralibs, dependlibs = dependlibs, includepaths = includepaths)
+
 test_cases = [
   'address', 'socket', 'tcp', 'udp', 'poll'
 ]
@@ -19,13 +19,214 @@ network_address_clone(const network_address_t* address) {
 	network_address_t* cloned = 0;
 	if (address) {
 		cloned = memory_allocate(HASH_NETWORK, sizeof(network_address_t) + address->address_size, 0, MEMORY_PERSISTENT);
+		NETWORK_COUNT_ALLOCATION(NETWORK_ALLOCATION_ADDRESS_CLONE, sizeof(network_address_t) + address->address_size);
 		memcpy(cloned, address, sizeof(network_address_t) + address->address_size);
 	}
 	return cloned;
 }
 
+static bool
+network_address_parse_decimal(const char* str, size_t length, size_t max_digits, uint32_t max_value, uint32_t* value) {
+	uint64_t result = 0;
+	if (!length || (length > max_digits) || ((length > 1) && (str[0] == '0')))
+		return false;
+	for (size_t ichar = 0; ichar < length; ++ichar) {
+		uint32_t digit = (uint32_t)(str[ichar] - '0');
+		if (digit > 9)
+			return false;
+		result = (result * 10) + digit;
+	}
+	if (result > max_value)
+		return false;
+	*value = (uint32_t)result;
+	return true;
+}
+
+static bool
+network_address_parse_ipv4_ip(const char* str, size_t length, uint32_t* ip) {
+	uint32_t result = 0;
+	size_t start = 0;
+	for (unsigned int ipart = 0; ipart < 4; ++ipart) {
+		size_t end = start;
+		uint32_t part;
+		while ((end < length) && (str[end] != '.'))
+			++end;
+		if (((ipart < 3) == (end == length)) || !network_address_parse_decimal(str + start, end - start, 3, 255, &part))
+			return false;
+		result = (result << 8) | part;
+		start = end + 1;
+	}
+	*ip = result;
+	return true;
+}
+
+static bool
+network_address_parse_ipv6_ip(const char* str, size_t length, uint8_t* ip) {
+	uint16_t group[8];
+	size_t count = 0;
+	size_t gap = 8;
+	size_t pos = 0;
+
+	if ((length >= 2) && (str[0] == ':')) {
+		if (str[1] != ':')
+			return false;
+		gap = 0;
+		pos = 2;
+	}
+
+	while (pos < length) {
+		size_t start = pos;
+		uint32_t value = 0;
+		if (count == 8)
+			return false;
+		while ((pos < length) && ((pos - start) < 4)) {
+			char c = str[pos];
+			if ((c >= '0') && (c <= '9'))
+				value = (value << 4) | (uint32_t)(c - '0');
+			else if ((c >= 'a') && (c <= 'f'))
+				value = (value << 4) | (uint32_t)(c - 'a' + 10);
+			else if ((c >= 'A') && (c <= 'F'))
+				value = (value << 4) | (uint32_t)(c - 'A' + 10);
+			else
+				break;
+			++pos;
+		}
+		if (pos == start)
+			return false;
+		if ((pos < length) && (str[pos] == '.')) {
+			// Embedded IPv4 address in last 32 bits
+			uint32_t ipv4;
+			if ((count > 6) || !network_address_parse_ipv4_ip(str + start, length - start, &ipv4))
+				return false;
+			group[count++] = (uint16_t)(ipv4 >> 16);
+			group[count++] = (uint16_t)(ipv4 & 0xFFFF);
+			pos = length;
+			break;
+		}
+		group[count++] = (uint16_t)value;
+		if (pos == length)
+			break;
+		if ((str[pos] != ':') || (++pos == length))
+			return false;
+		if (str[pos] == ':') {
+			if (gap != 8)
+				return false;
+			gap = count;
+			++pos;
+		}
+	}
+
+	if ((gap == 8) ? (count != 8) : (count > 7))
+		return false;
+
+	memset(ip, 0, 16);
+	for (size_t igroup = 0; igroup < count; ++igroup) {
+		size_t slot = (igroup < gap) ? igroup : (igroup + (8 - count));
+		ip[slot * 2] = (uint8_t)(group[igroup] >> 8);
+		ip[(slot * 2) + 1] = (uint8_t)(group[igroup] & 0xFF);
+	}
+	return true;
+}
+
+bool
+network_address_ipv4_parse(network_address_ipv4_t* address, const char* str, size_t length) {
+	size_t end = 0;
+	uint32_t ip;
+	uint32_t port = 0;
+
+	while ((end < length) && (str[end] != ':'))
+		++end;
+	if (!network_address_parse_ipv4_ip(str, end, &ip))
+		return false;
+	if ((end < length) && !network_address_parse_decimal(str + end + 1, length - end - 1, 5, 65535, &port))
+		return false;
+
+	network_address_ipv4_initialize(address);
+	address->saddr.sin_addr.s_addr = byteorder_bigendian32(ip);
+	address->saddr.sin_port = htons((unsigned short)port);
+	return true;
+}
+
+bool
+network_address_ipv6_parse(network_address_ipv6_t* address, const char* str, size_t length) {
+	size_t end = length;
+	size_t scope_start;
+	uint32_t port = 0;
+	uint32_t scope = 0;
+	uint8_t ip[16];
+
+	if (length && (str[0] == '[')) {
+		// Bracketed format with optional port, [addr]:port
+		end = 1;
+		while ((end < length) && (str[end] != ']'))
+			++end;
+		if (end == length)
+			return false;
+		if ((end + 1 < length) && ((str[end + 1] != ':') || !network_address_parse_decimal(
+		                                                         str + end + 2, length - end - 2, 5, 65535, &port)))
+			return false;
+		++str;
+		--end;
+	}
+
+	// Only numeric scope identifiers, interface names need a system lookup
+	for (scope_start = 0; scope_start < end; ++scope_start) {
+		if (str[scope_start] == '%')
+			break;
+	}
+	if ((scope_start < end) &&
+	    !network_address_parse_decimal(str + scope_start + 1, end - scope_start - 1, 10, 0xFFFFFFFF, &scope))
+		return false;
+
+	if (!network_address_parse_ipv6_ip(str, scope_start, ip))
+		return false;
+
+	network_address_ipv6_initialize(address);
+	memcpy(&address->saddr.sin6_addr, ip, sizeof(ip));
+	address->saddr.sin6_port = htons((unsigned short)port);
+	address->saddr.sin6_scope_id = scope;
+	return true;
+}
+
+bool
+network_address_parse(network_address_t* address, const char* str, size_t length) {
+	if ((length > 5) && !memcmp(str, "unix:", 5))
+		return network_address_unix_initialize((network_address_unix_t*)address, str + 5, length - 5) != nullptr;
+	if (network_address_ipv4_parse((network_address_ipv4_t*)address, str, length))
+		return true;
+	return network_address_ipv6_parse((network_address_ipv6_t*)address, str, length);
+}
+
 network_address_t**
 network_address_resolve(const char* address, size_t length) {
+	network_address_t** addresses = 0;
+	network_address_ipv6_t parsed;
+
+	if (!address)
+		return addresses;
+
+	// Fast path for numeric addresses, no string processing or system resolver call
+	if (network_address_parse((network_address_t*)&parsed, address, length)) {
+		size_t size = (parsed.family == NETWORK_ADDRESSFAMILY_IPV4) ? sizeof(network_address_ipv4_t) :
+		                                                              sizeof(network_address_ipv6_t);
+		network_address_t* numeric = memory_allocate(HASH_NETWORK, size, 0, MEMORY_PERSISTENT);
+		NETWORK_COUNT_ALLOCATION(NETWORK_ALLOCATION_ADDRESS_RESOLVE, size);
+		memcpy(numeric, &parsed, size);
+		array_push(addresses, numeric);
+		return addresses;
+	}
+
+	if (network_resolver_cache_lookup(address, length, &addresses))
+		return addresses;
+
+	addresses = network_address_resolve_blocking(address, length);
+	network_resolver_cache_store(address, length, addresses);
+
+	return addresses;
+}
+
+network_address_t**
+network_address_resolve_blocking(const char* address, size_t length) {
 	network_address_t** addresses = 0;
 	string_t localaddress = (string_t){0, 0};
 	const char* final_address = address;
@@ -74,6 +275,7 @@ network_address_resolve(const char* address, size_t length) {
 
 	if (portdelim != STRING_NPOS) {
 		localaddress = string_clone(address, length);
+		NETWORK_COUNT_ALLOCATION(NETWORK_ALLOCATION_ADDRESS_RESOLVE, length + 1);
 		localaddress.str[portdelim] = 0;
 		final_address = localaddress.str;
 
@@ -96,6 +298,7 @@ network_address_resolve(const char* address, size_t length) {
 				network_address_ipv4_t* ipv4;
 				ipv4 = memory_allocate(HASH_NETWORK, sizeof(network_address_ipv4_t), 0,
 				                       MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+				NETWORK_COUNT_ALLOCATION(NETWORK_ALLOCATION_ADDRESS_RESOLVE, sizeof(network_address_ipv4_t));
 				ipv4->family = NETWORK_ADDRESSFAMILY_IPV4;
 				ipv4->address_size = sizeof(struct sockaddr_in);
 				memcpy(&ipv4->saddr, curaddr->ai_addr, sizeof(struct sockaddr_in));
@@ -105,6 +308,7 @@ network_address_resolve(const char* address, size_t length) {
 				network_address_ipv6_t* ipv6;
 				ipv6 = memory_allocate(HASH_NETWORK, sizeof(network_address_ipv6_t), 0,
 				                       MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+				NETWORK_COUNT_ALLOCATION(NETWORK_ALLOCATION_ADDRESS_RESOLVE, sizeof(network_address_ipv6_t));
 				ipv6->family = NETWORK_ADDRESSFAMILY_IPV6;
 				ipv6->address_size = sizeof(struct sockaddr_in6);
 				memcpy(&ipv6->saddr, curaddr->ai_addr, sizeof(struct sockaddr_in6));
@@ -127,9 +331,134 @@ network_address_resolve(const char* address, size_t length) {
 	return addresses;
 }
 
+static size_t
+network_address_format_decimal(char* out, uint32_t value) {
+	char digits[10];
+	size_t count = 0;
+	do {
+		digits[count++] = (char)('0' + (value % 10));
+		value /= 10;
+	} while (value);
+	for (size_t idigit = 0; idigit < count; ++idigit)
+		out[idigit] = digits[count - idigit - 1];
+	return count;
+}
+
+static size_t
+network_address_format_ipv4(char* out, const uint8_t* ip) {
+	size_t offset = 0;
+	for (unsigned int ipart = 0; ipart < 4; ++ipart) {
+		if (ipart)
+			out[offset++] = '.';
+		offset += network_address_format_decimal(out + offset, ip[ipart]);
+	}
+	return offset;
+}
+
+// Format IPv6 address according to RFC 5952, lowercase hex without leading zeros, the
+// longest run (first if tied) of two or more zero groups compressed to ::
+static size_t
+network_address_format_ipv6(char* out, const uint8_t* ip) {
+	static const char hexdigit[] = "0123456789abcdef";
+	uint16_t group[8];
+	size_t gap_start = 8, gap_length = 0;
+	size_t run_start = 0, run_length = 0;
+	size_t offset = 0;
+	size_t igroup;
+
+	for (igroup = 0; igroup < 8; ++igroup) {
+		group[igroup] = (uint16_t)((ip[igroup * 2] << 8) | ip[(igroup * 2) + 1]);
+		if (!group[igroup]) {
+			if (!run_length++)
+				run_start = igroup;
+			if ((run_length > gap_length) && (run_length > 1)) {
+				gap_start = run_start;
+				gap_length = run_length;
+			}
+		} else {
+			run_length = 0;
+		}
+	}
+
+	// IPv4-mapped addresses use dotted quad in the last 32 bits
+	if ((gap_start == 0) && (gap_length == 5) && (group[5] == 0xFFFF)) {
+		memcpy(out, "::ffff:", 7);
+		return 7 + network_address_format_ipv4(out + 7, ip + 12);
+	}
+
+	for (igroup = 0; igroup < 8; ++igroup) {
+		if (igroup == gap_start) {
+			out[offset++] = ':';
+			out[offset++] = ':';
+			igroup += gap_length - 1;
+			continue;
+		}
+		if (igroup && (igroup != gap_start + gap_length))
+			out[offset++] = ':';
+		uint16_t value = group[igroup];
+		bool leading = true;
+		for (int shift = 12; shift >= 0; shift -= 4) {
+			unsigned int nibble = (value >> shift) & 0xF;
+			if (nibble || !leading || !shift) {
+				out[offset++] = hexdigit[nibble];
+				leading = false;
+			}
+		}
+	}
+	return offset;
+}
+
+static string_t
+network_address_format_numeric(char* buffer, size_t capacity, const network_address_t* address) {
+	// Longest output is bracketed IPv6 with embedded IPv4, scope and port
+	char formatted[NETWORK_ADDRESS_NUMERIC_MAX_LENGTH + 24];
+	size_t offset = 0;
+	unsigned int port;
+
+	if (address->family == NETWORK_ADDRESSFAMILY_IPV4) {
+		const network_address_ipv4_t* addr_ipv4 = (const network_address_ipv4_t*)address;
+		offset = network_address_format_ipv4(formatted, (const uint8_t*)&addr_ipv4->saddr.sin_addr);
+		port = ntohs(addr_ipv4->saddr.sin_port);
+		if (port) {
+			formatted[offset++] = ':';
+			offset += network_address_format_decimal(formatted + offset, port);
+		}
+	} else {
+		const network_address_ipv6_t* addr_ipv6 = (const network_address_ipv6_t*)address;
+		port = ntohs(addr_ipv6->saddr.sin6_port);
+		if (port)
+			formatted[offset++] = '[';
+		offset += network_address_format_ipv6(formatted + offset, (const uint8_t*)&addr_ipv6->saddr.sin6_addr);
+		if (addr_ipv6->saddr.sin6_scope_id) {
+			formatted[offset++] = '%';
+			offset += network_address_format_decimal(formatted + offset, addr_ipv6->saddr.sin6_scope_id);
+		}
+		if (port) {
+			formatted[offset++] = ']';
+			formatted[offset++] = ':';
+			offset += network_address_format_decimal(formatted + offset, port);
+		}
+	}
+
+	return string_copy(buffer, capacity, formatted, offset);
+}
+
+static string_t
+network_address_format_unix(char* buffer, size_t capacity, const network_address_t* address) {
+	string_const_t path = network_address_unix_path(address);
+	if (network_address_unix_is_abstract(address))
+		return string_format(buffer, capacity, STRING_CONST("unix:@%.*s"), STRING_FORMAT(path));
+	return string_format(buffer, capacity, STRING_CONST("unix:%.*s"), STRING_FORMAT(path));
+}
+
 string_t
 network_address_to_string(char* buffer, size_t capacity, const network_address_t* address, bool numeric) {
 	if (address) {
+		if (address->family == NETWORK_ADDRESSFAMILY_UNIX)
+			return network_address_format_unix(buffer, capacity, address);
+		if (numeric &&
+		    ((address->family == NETWORK_ADDRESSFAMILY_IPV4) || (address->family == NETWORK_ADDRESSFAMILY_IPV6)))
+			return network_address_format_numeric(buffer, capacity, address);
 		if (address->family == NETWORK_ADDRESSFAMILY_IPV4) {
 			char host[NI_MAXHOST] = {0};
 			char service[NI_MAXSERV] = {0};
@@ -176,6 +505,74 @@ network_address_ipv4_initialize(network_address_ipv4_t* address) {
 	return (network_address_t*)address;
 }
 
+network_address_t*
+network_address_unix_initialize(network_address_unix_t* address, const char* path, size_t length) {
+#if FOUNDATION_PLATFORM_POSIX
+	size_t path_offset = offsetof(struct sockaddr_un, sun_path);
+	memset(address, 0, sizeof(network_address_unix_t));
+	if (!length || (length >= sizeof(address->saddr.sun_path)))
+		return nullptr;
+	address->saddr.sun_family = AF_UNIX;
+	address->family = NETWORK_ADDRESSFAMILY_UNIX;
+	if (path[0] == '@') {
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+		// Abstract name, leading zero byte and no terminator, length is part of the name
+		memcpy(address->saddr.sun_path + 1, path + 1, length - 1);
+		address->address_size = (network_address_size_t)(path_offset + length);
+#else
+		return nullptr;
+#endif
+	} else {
+		memcpy(address->saddr.sun_path, path, length);
+		address->address_size = (network_address_size_t)(path_offset + length + 1);
+	}
+#if FOUNDATION_PLATFORM_APPLE
+	address->saddr.sun_len = (uint8_t)address->address_size;
+#endif
+	return (network_address_t*)address;
+#else
+	FOUNDATION_UNUSED(address);
+	FOUNDATION_UNUSED(path);
+	FOUNDATION_UNUSED(length);
+	return nullptr;
+#endif
+}
+
+string_const_t
+network_address_unix_path(const network_address_t* address) {
+#if FOUNDATION_PLATFORM_POSIX
+	if (address && (address->family == NETWORK_ADDRESSFAMILY_UNIX)) {
+		const network_address_unix_t* address_unix = (const network_address_unix_t*)address;
+		size_t path_offset = offsetof(struct sockaddr_un, sun_path);
+		size_t length;
+		if ((size_t)address_unix->address_size <= path_offset)
+			return string_empty();
+		length = (size_t)address_unix->address_size - path_offset;
+		if (!address_unix->saddr.sun_path[0])
+			return string_const(address_unix->saddr.sun_path + 1, length - 1);
+		// Path is zero terminated if it fits, size reported by the system can include trailing zeros
+		while (length && !address_unix->saddr.sun_path[length - 1])
+			--length;
+		return string_const(address_unix->saddr.sun_path, length);
+	}
+#endif
+	FOUNDATION_UNUSED(address);
+	return string_empty();
+}
+
+bool
+network_address_unix_is_abstract(const network_address_t* address) {
+#if FOUNDATION_PLATFORM_POSIX
+	if (address && (address->family == NETWORK_ADDRESSFAMILY_UNIX)) {
+		const network_address_unix_t* address_unix = (const network_address_unix_t*)address;
+		return ((size_t)address_unix->address_size > offsetof(struct sockaddr_un, sun_path)) &&
+		       !address_unix->saddr.sun_path[0];
+	}
+#endif
+	FOUNDATION_UNUSED(address);
+	return false;
+}
+
 network_address_t*
 network_address_ipv6_initialize(network_address_ipv6_t* address) {
 	memset(address, 0, sizeof(network_address_ipv6_t));
@@ -273,6 +670,7 @@ network_address_local(void) {
 	do {
 		adapter_address =
 		    memory_allocate(HASH_NETWORK, (unsigned int)address_size, 0, MEMORY_TEMPORARY | MEMORY_ZERO_INITIALIZED);
+		NETWORK_COUNT_ALLOCATION(NETWORK_ALLOCATION_ADDRESS_RESOLVE, address_size);
 
 		ret = GetAdaptersAddresses(AF_UNSPEC, GAA_FLAG_SKIP_MULTICAST | GAA_FLAG_SKIP_ANYCAST, 0, adapter_address,
 		                           &address_size);
@@ -307,6 +705,7 @@ network_address_local(void) {
 			if (unicast->Address.lpSockaddr->sa_family == AF_INET) {
 				network_address_ipv4_t* ipv4 = memory_allocate(HASH_NETWORK, sizeof(network_address_ipv4_t), 0,
 				                                               MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+				NETWORK_COUNT_ALLOCATION(NETWORK_ALLOCATION_ADDRESS_RESOLVE, sizeof(network_address_ipv4_t));
 				ipv4->family = NETWORK_ADDRESSFAMILY_IPV4;
 				ipv4->address_size = sizeof(struct sockaddr_in);
 				memcpy(&ipv4->saddr, unicast->Address.lpSockaddr, sizeof(struct sockaddr_in));
@@ -315,6 +714,7 @@ network_address_local(void) {
 			} else if ((unicast->Address.lpSockaddr->sa_family == AF_INET6) && (unicast->DadState == NldsPreferred)) {
 				network_address_ipv6_t* ipv6 = memory_allocate(HASH_NETWORK, sizeof(network_address_ipv6_t), 0,
 				                                               MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+				NETWORK_COUNT_ALLOCATION(NETWORK_ALLOCATION_ADDRESS_RESOLVE, sizeof(network_address_ipv6_t));
 				ipv6->family = NETWORK_ADDRESSFAMILY_IPV6;
 				ipv6->address_size = sizeof(struct sockaddr_in6);
 				memcpy(&ipv6->saddr, unicast->Address.lpSockaddr, sizeof(struct sockaddr_in6));
@@ -345,6 +745,7 @@ network_address_local(void) {
 		if (getsockname(sock, (struct sockaddr*)&sin, &socklen) == 0) {
 			network_address_ipv4_t* ipv4 = memory_allocate(HASH_NETWORK, sizeof(network_address_ipv4_t), 0,
 			                                               MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+			NETWORK_COUNT_ALLOCATION(NETWORK_ALLOCATION_ADDRESS_RESOLVE, sizeof(network_address_ipv4_t));
 			ipv4->family = NETWORK_ADDRESSFAMILY_IPV4;
 			ipv4->address_size = sizeof(struct sockaddr_in);
 			ipv4->saddr.sin_family = AF_INET;
@@ -391,6 +792,7 @@ network_address_local(void) {
 		if (ifa->ifa_addr->sa_family == AF_INET) {
 			network_address_ipv4_t* ipv4 = memory_allocate(HASH_NETWORK, sizeof(network_address_ipv4_t), 0,
 			                                               MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+			NETWORK_COUNT_ALLOCATION(NETWORK_ALLOCATION_ADDRESS_RESOLVE, sizeof(network_address_ipv4_t));
 			ipv4->family = NETWORK_ADDRESSFAMILY_IPV4;
 			ipv4->address_size = sizeof(struct sockaddr_in);
 			memcpy(&ipv4->saddr, ifa->ifa_addr, sizeof(struct sockaddr_in));
@@ -404,6 +806,7 @@ network_address_local(void) {
 				continue;
 			network_address_ipv6_t* ipv6 = memory_allocate(HASH_NETWORK, sizeof(network_address_ipv6_t), 0,
 			                                               MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+			NETWORK_COUNT_ALLOCATION(NETWORK_ALLOCATION_ADDRESS_RESOLVE, sizeof(network_address_ipv6_t));
 			ipv6->family = NETWORK_ADDRESSFAMILY_IPV6;
 			ipv6->address_size = sizeof(struct sockaddr_in6);
 			memcpy(&ipv6->saddr, &saddr_in6, sizeof(struct sockaddr_in6));
@@ -430,9 +833,126 @@ bool
 network_address_equal(const network_address_t* first, const network_address_t* second) {
 	if (first == second)
 		return true;
-	if (!first || !second || (first->address_size != second->address_size))
+	if (!first || !second || (first->family != second->family) || (first->address_size != second->address_size))
+		return false;
+	return memcmp(&first->saddr, &second->saddr, (size_t)first->address_size) == 0;
+}
+
+bool
+network_address_to_compact(const network_address_t* address, network_address_compact_t* compact) {
+	memset(compact, 0, sizeof(network_address_compact_t));
+	if (!address)
+		return false;
+	if (address->family == NETWORK_ADDRESSFAMILY_IPV4) {
+		const network_address_ipv4_t* addr_ipv4 = (const network_address_ipv4_t*)address;
+		memcpy(compact->ip, &addr_ipv4->saddr.sin_addr, 4);
+		compact->port = ntohs(addr_ipv4->saddr.sin_port);
+	} else if (address->family == NETWORK_ADDRESSFAMILY_IPV6) {
+		const network_address_ipv6_t* addr_ipv6 = (const network_address_ipv6_t*)address;
+		memcpy(compact->ip, &addr_ipv6->saddr.sin6_addr, 16);
+		compact->port = ntohs(addr_ipv6->saddr.sin6_port);
+		compact->scope = addr_ipv6->saddr.sin6_scope_id;
+	} else {
 		return false;
-	return memcmp(first, second, first->address_size) == 0;
+	}
+	compact->family = (uint16_t)address->family;
+	return true;
+}
+
+network_address_t*
+network_address_from_compact(network_address_t* address, const network_address_compact_t* compact) {
+	if (compact->family == NETWORK_ADDRESSFAMILY_IPV6) {
+		network_address_ipv6_t* addr_ipv6 = (network_address_ipv6_t*)address;
+		network_address_ipv6_initialize(addr_ipv6);
+		memcpy(&addr_ipv6->saddr.sin6_addr, compact->ip, 16);
+		addr_ipv6->saddr.sin6_port = htons(compact->port);
+		addr_ipv6->saddr.sin6_scope_id = compact->scope;
+	} else {
+		network_address_ipv4_t* addr_ipv4 = (network_address_ipv4_t*)address;
+		network_address_ipv4_initialize(addr_ipv4);
+		memcpy(&addr_ipv4->saddr.sin_addr, compact->ip, 4);
+		addr_ipv4->saddr.sin_port = htons(compact->port);
+	}
+	return address;
+}
+
+bool
+network_address_compact_equal(const network_address_compact_t* first, const network_address_compact_t* second) {
+	return memcmp(first, second, sizeof(network_address_compact_t)) == 0;
+}
+
+static FOUNDATION_FORCEINLINE uint64_t
+network_address_hash_mix(uint64_t value) {
+	value ^= value >> 30;
+	value *= 0xbf58476d1ce4e5b9ULL;
+	value ^= value >> 27;
+	value *= 0x94d049bb133111ebULL;
+	value ^= value >> 31;
+	return value;
+}
+
+hash_t
+network_address_compact_hash(const network_address_compact_t* compact) {
+	uint64_t high, low, tail;
+	memcpy(&high, compact->ip, 8);
+	memcpy(&low, compact->ip + 8, 8);
+	tail = ((uint64_t)compact->scope << 32) | ((uint64_t)compact->port << 16) | compact->family;
+	return network_address_hash_mix(high ^ network_address_hash_mix(low ^ network_address_hash_mix(tail)));
+}
+
+hash_t
+network_address_hash(const network_address_t* address) {
+	network_address_compact_t compact;
+	if (address && (address->family == NETWORK_ADDRESSFAMILY_UNIX))
+		return hash(&address->saddr, (size_t)address->address_size);
+	if (!network_address_to_compact(address, &compact))
+		return 0;
+	return network_address_compact_hash(&compact);
+}
+
+network_address_compact_t*
+network_address_resolve_compact(const char* address, size_t length) {
+	network_address_compact_t* compact = nullptr;
+	network_address_t** addresses;
+	network_address_ipv6_t parsed;
+
+	if (!address)
+		return compact;
+
+	// Numeric addresses are parsed directly into the result array
+	if (network_address_parse((network_address_t*)&parsed, address, length)) {
+		network_address_compact_t entry;
+		network_address_to_compact((network_address_t*)&parsed, &entry);
+		array_push(compact, entry);
+		return compact;
+	}
+
+	addresses = network_address_resolve(address, length);
+	compact = network_address_array_compact(addresses);
+	network_address_array_deallocate(addresses);
+	return compact;
+}
+
+network_address_compact_t*
+network_address_local_compact(void) {
+	network_address_t** addresses = network_address_local();
+	network_address_compact_t* compact = network_address_array_compact(addresses);
+	network_address_array_deallocate(addresses);
+	return compact;
+}
+
+network_address_compact_t*
+network_address_array_compact(network_address_t** addresses) {
+	network_address_compact_t* compact = nullptr;
+	network_address_compact_t entry;
+	size_t asize = array_size(addresses);
+	if (asize)
+		array_reserve(compact, asize);
+	for (size_t iaddr = 0; iaddr < asize; ++iaddr) {
+		if (network_address_to_compact(addresses[iaddr], &entry))
+			array_push(compact, entry);
+	}
+	return compact;
 }
 
 void
@@ -21,9 +21,45 @@
 NETWORK_API network_address_t*
 network_address_clone(const network_address_t* address);
 
+/*! Resolve an address string to a list of network addresses. Numeric IPv4 and IPv6
+addresses are parsed directly, host names are looked up using the system resolver and
+the result kept in the resolve cache, see #network_address_resolve_async
+\param address Address string, optionally with port
+\param length Length of address string
+\return Array of addresses, must be deallocated with #network_address_array_deallocate */
 NETWORK_API network_address_t**
 network_address_resolve(const char* address, size_t length);
 
+/*! Parse a numeric IPv4 or IPv6 address with optional port in place, without any memory
+allocation or system call, see #network_address_ipv4_parse and #network_address_ipv6_parse.
+A string with a "unix:" prefix is parsed as a unix domain socket address, see
+#network_address_unix_initialize
+\param address Address structure receiving the parsed address, must be large enough to
+hold a #network_address_ipv6_t
+\param str Address string
+\param length Length of address string
+\return true if string is a valid numeric address, false if not */
+NETWORK_API bool
+network_address_parse(network_address_t* address, const char* str, size_t length);
+
+/*! Parse a numeric IPv4 dotted quad address with optional port suffix (a.b.c.d:port)
+\param address IPv4 address structure
+\param str Address string
+\param length Length of address string
+\return true if string is a valid IPv4 address, false if not */
+NETWORK_API bool
+network_address_ipv4_parse(network_address_ipv4_t* address, const char* str, size_t length);
+
+/*! Parse a numeric IPv6 address, including :: zero compression, embedded IPv4 address in
+the last 32 bits and numeric scope identifier (addr%scope). A port can be given using the
+bracketed format [addr]:port
+\param address IPv6 address structure
+\param str Address string
+\param length Length of address string
+\return true if string is a valid IPv6 address, false if not */
+NETWORK_API bool
+network_address_ipv6_parse(network_address_ipv6_t* address, const char* str, size_t length);
+
 NETWORK_API string_t
 network_address_to_string(char* buffer, size_t capacity, const network_address_t* address, bool numeric);
 
@@ -39,6 +75,62 @@ network_address_local(void);
 NETWORK_API bool
 network_address_equal(const network_address_t* first, const network_address_t* second);
 
+/*! Calculate a hash of the given address, covering the address family, IP address, port
+and IPv6 scope. Addresses comparing equal in an address map have equal hash values.
+\param address Address
+\return Hash value, 0 if address is null or not an IP address */
+NETWORK_API hash_t
+network_address_hash(const network_address_t* address);
+
+/*! Convert an IPv4 or IPv6 address to the compact fixed size representation
+\param address Address
+\param compact Destination compact address
+\return true if converted, false if address is null or not an IP address */
+NETWORK_API bool
+network_address_to_compact(const network_address_t* address, network_address_compact_t* compact);
+
+/*! Expand a compact address to a full address structure, for passing to system calls
+\param address Destination address structure, must be large enough to hold any IP address
+                (for example a network_address_ipv6_t or network_address_t)
+\param compact Compact address
+\return Expanded address (same as address argument) */
+NETWORK_API network_address_t*
+network_address_from_compact(network_address_t* address, const network_address_compact_t* compact);
+
+/*! Compare two compact addresses
+\param first First compact address
+\param second Second compact address
+\return true if addresses are equal, false if not */
+NETWORK_API bool
+network_address_compact_equal(const network_address_compact_t* first, const network_address_compact_t* second);
+
+/*! Calculate hash of a compact address, equal to #network_address_hash of the full address
+\param compact Compact address
+\return Hash value */
+NETWORK_API hash_t
+network_address_compact_hash(const network_address_compact_t* compact);
+
+/*! Resolve the given address, see #network_address_resolve, and return the result as a single
+contiguous array of compact addresses. Deallocate the array with array_deallocate.
+\param address Address string
+\param length Length of address string
+\return Array of compact addresses, null if resolve failed */
+NETWORK_API network_address_compact_t*
+network_address_resolve_compact(const char* address, size_t length);
+
+/*! Get the local addresses, see #network_address_local, as a single contiguous array of
+compact addresses. Deallocate the array with array_deallocate.
+\return Array of compact addresses */
+NETWORK_API network_address_compact_t*
+network_address_local_compact(void);
+
+/*! Convert an array of addresses to a contiguous array of compact addresses. Addresses that
+are not IP addresses are skipped. Deallocate the array with array_deallocate.
+\param addresses Array of addresses
+\return Array of compact addresses */
+NETWORK_API network_address_compact_t*
+network_address_array_compact(network_address_t** addresses);
+
 NETWORK_API void
 network_address_deallocate(network_address_t* address);
 
@@ -57,6 +149,29 @@ network_address_ipv4_initialize(network_address_ipv4_t* address);
 NETWORK_API network_address_t*
 network_address_ipv6_initialize(network_address_ipv6_t* address);
 
+/*! Initialize a unix domain socket address. A path starting with '@' denotes a name in the
+abstract namespace (Linux only), any other path a file system path.
+\param address Unix address structure
+\param path Socket path or abstract name
+\param length Length of path
+\return Initialized address as a base structure pointer, null if path is empty, too long or
+        not supported on platform */
+NETWORK_API network_address_t*
+network_address_unix_initialize(network_address_unix_t* address, const char* path, size_t length);
+
+/*! Get the path of a unix domain socket address. For an abstract address the name is returned
+without the '@' prefix, see #network_address_unix_is_abstract
+\param address Unix address
+\return Path, empty string if address is not a named unix domain socket address */
+NETWORK_API string_const_t
+network_address_unix_path(const network_address_t* address);
+
+/*! Query if a unix domain socket address is in the abstract namespace
+\param address Unix address
+\return true if abstract, false if not */
+NETWORK_API bool
+network_address_unix_is_abstract(const network_address_t* address);
+
 NETWORK_API void
 network_address_ip_set_port(network_address_t* address, unsigned int port);
 
@@ -0,0 +1,198 @@
+/* addressmap.c  -  Network library  -  Public Domain  -  2013 Mattias Jansson
+ *
+ * This library provides a network abstraction built on foundation streams. The latest source code is
+ * always available at
+ *
+ * https://github.com/mjansson/network_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any restrictions.
+ *
+ */
+
+#include <network/addressmap.h>
+#include <network/address.h>
+#include <network/internal.h>
+
+#include <foundation/foundation.h>
+
+#define NETWORK_ADDRESS_MAP_MIN_CAPACITY 16
+
+// Slot tags are the folded 32-bit key hash, zero marking an empty slot. The home slot of an
+// entry is derived from the tag, so the table can be rebuilt and entries shifted on erase
+// without hashing the keys again.
+static FOUNDATION_FORCEINLINE uint32_t
+network_address_map_tag(const network_address_compact_t* key) {
+	hash_t value = network_address_compact_hash(key);
+	uint32_t tag = (uint32_t)(value ^ (value >> 32));
+	return tag ? tag : 1;
+}
+
+static void
+network_address_map_reserve(network_address_map_t* map, size_t capacity) {
+	size_t memsize = (sizeof(uint32_t) + sizeof(network_address_compact_t) + sizeof(void*)) * capacity;
+	void* block = memory_allocate(HASH_NETWORK, memsize, 8, MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	NETWORK_COUNT_ALLOCATION(NETWORK_ALLOCATION_OTHER, memsize);
+	map->capacity = capacity;
+	map->values = block;
+	map->keys = pointer_offset(block, sizeof(void*) * capacity);
+	map->hashes = pointer_offset(map->keys, sizeof(network_address_compact_t) * capacity);
+}
+
+static size_t
+network_address_map_find(const network_address_map_t* map, const network_address_compact_t* key, uint32_t tag) {
+	size_t mask = map->capacity - 1;
+	size_t slot = tag & mask;
+	while (map->hashes[slot]) {
+		if ((map->hashes[slot] == tag) && !memcmp(map->keys + slot, key, sizeof(network_address_compact_t)))
+			return slot;
+		slot = (slot + 1) & mask;
+	}
+	return slot;
+}
+
+static void
+network_address_map_grow(network_address_map_t* map) {
+	uint32_t* hashes = map->hashes;
+	network_address_compact_t* keys = map->keys;
+	void** values = map->values;
+	size_t capacity = map->capacity;
+
+	network_address_map_reserve(map, capacity ? capacity * 2 : NETWORK_ADDRESS_MAP_MIN_CAPACITY);
+
+	size_t mask = map->capacity - 1;
+	for (size_t islot = 0; islot < capacity; ++islot) {
+		if (!hashes[islot])
+			continue;
+		size_t slot = hashes[islot] & mask;
+		while (map->hashes[slot])
+			slot = (slot + 1) & mask;
+		map->hashes[slot] = hashes[islot];
+		map->keys[slot] = keys[islot];
+		map->values[slot] = values[islot];
+	}
+
+	memory_deallocate(values);
+}
+
+network_address_map_t*
+network_address_map_allocate(size_t capacity) {
+	network_address_map_t* map = memory_allocate(HASH_NETWORK, sizeof(network_address_map_t), 0, MEMORY_PERSISTENT);
+	NETWORK_COUNT_ALLOCATION(NETWORK_ALLOCATION_OTHER, sizeof(network_address_map_t));
+	network_address_map_initialize(map, capacity);
+	return map;
+}
+
+void
+network_address_map_initialize(network_address_map_t* map, size_t capacity) {
+	size_t slots = NETWORK_ADDRESS_MAP_MIN_CAPACITY;
+	// Keep load factor below 3/4 without growing
+	while ((slots * 3) < (capacity * 4))
+		slots <<= 1;
+	map->count = 0;
+	network_address_map_reserve(map, slots);
+}
+
+void
+network_address_map_finalize(network_address_map_t* map) {
+	memory_deallocate(map->values);
+	memset(map, 0, sizeof(network_address_map_t));
+}
+
+void
+network_address_map_deallocate(network_address_map_t* map) {
+	if (!map)
+		return;
+	network_address_map_finalize(map);
+	memory_deallocate(map);
+}
+
+void*
+network_address_map_lookup(const network_address_map_t* map, const network_address_t* address) {
+	network_address_compact_t key;
+	size_t slot;
+	uint32_t tag;
+
+	if (!map->count || !network_address_to_compact(address, &key))
+		return nullptr;
+
+	tag = network_address_map_tag(&key);
+	slot = network_address_map_find(map, &key, tag);
+	return map->values[slot];
+}
+
+void*
+network_address_map_insert(network_address_map_t* map, const network_address_t* address, void* value) {
+	network_address_compact_t key;
+	void* previous;
+	size_t slot;
+	uint32_t tag;
+
+	FOUNDATION_ASSERT(value);
+	if (!value || !network_address_to_compact(address, &key))
+		return nullptr;
+
+	if (((map->count + 1) * 4) > (map->capacity * 3))
+		network_address_map_grow(map);
+
+	tag = network_address_map_tag(&key);
+	slot = network_address_map_find(map, &key, tag);
+	previous = map->values[slot];
+	if (!previous) {
+		map->hashes[slot] = tag;
+		map->keys[slot] = key;
+		++map->count;
+	}
+	map->values[slot] = value;
+	return previous;
+}
+
+void*
+network_address_map_erase(network_address_map_t* map, const network_address_t* address) {
+	network_address_compact_t key;
+	void* value;
+	size_t slot, hole, mask;
+	uint32_t tag;
+
+	if (!map->count || !network_address_to_compact(address, &key))
+		return nullptr;
+
+	tag = network_address_map_tag(&key);
+	slot = network_address_map_find(map, &key, tag);
+	value = map->values[slot];
+	if (!value)
+		return nullptr;
+
+	// Backward shift deletion, move following entries in the probe sequence into the hole
+	// unless their home slot lies cyclically after the hole
+	mask = map->capacity - 1;
+	hole = slot;
+	while (true) {
+		slot = (slot + 1) & mask;
+		if (!map->hashes[slot])
+			break;
+		size_t home = map->hashes[slot] & mask;
+		if (((slot - home) & mask) >= ((slot - hole) & mask)) {
+			map->hashes[hole] = map->hashes[slot];
+			map->keys[hole] = map->keys[slot];
+			map->values[hole] = map->values[slot];
+			hole = slot;
+		}
+	}
+	map->hashes[hole] = 0;
+	map->values[hole] = nullptr;
+	--map->count;
+
+	return value;
+}
+
+size_t
+network_address_map_size(const network_address_map_t* map) {
+	return map->count;
+}
+
+void
+network_address_map_clear(network_address_map_t* map) {
+	memset(map->hashes, 0, sizeof(uint32_t) * map->capacity);
+	memset(map->values, 0, sizeof(void*) * map->capacity);
+	map->count = 0;
+}
@@ -0,0 +1,77 @@
+/* addressmap.h  -  Network library  -  Public Domain  -  2013 Mattias Jansson
+ *
+ * This library provides a network abstraction built on foundation streams. The latest source code is
+ * always available at
+ *
+ * https://github.com/mjansson/network_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any restrictions.
+ *
+ */
+
+#pragma once
+
+/*! \file addressmap.h
+    Hash map from network address to value. The map uses open addressing with linear probing,
+    storing the compact representation of the address inline in the table, so lookups do not
+    touch the address structures used to populate the map. */
+
+#include <foundation/platform.h>
+
+#include <network/types.h>
+
+/*! Allocate an address map
+\param capacity Initial number of entries to reserve space for, the map grows as needed
+\return New address map */
+NETWORK_API network_address_map_t*
+network_address_map_allocate(size_t capacity);
+
+/*! Initialize an address map
+\param map Address map
+\param capacity Initial number of entries to reserve space for, the map grows as needed */
+NETWORK_API void
+network_address_map_initialize(network_address_map_t* map, size_t capacity);
+
+/*! Finalize an address map. Values stored in the map are not touched.
+\param map Address map */
+NETWORK_API void
+network_address_map_finalize(network_address_map_t* map);
+
+/*! Finalize and deallocate an address map
+\param map Address map */
+NETWORK_API void
+network_address_map_deallocate(network_address_map_t* map);
+
+/*! Lookup the value stored for the given address
+\param map Address map
+\param address Address
+\return Value stored for address, null if not found */
+NETWORK_API void*
+network_address_map_lookup(const network_address_map_t* map, const network_address_t* address);
+
+/*! Store a value for the given address, replacing any previous value. Only IPv4 and IPv6
+addresses can be stored in the map.
+\param map Address map
+\param address Address
+\param value Value to store, must not be null
+\return Previous value stored for address, null if none */
+NETWORK_API void*
+network_address_map_insert(network_address_map_t* map, const network_address_t* address, void* value);
+
+/*! Remove the value stored for the given address
+\param map Address map
+\param address Address
+\return Value removed, null if not found */
+NETWORK_API void*
+network_address_map_erase(network_address_map_t* map, const network_address_t* address);
+
+/*! Get number of entries in the map
+\param map Address map
+\return Number of entries */
+NETWORK_API size_t
+network_address_map_size(const network_address_map_t* map);
+
+/*! Remove all entries from the map
+\param map Address map */
+NETWORK_API void
+network_address_map_clear(network_address_map_t* map);
@@ -21,3 +21,25 @@
 /*! Dump network traffic to log (debug). Dump read/write information if > 0,
 dump full traffic (payload data) if > 1 */
 #define BUILD_ENABLE_NETWORK_DUMP_TRAFFIC 0
+
+/*! Count socket system calls made by the network library, see #network_syscall_count. Enabled in
+debug builds where the tests verify the counts, disabled otherwise since every counted call pays for
+an atomic increment. Define to 1 for measurements in other configurations */
+#ifndef BUILD_ENABLE_NETWORK_SYSCALL_COUNT
+#if BUILD_DEBUG
+#define BUILD_ENABLE_NETWORK_SYSCALL_COUNT 1
+#else
+#define BUILD_ENABLE_NETWORK_SYSCALL_COUNT 0
+#endif
+#endif
+
+/*! Count memory allocations made by the network library per call site, see #network_allocation_count.
+Enabled in debug builds where the tests verify the per call site counts, define to 1 for measurements
+in other configurations */
+#ifndef BUILD_ENABLE_NETWORK_ALLOCATION_COUNT
+#if BUILD_DEBUG
+#define BUILD_ENABLE_NETWORK_ALLOCATION_COUNT 1
+#else
+#define BUILD_ENABLE_NETWORK_ALLOCATION_COUNT 0
+#endif
+#endif
@@ -0,0 +1,443 @@
+/* cidr.c  -  Network library  -  Public Domain  -  2013 Mattias Jansson
+ *
+ * This library provides a network abstraction built on foundation streams. The latest source code is
+ * always available at
+ *
+ * https://github.com/mjansson/network_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any restrictions.
+ *
+ */
+
+#include <network/cidr.h>
+#include <network/address.h>
+#include <network/internal.h>
+
+#include <foundation/foundation.h>
+
+#if FOUNDATION_COMPILER_MSVC
+#include <intrin.h>
+#endif
+
+#define NETWORK_CIDR_BATCH 8
+
+#if FOUNDATION_COMPILER_GCC || FOUNDATION_COMPILER_CLANG
+#define NETWORK_CIDR_PREFETCH(addr) __builtin_prefetch(addr)
+#else
+#define NETWORK_CIDR_PREFETCH(addr) (void)sizeof(addr)
+#endif
+
+// Keys are 128-bit values in host byte order, most significant bit first. IPv4 prefixes are
+// kept in the upper 32 bits of the first word. Node index 0 is reserved as null link.
+
+static FOUNDATION_FORCEINLINE unsigned int
+network_cidr_clz(uint64_t value) {
+#if FOUNDATION_COMPILER_MSVC
+	unsigned long index;
+	_BitScanReverse64(&index, value);
+	return 63 - (unsigned int)index;
+#else
+	return (unsigned int)__builtin_clzll(value);
+#endif
+}
+
+static FOUNDATION_FORCEINLINE uint64_t
+network_cidr_mask(unsigned int bits) {
+	return bits ? (~0ULL << (64 - bits)) : 0;
+}
+
+static FOUNDATION_FORCEINLINE unsigned int
+network_cidr_bit(const uint64_t* key, unsigned int bit) {
+	if (bit < 64)
+		return (unsigned int)(key[0] >> (63 - bit)) & 1;
+	return (unsigned int)(key[1] >> (127 - bit)) & 1;
+}
+
+static FOUNDATION_FORCEINLINE bool
+network_cidr_match(const uint64_t* prefix, const uint64_t* key, unsigned int bits) {
+	if (bits <= 64)
+		return !((prefix[0] ^ key[0]) & network_cidr_mask(bits));
+	return (prefix[0] == key[0]) && !((prefix[1] ^ key[1]) & network_cidr_mask(bits - 64));
+}
+
+static unsigned int
+network_cidr_common(const uint64_t* first, const uint64_t* second, unsigned int max_bits) {
+	uint64_t diff = first[0] ^ second[0];
+	unsigned int common;
+	if (diff)
+		common = network_cidr_clz(diff);
+	else if ((diff = first[1] ^ second[1]) != 0)
+		common = 64 + network_cidr_clz(diff);
+	else
+		common = 128;
+	return (common < max_bits) ? common : max_bits;
+}
+
+// Get the trie key and family index of a prefix, IPv4-mapped IPv6 prefixes are converted to IPv4
+static int
+network_cidr_key(const network_address_compact_t* prefix, unsigned int* bits, uint64_t* key) {
+	uint64_t high, low;
+	memcpy(&high, prefix->ip, sizeof(uint64_t));
+	memcpy(&low, prefix->ip + 8, sizeof(uint64_t));
+	high = byteorder_bigendian64(high);
+	low = byteorder_bigendian64(low);
+
+	if (prefix->family == NETWORK_ADDRESSFAMILY_IPV4) {
+		if (*bits > 32)
+			return -1;
+		key[0] = high & network_cidr_mask(*bits);
+		key[1] = 0;
+		return NETWORK_ADDRESSFAMILY_IPV4;
+	}
+	if (prefix->family != NETWORK_ADDRESSFAMILY_IPV6 || (*bits > 128))
+		return -1;
+	if (!high && ((low >> 32) == 0xFFFF) && (*bits >= 96)) {
+		*bits -= 96;
+		key[0] = (low << 32) & network_cidr_mask(*bits);
+		key[1] = 0;
+		return NETWORK_ADDRESSFAMILY_IPV4;
+	}
+	key[0] = high & network_cidr_mask((*bits < 64) ? *bits : 64);
+	key[1] = low & network_cidr_mask((*bits > 64) ? *bits - 64 : 0);
+	return NETWORK_ADDRESSFAMILY_IPV6;
+}
+
+static uint32_t
+network_cidr_node_allocate(network_cidr_t* table, const uint64_t* key, unsigned int bits, void* value) {
+	network_cidr_node_t node;
+	size_t free_count = array_size(table->nodes_free);
+	uint32_t inode;
+
+	memset(&node, 0, sizeof(node));
+	node.key[0] = key[0] & network_cidr_mask((bits < 64) ? bits : 64);
+	node.key[1] = key[1] & network_cidr_mask((bits > 64) ? bits - 64 : 0);
+	node.bits = bits;
+	node.value = value;
+
+	if (free_count) {
+		inode = table->nodes_free[free_count - 1];
+		array_pop(table->nodes_free);
+		table->nodes[inode] = node;
+	} else {
+		inode = (uint32_t)array_size(table->nodes);
+		array_push(table->nodes, node);
+	}
+	return inode;
+}
+
+// Links must be looked up again after allocating nodes, the node array may be reallocated
+static FOUNDATION_FORCEINLINE uint32_t*
+network_cidr_link(network_cidr_t* table, int family, uint32_t parent, unsigned int side) {
+	return parent ? &table->nodes[parent].child[side] : &table->root[family];
+}
+
+// Splice out the node at the given link if it has no value and less than two children
+static bool
+network_cidr_prune(network_cidr_t* table, int family, uint32_t parent, unsigned int side) {
+	uint32_t* link = network_cidr_link(table, family, parent, side);
+	uint32_t inode = *link;
+	network_cidr_node_t* node = table->nodes + inode;
+	if (node->value || (node->child[0] && node->child[1]))
+		return false;
+	*link = node->child[0] ? node->child[0] : node->child[1];
+	memset(node, 0, sizeof(network_cidr_node_t));
+	array_push(table->nodes_free, inode);
+	return true;
+}
+
+static FOUNDATION_FORCEINLINE void*
+network_cidr_lookup_key(const network_cidr_t* table, int family, const uint64_t* key) {
+	const network_cidr_node_t* nodes = table->nodes;
+	void* best = nullptr;
+	uint32_t inode = table->root[family];
+	while (inode) {
+		const network_cidr_node_t* node = nodes + inode;
+		if (!network_cidr_match(node->key, key, node->bits))
+			break;
+		if (node->value)
+			best = node->value;
+		if (node->bits == 128)
+			break;
+		inode = node->child[network_cidr_bit(key, node->bits)];
+	}
+	return best;
+}
+
+network_cidr_t*
+network_cidr_allocate(void) {
+	network_cidr_t* table = memory_allocate(HASH_NETWORK, sizeof(network_cidr_t), 0, MEMORY_PERSISTENT);
+	NETWORK_COUNT_ALLOCATION(NETWORK_ALLOCATION_OTHER, sizeof(network_cidr_t));
+	network_cidr_initialize(table);
+	return table;
+}
+
+void
+network_cidr_initialize(network_cidr_t* table) {
+	network_cidr_node_t sentinel;
+	memset(table, 0, sizeof(network_cidr_t));
+	memset(&sentinel, 0, sizeof(sentinel));
+	array_push(table->nodes, sentinel);
+}
+
+void
+network_cidr_finalize(network_cidr_t* table) {
+	array_deallocate(table->nodes);
+	array_deallocate(table->nodes_free);
+	memset(table, 0, sizeof(network_cidr_t));
+}
+
+void
+network_cidr_deallocate(network_cidr_t* table) {
+	if (!table)
+		return;
+	network_cidr_finalize(table);
+	memory_deallocate(table);
+}
+
+bool
+network_cidr_parse(network_address_compact_t* prefix, unsigned int* bits, const char* cidr, size_t length) {
+	network_address_ipv6_t parsed;
+	unsigned int max_bits, prefix_bits = 0;
+	size_t delim = string_rfind(cidr, length, '/', STRING_NPOS);
+	size_t address_length = (delim != STRING_NPOS) ? delim : length;
+
+	// Only IP addresses form a prefix, a unix domain path is rejected by the compact conversion
+	if (!network_address_parse((network_address_t*)&parsed, cidr, address_length) ||
+	    network_address_ip_port((network_address_t*)&parsed) ||
+	    !network_address_to_compact((network_address_t*)&parsed, prefix))
+		return false;
+	max_bits = (prefix->family == NETWORK_ADDRESSFAMILY_IPV4) ? 32 : 128;
+
+	if (delim != STRING_NPOS) {
+		size_t ichar = delim + 1;
+		if ((ichar == length) || (length - ichar > 3))
+			return false;
+		for (; ichar < length; ++ichar) {
+			unsigned int digit = (unsigned int)(cidr[ichar] - '0');
+			if (digit > 9)
+				return false;
+			prefix_bits = (prefix_bits * 10) + digit;
+		}
+		if (prefix_bits > max_bits)
+			return false;
+	} else {
+		prefix_bits = max_bits;
+	}
+
+	// Clear host bits
+	for (unsigned int ibyte = 0; ibyte < 16; ++ibyte) {
+		unsigned int byte_bits = (ibyte * 8);
+		if (byte_bits >= prefix_bits)
+			prefix->ip[ibyte] = 0;
+		else if (byte_bits + 8 > prefix_bits)
+			prefix->ip[ibyte] &= (uint8_t)(0xFF << (8 - (prefix_bits - byte_bits)));
+	}
+	prefix->port = 0;
+	*bits = prefix_bits;
+	return true;
+}
+
+bool
+network_cidr_insert(network_cidr_t* table, const char* cidr, size_t length, void* value) {
+	network_address_compact_t prefix;
+	unsigned int bits;
+	if (!value || !network_cidr_parse(&prefix, &bits, cidr, length))
+		return false;
+	network_cidr_insert_prefix(table, &prefix, bits, value);
+	return true;
+}
+
+void*
+network_cidr_insert_prefix(network_cidr_t* table, const network_address_compact_t* prefix, unsigned int bits,
+                           void* value) {
+	uint64_t key[2];
+	uint32_t parent = 0;
+	unsigned int side = 0;
+	int family;
+
+	FOUNDATION_ASSERT(value);
+	if (!value || ((family = network_cidr_key(prefix, &bits, key)) < 0))
+		return nullptr;
+
+	while (true) {
+		uint32_t inode = *network_cidr_link(table, family, parent, side);
+		network_cidr_node_t* node;
+		uint64_t node_key[2];
+		unsigned int common;
+		uint32_t iparent;
+
+		if (!inode) {
+			uint32_t ileaf = network_cidr_node_allocate(table, key, bits, value);
+			*network_cidr_link(table, family, parent, side) = ileaf;
+			++table->count;
+			return nullptr;
+		}
+
+		node = table->nodes + inode;
+		common = network_cidr_common(node->key, key, (node->bits < bits) ? node->bits : bits);
+		if (common == node->bits) {
+			if (node->bits == bits) {
+				void* previous = node->value;
+				node->value = value;
+				if (!previous)
+					++table->count;
+				return previous;
+			}
+			parent = inode;
+			side = network_cidr_bit(key, node->bits);
+			continue;
+		}
+
+		node_key[0] = node->key[0];
+		node_key[1] = node->key[1];
+		if (common == bits) {
+			// New prefix covers the node, insert above it
+			iparent = network_cidr_node_allocate(table, key, bits, value);
+		} else {
+			// Branch at the first differing bit
+			uint32_t ileaf = network_cidr_node_allocate(table, key, bits, value);
+			iparent = network_cidr_node_allocate(table, key, common, nullptr);
+			table->nodes[iparent].child[network_cidr_bit(key, common)] = ileaf;
+		}
+		table->nodes[iparent].child[network_cidr_bit(node_key, common)] = inode;
+		*network_cidr_link(table, family, parent, side) = iparent;
+		++table->count;
+		return nullptr;
+	}
+}
+
+void*
+network_cidr_remove(network_cidr_t* table, const char* cidr, size_t length) {
+	network_address_compact_t prefix;
+	unsigned int bits;
+	if (!network_cidr_parse(&prefix, &bits, cidr, length))
+		return nullptr;
+	return network_cidr_remove_prefix(table, &prefix, bits);
+}
+
+void*
+network_cidr_remove_prefix(network_cidr_t* table, const network_address_compact_t* prefix, unsigned int bits) {
+	uint64_t key[2];
+	uint32_t parent = 0, grandparent = 0;
+	unsigned int side = 0, parent_side = 0;
+	network_cidr_node_t* node;
+	void* value;
+	int family;
+
+	if ((family = network_cidr_key(prefix, &bits, key)) < 0)
+		return nullptr;
+
+	while (true) {
+		uint32_t inode = *network_cidr_link(table, family, parent, side);
+		if (!inode)
+			return nullptr;
+		node = table->nodes + inode;
+		if ((node->bits > bits) || !network_cidr_match(node->key, key, node->bits))
+			return nullptr;
+		if (node->bits == bits)
+			break;
+		grandparent = parent;
+		parent_side = side;
+		parent = inode;
+		side = network_cidr_bit(key, node->bits);
+	}
+
+	value = node->value;
+	if (!value)
+		return nullptr;
+	node->value = nullptr;
+	--table->count;
+
+	// Removing a leaf leaves the parent with a single child, splice it out as well if it
+	// is a branch node without value
+	if (network_cidr_prune(table, family, parent, side) && parent)
+		network_cidr_prune(table, family, grandparent, parent_side);
+
+	return value;
+}
+
+void*
+network_cidr_lookup(const network_cidr_t* table, const network_address_t* address) {
+	network_address_compact_t compact;
+	if (!network_address_to_compact(address, &compact))
+		return nullptr;
+	return network_cidr_lookup_compact(table, &compact);
+}
+
+void*
+network_cidr_lookup_compact(const network_cidr_t* table, const network_address_compact_t* address) {
+	uint64_t key[2];
+	unsigned int bits = 128;
+	int family;
+	if (!table->count)
+		return nullptr;
+	if (address->family == NETWORK_ADDRESSFAMILY_IPV4)
+		bits = 32;
+	if ((family = network_cidr_key(address, &bits, key)) < 0)
+		return nullptr;
+	return network_cidr_lookup_key(table, family, key);
+}
+
+void
+network_cidr_lookup_batch(const network_cidr_t* table, const network_address_compact_t* addresses, size_t count,
+                          void** values) {
+	const network_cidr_node_t* nodes = table->nodes;
+	uint64_t keys[NETWORK_CIDR_BATCH][2];
+	uint32_t current[NETWORK_CIDR_BATCH];
+
+	for (size_t base = 0; base < count; base += NETWORK_CIDR_BATCH) {
+		size_t lanes = ((count - base) < NETWORK_CIDR_BATCH) ? (count - base) : NETWORK_CIDR_BATCH;
+		void** result = values + base;
+		bool active = false;
+
+		for (size_t ilane = 0; ilane < lanes; ++ilane) {
+			const network_address_compact_t* address = addresses + base + ilane;
+			unsigned int bits = (address->family == NETWORK_ADDRESSFAMILY_IPV4) ? 32 : 128;
+			int family = network_cidr_key(address, &bits, keys[ilane]);
+			result[ilane] = nullptr;
+			current[ilane] = (family >= 0) ? table->root[family] : 0;
+			if (current[ilane]) {
+				NETWORK_CIDR_PREFETCH(nodes + current[ilane]);
+				active = true;
+			}
+		}
+
+		// Advance all lanes one trie level per pass, prefetching the next level node of each
+		while (active) {
+			active = false;
+			for (size_t ilane = 0; ilane < lanes; ++ilane) {
+				const network_cidr_node_t* node;
+				if (!current[ilane])
+					continue;
+				node = nodes + current[ilane];
+				if (!network_cidr_match(node->key, keys[ilane], node->bits)) {
+					current[ilane] = 0;
+					continue;
+				}
+				if (node->value)
+					result[ilane] = node->value;
+				current[ilane] = (node->bits < 128) ? node->child[network_cidr_bit(keys[ilane], node->bits)] : 0;
+				if (current[ilane]) {
+					NETWORK_CIDR_PREFETCH(nodes + current[ilane]);
+					active = true;
+				}
+			}
+		}
+	}
+}
+
+size_t
+network_cidr_size(const network_cidr_t* table) {
+	return table->count;
+}
+
+void
+network_cidr_clear(network_cidr_t* table) {
+	network_cidr_node_t sentinel;
+	memset(&sentinel, 0, sizeof(sentinel));
+	array_clear(table->nodes);
+	array_clear(table->nodes_free);
+	array_push(table->nodes, sentinel);
+	table->root[0] = table->root[1] = 0;
+	table->count = 0;
+}
@@ -0,0 +1,123 @@
+/* cidr.h  -  Network library  -  Public Domain  -  2013 Mattias Jansson
+ *
+ * This library provides a network abstraction built on foundation streams. The latest source code is
+ * always available at
+ *
+ * https://github.com/mjansson/network_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any restrictions.
+ *
+ */
+
+#pragma once
+
+/*! \file cidr.h
+    CIDR prefix table with longest prefix match lookup, for address allow/deny lists and routing
+    tables. Prefixes are stored in path compressed binary radix tries, one per address family.
+    IPv4-mapped IPv6 addresses (::ffff:a.b.c.d) are matched against the IPv4 prefixes. */
+
+#include <foundation/platform.h>
+
+#include <network/types.h>
+
+/*! Allocate a CIDR table
+\return New CIDR table */
+NETWORK_API network_cidr_t*
+network_cidr_allocate(void);
+
+/*! Initialize a CIDR table
+\param table CIDR table */
+NETWORK_API void
+network_cidr_initialize(network_cidr_t* table);
+
+/*! Finalize a CIDR table. Values stored in the table are not touched.
+\param table CIDR table */
+NETWORK_API void
+network_cidr_finalize(network_cidr_t* table);
+
+/*! Finalize and deallocate a CIDR table
+\param table CIDR table */
+NETWORK_API void
+network_cidr_deallocate(network_cidr_t* table);
+
+/*! Parse a prefix in CIDR notation, for example "10.0.0.0/8" or "2001:db8::/32". An address
+without prefix length is parsed as a full length prefix. Host bits below the prefix length are
+cleared in the parsed prefix.
+\param prefix Destination prefix address
+\param bits Destination prefix length
+\param cidr Prefix string
+\param length Length of prefix string
+\return true if successful, false if not a valid prefix */
+NETWORK_API bool
+network_cidr_parse(network_address_compact_t* prefix, unsigned int* bits, const char* cidr, size_t length);
+
+/*! Insert a prefix in CIDR notation in the table, see #network_cidr_parse
+\param table CIDR table
+\param cidr Prefix string
+\param length Length of prefix string
+\param value Value to store for prefix, must not be null
+\return true if successful, false if not a valid prefix */
+NETWORK_API bool
+network_cidr_insert(network_cidr_t* table, const char* cidr, size_t length, void* value);
+
+/*! Insert a prefix in the table, replacing any previous value for the same prefix
+\param table CIDR table
+\param prefix Prefix address
+\param bits Prefix length
+\param value Value to store for prefix, must not be null
+\return Previous value stored for prefix, null if none */
+NETWORK_API void*
+network_cidr_insert_prefix(network_cidr_t* table, const network_address_compact_t* prefix, unsigned int bits,
+                           void* value);
+
+/*! Remove a prefix in CIDR notation from the table, see #network_cidr_parse
+\param table CIDR table
+\param cidr Prefix string
+\param length Length of prefix string
+\return Value removed, null if not found */
+NETWORK_API void*
+network_cidr_remove(network_cidr_t* table, const char* cidr, size_t length);
+
+/*! Remove a prefix from the table
+\param table CIDR table
+\param prefix Prefix address
+\param bits Prefix length
+\return Value removed, null if not found */
+NETWORK_API void*
+network_cidr_remove_prefix(network_cidr_t* table, const network_address_compact_t* prefix, unsigned int bits);
+
+/*! Find the value of the longest prefix matching the given address
+\param table CIDR table
+\param address Address
+\return Value of longest matching prefix, null if no prefix matches */
+NETWORK_API void*
+network_cidr_lookup(const network_cidr_t* table, const network_address_t* address);
+
+/*! Find the value of the longest prefix matching the given compact address
+\param table CIDR table
+\param address Compact address
+\return Value of longest matching prefix, null if no prefix matches */
+NETWORK_API void*
+network_cidr_lookup_compact(const network_cidr_t* table, const network_address_compact_t* address);
+
+/*! Find the values of the longest prefixes matching a batch of addresses. Lookups in the batch
+are interleaved so memory latency of the trie traversal for one address overlaps with the
+others, giving higher throughput than individual lookups.
+\param table CIDR table
+\param addresses Compact addresses
+\param count Number of addresses
+\param values Destination array receiving value of longest matching prefix for each address */
+NETWORK_API void
+network_cidr_lookup_batch(const network_cidr_t* table, const network_address_compact_t* addresses, size_t count,
+                          void** values);
+
+/*! Get number of prefixes in the table
+\param table CIDR table
+\return Number of prefixes */
+NETWORK_API size_t
+network_cidr_size(const network_cidr_t* table);
+
+/*! Remove all prefixes from the table
+\param table CIDR table */
+NETWORK_API void
+network_cidr_clear(network_cidr_t* table);
@@ -27,6 +27,7 @@
 #include <foundation/posix.h>
 #include <fcntl.h>
 #include <sys/select.h>
+#include <poll.h>
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <net/if.h>
@@ -50,9 +51,22 @@ typedef enum {
 	SOCKETFLAG_BLOCKING = 0x00000001,
 	SOCKETFLAG_TCPDELAY = 0x00000002,
 	SOCKETFLAG_REUSE_ADDR = 0x00000004,
-	SOCKETFLAG_REUSE_PORT = 0x00000008
+	SOCKETFLAG_REUSE_PORT = 0x00000008,
+	SOCKETFLAG_FILTER_ALLOW = 0x00000010
 } socket_flag_t;
 
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+#define NETWORK_SEND_MORE MSG_MORE
+#else
+#define NETWORK_SEND_MORE 0
+#endif
+
+#if FOUNDATION_PLATFORM_WINDOWS
+#define NETWORK_SEND_NOWAIT 0
+#else
+#define NETWORK_SEND_NOWAIT MSG_DONTWAIT
+#endif
+
 #if FOUNDATION_PLATFORM_WINDOWS
 #define NETWORK_SOCKET_ERROR ((int)WSAGetLastError())
 #define NETWORK_RESOLV_ERROR NETWORK_SOCKET_ERROR
@@ -63,6 +77,23 @@ typedef enum {
 
 NETWORK_EXTERN network_config_t network_config;
 
+#if BUILD_ENABLE_NETWORK_SYSCALL_COUNT
+NETWORK_EXTERN atomic64_t network_syscall_counter[NETWORK_SYSCALL_COUNT];
+#define NETWORK_COUNT_SYSCALL(call) atomic_incr64(&network_syscall_counter[call], memory_order_relaxed)
+#else
+#define NETWORK_COUNT_SYSCALL(call) ((void)0)
+#endif
+
+#if BUILD_ENABLE_NETWORK_ALLOCATION_COUNT
+NETWORK_EXTERN atomic64_t network_allocation_counter[NETWORK_ALLOCATION_COUNT];
+NETWORK_EXTERN atomic64_t network_allocation_size[NETWORK_ALLOCATION_COUNT];
+#define NETWORK_COUNT_ALLOCATION(site, size)                                 \
+	(atomic_incr64(&network_allocation_counter[site], memory_order_relaxed), \
+	 atomic_add64(&network_allocation_size[site], (int64_t)(size), memory_order_relaxed))
+#else
+#define NETWORK_COUNT_ALLOCATION(site, size) ((void)0)
+#endif
+
 NETWORK_API int
 socket_create_fd(socket_t* sock, network_address_family_t family);
 
@@ -81,5 +112,44 @@ socket_set_state(socket_t* sock, socket_state_t state);
 NETWORK_API int
 socket_available_fd(int fd);
 
+NETWORK_API int
+socket_error_fd(int fd);
+
+NETWORK_API bool
+socket_filter_allow(const socket_t* sock, const network_address_t* address);
+
+NETWORK_API int
+socket_wait_fd(int fd, bool write, unsigned int timeoutms);
+
+NETWORK_API int
+socket_wait(socket_t* sock, bool write, unsigned int timeoutms);
+
+NETWORK_API size_t
+socket_send(socket_t* sock, const void* buffer, size_t size, int flags);
+
+NETWORK_API bool
+socket_stream_flush_corked(socket_stream_t* stream);
+
 NETWORK_API int
 socket_streams_initialize(void);
+
+NETWORK_API network_address_t**
+network_address_resolve_blocking(const char* address, size_t length);
+
+NETWORK_API int
+network_monitor_initialize(void);
+
+NETWORK_API void
+network_monitor_finalize(void);
+
+NETWORK_API int
+network_resolver_initialize(void);
+
+NETWORK_API void
+network_resolver_finalize(void);
+
+NETWORK_API bool
+network_resolver_cache_lookup(const char* address, size_t length, network_address_t*** addresses);
+
+NETWORK_API void
+network_resolver_cache_store(const char* address, size_t length, network_address_t** addresses);
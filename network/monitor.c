@@ -0,0 +1,445 @@
+/* monitor.c  -  Network library  -  Public Domain  -  2013 Mattias Jansson
+ *
+ * This library provides a network abstraction built on foundation streams. The latest source code is
+ * always available at
+ *
+ * https://github.com/mjansson/network_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any restrictions.
+ *
+ */
+
+#include <network/monitor.h>
+#include <network/address.h>
+#include <network/socket.h>
+#include <network/internal.h>
+
+#include <foundation/foundation.h>
+
+#if FOUNDATION_PLATFORM_LINUX
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#define NETWORK_MONITOR_NETLINK 1
+#else
+#define NETWORK_MONITOR_NETLINK 0
+#endif
+
+static mutex_t* monitor_lock;
+static network_address_compact_t* monitor_local;
+static atomic32_t monitor_generation;
+static bool monitor_valid;
+
+#if NETWORK_MONITOR_NETLINK
+
+typedef struct network_monitor_address_t {
+	network_address_compact_t address;
+	int ifindex;
+} network_monitor_address_t;
+
+typedef struct network_monitor_link_t {
+	int ifindex;
+	unsigned int flags;
+} network_monitor_link_t;
+
+static socket_t* monitor_socket;
+// Receive buffer reused by all notification reads and dumps, allocated with the socket
+static void* monitor_buffer;
+static network_monitor_address_t* monitor_addresses;
+static network_monitor_link_t* monitor_links;
+static uint32_t monitor_sequence;
+
+// Kernel dumps are sent in messages of up to 32KiB, smaller buffers truncate them
+#define NETWORK_MONITOR_BUFFER_SIZE 32768
+
+static size_t
+network_monitor_find_link(int ifindex) {
+	for (size_t ilink = 0, lsize = array_size(monitor_links); ilink < lsize; ++ilink) {
+		if (monitor_links[ilink].ifindex == ifindex)
+			return ilink;
+	}
+	return STRING_NPOS;
+}
+
+static size_t
+network_monitor_find_address(const network_monitor_address_t* entry) {
+	for (size_t iaddr = 0, asize = array_size(monitor_addresses); iaddr < asize; ++iaddr) {
+		if ((monitor_addresses[iaddr].ifindex == entry->ifindex) &&
+		    network_address_compact_equal(&monitor_addresses[iaddr].address, &entry->address))
+			return iaddr;
+	}
+	return STRING_NPOS;
+}
+
+static void
+network_monitor_link_message(struct nlmsghdr* msg) {
+	struct ifinfomsg* ifi = NLMSG_DATA(msg);
+	size_t ilink;
+
+	if (msg->nlmsg_len < NLMSG_LENGTH(sizeof(struct ifinfomsg)))
+		return;
+
+	ilink = network_monitor_find_link(ifi->ifi_index);
+	if (msg->nlmsg_type == RTM_NEWLINK) {
+		network_monitor_link_t link = {ifi->ifi_index, ifi->ifi_flags};
+		if (ilink != STRING_NPOS)
+			monitor_links[ilink] = link;
+		else
+			array_push(monitor_links, link);
+	} else {
+		if (ilink != STRING_NPOS)
+			array_erase(monitor_links, ilink);
+		for (size_t iaddr = 0; iaddr < array_size(monitor_addresses);) {
+			if (monitor_addresses[iaddr].ifindex == ifi->ifi_index)
+				array_erase_ordered(monitor_addresses, iaddr);
+			else
+				++iaddr;
+		}
+	}
+}
+
+static void
+network_monitor_address_message(struct nlmsghdr* msg) {
+	struct ifaddrmsg* ifa = NLMSG_DATA(msg);
+	network_monitor_address_t entry;
+	struct rtattr* rta;
+	const uint8_t* ip = nullptr;
+	int length;
+	size_t iaddr;
+
+	if (msg->nlmsg_len < NLMSG_LENGTH(sizeof(struct ifaddrmsg)))
+		return;
+	if ((ifa->ifa_family != AF_INET) && (ifa->ifa_family != AF_INET6))
+		return;
+
+	// Local address takes precedence, the address attribute is the peer on point-to-point links
+	length = (int)IFA_PAYLOAD(msg);
+	for (rta = IFA_RTA(ifa); RTA_OK(rta, length); rta = RTA_NEXT(rta, length)) {
+		if ((rta->rta_type == IFA_LOCAL) || ((rta->rta_type == IFA_ADDRESS) && !ip))
+			ip = RTA_DATA(rta);
+	}
+	if (!ip)
+		return;
+
+	memset(&entry, 0, sizeof(entry));
+	entry.ifindex = (int)ifa->ifa_index;
+	if (ifa->ifa_family == AF_INET) {
+		entry.address.family = NETWORK_ADDRESSFAMILY_IPV4;
+		memcpy(entry.address.ip, ip, 4);
+	} else {
+		// Link local addresses are ignored, matching network_address_local
+		if ((ip[0] == 0xFE) && ((ip[1] & 0xC0) == 0x80))
+			return;
+		entry.address.family = NETWORK_ADDRESSFAMILY_IPV6;
+		memcpy(entry.address.ip, ip, 16);
+	}
+
+	iaddr = network_monitor_find_address(&entry);
+	if ((msg->nlmsg_type == RTM_NEWADDR) && (iaddr == STRING_NPOS))
+		array_push(monitor_addresses, entry);
+	else if ((msg->nlmsg_type == RTM_DELADDR) && (iaddr != STRING_NPOS))
+		array_erase_ordered(monitor_addresses, iaddr);
+}
+
+static void
+network_monitor_message(struct nlmsghdr* msg) {
+	switch (msg->nlmsg_type) {
+		case RTM_NEWLINK:
+		case RTM_DELLINK:
+			network_monitor_link_message(msg);
+			break;
+		case RTM_NEWADDR:
+		case RTM_DELADDR:
+			network_monitor_address_message(msg);
+			break;
+		default:
+			break;
+	}
+}
+
+static bool
+network_monitor_dump(int fd, uint16_t type, void* buffer) {
+	struct {
+		struct nlmsghdr header;
+		struct rtgenmsg message;
+	} request;
+
+	memset(&request, 0, sizeof(request));
+	request.header.nlmsg_len = NLMSG_LENGTH(sizeof(struct rtgenmsg));
+	request.header.nlmsg_type = type;
+	request.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+	request.header.nlmsg_seq = ++monitor_sequence;
+	request.message.rtgen_family = AF_UNSPEC;
+
+	if (send(fd, &request, request.header.nlmsg_len, 0) < 0)
+		return false;
+
+	while (true) {
+		struct nlmsghdr* msg;
+		long size = recv(fd, buffer, NETWORK_MONITOR_BUFFER_SIZE, 0);
+		int remain = (int)size;
+		if (size < 0) {
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+		for (msg = buffer; NLMSG_OK(msg, remain); msg = NLMSG_NEXT(msg, remain)) {
+			if (msg->nlmsg_seq != request.header.nlmsg_seq)
+				continue;
+			if (msg->nlmsg_type == NLMSG_DONE)
+				return true;
+			if (msg->nlmsg_type == NLMSG_ERROR)
+				return false;
+			network_monitor_message(msg);
+		}
+	}
+}
+
+// Reload full link and address state with dump requests on a separate netlink socket, the
+// notification socket is subscribed first so no change between the two is lost
+static bool
+network_monitor_sync(void) {
+	void* buffer = monitor_buffer;
+	int fd = (int)socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+	bool success;
+
+	array_clear(monitor_links);
+	array_clear(monitor_addresses);
+	success = (fd >= 0) && network_monitor_dump(fd, RTM_GETLINK, buffer) &&
+	          network_monitor_dump(fd, RTM_GETADDR, buffer);
+	if (!success) {
+		int err = errno;
+		string_const_t errmsg = system_error_message(err);
+		log_warnf(HASH_NETWORK, WARNING_SYSTEM_CALL_FAIL,
+		          STRING_CONST("Unable to read interface addresses from netlink: %.*s (%d)"), STRING_FORMAT(errmsg),
+		          err);
+	}
+
+	if (fd >= 0)
+		close(fd);
+	return success;
+}
+
+// Process pending notifications, returns true if any state was updated
+static bool
+network_monitor_read(void) {
+	void* buffer = monitor_buffer;
+	bool received = false;
+	bool overflow = false;
+
+	while (true) {
+		struct nlmsghdr* msg;
+		long size = recv(monitor_socket->fd, buffer, NETWORK_MONITOR_BUFFER_SIZE, MSG_DONTWAIT);
+		int remain = (int)size;
+		if (size < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno == ENOBUFS) {
+				overflow = true;
+				continue;
+			}
+			break;
+		}
+		if (!size)
+			break;
+		for (msg = buffer; NLMSG_OK(msg, remain); msg = NLMSG_NEXT(msg, remain))
+			network_monitor_message(msg);
+		received = true;
+	}
+
+	// Notifications were dropped by the kernel, resynchronize full state
+	if (overflow)
+		network_monitor_sync();
+
+	return received || overflow;
+}
+
+static network_address_compact_t*
+network_monitor_collect(void) {
+	network_address_compact_t* local = nullptr;
+	for (size_t iaddr = 0, asize = array_size(monitor_addresses); iaddr < asize; ++iaddr) {
+		size_t ilink = network_monitor_find_link(monitor_addresses[iaddr].ifindex);
+		if (ilink == STRING_NPOS)
+			continue;
+		if (!(monitor_links[ilink].flags & IFF_UP) || (monitor_links[ilink].flags & IFF_POINTOPOINT))
+			continue;
+		array_push(local, monitor_addresses[iaddr].address);
+	}
+	return local;
+}
+
+static void
+network_monitor_open(void) {
+	struct sockaddr_nl local;
+	int fd = (int)socket(AF_NETLINK, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_ROUTE);
+
+	memset(&local, 0, sizeof(local));
+	local.nl_family = AF_NETLINK;
+	local.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR;
+	if ((fd < 0) || (bind(fd, (struct sockaddr*)&local, sizeof(local)) < 0)) {
+		int err = errno;
+		string_const_t errmsg = system_error_message(err);
+		log_warnf(HASH_NETWORK, WARNING_SYSTEM_CALL_FAIL,
+		          STRING_CONST("Unable to subscribe to netlink address notifications: %.*s (%d)"),
+		          STRING_FORMAT(errmsg), err);
+		if (fd >= 0)
+			close(fd);
+		return;
+	}
+
+	monitor_socket = memory_allocate(HASH_NETWORK, sizeof(socket_t), 0, MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	NETWORK_COUNT_ALLOCATION(NETWORK_ALLOCATION_SOCKET, sizeof(socket_t));
+	socket_initialize(monitor_socket);
+	monitor_socket->type = NETWORK_SOCKETTYPE_MONITOR;
+	monitor_socket->fd = fd;
+	monitor_buffer = memory_allocate(HASH_NETWORK, NETWORK_MONITOR_BUFFER_SIZE, 8, MEMORY_PERSISTENT);
+	NETWORK_COUNT_ALLOCATION(NETWORK_ALLOCATION_OTHER, NETWORK_MONITOR_BUFFER_SIZE);
+}
+
+static void
+network_monitor_close(void) {
+	socket_deallocate(monitor_socket);
+	monitor_socket = nullptr;
+	memory_deallocate(monitor_buffer);
+	monitor_buffer = nullptr;
+	array_deallocate(monitor_addresses);
+	array_deallocate(monitor_links);
+}
+
+#endif
+
+// Must be called with monitor lock held, takes ownership of the array
+static bool
+network_monitor_publish(network_address_compact_t* local) {
+	size_t count = array_size(local);
+	bool changed = (count != array_size(monitor_local)) ||
+	               (count && memcmp(local, monitor_local, sizeof(network_address_compact_t) * count));
+	array_deallocate(monitor_local);
+	monitor_local = local;
+	monitor_valid = true;
+	if (changed)
+		atomic_incr32(&monitor_generation, memory_order_release);
+	return changed;
+}
+
+// Must be called with monitor lock held
+static bool
+network_monitor_reload(void) {
+#if NETWORK_MONITOR_NETLINK
+	if (monitor_socket) {
+		if (network_monitor_sync())
+			return network_monitor_publish(network_monitor_collect());
+		// Netlink state is unusable, fall back to explicit refresh
+		network_monitor_close();
+	}
+#endif
+	return network_monitor_publish(network_address_local_compact());
+}
+
+// Must be called with monitor lock held
+static void
+network_monitor_start(void) {
+	if (monitor_valid)
+		return;
+#if NETWORK_MONITOR_NETLINK
+	network_monitor_open();
+#endif
+	network_monitor_reload();
+}
+
+int
+network_monitor_initialize(void) {
+	monitor_lock = mutex_allocate(STRING_CONST("monitor"));
+	monitor_local = nullptr;
+	monitor_valid = false;
+	atomic_store32(&monitor_generation, 0, memory_order_release);
+	return 0;
+}
+
+void
+network_monitor_finalize(void) {
+	mutex_lock(monitor_lock);
+#if NETWORK_MONITOR_NETLINK
+	network_monitor_close();
+#endif
+	array_deallocate(monitor_local);
+	monitor_valid = false;
+	mutex_unlock(monitor_lock);
+
+	mutex_deallocate(monitor_lock);
+	monitor_lock = nullptr;
+}
+
+size_t
+network_address_local_cached(network_address_compact_t* addresses, size_t capacity) {
+	size_t count;
+
+	if (!monitor_lock)
+		return 0;
+
+	mutex_lock(monitor_lock);
+	network_monitor_start();
+	count = array_size(monitor_local);
+	if (count && capacity)
+		memcpy(addresses, monitor_local, sizeof(network_address_compact_t) * ((count < capacity) ? count : capacity));
+	mutex_unlock(monitor_lock);
+
+	return count;
+}
+
+unsigned int
+network_address_local_generation(void) {
+	return (unsigned int)atomic_load32(&monitor_generation, memory_order_acquire);
+}
+
+bool
+network_address_local_refresh(void) {
+	bool changed;
+
+	if (!monitor_lock)
+		return false;
+
+	mutex_lock(monitor_lock);
+	if (!monitor_valid) {
+		network_monitor_start();
+		changed = (array_size(monitor_local) > 0);
+	} else {
+		changed = network_monitor_reload();
+	}
+	mutex_unlock(monitor_lock);
+
+	return changed;
+}
+
+socket_t*
+network_address_local_monitor(void) {
+	socket_t* sock = nullptr;
+
+	if (!monitor_lock)
+		return sock;
+
+	mutex_lock(monitor_lock);
+	network_monitor_start();
+#if NETWORK_MONITOR_NETLINK
+	sock = monitor_socket;
+#endif
+	mutex_unlock(monitor_lock);
+
+	return sock;
+}
+
+bool
+network_address_local_update(void) {
+	bool changed = false;
+
+	if (!monitor_lock)
+		return changed;
+
+	mutex_lock(monitor_lock);
+#if NETWORK_MONITOR_NETLINK
+	if (monitor_valid && monitor_socket && network_monitor_read())
+		changed = network_monitor_publish(network_monitor_collect());
+#endif
+	mutex_unlock(monitor_lock);
+
+	return changed;
+}
@@ -0,0 +1,55 @@
+/* monitor.h  -  Network library  -  Public Domain  -  2013 Mattias Jansson
+ *
+ * This library provides a network abstraction built on foundation streams. The latest source code is
+ * always available at
+ *
+ * https://github.com/mjansson/network_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any restrictions.
+ *
+ */
+
+#pragma once
+
+/*! \file monitor.h
+    Cached local interface address list. On Linux the cache is kept up to date incrementally from
+    rtnetlink address and link notifications, on other platforms it is refreshed explicitly. */
+
+#include <foundation/platform.h>
+
+#include <network/types.h>
+
+/*! Get the cached local interface addresses, same set as returned by #network_address_local.
+The cache is populated on first call. Once populated no system calls are made, the cache is
+updated by the address monitor (see #network_address_local_monitor) or by an explicit
+#network_address_local_refresh.
+\param addresses Destination array
+\param capacity Capacity of destination array
+\return Total number of local addresses, which may be larger than capacity */
+NETWORK_API size_t
+network_address_local_cached(network_address_compact_t* addresses, size_t capacity);
+
+/*! Get the generation counter of the local address cache. The counter is incremented each
+time the set of local addresses changes, and can be used to cheaply detect changes.
+\return Generation counter */
+NETWORK_API unsigned int
+network_address_local_generation(void);
+
+/*! Reload the local address cache from the system
+\return true if the set of local addresses changed, false if not */
+NETWORK_API bool
+network_address_local_refresh(void);
+
+/*! Get the local address monitor socket. Add the socket to a network poll object to keep the
+address cache updated, the poll generates a NETWORKEVENT_ADDRESS event on the monitor socket
+when the set of local addresses changes. The socket is owned by the network library and must
+not be deallocated. Only available on Linux (rtnetlink).
+\return Monitor socket, null if not supported on platform */
+NETWORK_API socket_t*
+network_address_local_monitor(void);
+
+/*! Process pending address notifications on the monitor socket without blocking, for
+applications not using network poll
+\return true if the set of local addresses changed, false if not */
+NETWORK_API bool
+network_address_local_update(void);
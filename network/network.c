@@ -19,13 +19,28 @@
 #endif
 
 network_config_t network_config;
+#if BUILD_ENABLE_NETWORK_SYSCALL_COUNT
+atomic64_t network_syscall_counter[NETWORK_SYSCALL_COUNT];
+#endif
+#if BUILD_ENABLE_NETWORK_ALLOCATION_COUNT
+atomic64_t network_allocation_counter[NETWORK_ALLOCATION_COUNT];
+atomic64_t network_allocation_size[NETWORK_ALLOCATION_COUNT];
+#endif
 static bool network_initialized;
 static bool network_has_ipv4;
 static bool network_has_ipv6;
 
 static void
 network_initialize_config(const network_config_t config) {
-	FOUNDATION_UNUSED(config);
+	network_config = config;
+	if (!network_config.resolver_threads)
+		network_config.resolver_threads = 2;
+	if (!network_config.resolver_cache_size)
+		network_config.resolver_cache_size = 256;
+	if (!network_config.resolver_cache_ttl)
+		network_config.resolver_cache_ttl = 60000;
+	if (!network_config.resolver_negative_ttl)
+		network_config.resolver_negative_ttl = 5000;
 }
 
 int
@@ -53,6 +68,12 @@ network_module_initialize(const network_config_t config) {
 	if (socket_streams_initialize() < 0)
 		return -1;
 
+	if (network_resolver_initialize() < 0)
+		return -1;
+
+	if (network_monitor_initialize() < 0)
+		return -1;
+
 	// Check support
 	fd = (int)socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
 	network_has_ipv4 = !(fd < 0);
@@ -88,9 +109,14 @@ network_module_finalize(void) {
 	if (!network_initialized)
 		return;
 
+	network_monitor_finalize();
+	network_resolver_finalize();
+
 #if FOUNDATION_PLATFORM_WINDOWS
 	WSACleanup();
 #endif
+
+	network_initialized = false;
 }
 
 network_config_t
@@ -107,3 +133,54 @@ bool
 network_supports_ipv6(void) {
 	return network_has_ipv6;
 }
+
+uint64_t
+network_syscall_count(network_syscall_t call) {
+#if BUILD_ENABLE_NETWORK_SYSCALL_COUNT
+	if ((unsigned int)call < NETWORK_SYSCALL_COUNT)
+		return (uint64_t)atomic_load64(&network_syscall_counter[call], memory_order_relaxed);
+#else
+	FOUNDATION_UNUSED(call);
+#endif
+	return 0;
+}
+
+void
+network_syscall_count_reset(void) {
+#if BUILD_ENABLE_NETWORK_SYSCALL_COUNT
+	for (unsigned int icall = 0; icall < NETWORK_SYSCALL_COUNT; ++icall)
+		atomic_store64(&network_syscall_counter[icall], 0, memory_order_relaxed);
+#endif
+}
+
+uint64_t
+network_allocation_count(network_allocation_t site) {
+#if BUILD_ENABLE_NETWORK_ALLOCATION_COUNT
+	if ((unsigned int)site < NETWORK_ALLOCATION_COUNT)
+		return (uint64_t)atomic_load64(&network_allocation_counter[site], memory_order_relaxed);
+#else
+	FOUNDATION_UNUSED(site);
+#endif
+	return 0;
+}
+
+uint64_t
+network_allocation_bytes(network_allocation_t site) {
+#if BUILD_ENABLE_NETWORK_ALLOCATION_COUNT
+	if ((unsigned int)site < NETWORK_ALLOCATION_COUNT)
+		return (uint64_t)atomic_load64(&network_allocation_size[site], memory_order_relaxed);
+#else
+	FOUNDATION_UNUSED(site);
+#endif
+	return 0;
+}
+
+void
+network_allocation_count_reset(void) {
+#if BUILD_ENABLE_NETWORK_ALLOCATION_COUNT
+	for (unsigned int isite = 0; isite < NETWORK_ALLOCATION_COUNT; ++isite) {
+		atomic_store64(&network_allocation_counter[isite], 0, memory_order_relaxed);
+		atomic_store64(&network_allocation_size[isite], 0, memory_order_relaxed);
+	}
+#endif
+}
@@ -19,11 +19,19 @@
 #include <network/types.h>
 #include <network/hashstrings.h>
 #include <network/address.h>
+#include <network/addressmap.h>
+#include <network/cidr.h>
+#include <network/monitor.h>
 #include <network/poll.h>
+#include <network/sampler.h>
+#include <network/shm.h>
+#include <network/sim.h>
 #include <network/socket.h>
 #include <network/stream.h>
 #include <network/tcp.h>
 #include <network/udp.h>
+#include <network/unix.h>
+#include <network/resolver.h>
 
 /*! Initialize network functionality. Must be called prior to any other network
 module API calls.
@@ -66,3 +74,37 @@ network_supports_ipv4(void);
 \return true if IPv6 is supported, false if not */
 NETWORK_API bool
 network_supports_ipv6(void);
+
+/*! Query number of socket system calls of the given kind made by the network library
+since module initialization or the last call to #network_syscall_count_reset. Always
+returns zero if built without BUILD_ENABLE_NETWORK_SYSCALL_COUNT.
+\param call System call kind
+\return Number of calls made */
+NETWORK_API uint64_t
+network_syscall_count(network_syscall_t call);
+
+/*! Reset all system call counters to zero */
+NETWORK_API void
+network_syscall_count_reset(void);
+
+/*! Query number of memory allocations made by the network library at the given call
+site since module initialization or the last call to #network_allocation_count_reset.
+All allocations are made through the foundation memory system with the HASH_NETWORK
+context, growth of internal foundation arrays is not counted. Always returns zero if
+built without BUILD_ENABLE_NETWORK_ALLOCATION_COUNT.
+\param site Allocation call site
+\return Number of allocations made */
+NETWORK_API uint64_t
+network_allocation_count(network_allocation_t site);
+
+/*! Query number of bytes allocated by the network library at the given call site since
+module initialization or the last call to #network_allocation_count_reset. Always returns
+zero if built without BUILD_ENABLE_NETWORK_ALLOCATION_COUNT.
+\param site Allocation call site
+\return Number of bytes allocated */
+NETWORK_API uint64_t
+network_allocation_bytes(network_allocation_t site);
+
+/*! Reset all allocation counters to zero */
+NETWORK_API void
+network_allocation_count_reset(void);
@@ -12,6 +12,9 @@
 #include <network/poll.h>
 #include <network/socket.h>
 #include <network/address.h>
+#include <network/monitor.h>
+#include <network/sampler.h>
+#include <network/sim.h>
 #include <network/internal.h>
 
 #include <foundation/foundation.h>
@@ -47,6 +50,7 @@ network_poll_allocate(unsigned int max_sockets) {
 	memsize += sizeof(struct epoll_event) * max_sockets;
 #endif
 	poll = memory_allocate(HASH_NETWORK, memsize, 8, MEMORY_PERSISTENT);
+	NETWORK_COUNT_ALLOCATION(NETWORK_ALLOCATION_POLL, memsize);
 	network_poll_initialize(poll, max_sockets);
 	return poll;
 }
@@ -55,6 +59,10 @@ void
 network_poll_initialize(network_poll_t* pollobj, unsigned int max_sockets) {
 	pollobj->sockets_count = 0;
 	pollobj->sockets_max = max_sockets;
+	pollobj->deadline_next = 0;
+	pollobj->sampler = nullptr;
+	pollobj->sim = nullptr;
+	pollobj->streams_dirty = nullptr;
 #if FOUNDATION_PLATFORM_APPLE
 	pollobj->pollfds = pointer_offset(pollobj->slots, sizeof(network_poll_slot_t) * max_sockets);
 #elif FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
@@ -65,10 +73,17 @@ network_poll_initialize(network_poll_t* pollobj, unsigned int max_sockets) {
 
 void
 network_poll_finalize(network_poll_t* pollobj) {
+	for (size_t istream = 0, count = array_size(pollobj->streams_dirty); istream < count; ++istream) {
+		pollobj->streams_dirty[istream]->dirty = false;
+		pollobj->streams_dirty[istream]->cork_poll = nullptr;
+	}
+	array_deallocate(pollobj->streams_dirty);
+	pollobj->streams_dirty = nullptr;
+	if (pollobj->sampler)
+		pollobj->sampler->poll = nullptr;
+	pollobj->sampler = nullptr;
 #if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
 	close(pollobj->fd_poll);
-#else
-	FOUNDATION_UNUSED(pollobj);
 #endif
 }
 
@@ -93,6 +108,11 @@ network_poll_sockets(network_poll_t* pollobj, socket_t** sockets, size_t max_soc
 
 static void
 network_poll_update_slot(network_poll_t* pollobj, size_t slot, socket_t* sock) {
+	// Simulated sockets have no system handle, readiness is taken from the simulation
+	if (pollobj->sim) {
+		pollobj->slots[slot].fd = sock->fd;
+		return;
+	}
 #if FOUNDATION_PLATFORM_APPLE
 	if (sock->fd != NETWORK_SOCKET_INVALID) {
 		pollobj->pollfds[slot].fd = sock->fd;
@@ -135,6 +155,7 @@ network_poll_add_socket(network_poll_t* pollobj, socket_t* sock) {
 
 		pollobj->slots[slot].sock = sock;
 		pollobj->slots[slot].fd = NETWORK_SOCKET_INVALID;
+		pollobj->slots[slot].deadline = 0;
 		++pollobj->sockets_count;
 
 		network_poll_update_slot(pollobj, slot, sock);
@@ -171,20 +192,24 @@ network_poll_remove_socket(network_poll_t* pollobj, socket_t* sock) {
 				memcpy(pollobj->pollfds + islot, pollobj->pollfds + (sockets_count - 1), sizeof(struct pollfd));
 #elif FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
 				// Mod the moved socket
-				struct epoll_event event;
-				event.events =
-				    ((pollobj->slots[sockets_count - 1].sock->state == SOCKETSTATE_CONNECTING) ? EPOLLOUT : EPOLLIN) |
-				    EPOLLERR | EPOLLHUP;
-				event.data.fd = (int)islot;
-				epoll_ctl(pollobj->fd_poll, EPOLL_CTL_MOD, pollobj->slots[sockets_count - 1].fd, &event);
+				if (!pollobj->sim) {
+					struct epoll_event event;
+					event.events =
+					    ((pollobj->slots[islot].sock->state == SOCKETSTATE_CONNECTING) ? EPOLLOUT : EPOLLIN) | EPOLLERR |
+					    EPOLLHUP;
+					event.data.fd = (int)islot;
+					epoll_ctl(pollobj->fd_poll, EPOLL_CTL_MOD, pollobj->slots[islot].fd, &event);
+				}
 #endif
 			}
 			memset(pollobj->slots + (sockets_count - 1), 0, sizeof(network_poll_slot_t));
 #if FOUNDATION_PLATFORM_APPLE
 			memset(pollobj->pollfds + (sockets_count - 1), 0, sizeof(struct pollfd));
 #elif FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
-			struct epoll_event event;
-			epoll_ctl(pollobj->fd_poll, EPOLL_CTL_DEL, fd_remove, &event);
+			if (!pollobj->sim) {
+				struct epoll_event event;
+				epoll_ctl(pollobj->fd_poll, EPOLL_CTL_DEL, fd_remove, &event);
+			}
 #endif
 			sockets_count = --pollobj->sockets_count;
 		}
@@ -200,6 +225,70 @@ network_poll_has_socket(network_poll_t* pollobj, socket_t* sock) {
 	return false;
 }
 
+void
+network_poll_set_connect_timeout(network_poll_t* pollobj, socket_t* sock, unsigned int timeoutms) {
+	tick_t deadline = 0;
+	if (timeoutms != NETWORK_TIMEOUT_INFINITE)
+		deadline = time_current() + (((tick_t)timeoutms * time_ticks_per_second()) / 1000);
+	// Scan from the back, the socket was most likely just added
+	for (size_t islot = pollobj->sockets_count; islot > 0; --islot) {
+		if (pollobj->slots[islot - 1].sock == sock) {
+			pollobj->slots[islot - 1].deadline = deadline;
+			if (deadline && (!pollobj->deadline_next || (deadline < pollobj->deadline_next)))
+				pollobj->deadline_next = deadline;
+			break;
+		}
+	}
+}
+
+// Run timed work after waiting: take a statistics sample if due, close pending connects past their
+// deadline and find the next deadline. Only scans the slots once the earliest deadline has passed,
+// so polls without connect deadlines pay nothing
+static size_t
+network_poll_timers(network_poll_t* pollobj, network_poll_event_t* events, size_t capacity, size_t events_count) {
+	tick_t now, deadline_next = 0;
+	if (pollobj->sampler)
+		network_sampler_update(pollobj->sampler);
+	if (!pollobj->deadline_next)
+		return events_count;
+	now = time_current();
+	if (now < pollobj->deadline_next)
+		return events_count;
+	for (size_t islot = 0, ssize = pollobj->sockets_count; islot < ssize; ++islot) {
+		network_poll_slot_t* slot = pollobj->slots + islot;
+		if (!slot->deadline)
+			continue;
+		if (slot->sock->state != SOCKETSTATE_CONNECTING) {
+			slot->deadline = 0;
+		} else if ((slot->deadline <= now) && (events_count < capacity)) {
+			slot->deadline = 0;
+			network_poll_push_event(events, capacity, events_count, NETWORKEVENT_TIMEOUT, slot->sock);
+			socket_close(slot->sock);
+			network_poll_update_slot(pollobj, islot, slot->sock);
+		} else if (!deadline_next || (slot->deadline < deadline_next)) {
+			// Expired deadlines with no room for the event are kept and reported by the next poll
+			deadline_next = slot->deadline;
+		}
+	}
+	pollobj->deadline_next = deadline_next;
+	return events_count;
+}
+
+size_t
+network_poll_flush(network_poll_t* pollobj) {
+	size_t istream, count, pending = 0, flushed = 0;
+	for (istream = 0, count = array_size(pollobj->streams_dirty); istream < count; ++istream) {
+		socket_stream_t* stream = pollobj->streams_dirty[istream];
+		if (socket_stream_flush_corked(stream))
+			++flushed;
+		else
+			pollobj->streams_dirty[pending++] = stream;
+	}
+	if (count)
+		array_resize(pollobj->streams_dirty, pending);
+	return flushed;
+}
+
 size_t
 network_poll(network_poll_t* pollobj, network_poll_event_t* events, size_t capacity, unsigned int timeoutms) {
 	int avail = 0;
@@ -213,9 +302,35 @@ network_poll(network_poll_t* pollobj, network_poll_event_t* events, size_t capac
 	fd_set fdread, fdwrite, fderr;
 #endif
 
+	if (pollobj->streams_dirty)
+		network_poll_flush(pollobj);
+
 	if (!pollobj->sockets_count)
 		return events_count;
 
+	if (pollobj->sim)
+		return network_sim_poll(pollobj->sim, pollobj, events, capacity, timeoutms);
+
+	// Wake up in time to expire the next pending connect
+	if (pollobj->deadline_next) {
+		tick_t now = time_current();
+		unsigned int deadlinems = 0;
+		if (pollobj->deadline_next > now)
+			deadlinems = (unsigned int)((((pollobj->deadline_next - now) * 1000) + time_ticks_per_second() - 1) /
+			                            time_ticks_per_second());
+		if (deadlinems < timeoutms)
+			timeoutms = deadlinems;
+	}
+	if (pollobj->sampler) {
+		tick_t now = time_current();
+		unsigned int samplems = 0;
+		if (pollobj->sampler->next > now)
+			samplems = (unsigned int)((((pollobj->sampler->next - now) * 1000) + time_ticks_per_second() - 1) /
+			                          time_ticks_per_second());
+		if (samplems < timeoutms)
+			timeoutms = samplems;
+	}
+
 #if FOUNDATION_PLATFORM_APPLE
 
 	int ret = poll(pollobj->pollfds, (nfds_t)pollobj->sockets_count, (int)timeoutms);
@@ -267,11 +382,11 @@ network_poll(network_poll_t* pollobj, network_poll_event_t* events, size_t capac
 		log_warnf(HASH_NETWORK, WARNING_SUSPICIOUS, STRING_CONST("Error in socket poll: %.*s (%d)"),
 		          STRING_FORMAT(errmsg), err);
 		if (!avail)
-			return events_count;
+			return network_poll_timers(pollobj, events, capacity, events_count);
 		ret = avail;
 	}
 	if (!avail && !ret)
-		return events_count;
+		return network_poll_timers(pollobj, events, capacity, events_count);
 
 #if FOUNDATION_PLATFORM_APPLE
 
@@ -325,6 +440,12 @@ network_poll(network_poll_t* pollobj, network_poll_event_t* events, size_t capac
 		socket_t* sock = pollobj->slots[event->data.fd].sock;
 		bool update_slot = false;
 		bool had_error = false;
+		if (sock->type == NETWORK_SOCKETTYPE_MONITOR) {
+			// Errors on the monitor socket signal dropped notifications, handled by a resync
+			if (network_address_local_update())
+				network_poll_push_event(events, capacity, events_count, NETWORKEVENT_ADDRESS, sock);
+			continue;
+		}
 		if (event->events & EPOLLERR) {
 			update_slot = true;
 			had_error = true;
@@ -393,5 +514,5 @@ network_poll(network_poll_t* pollobj, network_poll_event_t* events, size_t capac
 #error Not implemented
 #endif
 
-	return events_count;
+	return network_poll_timers(pollobj, events, capacity, events_count);
 }
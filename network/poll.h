@@ -42,6 +42,15 @@ network_poll_remove_socket(network_poll_t* poll, socket_t* sock);
 NETWORK_API bool
 network_poll_has_socket(network_poll_t* poll, socket_t* sock);
 
+/*! Set a deadline for a pending connect on a socket in the poll. If the socket is still in
+connecting state when the timeout expires, the socket is closed and a NETWORKEVENT_TIMEOUT event
+is generated. The deadline is cleared once the connection is established or fails.
+\param poll Poll object
+\param sock Socket in connecting state
+\param timeoutms Timeout in milliseconds, NETWORK_TIMEOUT_INFINITE to clear deadline */
+NETWORK_API void
+network_poll_set_connect_timeout(network_poll_t* poll, socket_t* sock, unsigned int timeoutms);
+
 NETWORK_API size_t
 network_poll_sockets_count(network_poll_t* poll);
 
@@ -50,3 +59,11 @@ network_poll_sockets(network_poll_t* poll, socket_t** sockets, size_t max_socket
 
 NETWORK_API size_t
 network_poll(network_poll_t* poll, network_poll_event_t* event, size_t capacity, unsigned int timeoutms);
+
+/*! Flush all corked socket streams associated with the poll object that have pending
+buffered data, issuing a single send per stream. Called automatically at the start of
+#network_poll. Streams that could not be fully flushed are kept for the next flush.
+\param poll Poll object
+\return Number of streams fully flushed */
+NETWORK_API size_t
+network_poll_flush(network_poll_t* poll);
@@ -0,0 +1,442 @@
+/* resolver.c  -  Network library  -  Public Domain  -  2013 Mattias Jansson
+ *
+ * This library provides a network abstraction built on foundation streams. The latest source code is
+ * always available at
+ *
+ * https://github.com/mjansson/network_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any restrictions.
+ *
+ */
+
+#include <network/resolver.h>
+#include <network/address.h>
+#include <network/internal.h>
+
+#include <foundation/foundation.h>
+
+typedef struct network_resolver_request_t network_resolver_request_t;
+typedef struct network_resolver_result_t network_resolver_result_t;
+typedef struct network_resolver_entry_t network_resolver_entry_t;
+
+struct network_resolver_request_t {
+	network_resolve_fn callback;
+	void* userdata;
+};
+
+//! Reference counted resolve result, shared between the cache and readers cloning it outside the lock
+struct network_resolver_result_t {
+	atomic32_t ref;
+	network_address_t** addresses;
+};
+
+struct network_resolver_entry_t {
+	hash_t key;
+	string_t address;
+	network_resolver_result_t* result;
+	tick_t expires;
+	tick_t used;
+	bool pending;
+	network_resolver_request_t* requests;
+};
+
+static mutex_t* resolver_lock;
+static semaphore_t resolver_jobs;
+static thread_t* resolver_threads;
+static size_t resolver_threads_count;
+static bool resolver_terminate;
+static size_t* resolver_queue;
+
+// Maps address hash to entry index + 1, entries are verified by string compare
+static hashtable64_t* resolver_table;
+static network_resolver_entry_t* resolver_entries;
+static size_t resolver_entries_count;
+static size_t resolver_entries_capacity;
+
+static tick_t
+network_resolver_ticks(unsigned int ms) {
+	return ((tick_t)ms * time_ticks_per_second()) / 1000;
+}
+
+static hash_t
+network_resolver_key(const char* address, size_t length) {
+	// Zero is reserved as empty key in the hash table
+	hash_t key = hash(address, length);
+	return key ? key : 1;
+}
+
+static network_address_t**
+network_resolver_clone_addresses(network_address_t** addresses) {
+	network_address_t** clone = 0;
+	for (size_t iaddr = 0, asize = array_size(addresses); iaddr < asize; ++iaddr)
+		array_push(clone, network_address_clone(addresses[iaddr]));
+	return clone;
+}
+
+static network_resolver_result_t*
+network_resolver_result_allocate(network_address_t** addresses) {
+	network_resolver_result_t* result;
+	if (!addresses)
+		return nullptr;
+	result = memory_allocate(HASH_NETWORK, sizeof(network_resolver_result_t), 0, MEMORY_PERSISTENT);
+	NETWORK_COUNT_ALLOCATION(NETWORK_ALLOCATION_OTHER, sizeof(network_resolver_result_t));
+	atomic_store32(&result->ref, 1, memory_order_release);
+	result->addresses = addresses;
+	return result;
+}
+
+static network_resolver_result_t*
+network_resolver_result_acquire(network_resolver_result_t* result) {
+	if (result)
+		atomic_incr32(&result->ref, memory_order_acquire);
+	return result;
+}
+
+static void
+network_resolver_result_release(network_resolver_result_t* result) {
+	if (result && !atomic_decr32(&result->ref, memory_order_release)) {
+		network_address_array_deallocate(result->addresses);
+		memory_deallocate(result);
+	}
+}
+
+//! Clone the addresses of a result and release the reference, called without the resolver lock
+static network_address_t**
+network_resolver_result_take(network_resolver_result_t* result) {
+	network_address_t** addresses = nullptr;
+	if (result) {
+		addresses = network_resolver_clone_addresses(result->addresses);
+		network_resolver_result_release(result);
+	}
+	return addresses;
+}
+
+// Must be called with resolver lock held
+static void
+network_resolver_entry_clear(network_resolver_entry_t* entry) {
+	size_t ientry = (size_t)(entry - resolver_entries);
+	if (entry->key && (hashtable64_get(resolver_table, entry->key) == ientry + 1))
+		hashtable64_erase(resolver_table, entry->key);
+	string_deallocate(entry->address.str);
+	network_resolver_result_release(entry->result);
+	array_deallocate(entry->requests);
+	memset(entry, 0, sizeof(network_resolver_entry_t));
+}
+
+// Must be called with resolver lock held
+static void
+network_resolver_index(network_resolver_entry_t* entry) {
+	uint64_t value = (uint64_t)(entry - resolver_entries) + 1;
+	if (!hashtable64_set(resolver_table, entry->key, value)) {
+		// Erased keys are not reclaimed by the hash table, rebuild from live entries when full
+		hashtable64_clear(resolver_table);
+		for (size_t ientry = 0; ientry < resolver_entries_count; ++ientry) {
+			if (resolver_entries[ientry].key)
+				hashtable64_set(resolver_table, resolver_entries[ientry].key, (uint64_t)ientry + 1);
+		}
+	}
+}
+
+// Must be called with resolver lock held
+static network_resolver_entry_t*
+network_resolver_find(hash_t key, const char* address, size_t length) {
+	uint64_t value = hashtable64_get(resolver_table, key);
+	if (value && (value <= resolver_entries_count)) {
+		network_resolver_entry_t* entry = resolver_entries + (value - 1);
+		if ((entry->key == key) && string_equal(STRING_ARGS(entry->address), address, length))
+			return entry;
+	}
+	return nullptr;
+}
+
+// Must be called with resolver lock held, returns null if all entries are in-flight
+static network_resolver_entry_t*
+network_resolver_allocate(hash_t key, const char* address, size_t length, tick_t now) {
+	network_resolver_entry_t* entry = nullptr;
+	size_t ientry = resolver_entries_count;
+
+	if (resolver_entries_count >= resolver_entries_capacity) {
+		// Evict an expired entry, or the least recently used completed entry
+		tick_t oldest = 0;
+		for (size_t icheck = 0; icheck < resolver_entries_count; ++icheck) {
+			network_resolver_entry_t* check = resolver_entries + icheck;
+			if (check->pending)
+				continue;
+			if (check->expires <= now) {
+				ientry = icheck;
+				break;
+			}
+			if ((ientry == resolver_entries_count) || (check->used < oldest)) {
+				ientry = icheck;
+				oldest = check->used;
+			}
+		}
+		if (ientry == resolver_entries_count)
+			return nullptr;
+		network_resolver_entry_clear(resolver_entries + ientry);
+	} else {
+		++resolver_entries_count;
+	}
+
+	entry = resolver_entries + ientry;
+	entry->key = key;
+	entry->address = string_clone(address, length);
+	NETWORK_COUNT_ALLOCATION(NETWORK_ALLOCATION_OTHER, length + 1);
+	entry->used = now;
+	network_resolver_index(entry);
+	return entry;
+}
+
+// Must be called with resolver lock held
+static void
+network_resolver_complete(network_resolver_entry_t* entry, network_address_t** addresses) {
+	unsigned int ttl = addresses ? network_config.resolver_cache_ttl : network_config.resolver_negative_ttl;
+	network_resolver_result_release(entry->result);
+	entry->result = network_resolver_result_allocate(addresses);
+	entry->pending = false;
+	entry->expires = time_current() + network_resolver_ticks(ttl);
+}
+
+static void*
+network_resolver_worker(void* arg) {
+	FOUNDATION_UNUSED(arg);
+
+	while (semaphore_wait(&resolver_jobs)) {
+		network_resolver_request_t* requests;
+		network_resolver_entry_t* entry;
+		network_resolver_result_t* result;
+		network_address_t** addresses;
+		string_t address;
+		size_t ientry;
+
+		mutex_lock(resolver_lock);
+		if (resolver_terminate || !array_size(resolver_queue)) {
+			bool terminate = resolver_terminate;
+			mutex_unlock(resolver_lock);
+			if (terminate)
+				break;
+			continue;
+		}
+		ientry = resolver_queue[0];
+		array_erase_ordered(resolver_queue, 0);
+		address = string_clone(STRING_ARGS(resolver_entries[ientry].address));
+		NETWORK_COUNT_ALLOCATION(NETWORK_ALLOCATION_OTHER, address.length + 1);
+		mutex_unlock(resolver_lock);
+
+		addresses = network_address_resolve_blocking(STRING_ARGS(address));
+
+		mutex_lock(resolver_lock);
+		entry = resolver_entries + ientry;
+		network_resolver_complete(entry, addresses);
+		requests = entry->requests;
+		entry->requests = nullptr;
+		// Keep a reference, the entry may be evicted once lock is released
+		result = network_resolver_result_acquire(entry->result);
+		mutex_unlock(resolver_lock);
+
+		for (size_t ireq = 0, rsize = array_size(requests); ireq < rsize; ++ireq)
+			requests[ireq].callback(STRING_ARGS(address),
+			                        result ? network_resolver_clone_addresses(result->addresses) : nullptr,
+			                        requests[ireq].userdata);
+
+		network_resolver_result_release(result);
+		array_deallocate(requests);
+		string_deallocate(address.str);
+	}
+
+	return 0;
+}
+
+int
+network_resolver_initialize(void) {
+	resolver_entries_capacity = network_config.resolver_cache_size;
+	resolver_entries_count = 0;
+	resolver_entries = memory_allocate(HASH_NETWORK, sizeof(network_resolver_entry_t) * resolver_entries_capacity, 0,
+	                                   MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	NETWORK_COUNT_ALLOCATION(NETWORK_ALLOCATION_OTHER, sizeof(network_resolver_entry_t) * resolver_entries_capacity);
+	resolver_table = hashtable64_allocate(resolver_entries_capacity * 2);
+	resolver_lock = mutex_allocate(STRING_CONST("resolver"));
+	resolver_queue = nullptr;
+	resolver_terminate = false;
+	semaphore_initialize(&resolver_jobs, 0);
+
+	resolver_threads_count = network_config.resolver_threads;
+	resolver_threads = memory_allocate(HASH_NETWORK, sizeof(thread_t) * resolver_threads_count, 0,
+	                                   MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	NETWORK_COUNT_ALLOCATION(NETWORK_ALLOCATION_OTHER, sizeof(thread_t) * resolver_threads_count);
+	for (size_t ithread = 0; ithread < resolver_threads_count; ++ithread) {
+		thread_initialize(resolver_threads + ithread, network_resolver_worker, nullptr, STRING_CONST("resolver"),
+		                  THREAD_PRIORITY_NORMAL, 0);
+		thread_start(resolver_threads + ithread);
+	}
+
+	return 0;
+}
+
+void
+network_resolver_finalize(void) {
+	mutex_lock(resolver_lock);
+	resolver_terminate = true;
+	mutex_unlock(resolver_lock);
+
+	for (size_t ithread = 0; ithread < resolver_threads_count; ++ithread)
+		semaphore_post(&resolver_jobs);
+	for (size_t ithread = 0; ithread < resolver_threads_count; ++ithread) {
+		thread_join(resolver_threads + ithread);
+		thread_finalize(resolver_threads + ithread);
+	}
+	memory_deallocate(resolver_threads);
+	resolver_threads = nullptr;
+	resolver_threads_count = 0;
+
+	// Requests still queued when terminating are dropped without callback
+	for (size_t ientry = 0; ientry < resolver_entries_count; ++ientry)
+		network_resolver_entry_clear(resolver_entries + ientry);
+	memory_deallocate(resolver_entries);
+	hashtable64_deallocate(resolver_table);
+	array_deallocate(resolver_queue);
+	resolver_entries = nullptr;
+	resolver_table = nullptr;
+	resolver_entries_count = 0;
+	resolver_entries_capacity = 0;
+
+	semaphore_finalize(&resolver_jobs);
+	mutex_deallocate(resolver_lock);
+	resolver_lock = nullptr;
+}
+
+bool
+network_resolver_cache_lookup(const char* address, size_t length, network_address_t*** addresses) {
+	network_resolver_entry_t* entry;
+	network_resolver_result_t* result = nullptr;
+	hash_t key;
+	tick_t now;
+	bool found = false;
+
+	if (!resolver_lock)
+		return false;
+
+	key = network_resolver_key(address, length);
+	now = time_current();
+
+	mutex_lock(resolver_lock);
+	entry = network_resolver_find(key, address, length);
+	if (entry && !entry->pending && (entry->expires > now)) {
+		entry->used = now;
+		result = network_resolver_result_acquire(entry->result);
+		found = true;
+	}
+	mutex_unlock(resolver_lock);
+
+	if (found)
+		*addresses = network_resolver_result_take(result);
+
+	return found;
+}
+
+void
+network_resolver_cache_store(const char* address, size_t length, network_address_t** addresses) {
+	network_resolver_entry_t* entry;
+	hash_t key;
+	tick_t now;
+
+	if (!resolver_lock)
+		return;
+
+	key = network_resolver_key(address, length);
+	now = time_current();
+	addresses = network_resolver_clone_addresses(addresses);
+
+	mutex_lock(resolver_lock);
+	entry = network_resolver_find(key, address, length);
+	if (!entry)
+		entry = network_resolver_allocate(key, address, length, now);
+	// In-flight entries are completed by the worker thread
+	if (entry && !entry->pending) {
+		entry->used = now;
+		network_resolver_complete(entry, addresses);
+		addresses = nullptr;
+	}
+	mutex_unlock(resolver_lock);
+
+	network_address_array_deallocate(addresses);
+}
+
+bool
+network_address_resolve_async(const char* address, size_t length, network_resolve_fn callback, void* userdata) {
+	network_resolver_request_t request = {callback, userdata};
+	network_resolver_entry_t* entry;
+	network_resolver_result_t* result;
+	network_address_ipv6_t numeric;
+	hash_t key;
+	tick_t now;
+
+	if (!address || !callback)
+		return false;
+
+	if (network_address_parse((network_address_t*)&numeric, address, length)) {
+		callback(address, length, network_address_resolve(address, length), userdata);
+		return true;
+	}
+
+	if (!resolver_lock || !resolver_threads_count) {
+		callback(address, length, network_address_resolve(address, length), userdata);
+		return true;
+	}
+
+	key = network_resolver_key(address, length);
+	now = time_current();
+
+	mutex_lock(resolver_lock);
+	entry = network_resolver_find(key, address, length);
+	if (entry && !entry->pending && (entry->expires <= now)) {
+		network_resolver_result_release(entry->result);
+		entry->result = nullptr;
+		entry->pending = true;
+		array_push(resolver_queue, (size_t)(entry - resolver_entries));
+		semaphore_post(&resolver_jobs);
+	} else if (!entry) {
+		entry = network_resolver_allocate(key, address, length, now);
+		if (!entry) {
+			mutex_unlock(resolver_lock);
+			log_warnf(HASH_NETWORK, WARNING_RESOURCE,
+			          STRING_CONST("Unable to queue resolve of '%.*s', all resolver cache entries in-flight"),
+			          (int)length, address);
+			return false;
+		}
+		entry->pending = true;
+		array_push(resolver_queue, (size_t)(entry - resolver_entries));
+		semaphore_post(&resolver_jobs);
+	}
+
+	if (entry->pending) {
+		// Merge with the in-flight resolve of the same address
+		array_push(entry->requests, request);
+		mutex_unlock(resolver_lock);
+		return true;
+	}
+
+	entry->used = now;
+	result = network_resolver_result_acquire(entry->result);
+	mutex_unlock(resolver_lock);
+
+	callback(address, length, network_resolver_result_take(result), userdata);
+	return true;
+}
+
+void
+network_resolver_cache_clear(void) {
+	if (!resolver_lock)
+		return;
+
+	mutex_lock(resolver_lock);
+	for (size_t ientry = 0; ientry < resolver_entries_count; ++ientry) {
+		network_resolver_entry_t* entry = resolver_entries + ientry;
+		if (!entry->pending) {
+			network_resolver_result_release(entry->result);
+			entry->result = nullptr;
+			entry->expires = 0;
+		}
+	}
+	mutex_unlock(resolver_lock);
+}
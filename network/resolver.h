@@ -0,0 +1,36 @@
+/* resolver.h  -  Network library  -  Public Domain  -  2013 Mattias Jansson
+ *
+ * This library provides a network abstraction built on foundation streams. The latest source code is
+ * always available at
+ *
+ * https://github.com/mjansson/network_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any restrictions.
+ *
+ */
+
+#pragma once
+
+/*! \file resolver.h
+    Asynchronous address resolver and resolve result cache */
+
+#include <foundation/platform.h>
+
+#include <network/types.h>
+
+/*! Resolve the given address asynchronously on a resolver worker thread. If the result is
+available in the resolve cache the callback is called directly on the calling thread,
+otherwise it is called on a resolver worker thread once the resolve completes. Concurrent
+resolves of the same address are merged into a single lookup. The callback takes ownership
+of the address array and must deallocate it with #network_address_array_deallocate.
+\param address Address string, see #network_address_resolve
+\param length Length of address string
+\param callback Callback receiving the result (null array if resolve failed)
+\param userdata User data passed to callback
+\return true if resolve was completed or queued, false if the resolver queue is full */
+NETWORK_API bool
+network_address_resolve_async(const char* address, size_t length, network_resolve_fn callback, void* userdata);
+
+/*! Clear all completed results from the resolve cache. In-flight resolves are not affected. */
+NETWORK_API void
+network_resolver_cache_clear(void);
@@ -0,0 +1,124 @@
+/* sampler.c  -  Network library  -  Public Domain  -  2013 Mattias Jansson
+ *
+ * This library provides a network abstraction built on foundation streams. The latest source code is
+ * always available at
+ *
+ * https://github.com/mjansson/network_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any restrictions.
+ *
+ */
+
+#include <network/sampler.h>
+#include <network/address.h>
+#include <network/tcp.h>
+#include <network/internal.h>
+
+#include <foundation/foundation.h>
+
+network_sampler_t*
+network_sampler_allocate(network_poll_t* poll, unsigned int intervalms, size_t capacity) {
+	network_sampler_t* sampler =
+	    memory_allocate(HASH_NETWORK, sizeof(network_sampler_t), 0, MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	NETWORK_COUNT_ALLOCATION(NETWORK_ALLOCATION_OTHER, sizeof(network_sampler_t));
+	network_sampler_initialize(sampler, poll, intervalms, capacity);
+	return sampler;
+}
+
+void
+network_sampler_initialize(network_sampler_t* sampler, network_poll_t* poll, unsigned int intervalms,
+                           size_t capacity) {
+	sampler->poll = poll;
+	sampler->interval = ((tick_t)intervalms * time_ticks_per_second()) / 1000;
+	if (!sampler->interval)
+		sampler->interval = 1;
+	sampler->next = time_current() + sampler->interval;
+	sampler->capacity = capacity ? capacity : 1;
+	sampler->read = 0;
+	sampler->write = 0;
+	sampler->samples =
+	    memory_allocate(HASH_NETWORK, sizeof(network_tcp_sample_t) * sampler->capacity, 0, MEMORY_PERSISTENT);
+	NETWORK_COUNT_ALLOCATION(NETWORK_ALLOCATION_OTHER, sizeof(network_tcp_sample_t) * sampler->capacity);
+	poll->sampler = sampler;
+}
+
+void
+network_sampler_finalize(network_sampler_t* sampler) {
+	if (sampler->poll && (sampler->poll->sampler == sampler))
+		sampler->poll->sampler = nullptr;
+	sampler->poll = nullptr;
+	memory_deallocate(sampler->samples);
+	sampler->samples = nullptr;
+}
+
+void
+network_sampler_deallocate(network_sampler_t* sampler) {
+	if (!sampler)
+		return;
+	network_sampler_finalize(sampler);
+	memory_deallocate(sampler);
+}
+
+size_t
+network_sampler_update(network_sampler_t* sampler) {
+	tick_t now = time_current();
+	if (now < sampler->next)
+		return 0;
+	// Keep a fixed cadence, but skip intervals missed by a stalled caller instead of bursting
+	sampler->next += sampler->interval;
+	if (sampler->next <= now)
+		sampler->next = now + sampler->interval;
+	return network_sampler_sample(sampler);
+}
+
+size_t
+network_sampler_sample(network_sampler_t* sampler) {
+	network_poll_t* poll = sampler->poll;
+	tick_t timestamp = time_current();
+	size_t sampled = 0;
+
+	if (!poll)
+		return 0;
+
+	for (size_t islot = 0, ssize = poll->sockets_count; islot < ssize; ++islot) {
+		socket_t* sock = poll->slots[islot].sock;
+		network_tcp_sample_t* sample;
+		network_tcp_info_t info;
+
+		if ((sock->type != NETWORK_SOCKETTYPE_TCP) || (sock->state != SOCKETSTATE_CONNECTED))
+			continue;
+		if (!tcp_socket_info(sock, &info))
+			continue;
+
+		sample = sampler->samples + (sampler->write % sampler->capacity);
+		sample->info = info;
+		sample->timestamp = timestamp;
+		sample->socket = sock;
+		if (sock->address_remote)
+			network_address_to_compact(sock->address_remote, &sample->remote);
+		else
+			memset(&sample->remote, 0, sizeof(sample->remote));
+
+		++sampler->write;
+		if (sampler->write - sampler->read > sampler->capacity)
+			sampler->read = sampler->write - sampler->capacity;
+		++sampled;
+	}
+
+	return sampled;
+}
+
+size_t
+network_sampler_read(network_sampler_t* sampler, network_tcp_sample_t* samples, size_t capacity) {
+	size_t count = 0;
+	while ((count < capacity) && (sampler->read < sampler->write)) {
+		samples[count++] = sampler->samples[sampler->read % sampler->capacity];
+		++sampler->read;
+	}
+	return count;
+}
+
+size_t
+network_sampler_available(const network_sampler_t* sampler) {
+	return sampler->write - sampler->read;
+}
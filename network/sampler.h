@@ -0,0 +1,76 @@
+/* sampler.h  -  Network library  -  Public Domain  -  2013 Mattias Jansson
+ *
+ * This library provides a network abstraction built on foundation streams. The latest source code is
+ * always available at
+ *
+ * https://github.com/mjansson/network_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any restrictions.
+ *
+ */
+
+#pragma once
+
+/*! \file sampler.h
+    Periodic sampling of TCP connection statistics for all sockets in a poll object into a ring
+    buffer, for finding slow peers and bufferbloat in running services. */
+
+#include <foundation/platform.h>
+
+#include <network/types.h>
+
+/*! Allocate a sampler and attach it to a poll object. Statistics of all connected TCP sockets
+in the poll are sampled at the given interval from within #network_poll, which wakes up in time
+for each sample. When the ring buffer is full the oldest samples are overwritten.
+\param poll Poll object
+\param intervalms Sample interval in milliseconds
+\param capacity Number of samples in ring buffer
+\return New sampler */
+NETWORK_API network_sampler_t*
+network_sampler_allocate(network_poll_t* poll, unsigned int intervalms, size_t capacity);
+
+/*! Initialize a sampler and attach it to a poll object, see #network_sampler_allocate
+\param sampler Sampler
+\param poll Poll object
+\param intervalms Sample interval in milliseconds
+\param capacity Number of samples in ring buffer */
+NETWORK_API void
+network_sampler_initialize(network_sampler_t* sampler, network_poll_t* poll, unsigned int intervalms,
+                           size_t capacity);
+
+/*! Detach a sampler from the poll object and finalize it
+\param sampler Sampler */
+NETWORK_API void
+network_sampler_finalize(network_sampler_t* sampler);
+
+/*! Finalize and deallocate a sampler
+\param sampler Sampler */
+NETWORK_API void
+network_sampler_deallocate(network_sampler_t* sampler);
+
+/*! Take a sample of all sockets if the sample interval has passed. Called automatically by
+#network_poll on the attached poll object.
+\param sampler Sampler
+\return Number of sockets sampled */
+NETWORK_API size_t
+network_sampler_update(network_sampler_t* sampler);
+
+/*! Take a sample of all sockets in the poll object directly
+\param sampler Sampler
+\return Number of sockets sampled */
+NETWORK_API size_t
+network_sampler_sample(network_sampler_t* sampler);
+
+/*! Read and remove samples from the ring buffer, oldest first
+\param sampler Sampler
+\param samples Destination array
+\param capacity Capacity of destination array
+\return Number of samples read */
+NETWORK_API size_t
+network_sampler_read(network_sampler_t* sampler, network_tcp_sample_t* samples, size_t capacity);
+
+/*! Get number of samples in the ring buffer
+\param sampler Sampler
+\return Number of samples available to read */
+NETWORK_API size_t
+network_sampler_available(const network_sampler_t* sampler);
@@ -0,0 +1,802 @@
+/* shm.c  -  Network library  -  Public Domain  -  2013 Mattias Jansson
+ *
+ * This library provides a network abstraction built on foundation streams. The latest source code is
+ * always available at
+ *
+ * https://github.com/mjansson/network_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any restrictions.
+ *
+ */
+
+#include <network/shm.h>
+#include <network/address.h>
+#include <network/socket.h>
+#include <network/unix.h>
+#include <network/tcp.h>
+#include <network/internal.h>
+
+#include <foundation/foundation.h>
+
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+#include <sys/stat.h>
+#define NETWORK_SHM_SUPPORTED 1
+#else
+#define NETWORK_SHM_SUPPORTED 0
+#endif
+
+#define NETWORK_SHM_MAGIC 0x4e53484dU
+#define NETWORK_SHM_VERSION 1
+#define NETWORK_SHM_RING_SIZE (256 * 1024)
+#define NETWORK_SHM_CACHE_LINE 64
+
+#if NETWORK_SHM_SUPPORTED
+
+// Ring control block in shared memory. Positions are free running byte counters, producer and
+// consumer positions are on separate cache lines to avoid false sharing. The wait flags are set by
+// an end before sleeping on its event handle and cleared by the other end when signalling it.
+typedef struct shm_ring_t {
+	atomic64_t head;
+	char head_pad[NETWORK_SHM_CACHE_LINE - sizeof(atomic64_t)];
+	atomic64_t tail;
+	char tail_pad[NETWORK_SHM_CACHE_LINE - sizeof(atomic64_t)];
+	atomic32_t data_wait;
+	atomic32_t space_wait;
+	atomic32_t closed;
+	char flags_pad[NETWORK_SHM_CACHE_LINE - (3 * sizeof(atomic32_t))];
+} shm_ring_t;
+
+// Segment layout is the header, the server to client ring, the client to server ring and
+// then the data buffers of the two rings
+typedef struct shm_header_t {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t ring_size;
+	//! Number of ends referencing an in-process segment
+	atomic32_t refs;
+	char pad[NETWORK_SHM_CACHE_LINE - 16 - sizeof(atomic32_t)];
+	shm_ring_t ring[2];
+} shm_header_t;
+
+typedef struct shm_transport_t {
+	shm_header_t* header;
+	//! Size of mapped segment, zero for an in-process segment
+	size_t mapping_size;
+	size_t ring_size;
+	shm_ring_t* rx;
+	shm_ring_t* tx;
+	uint8_t* rx_data;
+	uint8_t* tx_data;
+	//! Event handle of the peer
+	int fd_peer;
+	//! Set if the own event handle was cleared and must be signalled again if data remains
+	bool cleared;
+	//! Set if the rings hold length prefixed datagrams instead of a byte stream
+	bool datagram;
+	//! Space needed in the transmit ring by the last failed write
+	size_t space_need;
+} shm_transport_t;
+
+static size_t
+shm_socket_read(socket_t* sock, void* buffer, size_t size);
+
+static size_t
+shm_socket_send(socket_t* sock, const void* buffer, size_t size, int flags);
+
+static int
+shm_socket_available(const socket_t* sock);
+
+static int
+shm_socket_wait(socket_t* sock, bool write, unsigned int timeoutms);
+
+static size_t
+shm_socket_recvfrom(socket_t* sock, void* buffer, size_t capacity, const network_address_t** address);
+
+static size_t
+shm_socket_sendto(socket_t* sock, const void* buffer, size_t size, const network_address_t* address);
+
+static void
+shm_socket_close(socket_t* sock);
+
+static const socket_vtable_t shm_socket_vtable = {shm_socket_read,    shm_socket_send,     shm_socket_available,
+                                                   shm_socket_wait,    shm_socket_recvfrom, shm_socket_sendto,
+                                                   shm_socket_close};
+
+//! Port counter for the synthetic addresses of in-process pairs
+static atomic32_t shm_pair_port;
+
+#endif
+
+static void
+shm_socket_open(socket_t*, unsigned int);
+
+static void
+shm_stream_initialize(socket_t*, stream_t*);
+
+socket_t*
+shm_socket_allocate(void) {
+	socket_t* sock = memory_allocate(HASH_NETWORK, sizeof(socket_t), 0, MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	NETWORK_COUNT_ALLOCATION(NETWORK_ALLOCATION_SOCKET, sizeof(socket_t));
+	shm_socket_initialize(sock);
+	return sock;
+}
+
+void
+shm_socket_initialize(socket_t* sock) {
+	socket_initialize(sock);
+
+	sock->type = NETWORK_SOCKETTYPE_SHM;
+	sock->family = NETWORK_ADDRESSFAMILY_UNIX;
+	sock->open_fn = shm_socket_open;
+	sock->stream_initialize_fn = shm_stream_initialize;
+}
+
+static void
+shm_socket_open(socket_t* sock, unsigned int family) {
+	// The event handle is created by the handshake, shared memory sockets can not be bound
+	log_errorf(HASH_NETWORK, ERROR_UNSUPPORTED,
+	           STRING_CONST("Unable to open shared memory socket (0x%" PRIfixPTR "): Use shm_socket_connect"),
+	           (uintptr_t)sock);
+	FOUNDATION_UNUSED(family);
+}
+
+static void
+shm_stream_initialize(socket_t* sock, stream_t* stream) {
+	bool datagram = (sock->type == NETWORK_SOCKETTYPE_SHM_DGRAM);
+	stream->inorder = 1;
+	stream->reliable = 1;
+	stream->path =
+	    string_allocate_format(STRING_CONST("%s://%" PRIfixPTR), datagram ? "shmgram" : "shm", (uintptr_t)sock);
+	NETWORK_COUNT_ALLOCATION(NETWORK_ALLOCATION_STREAM_PATH, stream->path.length + 1);
+}
+
+#if NETWORK_SHM_SUPPORTED
+
+static void
+shm_notify(int fd) {
+	uint64_t value = 1;
+	if (write(fd, &value, sizeof(value)) < 0) {
+		// Counter overflow can not happen with single increments, event is already signalled
+	}
+}
+
+static void
+shm_notify_clear(int fd) {
+	uint64_t value;
+	if (read(fd, &value, sizeof(value)) < 0) {
+		// Not signalled
+	}
+}
+
+static uint64_t
+shm_ring_used(shm_ring_t* ring) {
+	uint64_t head = (uint64_t)atomic_load64(&ring->head, memory_order_acquire);
+	uint64_t tail = (uint64_t)atomic_load64(&ring->tail, memory_order_acquire);
+	return head - tail;
+}
+
+static void
+shm_ring_copy_out(const shm_transport_t* shm, uint64_t position, void* buffer, size_t count) {
+	size_t offset = (size_t)(position & (shm->ring_size - 1));
+	size_t first = shm->ring_size - offset;
+	if (first > count)
+		first = count;
+	memcpy(buffer, shm->rx_data + offset, first);
+	if (count > first)
+		memcpy(pointer_offset(buffer, first), shm->rx_data, count - first);
+}
+
+static void
+shm_ring_copy_in(shm_transport_t* shm, uint64_t position, const void* buffer, size_t count) {
+	size_t offset = (size_t)(position & (shm->ring_size - 1));
+	size_t first = shm->ring_size - offset;
+	if (first > count)
+		first = count;
+	memcpy(shm->tx_data + offset, buffer, first);
+	if (count > first)
+		memcpy(shm->tx_data, pointer_offset_const(buffer, first), count - first);
+}
+
+// Read from the receive ring, a single datagram in datagram mode. When the ring is empty the own event
+// handle is cleared and the producer asked to signal it on the next write, rechecking the ring after
+// arming to not miss a write in between
+static size_t
+shm_transport_read(socket_t* sock, shm_transport_t* shm, void* buffer, size_t size) {
+	shm_ring_t* ring = shm->rx;
+	uint64_t tail = (uint64_t)atomic_load64(&ring->tail, memory_order_relaxed);
+	uint64_t head = (uint64_t)atomic_load64(&ring->head, memory_order_acquire);
+	size_t count, consumed;
+
+	if (head == tail) {
+		// Already armed with a cleared event handle unless signalled since, nothing to do until then
+		if (!shm->cleared || !atomic_load32(&ring->data_wait, memory_order_relaxed)) {
+			shm_notify_clear(sock->fd);
+			shm->cleared = true;
+			atomic_store32(&ring->data_wait, 1, memory_order_relaxed);
+			atomic_thread_fence_sequentially_consistent();
+			head = (uint64_t)atomic_load64(&ring->head, memory_order_acquire);
+		}
+		if (head == tail)
+			return 0;
+	}
+
+	if (shm->datagram) {
+		// Datagrams larger than the buffer are truncated
+		uint32_t length;
+		shm_ring_copy_out(shm, tail, &length, sizeof(length));
+		count = (length < size) ? length : size;
+		shm_ring_copy_out(shm, tail + sizeof(length), buffer, count);
+		consumed = sizeof(length) + length;
+	} else {
+		count = (size_t)(head - tail);
+		if (count > size)
+			count = size;
+		shm_ring_copy_out(shm, tail, buffer, count);
+		consumed = count;
+	}
+	atomic_store64(&ring->tail, (int64_t)(tail + consumed), memory_order_release);
+
+	atomic_thread_fence_sequentially_consistent();
+	if (atomic_load32(&ring->space_wait, memory_order_relaxed) &&
+	    atomic_cas32(&ring->space_wait, 0, 1, memory_order_acq_rel, memory_order_relaxed))
+		shm_notify(shm->fd_peer);
+
+	// Keep the event handle signalled while data remains for level triggered polling
+	if (shm->cleared && (head != tail + consumed)) {
+		shm->cleared = false;
+		shm_notify(sock->fd);
+	}
+
+	return count;
+}
+
+// Write to the transmit ring, all or nothing in datagram mode
+static size_t
+shm_transport_write(shm_transport_t* shm, const void* buffer, size_t size) {
+	shm_ring_t* ring = shm->tx;
+	size_t prefix = shm->datagram ? sizeof(uint32_t) : 0;
+	size_t need = shm->datagram ? prefix + size : 1;
+	uint64_t head = (uint64_t)atomic_load64(&ring->head, memory_order_relaxed);
+	uint64_t tail = (uint64_t)atomic_load64(&ring->tail, memory_order_acquire);
+	size_t space = shm->ring_size - (size_t)(head - tail);
+	size_t count;
+
+	if (space < need) {
+		atomic_store32(&ring->space_wait, 1, memory_order_relaxed);
+		atomic_thread_fence_sequentially_consistent();
+		tail = (uint64_t)atomic_load64(&ring->tail, memory_order_acquire);
+		space = shm->ring_size - (size_t)(head - tail);
+		if (space < need) {
+			shm->space_need = need;
+			return 0;
+		}
+	}
+	shm->space_need = 1;
+
+	count = (size < space - prefix) ? size : space - prefix;
+	if (prefix) {
+		uint32_t length = (uint32_t)size;
+		shm_ring_copy_in(shm, head, &length, sizeof(length));
+	}
+	shm_ring_copy_in(shm, head + prefix, buffer, count);
+	atomic_store64(&ring->head, (int64_t)(head + prefix + count), memory_order_release);
+
+	atomic_thread_fence_sequentially_consistent();
+	if (atomic_load32(&ring->data_wait, memory_order_relaxed) &&
+	    atomic_cas32(&ring->data_wait, 0, 1, memory_order_acq_rel, memory_order_relaxed))
+		shm_notify(shm->fd_peer);
+
+	return count;
+}
+
+static bool
+shm_transport_ready(shm_transport_t* shm, bool write) {
+	if (write)
+		return atomic_load32(&shm->tx->closed, memory_order_acquire) ||
+		       (shm_ring_used(shm->tx) + shm->space_need <= shm->ring_size);
+	return atomic_load32(&shm->rx->closed, memory_order_acquire) || shm_ring_used(shm->rx);
+}
+
+static unsigned int
+shm_socket_busy_poll(const socket_t* sock) {
+	int usec = (sock->options_set & (1U << NETWORK_SOCKETOPTION_BUSY_POLL)) ?
+	               sock->options[NETWORK_SOCKETOPTION_BUSY_POLL] :
+	               network_config.socket_options[NETWORK_SOCKETOPTION_BUSY_POLL];
+	return (usec > 0) ? (unsigned int)usec : 0;
+}
+
+static size_t
+shm_socket_read(socket_t* sock, void* buffer, size_t size) {
+	while (sock->fd != NETWORK_SOCKET_INVALID) {
+		shm_transport_t* shm = sock->transport;
+		size_t read = shm_transport_read(sock, shm, buffer, size);
+		if (read)
+			return read;
+		if (atomic_load32(&shm->rx->closed, memory_order_acquire) && !shm_ring_used(shm->rx)) {
+			// Datagram sockets are connectionless, a closed peer is like an unreachable one
+			if (shm->datagram)
+				break;
+			log_debugf(HASH_NETWORK, STRING_CONST("Shared memory socket closed on remote end (0x%" PRIfixPTR " : %d)"),
+			           (uintptr_t)sock, sock->fd);
+			socket_close(sock);
+			break;
+		}
+		if (!(sock->flags & SOCKETFLAG_BLOCKING) || (shm_socket_wait(sock, false, NETWORK_TIMEOUT_INFINITE) < 0))
+			break;
+	}
+	return 0;
+}
+
+static size_t
+shm_socket_send(socket_t* sock, const void* buffer, size_t size, int flags) {
+	size_t total_write = 0;
+	FOUNDATION_UNUSED(flags);
+	if (((shm_transport_t*)sock->transport)->datagram)
+		return shm_socket_sendto(sock, buffer, size, sock->address_remote);
+	while ((sock->fd != NETWORK_SOCKET_INVALID) && (total_write < size)) {
+		shm_transport_t* shm = sock->transport;
+		if (atomic_load32(&shm->tx->closed, memory_order_acquire)) {
+			log_debugf(HASH_NETWORK, STRING_CONST("Shared memory socket closed on remote end (0x%" PRIfixPTR " : %d)"),
+			           (uintptr_t)sock, sock->fd);
+			socket_close(sock);
+			break;
+		}
+		size_t written = shm_transport_write(shm, pointer_offset_const(buffer, total_write), size - total_write);
+		total_write += written;
+		if (!written &&
+		    (!(sock->flags & SOCKETFLAG_BLOCKING) || (shm_socket_wait(sock, true, NETWORK_TIMEOUT_INFINITE) < 0)))
+			break;
+	}
+	return total_write;
+}
+
+static size_t
+shm_socket_recvfrom(socket_t* sock, void* buffer, size_t capacity, const network_address_t** address) {
+	size_t read = shm_socket_read(sock, buffer, capacity);
+	if (read && address)
+		*address = sock->address_remote;
+	return read;
+}
+
+static size_t
+shm_socket_sendto(socket_t* sock, const void* buffer, size_t size, const network_address_t* address) {
+	shm_transport_t* shm = sock->transport;
+	if (!shm->datagram || !address || !network_address_equal(address, sock->address_remote))
+		return 0;
+	if (size > shm->ring_size - sizeof(uint32_t)) {
+		log_warnf(HASH_NETWORK, WARNING_INVALID_VALUE,
+		          STRING_CONST("Datagram of %" PRIsize " bytes larger than ring on socket (0x%" PRIfixPTR " : %d)"),
+		          size, (uintptr_t)sock, sock->fd);
+		return 0;
+	}
+	while (!atomic_load32(&shm->tx->closed, memory_order_acquire)) {
+		if (shm_transport_write(shm, buffer, size) || !size)
+			return size;
+		if (!(sock->flags & SOCKETFLAG_BLOCKING) || (shm_socket_wait(sock, true, NETWORK_TIMEOUT_INFINITE) < 0))
+			break;
+	}
+	return 0;
+}
+
+static int
+shm_socket_available(const socket_t* sock) {
+	shm_transport_t* shm = sock->transport;
+	uint64_t used = shm_ring_used(shm->rx);
+	if (!used && atomic_load32(&shm->rx->closed, memory_order_acquire))
+		return -1;
+	return (used > INT32_MAX) ? INT32_MAX : (int)used;
+}
+
+static int
+shm_socket_wait(socket_t* sock, bool write, unsigned int timeoutms) {
+	shm_transport_t* shm = sock->transport;
+	unsigned int busy_poll = shm_socket_busy_poll(sock);
+	tick_t deadline = 0;
+	int ret = 1;
+
+	if (shm_transport_ready(shm, write))
+		return 1;
+
+	if (busy_poll) {
+		tick_t spin_end = time_current() + (((tick_t)busy_poll * time_ticks_per_second()) / 1000000);
+		do {
+			if (shm_transport_ready(shm, write))
+				return 1;
+		} while (time_current() < spin_end);
+	}
+
+	if ((timeoutms != NETWORK_TIMEOUT_INFINITE) && timeoutms)
+		deadline = time_current() + (((tick_t)timeoutms * time_ticks_per_second()) / 1000);
+
+	while (true) {
+		unsigned int waitms = timeoutms;
+
+		// Arm the wait flag and recheck, the peer signals the event handle if it sees the flag set. The
+		// event handle also carries data signals, so the data flag is armed whenever it is cleared or a
+		// write wait could leave a poll driven reader without a signal for data arriving later
+		shm_notify_clear(sock->fd);
+		shm->cleared = true;
+		atomic_store32(&shm->rx->data_wait, 1, memory_order_relaxed);
+		if (write)
+			atomic_store32(&shm->tx->space_wait, 1, memory_order_relaxed);
+		atomic_thread_fence_sequentially_consistent();
+		if (shm_transport_ready(shm, write))
+			break;
+
+		if (deadline) {
+			tick_t now = time_current();
+			if (now >= deadline) {
+				ret = 0;
+				break;
+			}
+			waitms = (unsigned int)((((deadline - now) * 1000) + time_ticks_per_second() - 1) /
+			                        time_ticks_per_second());
+		}
+		ret = socket_wait_fd(sock->fd, false, waitms);
+		if ((ret < 0) || (!ret && (timeoutms != NETWORK_TIMEOUT_INFINITE)))
+			break;
+	}
+
+	// Waiting for space can consume a data signal, restore it if data is pending
+	if (shm->cleared && shm_ring_used(shm->rx)) {
+		shm->cleared = false;
+		shm_notify(sock->fd);
+	}
+
+	return ret;
+}
+
+static void
+shm_socket_close(socket_t* sock) {
+	shm_transport_t* shm = sock->transport;
+	if (!shm)
+		return;
+
+	atomic_store32(&shm->tx->closed, 1, memory_order_release);
+	atomic_store32(&shm->rx->closed, 1, memory_order_release);
+	shm_notify(shm->fd_peer);
+
+	if (shm->mapping_size)
+		munmap(shm->header, shm->mapping_size);
+	else if (atomic_decr32(&shm->header->refs, memory_order_acq_rel) == 0)
+		memory_deallocate(shm->header);
+	close(shm->fd_peer);
+	memory_deallocate(shm);
+	sock->transport = nullptr;
+	sock->vtable = nullptr;
+}
+
+static size_t
+shm_ring_size(void) {
+	size_t size = network_config.shm_ring_size ? network_config.shm_ring_size : NETWORK_SHM_RING_SIZE;
+	size_t ring_size = 4096;
+	while (ring_size < size)
+		ring_size <<= 1;
+	return ring_size;
+}
+
+// Initialize a new segment. Both ends start out waiting for data with cleared event handles, so the
+// first write signals the peer
+static void
+shm_header_initialize(shm_header_t* header, size_t ring_size) {
+	header->magic = NETWORK_SHM_MAGIC;
+	header->version = NETWORK_SHM_VERSION;
+	header->ring_size = ring_size;
+	atomic_store32(&header->ring[0].data_wait, 1, memory_order_relaxed);
+	atomic_store32(&header->ring[1].data_wait, 1, memory_order_relaxed);
+}
+
+// Take ownership of the mapped segment and event handles and mark the socket connected
+static void
+shm_socket_establish(socket_t* sock, shm_header_t* header, size_t mapping_size, int fd, int fd_peer, bool server) {
+	shm_transport_t* shm =
+	    memory_allocate(HASH_NETWORK, sizeof(shm_transport_t), 0, MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	NETWORK_COUNT_ALLOCATION(NETWORK_ALLOCATION_TRANSPORT, sizeof(shm_transport_t));
+	uint8_t* data = pointer_offset(header, sizeof(shm_header_t));
+
+	shm->header = header;
+	shm->mapping_size = mapping_size;
+	shm->ring_size = (size_t)header->ring_size;
+	shm->tx = &header->ring[server ? 0 : 1];
+	shm->rx = &header->ring[server ? 1 : 0];
+	shm->tx_data = data + (server ? 0 : shm->ring_size);
+	shm->rx_data = data + (server ? shm->ring_size : 0);
+	shm->fd_peer = fd_peer;
+	shm->space_need = 1;
+	shm->cleared = true;
+
+	sock->fd = fd;
+	sock->transport = shm;
+	sock->vtable = &shm_socket_vtable;
+	sock->family = NETWORK_ADDRESSFAMILY_UNIX;
+	socket_set_state(sock, SOCKETSTATE_CONNECTED);
+
+	log_debugf(HASH_NETWORK,
+	           STRING_CONST("Established shared memory socket (0x%" PRIfixPTR " : %d) with %" PRIsize " byte rings"),
+	           (uintptr_t)sock, sock->fd, shm->ring_size);
+}
+
+typedef struct shm_handshake_t {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t ring_size;
+} shm_handshake_t;
+
+#define NETWORK_SHM_HANDSHAKE_FDS 3
+
+#endif
+
+socket_t*
+shm_socket_accept(socket_t* listener, unsigned int timeoutms) {
+#if NETWORK_SHM_SUPPORTED
+	socket_t* conn;
+	socket_t* sock = nullptr;
+	size_t ring_size = shm_ring_size();
+	size_t mapping_size = sizeof(shm_header_t) + (2 * ring_size);
+	shm_header_t* header = MAP_FAILED;
+	shm_handshake_t handshake;
+	int fds[NETWORK_SHM_HANDSHAKE_FDS] = {-1, -1, -1};
+	struct msghdr msg;
+	struct iovec iov;
+	struct cmsghdr* cmsg;
+	union {
+		char buffer[CMSG_SPACE(sizeof(fds))];
+		struct cmsghdr align;
+	} control;
+
+	if (listener->type != NETWORK_SOCKETTYPE_UNIX_STREAM) {
+		log_errorf(HASH_NETWORK, ERROR_INVALID_VALUE,
+		           STRING_CONST("Unable to accept shared memory socket on (0x%" PRIfixPTR " : %d): Not a unix stream "
+		                        "socket"),
+		           (uintptr_t)listener, listener->fd);
+		return nullptr;
+	}
+
+	conn = tcp_socket_accept(listener, timeoutms);
+	if (!conn)
+		return nullptr;
+
+	// Segment, server event handle and client event handle
+	fds[0] = memfd_create("network_shm", MFD_CLOEXEC);
+	fds[1] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	fds[2] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if ((fds[0] < 0) || (fds[1] < 0) || (fds[2] < 0) || (ftruncate(fds[0], (off_t)mapping_size) < 0) ||
+	    ((header = mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, fds[0], 0)) == MAP_FAILED)) {
+		int err = errno;
+		string_const_t errmsg = system_error_message(err);
+		log_errorf(HASH_NETWORK, ERROR_SYSTEM_CALL_FAIL,
+		           STRING_CONST("Unable to create shared memory segment for socket (0x%" PRIfixPTR " : %d): %.*s (%d)"),
+		           (uintptr_t)conn, conn->fd, STRING_FORMAT(errmsg), err);
+		goto exit;
+	}
+
+	shm_header_initialize(header, ring_size);
+
+	handshake.magic = NETWORK_SHM_MAGIC;
+	handshake.version = NETWORK_SHM_VERSION;
+	handshake.ring_size = ring_size;
+
+	memset(&msg, 0, sizeof(msg));
+	memset(&control, 0, sizeof(control));
+	iov.iov_base = &handshake;
+	iov.iov_len = sizeof(handshake);
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control.buffer;
+	msg.msg_controllen = sizeof(control.buffer);
+	cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+	memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+	if (sendmsg(conn->fd, &msg, MSG_NOSIGNAL) != (ssize_t)sizeof(handshake)) {
+		int err = errno;
+		string_const_t errmsg = system_error_message(err);
+		log_warnf(HASH_NETWORK, WARNING_SYSTEM_CALL_FAIL,
+		          STRING_CONST("Unable to send shared memory handshake on socket (0x%" PRIfixPTR " : %d): %.*s (%d)"),
+		          (uintptr_t)conn, conn->fd, STRING_FORMAT(errmsg), err);
+		goto exit;
+	}
+
+	sock = shm_socket_allocate();
+	shm_socket_establish(sock, header, mapping_size, fds[1], fds[2], true);
+	header = MAP_FAILED;
+	fds[1] = fds[2] = -1;
+
+	sock->address_local = conn->address_local;
+	sock->address_remote = conn->address_remote;
+	conn->address_local = nullptr;
+	conn->address_remote = nullptr;
+
+exit:
+	if (header != MAP_FAILED)
+		munmap(header, mapping_size);
+	for (int ifd = 0; ifd < NETWORK_SHM_HANDSHAKE_FDS; ++ifd) {
+		if (fds[ifd] >= 0)
+			close(fds[ifd]);
+	}
+	socket_deallocate(conn);
+	return sock;
+#else
+	log_errorf(HASH_NETWORK, ERROR_UNSUPPORTED,
+	           STRING_CONST("Unable to accept shared memory socket on (0x%" PRIfixPTR "): Not supported on platform"),
+	           (uintptr_t)listener);
+	FOUNDATION_UNUSED(timeoutms);
+	return nullptr;
+#endif
+}
+
+bool
+shm_socket_connect(socket_t* sock, const network_address_t* address, unsigned int timeoutms) {
+#if NETWORK_SHM_SUPPORTED
+	socket_t* conn;
+	shm_header_t* header = MAP_FAILED;
+	shm_handshake_t handshake;
+	int fds[NETWORK_SHM_HANDSHAKE_FDS] = {-1, -1, -1};
+	size_t mapping_size = 0;
+	bool success = false;
+	struct msghdr msg;
+	struct iovec iov;
+	struct cmsghdr* cmsg;
+	struct stat st;
+	ssize_t ret;
+	union {
+		char buffer[CMSG_SPACE(sizeof(fds))];
+		struct cmsghdr align;
+	} control;
+
+	FOUNDATION_ASSERT(sock->type == NETWORK_SOCKETTYPE_SHM);
+	if (sock->fd != NETWORK_SOCKET_INVALID)
+		socket_close(sock);
+
+	conn = unix_socket_allocate(NETWORK_SOCKETTYPE_UNIX_STREAM);
+	if (!socket_connect(conn, address, timeoutms) || (socket_wait_fd(conn->fd, false, timeoutms) <= 0))
+		goto exit;
+
+	memset(&msg, 0, sizeof(msg));
+	iov.iov_base = &handshake;
+	iov.iov_len = sizeof(handshake);
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control.buffer;
+	msg.msg_controllen = sizeof(control.buffer);
+	ret = recvmsg(conn->fd, &msg, MSG_CMSG_CLOEXEC);
+
+	for (cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+		if ((cmsg->cmsg_level == SOL_SOCKET) && (cmsg->cmsg_type == SCM_RIGHTS) &&
+		    (cmsg->cmsg_len == CMSG_LEN(sizeof(fds))))
+			memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
+	}
+
+	if ((ret != (ssize_t)sizeof(handshake)) || (fds[0] < 0) || (handshake.magic != NETWORK_SHM_MAGIC) ||
+	    (handshake.version != NETWORK_SHM_VERSION) || !handshake.ring_size ||
+	    (handshake.ring_size & (handshake.ring_size - 1))) {
+		log_warnf(HASH_NETWORK, WARNING_INVALID_VALUE,
+		          STRING_CONST("Invalid shared memory handshake on socket (0x%" PRIfixPTR " : %d)"), (uintptr_t)conn,
+		          conn->fd);
+		goto exit;
+	}
+
+	mapping_size = sizeof(shm_header_t) + (2 * (size_t)handshake.ring_size);
+	if ((fstat(fds[0], &st) < 0) || ((size_t)st.st_size < mapping_size) ||
+	    ((header = mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, fds[0], 0)) == MAP_FAILED) ||
+	    (header->magic != NETWORK_SHM_MAGIC) || (header->ring_size != handshake.ring_size)) {
+		log_warnf(HASH_NETWORK, WARNING_INVALID_VALUE,
+		          STRING_CONST("Invalid shared memory segment on socket (0x%" PRIfixPTR " : %d)"), (uintptr_t)conn,
+		          conn->fd);
+		goto exit;
+	}
+
+	shm_socket_establish(sock, header, mapping_size, fds[2], fds[1], false);
+	header = MAP_FAILED;
+	fds[1] = fds[2] = -1;
+	success = true;
+
+	sock->address_local = conn->address_local;
+	sock->address_remote = conn->address_remote;
+	conn->address_local = nullptr;
+	conn->address_remote = nullptr;
+
+exit:
+	if (header != MAP_FAILED)
+		munmap(header, mapping_size);
+	for (int ifd = 0; ifd < NETWORK_SHM_HANDSHAKE_FDS; ++ifd) {
+		if (fds[ifd] >= 0)
+			close(fds[ifd]);
+	}
+	socket_deallocate(conn);
+	return success;
+#else
+	log_errorf(HASH_NETWORK, ERROR_UNSUPPORTED,
+	           STRING_CONST("Unable to connect shared memory socket (0x%" PRIfixPTR "): Not supported on platform"),
+	           (uintptr_t)sock);
+	FOUNDATION_UNUSED(address);
+	FOUNDATION_UNUSED(timeoutms);
+	return false;
+#endif
+}
+
+#if NETWORK_SHM_SUPPORTED
+
+// Give an in-process socket a unique IPv4 loopback address so protocol code can address it
+static network_address_t*
+shm_socket_pair_address(void) {
+	network_address_ipv4_t address;
+	unsigned int port = (unsigned int)atomic_incr32(&shm_pair_port, memory_order_relaxed);
+	network_address_ipv4_initialize(&address);
+	network_address_ipv4_set_ip((network_address_t*)&address, network_address_ipv4_make_ip(127, 0, 0, 1));
+	network_address_ip_set_port((network_address_t*)&address, 1 + (port % 65535));
+	return network_address_clone((const network_address_t*)&address);
+}
+
+#endif
+
+bool
+shm_socket_pair(socket_t** first, socket_t** second, bool datagram) {
+#if NETWORK_SHM_SUPPORTED
+	size_t ring_size = shm_ring_size();
+	shm_header_t* header;
+	int fds[4] = {-1, -1, -1, -1};
+
+	*first = nullptr;
+	*second = nullptr;
+
+	// Own event handle of each end and a duplicate of it owned by the other end
+	fds[0] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	fds[1] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if ((fds[0] >= 0) && (fds[1] >= 0)) {
+		fds[2] = fcntl(fds[1], F_DUPFD_CLOEXEC, 0);
+		fds[3] = fcntl(fds[0], F_DUPFD_CLOEXEC, 0);
+	}
+	if ((fds[2] < 0) || (fds[3] < 0)) {
+		int err = errno;
+		string_const_t errmsg = system_error_message(err);
+		log_errorf(HASH_NETWORK, ERROR_SYSTEM_CALL_FAIL,
+		           STRING_CONST("Unable to create event handles for shared memory socket pair: %.*s (%d)"),
+		           STRING_FORMAT(errmsg), err);
+		for (int ifd = 0; ifd < 4; ++ifd) {
+			if (fds[ifd] >= 0)
+				close(fds[ifd]);
+		}
+		return false;
+	}
+
+	header = memory_allocate(HASH_NETWORK, sizeof(shm_header_t) + (2 * ring_size), NETWORK_SHM_CACHE_LINE,
+	                         MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	NETWORK_COUNT_ALLOCATION(NETWORK_ALLOCATION_TRANSPORT, sizeof(shm_header_t) + (2 * ring_size));
+	shm_header_initialize(header, ring_size);
+	atomic_store32(&header->refs, 2, memory_order_release);
+
+	*first = shm_socket_allocate();
+	*second = shm_socket_allocate();
+	shm_socket_establish(*first, header, 0, fds[0], fds[2], true);
+	shm_socket_establish(*second, header, 0, fds[1], fds[3], false);
+
+	(*first)->address_local = shm_socket_pair_address();
+	(*second)->address_local = shm_socket_pair_address();
+	(*first)->address_remote = network_address_clone((*second)->address_local);
+	(*second)->address_remote = network_address_clone((*first)->address_local);
+	(*first)->family = (*second)->family = NETWORK_ADDRESSFAMILY_IPV4;
+
+	if (datagram) {
+		socket_t* socks[2] = {*first, *second};
+		for (int isock = 0; isock < 2; ++isock) {
+			socks[isock]->type = NETWORK_SOCKETTYPE_SHM_DGRAM;
+			((shm_transport_t*)socks[isock]->transport)->datagram = true;
+			socket_set_state(socks[isock], SOCKETSTATE_NOTCONNECTED);
+		}
+	}
+
+	return true;
+#else
+	log_errorf(HASH_NETWORK, ERROR_UNSUPPORTED,
+	           STRING_CONST("Unable to create shared memory socket pair: Not supported on platform"));
+	*first = nullptr;
+	*second = nullptr;
+	FOUNDATION_UNUSED(datagram);
+	return false;
+#endif
+}
@@ -0,0 +1,80 @@
+/* shm.h  -  Network library  -  Public Domain  -  2013 Mattias Jansson
+ *
+ * This library provides a network abstraction built on foundation streams. The latest source code is
+ * always available at
+ *
+ * https://github.com/mjansson/network_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any restrictions.
+ *
+ */
+
+#pragma once
+
+/*! \file shm.h
+    Shared memory stream transport for peers on the same host. A connection is a pair of single
+    producer, single consumer byte rings in a shared memory segment, one per direction, so data is
+    transferred without passing through the kernel. Each end has an event handle as socket file
+    descriptor which is signalled by the peer only when the end is waiting for data or space, and
+    the socket can be added to a poll object, used with a beacon and with socket streams like any
+    other stream socket.
+
+    Connections are established over a unix domain stream socket: the server listens on a unix
+    socket (#unix_socket_allocate, #socket_bind and #tcp_socket_listen) and accepts connections with
+    #shm_socket_accept, the client connects with #shm_socket_connect. The handshake connection is
+    closed once the shared memory segment has been passed, so an end exiting without closing the
+    socket is not detected by the peer.
+
+    Blocking reads and waits spin on the ring for the number of microseconds given by the
+    NETWORK_SOCKETOPTION_BUSY_POLL socket option before sleeping on the event handle, trading
+    processor time for latency, which only pays off when the two ends run on separate cores.
+
+    The same transport also provides in-process socket pairs (#shm_socket_pair) without kernel
+    sockets, ports or handshake, for unit testing and benchmarking protocol code at memory speed.
+    Only supported on Linux. */
+
+#include <foundation/platform.h>
+
+#include <network/types.h>
+#include <network/socket.h>
+
+/*! Allocate a shared memory socket
+\return New socket */
+NETWORK_API socket_t*
+shm_socket_allocate(void);
+
+/*! Initialize a shared memory socket
+\param sock Socket */
+NETWORK_API void
+shm_socket_initialize(socket_t* sock);
+
+/*! Connect a shared memory socket to a server listening on the given unix address
+\param sock Socket
+\param address Unix address of the listening server
+\param timeoutms Timeout in milliseconds for the connection and handshake
+\return true if connected, false if not */
+NETWORK_API bool
+shm_socket_connect(socket_t* sock, const network_address_t* address, unsigned int timeoutms);
+
+/*! Accept a connection on a listening unix stream socket and establish a shared memory
+connection with the peer. The size of the rings is taken from the network config
+(see #network_config_t::shm_ring_size).
+\param listener Listening unix stream socket
+\param timeoutms Timeout in milliseconds to wait for a connection
+\return New shared memory socket, null if no connection or the handshake failed */
+NETWORK_API socket_t*
+shm_socket_accept(socket_t* listener, unsigned int timeoutms);
+
+/*! Create a connected pair of in-process shared memory sockets. The sockets work like the two ends
+of a loopback connection: data written to one end is read from the other, and each end can be added
+to a poll object and used with socket streams. Each end has a unique synthetic IPv4 loopback
+address as local address and the address of the other end as remote address. In datagram mode the
+sockets are of type NETWORK_SOCKETTYPE_SHM_DGRAM and are used with #udp_socket_sendto and
+#udp_socket_recvfrom addressing the other end (or #socket_write and #socket_read), datagrams
+keep their boundaries and are never reordered or dropped while there is room in the ring.
+\param first Destination first socket
+\param second Destination second socket
+\param datagram Flag for datagram mode instead of a byte stream
+\return true if successful, false if not */
+NETWORK_API bool
+shm_socket_pair(socket_t** first, socket_t** second, bool datagram);
@@ -0,0 +1,522 @@
+/* sim.c  -  Network library  -  Public Domain  -  2013 Mattias Jansson
+ *
+ * This library provides a network abstraction built on foundation streams. The latest source code is
+ * always available at
+ *
+ * https://github.com/mjansson/network_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any restrictions.
+ *
+ */
+
+#include <network/sim.h>
+#include <network/address.h>
+#include <network/addressmap.h>
+#include <network/poll.h>
+#include <network/socket.h>
+#include <network/udp.h>
+#include <network/internal.h>
+
+#include <foundation/foundation.h>
+
+#define NETWORK_SIM_PORT_FIRST 49152
+#define NETWORK_SIM_HANDLE_FIRST 0x40000000
+
+struct network_sim_route_t {
+	//! Source host, port is zero
+	network_address_compact_t from;
+	//! Destination host, port is zero
+	network_address_compact_t to;
+	//! Link characteristics, only used if custom flag is set
+	network_sim_link_t link;
+	//! Flag set if link was explicitly set, otherwise the default link is used
+	bool custom;
+	//! Time when the link is done transmitting queued datagrams
+	tick_t busy_until;
+};
+
+struct network_sim_datagram_t {
+	tick_t deliver;
+	uint64_t sequence;
+	network_address_compact_t source;
+	network_address_compact_t target;
+	size_t size;
+	uint8_t data[FOUNDATION_FLEXIBLE_ARRAY];
+};
+
+// Transport of a simulated socket, queue of delivered datagrams not yet read
+typedef struct network_sim_endpoint_t {
+	network_sim_t* sim;
+	network_sim_datagram_t** queue;
+	size_t queue_read;
+} network_sim_endpoint_t;
+
+static size_t
+network_sim_socket_read(socket_t* sock, void* buffer, size_t size);
+
+static size_t
+network_sim_socket_send(socket_t* sock, const void* buffer, size_t size, int flags);
+
+static int
+network_sim_socket_available(const socket_t* sock);
+
+static int
+network_sim_socket_wait(socket_t* sock, bool write, unsigned int timeoutms);
+
+static size_t
+network_sim_socket_recvfrom(socket_t* sock, void* buffer, size_t capacity, const network_address_t** address);
+
+static size_t
+network_sim_socket_sendto(socket_t* sock, const void* buffer, size_t size, const network_address_t* address);
+
+static void
+network_sim_socket_close(socket_t* sock);
+
+static const socket_vtable_t network_sim_socket_vtable = {
+    network_sim_socket_read,     network_sim_socket_send,   network_sim_socket_available, network_sim_socket_wait,
+    network_sim_socket_recvfrom, network_sim_socket_sendto, network_sim_socket_close};
+
+network_sim_t*
+network_sim_allocate(uint64_t seed) {
+	network_sim_t* sim = memory_allocate(HASH_NETWORK, sizeof(network_sim_t), 0, MEMORY_PERSISTENT);
+	NETWORK_COUNT_ALLOCATION(NETWORK_ALLOCATION_TRANSPORT, sizeof(network_sim_t));
+	network_sim_initialize(sim, seed);
+	return sim;
+}
+
+void
+network_sim_initialize(network_sim_t* sim, uint64_t seed) {
+	memset(sim, 0, sizeof(network_sim_t));
+	sim->random = seed;
+	sim->port_next = NETWORK_SIM_PORT_FIRST;
+	sim->handle_next = NETWORK_SIM_HANDLE_FIRST;
+	network_address_map_initialize(&sim->sockets, 16);
+}
+
+void
+network_sim_finalize(network_sim_t* sim) {
+	for (size_t iflight = 0, count = array_size(sim->flight); iflight < count; ++iflight)
+		memory_deallocate(sim->flight[iflight]);
+	array_deallocate(sim->flight);
+	array_deallocate(sim->routes);
+	if (network_address_map_size(&sim->sockets))
+		log_warnf(HASH_NETWORK, WARNING_SUSPICIOUS,
+		          STRING_CONST("Finalizing simulated network with %" PRIsize " sockets still allocated"),
+		          network_address_map_size(&sim->sockets));
+	network_address_map_finalize(&sim->sockets);
+}
+
+void
+network_sim_deallocate(network_sim_t* sim) {
+	network_sim_finalize(sim);
+	memory_deallocate(sim);
+}
+
+// Random generator (splitmix64), fast and fully determined by the seed
+static uint64_t
+network_sim_random(network_sim_t* sim) {
+	uint64_t value = (sim->random += 0x9e3779b97f4a7c15ULL);
+	value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+	return value ^ (value >> 31);
+}
+
+static bool
+network_sim_roll(network_sim_t* sim, real probability) {
+	if (probability <= 0)
+		return false;
+	return ((double)(network_sim_random(sim) >> 11) / 9007199254740992.0) < (double)probability;
+}
+
+static tick_t
+network_sim_ticks(uint64_t usec) {
+	return (tick_t)((usec * (uint64_t)time_ticks_per_second()) / 1000000ULL);
+}
+
+static void
+network_sim_host(const network_address_t* address, network_address_compact_t* host) {
+	if (!network_address_to_compact(address, host))
+		memset(host, 0, sizeof(network_address_compact_t));
+	host->port = 0;
+}
+
+static network_sim_route_t*
+network_sim_route(network_sim_t* sim, const network_address_compact_t* from, const network_address_compact_t* to) {
+	network_sim_route_t route;
+	for (size_t iroute = 0, count = array_size(sim->routes); iroute < count; ++iroute) {
+		if (network_address_compact_equal(&sim->routes[iroute].from, from) &&
+		    network_address_compact_equal(&sim->routes[iroute].to, to))
+			return sim->routes + iroute;
+	}
+	memset(&route, 0, sizeof(route));
+	route.from = *from;
+	route.to = *to;
+	array_push(sim->routes, route);
+	return sim->routes + (array_size(sim->routes) - 1);
+}
+
+void
+network_sim_set_default_link(network_sim_t* sim, const network_sim_link_t* link) {
+	sim->link_default = *link;
+}
+
+void
+network_sim_set_link(network_sim_t* sim, const network_address_t* from, const network_address_t* to,
+                     const network_sim_link_t* link) {
+	network_address_compact_t host_from, host_to;
+	network_sim_host(from, &host_from);
+	network_sim_host(to, &host_to);
+	network_sim_route_t* route = network_sim_route(sim, &host_from, &host_to);
+	route->link = *link;
+	route->custom = true;
+}
+
+static bool
+network_sim_datagram_before(const network_sim_datagram_t* first, const network_sim_datagram_t* second) {
+	return (first->deliver < second->deliver) ||
+	       ((first->deliver == second->deliver) && (first->sequence < second->sequence));
+}
+
+static void
+network_sim_flight_push(network_sim_t* sim, network_sim_datagram_t* datagram) {
+	size_t index = array_size(sim->flight);
+	array_push(sim->flight, datagram);
+	while (index) {
+		size_t parent = (index - 1) / 2;
+		if (!network_sim_datagram_before(datagram, sim->flight[parent]))
+			break;
+		sim->flight[index] = sim->flight[parent];
+		index = parent;
+	}
+	sim->flight[index] = datagram;
+}
+
+static network_sim_datagram_t*
+network_sim_flight_pop(network_sim_t* sim) {
+	network_sim_datagram_t* top = sim->flight[0];
+	size_t count = array_size(sim->flight) - 1;
+	network_sim_datagram_t* last = sim->flight[count];
+	size_t index = 0;
+	array_pop(sim->flight);
+	while (count) {
+		size_t child = (2 * index) + 1;
+		if (child >= count)
+			break;
+		if ((child + 1 < count) && network_sim_datagram_before(sim->flight[child + 1], sim->flight[child]))
+			++child;
+		if (!network_sim_datagram_before(sim->flight[child], last))
+			break;
+		sim->flight[index] = sim->flight[child];
+		index = child;
+	}
+	if (count)
+		sim->flight[index] = last;
+	return top;
+}
+
+static bool
+network_sim_deliver(network_sim_t* sim, network_sim_datagram_t* datagram) {
+	network_address_t target;
+	socket_t* sock = network_address_map_lookup(&sim->sockets,
+	                                            network_address_from_compact(&target, &datagram->target));
+	if (!sock) {
+		++sim->statistics.unreachable;
+		memory_deallocate(datagram);
+		return false;
+	}
+	if (sock->filter) {
+		network_address_t source;
+		if (!socket_filter_allow(sock, network_address_from_compact(&source, &datagram->source))) {
+			memory_deallocate(datagram);
+			return false;
+		}
+	}
+	network_sim_endpoint_t* endpoint = sock->transport;
+	array_push(endpoint->queue, datagram);
+	++sim->statistics.delivered;
+	sim->statistics.bytes_delivered += datagram->size;
+	return true;
+}
+
+// Advance the clock to the given time, delivering due datagrams in order
+static size_t
+network_sim_run(network_sim_t* sim, tick_t until) {
+	size_t delivered = 0;
+	while (array_size(sim->flight) && (sim->flight[0]->deliver <= until)) {
+		network_sim_datagram_t* datagram = network_sim_flight_pop(sim);
+		if (datagram->deliver > sim->time)
+			sim->time = datagram->deliver;
+		if (network_sim_deliver(sim, datagram))
+			++delivered;
+	}
+	if (until > sim->time)
+		sim->time = until;
+	return delivered;
+}
+
+tick_t
+network_sim_time(const network_sim_t* sim) {
+	return sim->time;
+}
+
+tick_t
+network_sim_next(const network_sim_t* sim) {
+	return array_size(sim->flight) ? sim->flight[0]->deliver : 0;
+}
+
+size_t
+network_sim_advance(network_sim_t* sim, tick_t ticks) {
+	return network_sim_run(sim, sim->time + ticks);
+}
+
+const network_sim_statistics_t*
+network_sim_statistics(const network_sim_t* sim) {
+	return &sim->statistics;
+}
+
+socket_t*
+network_sim_socket_allocate(network_sim_t* sim, const network_address_t* address) {
+	network_address_compact_t compact;
+	network_address_t* local;
+	network_sim_endpoint_t* endpoint;
+	socket_t* sock;
+
+	if (!network_address_to_compact(address, &compact)) {
+		log_errorf(HASH_NETWORK, ERROR_INVALID_VALUE,
+		           STRING_CONST("Unable to allocate simulated socket: Not an IP address"));
+		return nullptr;
+	}
+
+	local = network_address_clone(address);
+	if (!compact.port) {
+		for (unsigned int itry = 0; itry < (65536 - NETWORK_SIM_PORT_FIRST); ++itry) {
+			unsigned int port = sim->port_next;
+			sim->port_next = (port < 65535) ? port + 1 : NETWORK_SIM_PORT_FIRST;
+			network_address_ip_set_port(local, port);
+			if (!network_address_map_lookup(&sim->sockets, local))
+				break;
+		}
+	}
+	if (network_address_map_lookup(&sim->sockets, local)) {
+#if BUILD_ENABLE_LOG
+		char buffer[NETWORK_ADDRESS_NUMERIC_MAX_LENGTH];
+		string_t address_str = network_address_to_string(buffer, sizeof(buffer), local, true);
+		log_warnf(HASH_NETWORK, WARNING_INVALID_VALUE,
+		          STRING_CONST("Unable to allocate simulated socket: Address %.*s already bound"),
+		          STRING_FORMAT(address_str));
+#endif
+		memory_deallocate(local);
+		return nullptr;
+	}
+
+	sock = udp_socket_allocate();
+	endpoint = memory_allocate(HASH_NETWORK, sizeof(network_sim_endpoint_t), 0,
+	                           MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	NETWORK_COUNT_ALLOCATION(NETWORK_ALLOCATION_TRANSPORT, sizeof(network_sim_endpoint_t));
+	endpoint->sim = sim;
+
+	// The handle is only an identifier, never passed to the system
+	sock->fd = sim->handle_next++;
+	sock->family = address->family;
+	sock->vtable = &network_sim_socket_vtable;
+	sock->transport = endpoint;
+	sock->address_local = local;
+	sock->address_remote = network_address_clone(local);
+	network_address_map_insert(&sim->sockets, local, sock);
+
+	log_debugf(HASH_NETWORK, STRING_CONST("Allocated simulated socket (0x%" PRIfixPTR " : %d)"), (uintptr_t)sock,
+	           sock->fd);
+	return sock;
+}
+
+void
+network_sim_attach_poll(network_sim_t* sim, network_poll_t* poll) {
+	FOUNDATION_ASSERT_MSG(!network_poll_sockets_count(poll), "Simulation must be attached to an empty poll object");
+	poll->sim = sim;
+}
+
+size_t
+network_sim_poll(network_sim_t* sim, network_poll_t* poll, network_poll_event_t* events, size_t capacity,
+                 unsigned int timeoutms) {
+	tick_t deadline = 0;
+	if (timeoutms && (timeoutms != NETWORK_TIMEOUT_INFINITE))
+		deadline = sim->time + network_sim_ticks((uint64_t)timeoutms * 1000);
+
+	while (true) {
+		size_t events_count = 0;
+		for (size_t islot = 0, ssize = poll->sockets_count; (islot < ssize) && (events_count < capacity); ++islot) {
+			socket_t* sock = poll->slots[islot].sock;
+			if ((sock->vtable == &network_sim_socket_vtable) && (network_sim_socket_available(sock) > 0)) {
+				events[events_count].event = NETWORKEVENT_DATAIN;
+				events[events_count].socket = sock;
+				++events_count;
+			}
+		}
+		if (events_count || !timeoutms)
+			return events_count;
+
+		// Nothing pending, skip virtual time ahead to the next delivery
+		tick_t next = network_sim_next(sim);
+		if (!next)
+			return 0;
+		if (deadline && (next > deadline)) {
+			network_sim_run(sim, deadline);
+			return 0;
+		}
+		network_sim_run(sim, next);
+	}
+}
+
+static size_t
+network_sim_socket_recvfrom(socket_t* sock, void* buffer, size_t capacity, const network_address_t** address) {
+	network_sim_endpoint_t* endpoint = sock->transport;
+	network_sim_datagram_t* datagram;
+	size_t size;
+
+	if ((endpoint->queue_read >= array_size(endpoint->queue)) &&
+	    (!(sock->flags & SOCKETFLAG_BLOCKING) || (network_sim_socket_wait(sock, false, NETWORK_TIMEOUT_INFINITE) <= 0)))
+		return 0;
+
+	datagram = endpoint->queue[endpoint->queue_read++];
+	if (endpoint->queue_read == array_size(endpoint->queue)) {
+		array_clear(endpoint->queue);
+		endpoint->queue_read = 0;
+	}
+
+	size = (datagram->size < capacity) ? datagram->size : capacity;
+	memcpy(buffer, datagram->data, size);
+	network_address_from_compact(sock->address_remote, &datagram->source);
+	if (address)
+		*address = sock->address_remote;
+	memory_deallocate(datagram);
+	return size;
+}
+
+static size_t
+network_sim_socket_sendto(socket_t* sock, const void* buffer, size_t size, const network_address_t* address) {
+	network_sim_endpoint_t* endpoint = sock->transport;
+	network_sim_t* sim = endpoint->sim;
+	network_address_compact_t source, target, host_from, host_to;
+	network_sim_datagram_t* datagram;
+	const network_sim_link_t* link;
+	network_sim_route_t* route;
+	tick_t start, deliver;
+
+	if (!network_address_to_compact(address, &target))
+		return 0;
+	network_address_to_compact(sock->address_local, &source);
+	++sim->statistics.sent;
+
+	host_from = source;
+	host_from.port = 0;
+	host_to = target;
+	host_to.port = 0;
+	route = network_sim_route(sim, &host_from, &host_to);
+	link = route->custom ? &route->link : &sim->link_default;
+
+	// Serialize on the link, datagrams queue behind the ones still being transmitted
+	start = (route->busy_until > sim->time) ? route->busy_until : sim->time;
+	if (link->bandwidth) {
+		uint64_t queued = (uint64_t)(((double)(start - sim->time) * (double)link->bandwidth) /
+		                             (double)time_ticks_per_second());
+		if (link->queue_limit && ((queued + size) > link->queue_limit)) {
+			++sim->statistics.dropped;
+			return size;
+		}
+		start += (tick_t)(((uint64_t)size * (uint64_t)time_ticks_per_second()) / link->bandwidth);
+	}
+	route->busy_until = start;
+
+	if (network_sim_roll(sim, link->loss)) {
+		++sim->statistics.lost;
+		return size;
+	}
+
+	deliver = start + network_sim_ticks(link->latency);
+	if (link->jitter)
+		deliver += network_sim_ticks(network_sim_random(sim) % ((uint64_t)link->jitter + 1));
+	// Reordered datagrams arrive after datagrams sent later, delay by at least a millisecond
+	// so links without latency also reorder
+	if (network_sim_roll(sim, link->reorder))
+		deliver += network_sim_ticks((link->latency + link->jitter > 1000) ? (link->latency + link->jitter) : 1000);
+
+	datagram = memory_allocate(HASH_NETWORK, sizeof(network_sim_datagram_t) + size, 0, MEMORY_PERSISTENT);
+	NETWORK_COUNT_ALLOCATION(NETWORK_ALLOCATION_TRANSPORT, sizeof(network_sim_datagram_t) + size);
+	datagram->deliver = deliver;
+	datagram->sequence = sim->sequence++;
+	datagram->source = source;
+	datagram->target = target;
+	datagram->size = size;
+	memcpy(datagram->data, buffer, size);
+	network_sim_flight_push(sim, datagram);
+
+	return size;
+}
+
+static size_t
+network_sim_socket_read(socket_t* sock, void* buffer, size_t size) {
+	return network_sim_socket_recvfrom(sock, buffer, size, nullptr);
+}
+
+static size_t
+network_sim_socket_send(socket_t* sock, const void* buffer, size_t size, int flags) {
+	// Simulated sockets are never connected, datagrams must be addressed
+	FOUNDATION_UNUSED(sock);
+	FOUNDATION_UNUSED(buffer);
+	FOUNDATION_UNUSED(size);
+	FOUNDATION_UNUSED(flags);
+	return 0;
+}
+
+static int
+network_sim_socket_available(const socket_t* sock) {
+	const network_sim_endpoint_t* endpoint = sock->transport;
+	if (endpoint->queue_read >= array_size(endpoint->queue))
+		return 0;
+	size_t size = endpoint->queue[endpoint->queue_read]->size;
+	return (size > INT32_MAX) ? INT32_MAX : (int)size;
+}
+
+static int
+network_sim_socket_wait(socket_t* sock, bool write, unsigned int timeoutms) {
+	network_sim_endpoint_t* endpoint = sock->transport;
+	network_sim_t* sim = endpoint->sim;
+	tick_t deadline = 0;
+
+	// Sends never block, datagrams queue on the link
+	if (write)
+		return 1;
+
+	if ((timeoutms != NETWORK_TIMEOUT_INFINITE) && timeoutms)
+		deadline = sim->time + network_sim_ticks((uint64_t)timeoutms * 1000);
+	while (endpoint->queue_read >= array_size(endpoint->queue)) {
+		tick_t next = network_sim_next(sim);
+		if (!next || !timeoutms)
+			return 0;
+		if (deadline && (next > deadline)) {
+			network_sim_run(sim, deadline);
+			return 0;
+		}
+		network_sim_run(sim, next);
+	}
+	return 1;
+}
+
+static void
+network_sim_socket_close(socket_t* sock) {
+	network_sim_endpoint_t* endpoint = sock->transport;
+	if (!endpoint)
+		return;
+
+	if (network_address_map_lookup(&endpoint->sim->sockets, sock->address_local) == sock)
+		network_address_map_erase(&endpoint->sim->sockets, sock->address_local);
+	for (size_t iqueue = endpoint->queue_read, count = array_size(endpoint->queue); iqueue < count; ++iqueue)
+		memory_deallocate(endpoint->queue[iqueue]);
+	array_deallocate(endpoint->queue);
+	memory_deallocate(endpoint);
+
+	// Handle is not a system handle, invalidate it so it is not closed
+	sock->fd = NETWORK_SOCKET_INVALID;
+	sock->transport = nullptr;
+	sock->vtable = nullptr;
+}
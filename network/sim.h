@@ -0,0 +1,127 @@
+/* sim.h  -  Network library  -  Public Domain  -  2013 Mattias Jansson
+ *
+ * This library provides a network abstraction built on foundation streams. The latest source code is
+ * always available at
+ *
+ * https://github.com/mjansson/network_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any restrictions.
+ *
+ */
+
+#pragma once
+
+/*! \file sim.h
+    Deterministic simulated network driven by a virtual clock, for reproducing loss, reordering
+    and latency dependent behaviour of datagram protocols and running long scenarios in a fraction
+    of the wall clock time. Datagrams sent on simulated sockets pass over links between host pairs
+    with configurable latency, jitter, bandwidth, queue limit, loss and reorder probability. All
+    random decisions are taken from a generator seeded at initialization, so a simulation replays
+    identically given the same seed and the same sequence of calls.
+
+    Simulated sockets are datagram sockets used with #udp_socket_sendto and #udp_socket_recvfrom.
+    They are bound to an address in the simulation when allocated and never touch the system
+    network stack. A poll object attached to the simulation (#network_sim_attach_poll) reports
+    sockets with pending datagrams, and a poll timeout advances the virtual clock to the next
+    delivery instead of sleeping. Time dependent protocol code must take its time from
+    #network_sim_time instead of the system clock. Reliable streams are not simulated. */
+
+#include <foundation/platform.h>
+
+#include <network/types.h>
+
+/*! Allocate a simulated network
+\param seed Random generator seed
+\return New simulated network */
+NETWORK_API network_sim_t*
+network_sim_allocate(uint64_t seed);
+
+/*! Initialize a simulated network. The virtual clock starts at zero and the default link has no
+latency, unlimited bandwidth and no loss.
+\param sim Simulated network
+\param seed Random generator seed */
+NETWORK_API void
+network_sim_initialize(network_sim_t* sim, uint64_t seed);
+
+/*! Finalize a simulated network, discarding datagrams in flight. Sockets allocated in the
+simulation must be deallocated before the simulation is finalized.
+\param sim Simulated network */
+NETWORK_API void
+network_sim_finalize(network_sim_t* sim);
+
+/*! Finalize and deallocate a simulated network
+\param sim Simulated network */
+NETWORK_API void
+network_sim_deallocate(network_sim_t* sim);
+
+/*! Set the link characteristics used for host pairs without an explicit link. Does not change
+links already set with #network_sim_set_link.
+\param sim Simulated network
+\param link Link characteristics */
+NETWORK_API void
+network_sim_set_default_link(network_sim_t* sim, const network_sim_link_t* link);
+
+/*! Set the link characteristics of datagrams sent from one host to another. Links are directed
+and between hosts, the port of the addresses is ignored. Datagrams already in flight are not
+affected.
+\param sim Simulated network
+\param from Source host address
+\param to Destination host address
+\param link Link characteristics */
+NETWORK_API void
+network_sim_set_link(network_sim_t* sim, const network_address_t* from, const network_address_t* to,
+                     const network_sim_link_t* link);
+
+/*! Allocate a simulated datagram socket bound to the given IPv4 or IPv6 address. A zero port
+is replaced by an unused ephemeral port. The socket is deallocated with #socket_deallocate.
+\param sim Simulated network
+\param address Local address
+\return New socket, null if the address is already bound in the simulation */
+NETWORK_API socket_t*
+network_sim_socket_allocate(network_sim_t* sim, const network_address_t* address);
+
+/*! Attach a poll object to the simulation. The poll object must be empty and must only be used
+with simulated sockets of this simulation. #network_poll then reports a NETWORKEVENT_DATAIN event
+for each socket with pending datagrams, and if there are none advances the virtual clock to the
+next delivery or until the timeout has passed in virtual time. A zero timeout never advances the
+clock, and the poll returns immediately if no datagram is in flight.
+\param sim Simulated network
+\param poll Poll object */
+NETWORK_API void
+network_sim_attach_poll(network_sim_t* sim, network_poll_t* poll);
+
+/*! Get the current virtual time
+\param sim Simulated network
+\return Virtual time in ticks, see time_ticks_per_second */
+NETWORK_API tick_t
+network_sim_time(const network_sim_t* sim);
+
+/*! Get the virtual time of the next datagram delivery
+\param sim Simulated network
+\return Delivery time in ticks, zero if no datagram is in flight */
+NETWORK_API tick_t
+network_sim_next(const network_sim_t* sim);
+
+/*! Advance the virtual clock, delivering all datagrams due up to the new time
+\param sim Simulated network
+\param ticks Number of ticks to advance
+\return Number of datagrams delivered */
+NETWORK_API size_t
+network_sim_advance(network_sim_t* sim, tick_t ticks);
+
+/*! Get the statistics counters of the simulation
+\param sim Simulated network
+\return Statistics counters */
+NETWORK_API const network_sim_statistics_t*
+network_sim_statistics(const network_sim_t* sim);
+
+/*! Poll the sockets of a poll object attached to the simulation. Called by #network_poll.
+\param sim Simulated network
+\param poll Poll object
+\param events Destination event array
+\param capacity Capacity of event array
+\param timeoutms Timeout in milliseconds of virtual time
+\return Number of events */
+NETWORK_API size_t
+network_sim_poll(network_sim_t* sim, network_poll_t* poll, network_poll_event_t* events, size_t capacity,
+                 unsigned int timeoutms);
@@ -11,14 +11,23 @@
 
 #include <network/socket.h>
 #include <network/address.h>
+#include <network/cidr.h>
 #include <network/internal.h>
 #include <network/hashstrings.h>
 
 #include <foundation/foundation.h>
 
+#if FOUNDATION_PLATFORM_POSIX
+#include <netinet/tcp.h>
+#include <netinet/ip.h>
+#endif
+
 static void
 socket_set_blocking_fd(int fd, bool block);
 
+static void
+socket_apply_options(socket_t* sock);
+
 void
 socket_initialize(socket_t* sock) {
 	memset(sock, 0, sizeof(socket_t));
@@ -45,6 +54,7 @@ socket_create_fd(socket_t* sock, network_address_family_t family) {
 		socket_set_blocking(sock, sock->flags & SOCKETFLAG_BLOCKING);
 		socket_set_reuse_address(sock, sock->flags & SOCKETFLAG_REUSE_ADDR);
 		socket_set_reuse_port(sock, sock->flags & SOCKETFLAG_REUSE_PORT);
+		socket_apply_options(sock);
 	}
 
 	return sock->fd;
@@ -165,44 +175,22 @@ socket_connect_impl(socket_t* sock, const network_address_t* address, unsigned i
 			if (!timeoutms) {
 				failed = false;
 			} else {
-				struct timeval tv;
-				fd_set fdwrite, fderr;
-				int ret;
-
-				FD_ZERO(&fdwrite);
-				FD_ZERO(&fderr);
-				FD_SET(sock->fd, &fdwrite);
-				FD_SET(sock->fd, &fderr);
-
-				tv.tv_sec = timeoutms / 1000;
-				tv.tv_usec = (timeoutms % 1000) * 1000;
-
-				ret = select((int)(sock->fd + 1), 0, &fdwrite, &fderr,
-				             (timeoutms != NETWORK_TIMEOUT_INFINITE) ? &tv : nullptr);
+				int ret = socket_wait_fd(sock->fd, true, timeoutms);
 				if (ret > 0) {
-#if FOUNDATION_PLATFORM_WINDOWS
-					int serr = 0;
-					int slen = sizeof(int);
-					getsockopt(sock->fd, SOL_SOCKET, SO_ERROR, (char*)&serr, &slen);
-#else
-					int serr = 0;
-					socklen_t slen = sizeof(int);
-					getsockopt(sock->fd, SOL_SOCKET, SO_ERROR, (void*)&serr, &slen);
-#endif
-					if (!serr && !FD_ISSET(sock->fd, &fderr)) {
+					int serr = socket_error_fd(sock->fd);
+					if (!serr) {
 						failed = false;
-						if (FD_ISSET(sock->fd, &fdwrite))
-							socket_set_state(sock, SOCKETSTATE_CONNECTED);
+						socket_set_state(sock, SOCKETSTATE_CONNECTED);
 					} else {
 						err = serr;
 #if BUILD_ENABLE_DEBUG_LOG
-						error_message = string_const(STRING_CONST("select indicated socket error"));
+						error_message = string_const(STRING_CONST("poll indicated socket error"));
 #endif
 					}
 				} else if (ret < 0) {
 					err = NETWORK_SOCKET_ERROR;
 #if BUILD_ENABLE_DEBUG_LOG
-					error_message = string_const(STRING_CONST("select failed"));
+					error_message = string_const(STRING_CONST("poll failed"));
 #endif
 				} else {
 #if FOUNDATION_PLATFORM_WINDOWS
@@ -211,7 +199,7 @@ socket_connect_impl(socket_t* sock, const network_address_t* address, unsigned i
 					err = ETIMEDOUT;
 #endif
 #if BUILD_ENABLE_DEBUG_LOG
-					error_message = string_const(STRING_CONST("select timed out"));
+					error_message = string_const(STRING_CONST("poll timed out"));
 #endif
 				}
 			}
@@ -305,7 +293,8 @@ socket_blocking(const socket_t* sock) {
 void
 socket_set_blocking(socket_t* sock, bool block) {
 	sock->flags = (block ? sock->flags | SOCKETFLAG_BLOCKING : sock->flags & ~SOCKETFLAG_BLOCKING);
-	if (sock->fd != NETWORK_SOCKET_INVALID)
+	// Transport notification handles are always non-blocking, the transport implements blocking mode
+	if ((sock->fd != NETWORK_SOCKET_INVALID) && !sock->vtable)
 		socket_set_blocking_fd(sock->fd, block);
 }
 
@@ -362,6 +351,132 @@ socket_set_reuse_port(socket_t* sock, bool reuse) {
 #endif
 }
 
+// Map option to setsockopt level and name for the socket, false if not supported
+static bool
+socket_option_name(const socket_t* sock, network_socket_option_t option, int* level, int* name) {
+	bool tcp = (sock->type == NETWORK_SOCKETTYPE_TCP);
+	bool ip = (sock->family != NETWORK_ADDRESSFAMILY_UNIX);
+	*level = SOL_SOCKET;
+	switch (option) {
+		case NETWORK_SOCKETOPTION_SEND_BUFFER:
+			*name = SO_SNDBUF;
+			return true;
+		case NETWORK_SOCKETOPTION_RECEIVE_BUFFER:
+			*name = SO_RCVBUF;
+			return true;
+#if defined(SO_RCVLOWAT) && !FOUNDATION_PLATFORM_WINDOWS
+		case NETWORK_SOCKETOPTION_RECEIVE_LOWAT:
+			*name = SO_RCVLOWAT;
+			return true;
+#endif
+#if defined(SO_PRIORITY)
+		case NETWORK_SOCKETOPTION_PRIORITY:
+			*name = SO_PRIORITY;
+			return true;
+#endif
+#if defined(SO_BUSY_POLL)
+		case NETWORK_SOCKETOPTION_BUSY_POLL:
+			*name = SO_BUSY_POLL;
+			return true;
+#endif
+		case NETWORK_SOCKETOPTION_TOS:
+#if defined(IPV6_TCLASS)
+			if (sock->family == NETWORK_ADDRESSFAMILY_IPV6) {
+				*level = IPPROTO_IPV6;
+				*name = IPV6_TCLASS;
+				return true;
+			}
+#endif
+			*level = IPPROTO_IP;
+			*name = IP_TOS;
+			return ip;
+#if defined(TCP_QUICKACK)
+		case NETWORK_SOCKETOPTION_TCP_QUICKACK:
+			*level = IPPROTO_TCP;
+			*name = TCP_QUICKACK;
+			return tcp;
+#endif
+#if defined(TCP_NOTSENT_LOWAT)
+		case NETWORK_SOCKETOPTION_TCP_NOTSENT_LOWAT:
+			*level = IPPROTO_TCP;
+			*name = TCP_NOTSENT_LOWAT;
+			return tcp;
+#endif
+#if defined(TCP_USER_TIMEOUT)
+		case NETWORK_SOCKETOPTION_TCP_USER_TIMEOUT:
+			*level = IPPROTO_TCP;
+			*name = TCP_USER_TIMEOUT;
+			return tcp;
+#endif
+		default:
+			break;
+	}
+	FOUNDATION_UNUSED(tcp);
+	FOUNDATION_UNUSED(ip);
+	return false;
+}
+
+static bool
+socket_set_option_fd(socket_t* sock, network_socket_option_t option, int value) {
+	int level, name;
+	if (!socket_option_name(sock, option, &level, &name))
+		return false;
+	if (setsockopt(sock->fd, level, name, (const char*)&value, sizeof(value)) < 0) {
+		const int sockerr = NETWORK_SOCKET_ERROR;
+		const string_const_t errmsg = system_error_message(sockerr);
+		log_warnf(HASH_NETWORK, WARNING_SYSTEM_CALL_FAIL,
+		          STRING_CONST("Unable to set option %d to %d on socket (0x%" PRIfixPTR " : %d): %.*s (%d)"),
+		          (int)option, value, (uintptr_t)sock, sock->fd, STRING_FORMAT(errmsg), sockerr);
+		FOUNDATION_UNUSED(sockerr);
+		return false;
+	}
+	return true;
+}
+
+static void
+socket_apply_options(socket_t* sock) {
+	for (int option = 0; option < NETWORK_SOCKETOPTION_COUNT; ++option) {
+		int level, name;
+		if (sock->options_set & (1U << option)) {
+			socket_set_option_fd(sock, (network_socket_option_t)option, sock->options[option]);
+		} else if (network_config.socket_options[option] &&
+		           socket_option_name(sock, (network_socket_option_t)option, &level, &name)) {
+			socket_set_option_fd(sock, (network_socket_option_t)option, network_config.socket_options[option]);
+		}
+	}
+}
+
+bool
+socket_set_option(socket_t* sock, network_socket_option_t option, int value) {
+	int level, name;
+	if ((unsigned int)option >= NETWORK_SOCKETOPTION_COUNT)
+		return false;
+	sock->options[option] = value;
+	sock->options_set |= (1U << option);
+	// Transports without a kernel socket only implement busy polling, read from the stored value
+	if (sock->vtable)
+		return (option == NETWORK_SOCKETOPTION_BUSY_POLL);
+	if (sock->fd != NETWORK_SOCKET_INVALID)
+		return socket_set_option_fd(sock, option, value);
+	return socket_option_name(sock, option, &level, &name);
+}
+
+int
+socket_option(const socket_t* sock, network_socket_option_t option) {
+	int level, name;
+	if ((unsigned int)option >= NETWORK_SOCKETOPTION_COUNT)
+		return -1;
+	if ((sock->fd != NETWORK_SOCKET_INVALID) && !sock->vtable && socket_option_name(sock, option, &level, &name)) {
+		int value = 0;
+		network_address_size_t size = sizeof(value);
+		NETWORK_COUNT_SYSCALL(NETWORK_SYSCALL_GETSOCKOPT);
+		if (getsockopt(sock->fd, level, name, (char*)&value, &size) == 0)
+			return value;
+		return -1;
+	}
+	return (sock->options_set & (1U << option)) ? sock->options[option] : -1;
+}
+
 bool
 socket_set_multicast_group(socket_t* sock, const network_address_t* multicast_address,
                            const network_address_t* local_address, bool allow_loopback) {
@@ -489,6 +604,7 @@ socket_poll_state(socket_t* sock) {
 			tv.tv_sec = 0;
 			tv.tv_usec = 0;
 
+			NETWORK_COUNT_SYSCALL(NETWORK_SYSCALL_SELECT);
 			select((int)(sock->fd + 1), 0, &fdwrite, &fderr, &tv);
 
 			if (FD_ISSET(sock->fd, &fderr)) {
@@ -505,7 +621,7 @@ socket_poll_state(socket_t* sock) {
 			break;
 
 		case SOCKETSTATE_CONNECTED:
-			available = socket_available_fd(sock->fd);
+			available = sock->vtable ? sock->vtable->available(sock) : socket_available_fd(sock->fd);
 			if (available < 0) {
 #if BUILD_ENABLE_DEBUG_LOG
 				log_debugf(HASH_NETWORK, STRING_CONST("Socket (0x%" PRIfixPTR " : %d): hangup in CONNECTED"),
@@ -538,7 +654,11 @@ socket_fd(socket_t* sock) {
 
 size_t
 socket_available_read(const socket_t* sock) {
-	return (sock->fd != NETWORK_SOCKET_INVALID) ? (unsigned int)socket_available_fd(sock->fd) : 0;
+	int available;
+	if (sock->fd == NETWORK_SOCKET_INVALID)
+		return 0;
+	available = sock->vtable ? sock->vtable->available(sock) : socket_available_fd(sock->fd);
+	return (available > 0) ? (size_t)available : 0;
 }
 
 size_t
@@ -549,6 +669,13 @@ socket_read(socket_t* sock, void* buffer, size_t size) {
 	if ((sock->fd == NETWORK_SOCKET_INVALID) || !size)
 		return 0;
 
+	if (sock->vtable) {
+		read = sock->vtable->read(sock, buffer, size);
+		sock->bytes_read += read;
+		return read;
+	}
+
+	NETWORK_COUNT_SYSCALL(NETWORK_SYSCALL_RECV);
 	ret = recv(sock->fd, (char*)buffer, (network_send_size_t)size, 0);
 	if (ret > 0) {
 #if BUILD_ENABLE_NETWORK_DUMP_TRAFFIC > 1
@@ -593,17 +720,22 @@ socket_read(socket_t* sock, void* buffer, size_t size) {
 	} else {
 		int sockerr = NETWORK_SOCKET_ERROR;
 #if FOUNDATION_PLATFORM_WINDOWS
-		if (sockerr != WSAEWOULDBLOCK)
+		if (sockerr == WSAEWOULDBLOCK)
 #else
-		if (sockerr != EAGAIN)
+		if (sockerr == EAGAIN)
 #endif
 		{
-			string_const_t errmsg = system_error_message(sockerr);
-			log_warnf(HASH_NETWORK, WARNING_SYSTEM_CALL_FAIL,
-			          STRING_CONST("Socket recv() failed on socket (0x%" PRIfixPTR " : %d): %.*s (%d)"),
-			          (uintptr_t)sock, sock->fd, STRING_FORMAT(errmsg), sockerr);
+			// Nothing to read, fast exit unless a pending connection needs a state update
+			if (sock->state == SOCKETSTATE_CONNECTING)
+				socket_poll_state(sock);
+			return 0;
 		}
 
+		string_const_t errmsg = system_error_message(sockerr);
+		log_warnf(HASH_NETWORK, WARNING_SYSTEM_CALL_FAIL,
+		          STRING_CONST("Socket recv() failed on socket (0x%" PRIfixPTR " : %d): %.*s (%d)"), (uintptr_t)sock,
+		          sock->fd, STRING_FORMAT(errmsg), sockerr);
+
 #if FOUNDATION_PLATFORM_WINDOWS
 		if ((sockerr == WSAENETDOWN) || (sockerr == WSAENETRESET) || (sockerr == WSAENOTCONN) ||
 		    (sockerr == WSAECONNABORTED) || (sockerr == WSAECONNRESET) || (sockerr == WSAETIMEDOUT))
@@ -622,16 +754,28 @@ socket_read(socket_t* sock, void* buffer, size_t size) {
 
 size_t
 socket_write(socket_t* sock, const void* buffer, size_t size) {
+	return socket_send(sock, buffer, size, 0);
+}
+
+size_t
+socket_send(socket_t* sock, const void* buffer, size_t size, int flags) {
 	size_t total_write = 0;
 
 	if ((sock->fd == NETWORK_SOCKET_INVALID) || !size)
 		return 0;
 
+	if (sock->vtable) {
+		total_write = sock->vtable->send(sock, buffer, size, flags);
+		sock->bytes_written += total_write;
+		return total_write;
+	}
+
 	while (total_write < size) {
 		const char* current = (const char*)pointer_offset_const(buffer, total_write);
 		size_t remain = size - total_write;
 
-		long res = send(sock->fd, current, (network_send_size_t)remain, 0);
+		NETWORK_COUNT_SYSCALL(NETWORK_SYSCALL_SEND);
+		long res = send(sock->fd, current, (network_send_size_t)remain, flags);
 		if (res > 0) {
 #if BUILD_ENABLE_NETWORK_DUMP_TRAFFIC > 1
 			const unsigned char* src = (const unsigned char*)current;
@@ -663,35 +807,19 @@ socket_write(socket_t* sock, const void* buffer, size_t size) {
 		} else if (res <= 0) {
 			int sockerr = NETWORK_SOCKET_ERROR;
 
-#if FOUNDATION_PLATFORM_WINDOWS
-			int serr = 0;
-			int slen = sizeof(int);
-			getsockopt(sock->fd, SOL_SOCKET, SO_ERROR, (char*)&serr, &slen);
-#else
-			int serr = 0;
-			socklen_t slen = sizeof(int);
-			getsockopt(sock->fd, SOL_SOCKET, SO_ERROR, (void*)&serr, &slen);
-#endif
-
+			// Send buffer full, fast exit with partial write and unchanged socket state
 #if FOUNDATION_PLATFORM_WINDOWS
 			if (sockerr == WSAEWOULDBLOCK)
 #else
 			if (sockerr == EAGAIN)
 #endif
-			{
-				if (serr) {
-					log_warnf(HASH_NETWORK, WARNING_SUSPICIOUS,
-					          STRING_CONST("Partial socket send() on (0x%" PRIfixPTR " : %d): %" PRIsize " of %" PRIsize
-					                       " bytes written to socket (SO_ERROR %d)"),
-					          (uintptr_t)sock, sock->fd, total_write, size, serr);
-				}
-			} else {
-				const string_const_t errstr = system_error_message(sockerr);
-				log_warnf(
-				    HASH_NETWORK, WARNING_SYSTEM_CALL_FAIL,
-				    STRING_CONST("Socket send() failed on socket (0x%" PRIfixPTR " : %d): %.*s (%d) (SO_ERROR %d)"),
-				    (uintptr_t)sock, sock->fd, STRING_FORMAT(errstr), sockerr, serr);
-			}
+				break;
+
+			int serr = socket_error_fd(sock->fd);
+			const string_const_t errstr = system_error_message(sockerr);
+			log_warnf(HASH_NETWORK, WARNING_SYSTEM_CALL_FAIL,
+			          STRING_CONST("Socket send() failed on socket (0x%" PRIfixPTR " : %d): %.*s (%d) (SO_ERROR %d)"),
+			          (uintptr_t)sock, sock->fd, STRING_FORMAT(errstr), sockerr, serr);
 
 #if FOUNDATION_PLATFORM_WINDOWS
 			if ((sockerr == WSAENETDOWN) || (sockerr == WSAENETRESET) || (sockerr == WSAENOTCONN) ||
@@ -715,6 +843,22 @@ socket_write(socket_t* sock, const void* buffer, size_t size) {
 	return total_write;
 }
 
+// Returns pending socket error (SO_ERROR), clearing it
+int
+socket_error_fd(int fd) {
+	int serr = 0;
+#if FOUNDATION_PLATFORM_WINDOWS
+	int slen = sizeof(int);
+	NETWORK_COUNT_SYSCALL(NETWORK_SYSCALL_GETSOCKOPT);
+	getsockopt(fd, SOL_SOCKET, SO_ERROR, (char*)&serr, &slen);
+#else
+	socklen_t slen = sizeof(int);
+	NETWORK_COUNT_SYSCALL(NETWORK_SYSCALL_GETSOCKOPT);
+	getsockopt(fd, SOL_SOCKET, SO_ERROR, (void*)&serr, &slen);
+#endif
+	return serr;
+}
+
 // Returns -1 if nothing available and socket closed, 0 if nothing available but still open, >0 if data available
 int
 socket_available_fd(int fd) {
@@ -724,6 +868,7 @@ socket_available_fd(int fd) {
 	if (fd == NETWORK_SOCKET_INVALID)
 		return -1;
 
+	NETWORK_COUNT_SYSCALL(NETWORK_SYSCALL_IOCTL);
 #if FOUNDATION_PLATFORM_WINDOWS
 	{
 		u_long avail = 0;
@@ -741,6 +886,43 @@ socket_available_fd(int fd) {
 	return (!available && closed) ? -1 : available;
 }
 
+// Returns -1 on error, 0 if timed out or interrupted, 1 if ready for read/write (or in error/hangup state)
+int
+socket_wait_fd(int fd, bool write, unsigned int timeoutms) {
+#if FOUNDATION_PLATFORM_WINDOWS
+	WSAPOLLFD pfd;
+#else
+	struct pollfd pfd;
+#endif
+	int timeout = (timeoutms == NETWORK_TIMEOUT_INFINITE) ? -1 : (int)timeoutms;
+	int ret;
+
+	if (fd == NETWORK_SOCKET_INVALID)
+		return -1;
+
+	pfd.fd = fd;
+	pfd.events = write ? POLLOUT : POLLIN;
+	pfd.revents = 0;
+
+	NETWORK_COUNT_SYSCALL(NETWORK_SYSCALL_POLL);
+#if FOUNDATION_PLATFORM_WINDOWS
+	ret = WSAPoll(&pfd, 1, timeout);
+#else
+	ret = poll(&pfd, 1, timeout);
+	if ((ret < 0) && (errno == EINTR))
+		ret = 0;
+#endif
+
+	return (ret > 0) ? 1 : ret;
+}
+
+int
+socket_wait(socket_t* sock, bool write, unsigned int timeoutms) {
+	if (sock->vtable && (sock->fd != NETWORK_SOCKET_INVALID))
+		return sock->vtable->wait(sock, write, timeoutms);
+	return socket_wait_fd(sock->fd, write, timeoutms);
+}
+
 void
 socket_close(socket_t* sock) {
 	int fd = NETWORK_SOCKET_INVALID;
@@ -748,6 +930,8 @@ socket_close(socket_t* sock) {
 	network_address_t* remote_address = sock->address_remote;
 
 	if (sock->fd != NETWORK_SOCKET_INVALID) {
+		if (sock->vtable)
+			sock->vtable->close(sock);
 		fd = sock->fd;
 		sock->fd = NETWORK_SOCKET_INVALID;
 		sock->family = 0;
@@ -806,13 +990,23 @@ socket_store_address_local(socket_t* sock, int family) {
 	if (family == NETWORK_ADDRESSFAMILY_IPV4) {
 		address_local = memory_allocate(HASH_NETWORK, sizeof(network_address_ipv4_t), 0,
 		                                MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+		NETWORK_COUNT_ALLOCATION(NETWORK_ALLOCATION_ADDRESS_LOCAL, sizeof(network_address_ipv4_t));
 		address_local->family = NETWORK_ADDRESSFAMILY_IPV4;
 		address_local->address_size = sizeof(struct sockaddr_in);
 	} else if (family == NETWORK_ADDRESSFAMILY_IPV6) {
 		address_local = memory_allocate(HASH_NETWORK, sizeof(network_address_ipv6_t), 0,
 		                                MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+		NETWORK_COUNT_ALLOCATION(NETWORK_ALLOCATION_ADDRESS_LOCAL, sizeof(network_address_ipv6_t));
 		address_local->family = NETWORK_ADDRESSFAMILY_IPV6;
 		address_local->address_size = sizeof(struct sockaddr_in6);
+#if FOUNDATION_PLATFORM_POSIX
+	} else if (family == NETWORK_ADDRESSFAMILY_UNIX) {
+		address_local = memory_allocate(HASH_NETWORK, sizeof(network_address_unix_t), 0,
+		                                MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+		NETWORK_COUNT_ALLOCATION(NETWORK_ALLOCATION_ADDRESS_LOCAL, sizeof(network_address_unix_t));
+		address_local->family = NETWORK_ADDRESSFAMILY_UNIX;
+		address_local->address_size = sizeof(struct sockaddr_un);
+#endif
 	} else {
 		FOUNDATION_ASSERT_FAILFORMAT_LOG(HASH_NETWORK,
 		                                 "Unable to get local address for socket (0x%" PRIfixPTR
@@ -837,7 +1031,8 @@ socket_set_beacon(socket_t* sock, beacon_t* beacon) {
 		if (sock->state == SOCKETSTATE_LISTENING) {
 			WSAEventSelect(sock->fd, sock->event, FD_ACCEPT);
 			beacon_add_handle(beacon, sock->event);
-		} else if ((sock->type == NETWORK_SOCKETTYPE_UDP) || (sock->state == SOCKETSTATE_CONNECTED)) {
+		} else if ((sock->type == NETWORK_SOCKETTYPE_UDP) || (sock->type == NETWORK_SOCKETTYPE_UNIX_DGRAM) ||
+		           (sock->state == SOCKETSTATE_CONNECTED)) {
 			WSAEventSelect(sock->fd, sock->event, FD_READ | FD_CLOSE);
 			beacon_add_handle(beacon, sock->event);
 		} else if ((sock->type == NETWORK_SOCKETTYPE_TCP) && (sock->state == SOCKETSTATE_CONNECTING)) {
@@ -854,6 +1049,18 @@ socket_set_beacon(socket_t* sock, beacon_t* beacon) {
 #endif
 }
 
+void
+socket_set_address_filter(socket_t* sock, const network_cidr_t* filter, bool allow) {
+	sock->filter = filter;
+	sock->flags = (allow ? sock->flags | SOCKETFLAG_FILTER_ALLOW : sock->flags & ~SOCKETFLAG_FILTER_ALLOW);
+}
+
+bool
+socket_filter_allow(const socket_t* sock, const network_address_t* address) {
+	bool match = (network_cidr_lookup(sock->filter, address) != nullptr);
+	return match == ((sock->flags & SOCKETFLAG_FILTER_ALLOW) != 0);
+}
+
 void
 socket_set_state(socket_t* sock, socket_state_t state) {
 	sock->state = state;
@@ -57,6 +57,27 @@ socket_reuse_port(const socket_t* sock);
 NETWORK_API void
 socket_set_reuse_port(socket_t* sock, bool reuse);
 
+/*! Set a socket option. The value is stored in the socket and reapplied if the socket file
+descriptor is recreated, options not explicitly set default to the values in the network config
+(see #network_config_t). Note that some options like TCP_QUICKACK are not permanent in the system
+and only stored values are reapplied on recreation.
+\param sock Socket
+\param option Option
+\param value Value
+\return true if successful (or deferred until the socket is created), false if the option is not
+        supported on the platform or for the socket type, or could not be set */
+NETWORK_API bool
+socket_set_option(socket_t* sock, network_socket_option_t option, int value);
+
+/*! Get a socket option. If the socket is created the current value is queried from the system,
+which can differ from the requested value (Linux doubles requested buffer sizes for bookkeeping
+overhead). Otherwise the value stored in the socket is returned.
+\param sock Socket
+\param option Option
+\return Option value, -1 if not supported or not set */
+NETWORK_API int
+socket_option(const socket_t* sock, network_socket_option_t option);
+
 NETWORK_API bool
 socket_set_multicast_group(socket_t* sock, const network_address_t* multicast_address,
                            const network_address_t* local_address, bool allow_loopback);
@@ -91,3 +112,13 @@ sockets the beacon is fired when a connection is available.
 \param beacon Beacon to fire */
 NETWORK_API void
 socket_set_beacon(socket_t* sock, beacon_t* beacon);
+
+/*! Set a CIDR table filtering peers of the socket. For listening TCP sockets connections from
+filtered peers are closed directly after accept, and for UDP sockets datagrams from filtered peers
+are dropped on receive. The table must outlive the socket or be reset before it is deallocated.
+\param sock Socket
+\param filter CIDR table, null to disable filtering
+\param allow If true only peers matching a prefix in the table are allowed (allow list),
+              if false peers matching a prefix are dropped (deny list) */
+NETWORK_API void
+socket_set_address_filter(socket_t* sock, const network_cidr_t* filter, bool allow);
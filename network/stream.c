@@ -15,6 +15,18 @@
 
 #include <foundation/foundation.h>
 
+#if FOUNDATION_ARCH_SSE2
+#include <emmintrin.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#elif FOUNDATION_ARCH_NEON
+#include <arm_neon.h>
+#endif
+
+//! Maximum encoded size of a 64-bit variable length integer
+#define SOCKET_STREAM_VARINT_MAX_SIZE 10
+
 static stream_vtable_t socket_stream_vtable;
 
 static size_t
@@ -22,8 +34,63 @@ socket_stream_available_nonblock_read(const socket_stream_t* stream) {
 	return (stream->write_in - stream->read_in) + socket_available_read(stream->socket);
 }
 
+// Queue a corked stream for flush by its poll object. The dirty list is owned by the thread
+// running the poll, see socket_stream_cork
+static void
+socket_stream_mark_dirty(socket_stream_t* stream) {
+	if (stream->corked && !stream->dirty && stream->cork_poll) {
+		stream->dirty = true;
+		array_push(stream->cork_poll->streams_dirty, stream);
+	}
+}
+
+static void
+socket_stream_remove_dirty(socket_stream_t* stream) {
+	size_t istream, count;
+	if (!stream->dirty || !stream->cork_poll)
+		return;
+	for (istream = 0, count = array_size(stream->cork_poll->streams_dirty); istream < count; ++istream) {
+		if (stream->cork_poll->streams_dirty[istream] == stream) {
+			array_erase(stream->cork_poll->streams_dirty, istream);
+			break;
+		}
+	}
+	stream->dirty = false;
+}
+
+static tick_t
+socket_stream_deadline(unsigned int timeoutms) {
+	if (!timeoutms || (timeoutms == NETWORK_TIMEOUT_INFINITE))
+		return 0;
+	return time_current() + (((tick_t)timeoutms * time_ticks_per_second()) / 1000);
+}
+
+//! Wait until socket is readable/writable, return false if deadline passed (zero deadline waits indefinitely)
+static bool
+socket_stream_wait(socket_stream_t* stream, bool write, tick_t deadline) {
+	socket_t* sock = stream->socket;
+	unsigned int timeoutms = NETWORK_TIMEOUT_INFINITE;
+	int ret;
+
+	while (sock->fd != NETWORK_SOCKET_INVALID) {
+		if (deadline) {
+			tick_t now = time_current();
+			if (now >= deadline)
+				return false;
+			timeoutms = (unsigned int)((((deadline - now) * 1000) + time_ticks_per_second() - 1) /
+			                           time_ticks_per_second());
+		}
+		ret = socket_wait(sock, write, timeoutms);
+		if (ret > 0)
+			return true;
+		if (ret < 0)
+			return false;
+	}
+	return false;
+}
+
 static void
-socket_stream_doflush(socket_stream_t* stream) {
+socket_stream_doflush(socket_stream_t* stream, bool more) {
 	socket_t* sock;
 	size_t written;
 
@@ -34,7 +101,8 @@ socket_stream_doflush(socket_stream_t* stream) {
 	if ((sock->fd == NETWORK_SOCKET_INVALID) || (sock->state != SOCKETSTATE_CONNECTED))
 		return;
 
-	written = socket_write(sock, stream->buffer_out, stream->write_out);
+	written = socket_send(sock, stream->buffer_out, stream->write_out,
+	                      (more ? NETWORK_SEND_MORE : 0) | (stream->timeout_write ? NETWORK_SEND_NOWAIT : 0));
 	if (written) {
 		if (written < stream->write_out) {
 			memmove(stream->buffer_out, stream->buffer_out + written, stream->write_out - written);
@@ -45,6 +113,21 @@ socket_stream_doflush(socket_stream_t* stream) {
 	}
 }
 
+//! Flush output buffer, making room for more data. With a write timeout the flush waits for
+//! the socket to become writable until the deadline, until the buffer is drained if all is set
+static void
+socket_stream_flush_wait(socket_stream_t* stream, bool more, bool all, tick_t deadline) {
+	socket_t* sock = stream->socket;
+
+	socket_stream_doflush(stream, more);
+	if (!stream->timeout_write)
+		return;
+
+	while (stream->write_out && (all || (stream->write_out == stream->buffer_out_size)) &&
+	       (sock->state == SOCKETSTATE_CONNECTED) && socket_stream_wait(stream, true, deadline))
+		socket_stream_doflush(stream, more);
+}
+
 static size_t
 socket_stream_read(stream_t* stream, void* buffer, size_t size) {
 	socket_stream_t* sockstream;
@@ -54,6 +137,7 @@ socket_stream_read(stream_t* stream, void* buffer, size_t size) {
 	size_t copy;
 	bool try_again;
 	size_t want_read;
+	tick_t deadline;
 
 	sockstream = (socket_stream_t*)stream;
 	sock = sockstream->socket;
@@ -62,6 +146,8 @@ socket_stream_read(stream_t* stream, void* buffer, size_t size) {
 	    ((sock->state != SOCKETSTATE_CONNECTED) && (sock->state != SOCKETSTATE_DISCONNECTED)) || !size)
 		goto exit;
 
+	deadline = socket_stream_deadline(sockstream->timeout_read);
+
 	do {
 		try_again = false;
 
@@ -94,19 +180,30 @@ socket_stream_read(stream_t* stream, void* buffer, size_t size) {
 			FOUNDATION_ASSERT(sockstream->read_in == 0);
 			FOUNDATION_ASSERT(sockstream->write_in == 0);
 			sockstream->read_in = 0;
-			sockstream->write_in = socket_read(sock, sockstream->buffer_in, sockstream->buffer_in_size);
-			if (sockstream->write_in > 0)
-				try_again = true;
+			if (sockstream->timeout_read) {
+				// Wait for data instead of blocking or spinning, socket read state is updated by the read
+				if (!socket_stream_wait(sockstream, false, deadline))
+					break;
+				sockstream->write_in = socket_read(sock, sockstream->buffer_in, sockstream->buffer_in_size);
+				try_again = (sockstream->write_in > 0) ||
+				            ((sock->fd != NETWORK_SOCKET_INVALID) && (sock->state == SOCKETSTATE_CONNECTED));
+			} else {
+				sockstream->write_in = socket_read(sock, sockstream->buffer_in, sockstream->buffer_in_size);
+				if (sockstream->write_in > 0)
+					try_again = true;
+			}
 		}
 	} while ((was_read < size) && try_again);
 
-	if (was_read < size) {
+	if ((was_read < size) && !sockstream->timeout_read) {
 		if (was_read)
 			log_warnf(
 			    HASH_NETWORK, WARNING_SUSPICIOUS,
 			    STRING_CONST("Socket stream (0x%" PRIfixPTR " : %d): partial read %" PRIsize " of %" PRIsize " bytes"),
 			    (uintptr_t)sock, sock->fd, was_read, size);
-		socket_poll_state(sock);
+		// Reads on a connected socket already update state on close and errors
+		if (sock->state != SOCKETSTATE_CONNECTED)
+			socket_poll_state(sock);
 	}
 
 exit:
@@ -120,6 +217,7 @@ socket_stream_write(stream_t* stream, const void* buffer, size_t size) {
 	socket_t* sock;
 	size_t was_written = 0;
 	size_t remain;
+	tick_t deadline;
 
 	sockstream = (socket_stream_t*)stream;
 	sock = sockstream->socket;
@@ -127,6 +225,8 @@ socket_stream_write(stream_t* stream, const void* buffer, size_t size) {
 	if ((sock->fd == NETWORK_SOCKET_INVALID) || (sock->state != SOCKETSTATE_CONNECTED) || !size || !buffer)
 		goto exit;
 
+	deadline = socket_stream_deadline(sockstream->timeout_write);
+
 	remain = sockstream->buffer_out_size - sockstream->write_out;
 
 	do {
@@ -149,7 +249,7 @@ socket_stream_write(stream_t* stream, const void* buffer, size_t size) {
 			sockstream->write_out += remain;
 		}
 
-		socket_stream_doflush(sockstream);
+		socket_stream_flush_wait(sockstream, sockstream->corked, false, deadline);
 
 		if (sock->state != SOCKETSTATE_CONNECTED) {
 			log_warnf(
@@ -163,6 +263,9 @@ socket_stream_write(stream_t* stream, const void* buffer, size_t size) {
 
 	} while (remain);
 
+	if (sockstream->write_out)
+		socket_stream_mark_dirty(sockstream);
+
 exit:
 
 	return was_written;
@@ -202,7 +305,6 @@ static void
 socket_stream_buffer_read(stream_t* stream) {
 	socket_stream_t* sockstream;
 	socket_t* sock;
-	int available;
 
 	FOUNDATION_ASSERT(stream);
 	FOUNDATION_ASSERT(stream->type == STREAMTYPE_SOCKET);
@@ -212,8 +314,7 @@ socket_stream_buffer_read(stream_t* stream) {
 	if ((sock->fd == NETWORK_SOCKET_INVALID) || (sock->state != SOCKETSTATE_CONNECTED) || sockstream->write_in)
 		return;
 
-	available = socket_available_fd(sock->fd);
-	if (available > 0) {
+	if (socket_available_read(sock)) {
 		size_t was_read = socket_read(sock, sockstream->buffer_in, sockstream->buffer_in_size);
 		if (was_read > 0)
 			sockstream->write_in += was_read;
@@ -225,7 +326,8 @@ socket_stream_flush(stream_t* stream) {
 	FOUNDATION_ASSERT(stream);
 	FOUNDATION_ASSERT(stream->type == STREAMTYPE_SOCKET);
 
-	socket_stream_doflush((socket_stream_t*)stream);
+	socket_stream_flush_wait((socket_stream_t*)stream, false, true,
+	                         socket_stream_deadline(((socket_stream_t*)stream)->timeout_write));
 }
 
 static void
@@ -278,11 +380,541 @@ socket_stream_last_modified(const stream_t* stream) {
 	return time_current();
 }
 
+static void
+socket_stream_swap_copy(void* dst, const void* src, size_t count, size_t element_size) {
+	uint8_t* out = dst;
+	const uint8_t* in = src;
+	size_t size = count * element_size;
+	size_t offset = 0;
+
+	// Source and destination may be the same array, loads always precede stores
+#if FOUNDATION_ARCH_SSE2
+	for (; offset + 16 <= size; offset += 16) {
+		__m128i value = _mm_loadu_si128((const __m128i*)(const void*)(in + offset));
+		value = _mm_or_si128(_mm_slli_epi16(value, 8), _mm_srli_epi16(value, 8));
+		if (element_size == 4) {
+			value = _mm_shufflelo_epi16(value, _MM_SHUFFLE(2, 3, 0, 1));
+			value = _mm_shufflehi_epi16(value, _MM_SHUFFLE(2, 3, 0, 1));
+		} else if (element_size == 8) {
+			value = _mm_shufflelo_epi16(value, _MM_SHUFFLE(0, 1, 2, 3));
+			value = _mm_shufflehi_epi16(value, _MM_SHUFFLE(0, 1, 2, 3));
+		}
+		_mm_storeu_si128((__m128i*)(void*)(out + offset), value);
+	}
+#elif FOUNDATION_ARCH_NEON
+	for (; offset + 16 <= size; offset += 16) {
+		uint8x16_t value = vld1q_u8(in + offset);
+		if (element_size == 2)
+			value = vrev16q_u8(value);
+		else if (element_size == 4)
+			value = vrev32q_u8(value);
+		else
+			value = vrev64q_u8(value);
+		vst1q_u8(out + offset, value);
+	}
+#endif
+
+	for (; offset < size; offset += element_size) {
+		if (element_size == 2) {
+			uint16_t value;
+			memcpy(&value, in + offset, sizeof(value));
+			value = byteorder_swap16(value);
+			memcpy(out + offset, &value, sizeof(value));
+		} else if (element_size == 4) {
+			uint32_t value;
+			memcpy(&value, in + offset, sizeof(value));
+			value = byteorder_swap32(value);
+			memcpy(out + offset, &value, sizeof(value));
+		} else {
+			uint64_t value;
+			memcpy(&value, in + offset, sizeof(value));
+			value = byteorder_swap64(value);
+			memcpy(out + offset, &value, sizeof(value));
+		}
+	}
+}
+
+//! Copy whole elements, swapping byte order if the stream byte order differs from the system
+static void
+socket_stream_element_copy(stream_t* stream, void* dst, const void* src, size_t count, size_t element_size) {
+	if (stream->swap)
+		socket_stream_swap_copy(dst, src, count, element_size);
+	else
+		memcpy(dst, src, count * element_size);
+}
+
+static size_t
+socket_stream_write_array(stream_t* stream, const void* values, size_t count, size_t element_size) {
+	socket_stream_t* sockstream;
+	socket_t* sock;
+	size_t was_written = 0;
+	tick_t deadline;
+
+	FOUNDATION_ASSERT(stream);
+	FOUNDATION_ASSERT(stream->type == STREAMTYPE_SOCKET);
+
+	sockstream = (socket_stream_t*)stream;
+	sock = sockstream->socket;
+
+	if ((sock->fd == NETWORK_SOCKET_INVALID) || (sock->state != SOCKETSTATE_CONNECTED) || !count || !values)
+		return 0;
+
+	deadline = socket_stream_deadline(sockstream->timeout_write);
+
+	// Only whole elements are buffered, the returned count is exactly what will be sent
+	while (was_written < count) {
+		size_t remain = (sockstream->buffer_out_size - sockstream->write_out) / element_size;
+		if (!remain) {
+			socket_stream_flush_wait(sockstream, sockstream->corked, false, deadline);
+			if (sock->state != SOCKETSTATE_CONNECTED)
+				break;
+			remain = (sockstream->buffer_out_size - sockstream->write_out) / element_size;
+			if (!remain)
+				break;
+		}
+		if (remain > (count - was_written))
+			remain = count - was_written;
+
+		socket_stream_element_copy(stream, sockstream->buffer_out + sockstream->write_out,
+		                           pointer_offset_const(values, was_written * element_size), remain, element_size);
+
+		sockstream->write_out += remain * element_size;
+		was_written += remain;
+	}
+
+	if (sockstream->write_out)
+		socket_stream_mark_dirty(sockstream);
+
+	if (was_written < count)
+		log_warnf(HASH_NETWORK, WARNING_SUSPICIOUS,
+		          STRING_CONST("Socket stream (0x%" PRIfixPTR " : %d): partial array write %" PRIsize " of %" PRIsize
+		                       " elements"),
+		          (uintptr_t)sock, sock->fd, was_written, count);
+
+	return was_written;
+}
+
+static size_t
+socket_stream_read_array(stream_t* stream, void* values, size_t count, size_t element_size) {
+	socket_stream_t* sockstream;
+	socket_t* sock;
+	size_t was_read = 0;
+	size_t buffered, copy, received;
+	tick_t deadline;
+
+	FOUNDATION_ASSERT(stream);
+	FOUNDATION_ASSERT(stream->type == STREAMTYPE_SOCKET);
+
+	sockstream = (socket_stream_t*)stream;
+	sock = sockstream->socket;
+
+	if ((sock->fd == NETWORK_SOCKET_INVALID) ||
+	    ((sock->state != SOCKETSTATE_CONNECTED) && (sock->state != SOCKETSTATE_DISCONNECTED)) || !count || !values)
+		return 0;
+
+	deadline = socket_stream_deadline(sockstream->timeout_read);
+
+	// Only whole elements are consumed, a trailing partial element stays buffered for the next read
+	while (was_read < count) {
+		buffered = sockstream->write_in - sockstream->read_in;
+		copy = buffered / element_size;
+		if (copy > (count - was_read))
+			copy = count - was_read;
+		if (copy) {
+			socket_stream_element_copy(stream, pointer_offset(values, was_read * element_size),
+			                           sockstream->buffer_in + sockstream->read_in, copy, element_size);
+			was_read += copy;
+			sockstream->read_in += copy * element_size;
+			buffered -= copy * element_size;
+			if (was_read == count)
+				break;
+		}
+
+		// Move the partial element to the start of the buffer and append data from the socket
+		if (buffered && sockstream->read_in)
+			memmove(sockstream->buffer_in, sockstream->buffer_in + sockstream->read_in, buffered);
+		sockstream->read_in = 0;
+		sockstream->write_in = buffered;
+
+		if (buffered >= sockstream->buffer_in_size)
+			break;
+		if (sockstream->timeout_read && !socket_stream_wait(sockstream, false, deadline))
+			break;
+		received = socket_read(sock, sockstream->buffer_in + buffered, sockstream->buffer_in_size - buffered);
+		if (!received) {
+			// With a read timeout keep waiting until the deadline unless the connection is gone
+			if (sockstream->timeout_read && (sock->fd != NETWORK_SOCKET_INVALID) &&
+			    (sock->state == SOCKETSTATE_CONNECTED))
+				continue;
+			break;
+		}
+		sockstream->write_in += received;
+	}
+
+	if (sockstream->read_in == sockstream->write_in) {
+		sockstream->read_in = 0;
+		sockstream->write_in = 0;
+	}
+
+	if (was_read < count) {
+		if (!sockstream->timeout_read && was_read)
+			log_warnf(HASH_NETWORK, WARNING_SUSPICIOUS,
+			          STRING_CONST("Socket stream (0x%" PRIfixPTR " : %d): partial array read %" PRIsize
+			                       " of %" PRIsize " elements"),
+			          (uintptr_t)sock, sock->fd, was_read, count);
+		if (sock->state != SOCKETSTATE_CONNECTED)
+			socket_poll_state(sock);
+	}
+
+	return was_read;
+}
+
+size_t
+socket_stream_write_int16_array(stream_t* stream, const int16_t* values, size_t count) {
+	return socket_stream_write_array(stream, values, count, sizeof(int16_t));
+}
+
+size_t
+socket_stream_write_int32_array(stream_t* stream, const int32_t* values, size_t count) {
+	return socket_stream_write_array(stream, values, count, sizeof(int32_t));
+}
+
+size_t
+socket_stream_write_int64_array(stream_t* stream, const int64_t* values, size_t count) {
+	return socket_stream_write_array(stream, values, count, sizeof(int64_t));
+}
+
+size_t
+socket_stream_write_float32_array(stream_t* stream, const float32_t* values, size_t count) {
+	return socket_stream_write_array(stream, values, count, sizeof(float32_t));
+}
+
+size_t
+socket_stream_write_float64_array(stream_t* stream, const float64_t* values, size_t count) {
+	return socket_stream_write_array(stream, values, count, sizeof(float64_t));
+}
+
+size_t
+socket_stream_read_int16_array(stream_t* stream, int16_t* values, size_t count) {
+	return socket_stream_read_array(stream, values, count, sizeof(int16_t));
+}
+
+size_t
+socket_stream_read_int32_array(stream_t* stream, int32_t* values, size_t count) {
+	return socket_stream_read_array(stream, values, count, sizeof(int32_t));
+}
+
+size_t
+socket_stream_read_int64_array(stream_t* stream, int64_t* values, size_t count) {
+	return socket_stream_read_array(stream, values, count, sizeof(int64_t));
+}
+
+size_t
+socket_stream_read_float32_array(stream_t* stream, float32_t* values, size_t count) {
+	return socket_stream_read_array(stream, values, count, sizeof(float32_t));
+}
+
+size_t
+socket_stream_read_float64_array(stream_t* stream, float64_t* values, size_t count) {
+	return socket_stream_read_array(stream, values, count, sizeof(float64_t));
+}
+
+static size_t
+socket_stream_encode_varint(uint8_t* buffer, uint64_t value) {
+	size_t size = 0;
+	while (value >= 0x80) {
+		buffer[size++] = (uint8_t)(value | 0x80);
+		value >>= 7;
+	}
+	buffer[size++] = (uint8_t)value;
+	return size;
+}
+
+// Returns number of bytes consumed, 0 if value is incomplete
+static size_t
+socket_stream_decode_varint(const uint8_t* buffer, size_t size, uint64_t* value) {
+	uint64_t result = 0;
+	unsigned int shift = 0;
+	size_t offset = 0;
+	if (size > SOCKET_STREAM_VARINT_MAX_SIZE)
+		size = SOCKET_STREAM_VARINT_MAX_SIZE;
+	while (offset < size) {
+		uint8_t byte = buffer[offset++];
+		result |= (uint64_t)(byte & 0x7F) << shift;
+		if (!(byte & 0x80)) {
+			*value = result;
+			return offset;
+		}
+		shift += 7;
+	}
+	return 0;
+}
+
+// Move any unread data to start of input buffer and fill remaining space from socket,
+// with a read timeout waiting for data until the deadline
+static size_t
+socket_stream_refill(socket_stream_t* stream, tick_t deadline) {
+	socket_t* sock = stream->socket;
+	size_t was_read;
+
+	if (stream->read_in) {
+		size_t pending = stream->write_in - stream->read_in;
+		if (pending)
+			memmove(stream->buffer_in, stream->buffer_in + stream->read_in, pending);
+		stream->read_in = 0;
+		stream->write_in = pending;
+	}
+
+	if (stream->write_in >= stream->buffer_in_size)
+		return 0;
+
+	do {
+		if (stream->timeout_read && !socket_stream_wait(stream, false, deadline))
+			return 0;
+		was_read = socket_read(sock, stream->buffer_in + stream->write_in, stream->buffer_in_size - stream->write_in);
+	} while (!was_read && stream->timeout_read && (sock->fd != NETWORK_SOCKET_INVALID) &&
+	         (sock->state == SOCKETSTATE_CONNECTED));
+	stream->write_in += was_read;
+	return was_read;
+}
+
+size_t
+socket_stream_write_varint_array(stream_t* stream, const uint64_t* values, size_t count) {
+	socket_stream_t* sockstream;
+	socket_t* sock;
+	size_t was_written = 0;
+	tick_t deadline;
+
+	FOUNDATION_ASSERT(stream);
+	FOUNDATION_ASSERT(stream->type == STREAMTYPE_SOCKET);
+
+	sockstream = (socket_stream_t*)stream;
+	sock = sockstream->socket;
+
+	if ((sock->fd == NETWORK_SOCKET_INVALID) || (sock->state != SOCKETSTATE_CONNECTED) || !count || !values)
+		return 0;
+
+	deadline = socket_stream_deadline(sockstream->timeout_write);
+	while (was_written < count) {
+		uint8_t* out = sockstream->buffer_out;
+		size_t capacity = sockstream->buffer_out_size;
+		size_t offset = sockstream->write_out;
+
+		while ((was_written < count) && (offset + SOCKET_STREAM_VARINT_MAX_SIZE <= capacity))
+			offset += socket_stream_encode_varint(out + offset, values[was_written++]);
+		sockstream->write_out = offset;
+
+		if (was_written < count) {
+			socket_stream_flush_wait(sockstream, sockstream->corked, false, deadline);
+			if (sock->state != SOCKETSTATE_CONNECTED)
+				break;
+			if (sockstream->write_out + SOCKET_STREAM_VARINT_MAX_SIZE > capacity) {
+				// Output buffer too small or unable to flush, only buffer the next value if it fits whole
+				// so the returned count is exactly what will be sent
+				uint8_t encoded[SOCKET_STREAM_VARINT_MAX_SIZE];
+				size_t size = socket_stream_encode_varint(encoded, values[was_written]);
+				if (sockstream->write_out + size > capacity)
+					break;
+				memcpy(out + sockstream->write_out, encoded, size);
+				sockstream->write_out += size;
+				++was_written;
+			}
+		}
+	}
+
+	if (sockstream->write_out)
+		socket_stream_mark_dirty(sockstream);
+
+	return was_written;
+}
+
+size_t
+socket_stream_read_varint_array(stream_t* stream, uint64_t* values, size_t count) {
+	socket_stream_t* sockstream;
+	socket_t* sock;
+	size_t was_read = 0;
+	tick_t deadline;
+
+	FOUNDATION_ASSERT(stream);
+	FOUNDATION_ASSERT(stream->type == STREAMTYPE_SOCKET);
+
+	sockstream = (socket_stream_t*)stream;
+	sock = sockstream->socket;
+
+	if ((sock->fd == NETWORK_SOCKET_INVALID) ||
+	    ((sock->state != SOCKETSTATE_CONNECTED) && (sock->state != SOCKETSTATE_DISCONNECTED)) || !count || !values)
+		return 0;
+
+	deadline = socket_stream_deadline(sockstream->timeout_read);
+	while (was_read < count) {
+		const uint8_t* in = sockstream->buffer_in;
+		size_t offset = sockstream->read_in;
+		size_t end = sockstream->write_in;
+
+		while (was_read < count) {
+			size_t consumed = socket_stream_decode_varint(in + offset, end - offset, values + was_read);
+			if (!consumed)
+				break;
+			offset += consumed;
+			++was_read;
+		}
+
+		if (offset == end) {
+			sockstream->read_in = 0;
+			sockstream->write_in = 0;
+		} else {
+			sockstream->read_in = offset;
+			if ((end - offset) >= SOCKET_STREAM_VARINT_MAX_SIZE) {
+				if (was_read < count) {
+					log_warnf(HASH_NETWORK, WARNING_INVALID_VALUE,
+					          STRING_CONST("Socket stream (0x%" PRIfixPTR " : %d): malformed variable length integer"),
+					          (uintptr_t)sock, sock->fd);
+					break;
+				}
+			}
+		}
+
+		if ((was_read < count) && !socket_stream_refill(sockstream, deadline))
+			break;
+	}
+
+	return was_read;
+}
+
+#if FOUNDATION_ARCH_SSE2
+
+static FOUNDATION_FORCEINLINE size_t
+socket_stream_first_bit(uint32_t mask) {
+#if FOUNDATION_COMPILER_MSVC
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return (size_t)index;
+#else
+	return (size_t)__builtin_ctz(mask);
+#endif
+}
+
+#endif
+
+//! Find first occurrence of byte in data, return length if not found
+static size_t
+socket_stream_scan_byte(const uint8_t* data, size_t length, uint8_t byte) {
+#if FOUNDATION_ARCH_SSE2
+	size_t offset = 0;
+#if defined(__AVX2__)
+	const __m256i wide_needle = _mm256_set1_epi8((char)byte);
+	for (; offset + 32 <= length; offset += 32) {
+		__m256i chunk = _mm256_loadu_si256((const __m256i*)(data + offset));
+		uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, wide_needle));
+		if (mask)
+			return offset + socket_stream_first_bit(mask);
+	}
+#endif
+	const __m128i needle = _mm_set1_epi8((char)byte);
+	for (; offset + 16 <= length; offset += 16) {
+		__m128i chunk = _mm_loadu_si128((const __m128i*)(data + offset));
+		uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle));
+		if (mask)
+			return offset + socket_stream_first_bit(mask);
+	}
+	for (; offset < length; ++offset) {
+		if (data[offset] == byte)
+			return offset;
+	}
+	return length;
+#else
+	const uint8_t* found = memchr(data, byte, length);
+	return found ? (size_t)(found - data) : length;
+#endif
+}
+
+//! Find delimiter in data starting at given offset, return length if not found
+static size_t
+socket_stream_scan(const uint8_t* data, size_t length, size_t offset, const char* delim, size_t delim_length) {
+	const uint8_t first = (uint8_t)delim[0];
+	while (offset + delim_length <= length) {
+		offset += socket_stream_scan_byte(data + offset, length - offset - (delim_length - 1), first);
+		if (offset + delim_length > length)
+			break;
+		if ((delim_length == 1) || !memcmp(data + offset + 1, delim + 1, delim_length - 1))
+			return offset;
+		++offset;
+	}
+	return length;
+}
+
+size_t
+socket_stream_find(stream_t* stream, const char* delim, size_t delim_length) {
+	socket_stream_t* sockstream;
+	size_t pending, offset;
+
+	FOUNDATION_ASSERT(stream);
+	FOUNDATION_ASSERT(stream->type == STREAMTYPE_SOCKET);
+
+	sockstream = (socket_stream_t*)stream;
+	pending = sockstream->write_in - sockstream->read_in;
+	if (!delim_length || (pending < delim_length))
+		return STRING_NPOS;
+
+	offset = socket_stream_scan(sockstream->buffer_in + sockstream->read_in, pending, 0, delim, delim_length);
+	return (offset < pending) ? offset : STRING_NPOS;
+}
+
+string_const_t
+socket_stream_read_until(stream_t* stream, const char* delim, size_t delim_length) {
+	socket_stream_t* sockstream;
+	socket_t* sock;
+	size_t scanned = 0;
+	size_t pending, offset;
+	const char* line;
+	tick_t deadline;
+
+	FOUNDATION_ASSERT(stream);
+	FOUNDATION_ASSERT(stream->type == STREAMTYPE_SOCKET);
+
+	sockstream = (socket_stream_t*)stream;
+	sock = sockstream->socket;
+
+	if (!delim_length || (sock->fd == NETWORK_SOCKET_INVALID) ||
+	    ((sock->state != SOCKETSTATE_CONNECTED) && (sock->state != SOCKETSTATE_DISCONNECTED)))
+		return string_null();
+
+	deadline = socket_stream_deadline(sockstream->timeout_read);
+	while (true) {
+		pending = sockstream->write_in - sockstream->read_in;
+		offset = socket_stream_scan(sockstream->buffer_in + sockstream->read_in, pending, scanned, delim, delim_length);
+		if (offset < pending)
+			break;
+
+		// Delimiter not found, only rescan the tail that could hold a partial delimiter
+		scanned = (pending >= delim_length) ? pending - (delim_length - 1) : 0;
+
+		if ((pending == sockstream->buffer_in_size) || !socket_stream_refill(sockstream, deadline)) {
+			if (pending == sockstream->buffer_in_size)
+				log_warnf(HASH_NETWORK, WARNING_SUSPICIOUS,
+				          STRING_CONST("Socket stream (0x%" PRIfixPTR " : %d): delimiter not found in full buffer of "
+				                       "%" PRIsize " bytes"),
+				          (uintptr_t)sock, sock->fd, sockstream->buffer_in_size);
+			return string_null();
+		}
+	}
+
+	line = (const char*)sockstream->buffer_in + sockstream->read_in;
+	sockstream->read_in += offset + delim_length;
+	if (sockstream->read_in == sockstream->write_in) {
+		sockstream->read_in = 0;
+		sockstream->write_in = 0;
+	}
+
+	return string_const(line, offset);
+}
+
 stream_t*
 socket_stream_allocate(socket_t* sock, size_t buffer_in, size_t buffer_out) {
 	size_t size = sizeof(socket_stream_t) + buffer_in + buffer_out;
 
 	socket_stream_t* sockstream = memory_allocate(HASH_NETWORK, size, 0, MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	NETWORK_COUNT_ALLOCATION(NETWORK_ALLOCATION_STREAM, size);
 	sockstream->buffer_in = pointer_offset(sockstream, sizeof(socket_stream_t));
 	sockstream->buffer_out = pointer_offset(sockstream->buffer_in, buffer_in);
 	sockstream->buffer_in_size = buffer_in;
@@ -306,9 +938,77 @@ socket_stream_initialize(socket_stream_t* stream, socket_t* sock) {
 		sock->stream_initialize_fn(sock, (stream_t*)stream);
 }
 
+void
+socket_stream_cork(stream_t* stream, network_poll_t* poll) {
+	socket_stream_t* sockstream;
+
+	FOUNDATION_ASSERT(stream);
+	FOUNDATION_ASSERT(stream->type == STREAMTYPE_SOCKET);
+
+	sockstream = (socket_stream_t*)stream;
+	if (sockstream->corked && (sockstream->cork_poll != poll))
+		socket_stream_remove_dirty(sockstream);
+
+	sockstream->corked = true;
+	sockstream->cork_poll = poll;
+	if (sockstream->write_out)
+		socket_stream_mark_dirty(sockstream);
+}
+
+void
+socket_stream_uncork(stream_t* stream) {
+	socket_stream_t* sockstream;
+
+	FOUNDATION_ASSERT(stream);
+	FOUNDATION_ASSERT(stream->type == STREAMTYPE_SOCKET);
+
+	sockstream = (socket_stream_t*)stream;
+	if (!sockstream->corked)
+		return;
+
+	socket_stream_remove_dirty(sockstream);
+	sockstream->corked = false;
+	sockstream->cork_poll = nullptr;
+	socket_stream_doflush(sockstream, false);
+}
+
+bool
+socket_stream_is_corked(stream_t* stream) {
+	FOUNDATION_ASSERT(stream);
+	FOUNDATION_ASSERT(stream->type == STREAMTYPE_SOCKET);
+	return ((socket_stream_t*)stream)->corked;
+}
+
+void
+socket_stream_set_timeout(stream_t* stream, unsigned int read_timeoutms, unsigned int write_timeoutms) {
+	socket_stream_t* sockstream;
+
+	FOUNDATION_ASSERT(stream);
+	FOUNDATION_ASSERT(stream->type == STREAMTYPE_SOCKET);
+
+	sockstream = (socket_stream_t*)stream;
+	sockstream->timeout_read = read_timeoutms;
+	sockstream->timeout_write = write_timeoutms;
+}
+
+bool
+socket_stream_flush_corked(socket_stream_t* stream) {
+	socket_t* sock = stream->socket;
+
+	stream->dirty = false;
+	socket_stream_doflush(stream, false);
+
+	if (stream->write_out && (sock->fd != NETWORK_SOCKET_INVALID) && (sock->state == SOCKETSTATE_CONNECTED)) {
+		// Socket send buffer full, retry on next flush
+		stream->dirty = true;
+		return false;
+	}
+	return true;
+}
+
 static void
 socket_stream_finalize_stream(stream_t* stream) {
-	FOUNDATION_UNUSED(stream);
+	socket_stream_remove_dirty((socket_stream_t*)stream);
 }
 
 int
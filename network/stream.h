@@ -26,3 +26,164 @@ socket_stream_initialize(socket_stream_t* stream, socket_t* sock);
 
 NETWORK_API void
 socket_stream_finalize(socket_stream_t* stream);
+
+/*! Enable corked mode on a socket stream. In corked mode writes only accumulate in the stream
+output buffer. The buffered data is sent with a single send call when the stream is explicitly
+flushed, or for streams associated with a poll object, by #network_poll_flush which is called
+at the start of each #network_poll call, i.e at the end of the previous event loop iteration.
+If the output buffer fills up mid-response the data is sent with a hint that more data follows
+(MSG_MORE where supported) to avoid pushing out partial segments. The poll object must outlive
+the stream, or the stream must be uncorked before the poll object is finalized. The list of
+streams pending flush in the poll object is not locked, a stream corked with a poll object must
+only be written from the thread calling #network_poll on that poll object.
+\param stream Socket stream
+\param poll Poll object flushing the stream, null for explicit flush only */
+NETWORK_API void
+socket_stream_cork(stream_t* stream, network_poll_t* poll);
+
+/*! Disable corked mode on a socket stream and flush any buffered data
+\param stream Socket stream */
+NETWORK_API void
+socket_stream_uncork(stream_t* stream);
+
+/*! Query if socket stream is in corked mode
+\param stream Socket stream
+\return true if corked, false if not */
+NETWORK_API bool
+socket_stream_is_corked(stream_t* stream);
+
+/*! Set read and write deadlines on a socket stream. With a timeout set, a read or write on
+the stream waits on the socket with poll() until data can be transferred or the deadline for
+the call expires, instead of blocking indefinitely on a blocking socket or returning a partial
+result immediately on a non-blocking socket. A timeout of zero disables the deadline (the
+default) and restores the plain blocking/non-blocking behaviour of the underlying socket, and
+#NETWORK_TIMEOUT_INFINITE waits until the operation completes or the socket is closed.
+\param stream Socket stream
+\param read_timeoutms Read timeout in milliseconds
+\param write_timeoutms Write timeout in milliseconds */
+NETWORK_API void
+socket_stream_set_timeout(stream_t* stream, unsigned int read_timeoutms, unsigned int write_timeoutms);
+
+/*! Write an array of 16-bit integers to a socket stream. Values are byte swapped to the
+stream byte order while being copied directly into the stream output buffer.
+\param stream Socket stream
+\param values Values to write
+\param count Number of values
+\return Number of values written */
+NETWORK_API size_t
+socket_stream_write_int16_array(stream_t* stream, const int16_t* values, size_t count);
+
+/*! Write an array of 32-bit integers to a socket stream, see #socket_stream_write_int16_array
+\param stream Socket stream
+\param values Values to write
+\param count Number of values
+\return Number of values written */
+NETWORK_API size_t
+socket_stream_write_int32_array(stream_t* stream, const int32_t* values, size_t count);
+
+/*! Write an array of 64-bit integers to a socket stream, see #socket_stream_write_int16_array
+\param stream Socket stream
+\param values Values to write
+\param count Number of values
+\return Number of values written */
+NETWORK_API size_t
+socket_stream_write_int64_array(stream_t* stream, const int64_t* values, size_t count);
+
+/*! Write an array of 32-bit floats to a socket stream, see #socket_stream_write_int16_array
+\param stream Socket stream
+\param values Values to write
+\param count Number of values
+\return Number of values written */
+NETWORK_API size_t
+socket_stream_write_float32_array(stream_t* stream, const float32_t* values, size_t count);
+
+/*! Write an array of 64-bit floats to a socket stream, see #socket_stream_write_int16_array
+\param stream Socket stream
+\param values Values to write
+\param count Number of values
+\return Number of values written */
+NETWORK_API size_t
+socket_stream_write_float64_array(stream_t* stream, const float64_t* values, size_t count);
+
+/*! Read an array of 16-bit integers from a socket stream. Values are byte swapped from the
+stream byte order in place in the destination array.
+\param stream Socket stream
+\param values Destination array
+\param count Number of values to read
+\return Number of values read */
+NETWORK_API size_t
+socket_stream_read_int16_array(stream_t* stream, int16_t* values, size_t count);
+
+/*! Read an array of 32-bit integers from a socket stream, see #socket_stream_read_int16_array
+\param stream Socket stream
+\param values Destination array
+\param count Number of values to read
+\return Number of values read */
+NETWORK_API size_t
+socket_stream_read_int32_array(stream_t* stream, int32_t* values, size_t count);
+
+/*! Read an array of 64-bit integers from a socket stream, see #socket_stream_read_int16_array
+\param stream Socket stream
+\param values Destination array
+\param count Number of values to read
+\return Number of values read */
+NETWORK_API size_t
+socket_stream_read_int64_array(stream_t* stream, int64_t* values, size_t count);
+
+/*! Read an array of 32-bit floats from a socket stream, see #socket_stream_read_int16_array
+\param stream Socket stream
+\param values Destination array
+\param count Number of values to read
+\return Number of values read */
+NETWORK_API size_t
+socket_stream_read_float32_array(stream_t* stream, float32_t* values, size_t count);
+
+/*! Read an array of 64-bit floats from a socket stream, see #socket_stream_read_int16_array
+\param stream Socket stream
+\param values Destination array
+\param count Number of values to read
+\return Number of values read */
+NETWORK_API size_t
+socket_stream_read_float64_array(stream_t* stream, float64_t* values, size_t count);
+
+/*! Write an array of unsigned integers to a socket stream as variable length integers
+(LEB128, 7 bits per byte). The encoding is byte order independent.
+\param stream Socket stream
+\param values Values to write
+\param count Number of values
+\return Number of values written */
+NETWORK_API size_t
+socket_stream_write_varint_array(stream_t* stream, const uint64_t* values, size_t count);
+
+/*! Read an array of variable length integers from a socket stream. Values are decoded in
+batches directly from the stream input buffer. A value only partially received is kept
+buffered until the remaining bytes arrive.
+\param stream Socket stream
+\param values Destination array
+\param count Number of values to read
+\return Number of values read */
+NETWORK_API size_t
+socket_stream_read_varint_array(stream_t* stream, uint64_t* values, size_t count);
+
+/*! Find a delimiter in the data currently buffered in the socket stream input buffer,
+without reading more data from the socket.
+\param stream Socket stream
+\param delim Delimiter
+\param delim_length Length of delimiter
+\return Offset of delimiter relative to current read position, STRING_NPOS if not found */
+NETWORK_API size_t
+socket_stream_find(stream_t* stream, const char* delim, size_t delim_length);
+
+/*! Read data up to the given delimiter (for example "\r\n" in line based text protocols).
+The input buffer is scanned and incrementally refilled from the socket until the delimiter
+is found. The returned string is a view into the stream input buffer, excluding the
+delimiter, and is only valid until the next read operation on the stream. The line and
+delimiter are consumed from the stream. If the delimiter is not found before the socket
+would block, or the line does not fit in the stream input buffer, a null string is
+returned and the data is kept buffered.
+\param stream Socket stream
+\param delim Delimiter
+\param delim_length Length of delimiter
+\return View of data up to the delimiter, null string (null pointer) if not found */
+NETWORK_API string_const_t
+socket_stream_read_until(stream_t* stream, const char* delim, size_t delim_length);
@@ -12,6 +12,8 @@
 #include <network/tcp.h>
 #include <network/socket.h>
 #include <network/address.h>
+#include <network/poll.h>
+#include <network/unix.h>
 #include <network/internal.h>
 
 #include <foundation/foundation.h>
@@ -23,12 +25,68 @@
 static void
 tcp_socket_open(socket_t*, unsigned int);
 
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+
+// Kernel layout of struct tcp_info, the libc declaration lacks fields added after Linux 2.6. The
+// kernel copies as much as fits and returns the length, fields past the length were not provided
+typedef struct tcp_info_kernel_t {
+	uint8_t state;
+	uint8_t ca_state;
+	uint8_t retransmits;
+	uint8_t probes;
+	uint8_t backoff;
+	uint8_t options;
+	uint8_t wscale;
+	uint8_t flags;
+	uint32_t rto;
+	uint32_t ato;
+	uint32_t snd_mss;
+	uint32_t rcv_mss;
+	uint32_t unacked;
+	uint32_t sacked;
+	uint32_t lost;
+	uint32_t retrans;
+	uint32_t fackets;
+	uint32_t last_data_sent;
+	uint32_t last_ack_sent;
+	uint32_t last_data_recv;
+	uint32_t last_ack_recv;
+	uint32_t pmtu;
+	uint32_t rcv_ssthresh;
+	uint32_t rtt;
+	uint32_t rttvar;
+	uint32_t snd_ssthresh;
+	uint32_t snd_cwnd;
+	uint32_t advmss;
+	uint32_t reordering;
+	uint32_t rcv_rtt;
+	uint32_t rcv_space;
+	uint32_t total_retrans;
+	uint64_t pacing_rate;
+	uint64_t max_pacing_rate;
+	uint64_t bytes_acked;
+	uint64_t bytes_received;
+	uint32_t segs_out;
+	uint32_t segs_in;
+	uint32_t notsent_bytes;
+	uint32_t min_rtt;
+	uint32_t data_segs_in;
+	uint32_t data_segs_out;
+	uint64_t delivery_rate;
+} tcp_info_kernel_t;
+
+#define TCP_INFO_HAS(length, field) \
+	((length) >= (offsetof(tcp_info_kernel_t, field) + sizeof(((tcp_info_kernel_t*)0)->field)))
+
+#endif
+
 static void
 tcp_stream_initialize(socket_t*, stream_t*);
 
 socket_t*
 tcp_socket_allocate(void) {
 	socket_t* sock = memory_allocate(HASH_NETWORK, sizeof(socket_t), 0, MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	NETWORK_COUNT_ALLOCATION(NETWORK_ALLOCATION_SOCKET, sizeof(socket_t));
 	tcp_socket_initialize(sock);
 	return sock;
 }
@@ -109,7 +167,7 @@ tcp_socket_accept(socket_t* sock, unsigned int timeoutms) {
 
 	address_remote = network_address_clone(sock->address_local);
 	address_ip = (network_address_ip_t*)address_remote;
-	address_len = address_remote->address_size;
+	address_len = (socklen_t)sizeof(struct sockaddr_storage);
 
 	fd = (int)accept(sock->fd, &address_ip->saddr, &address_len);
 	if (fd < 0) {
@@ -136,7 +194,7 @@ tcp_socket_accept(socket_t* sock, unsigned int timeoutms) {
 				ret =
 				    select(sock->fd + 1, &fdread, 0, &fderr, (timeoutms != NETWORK_TIMEOUT_INFINITE) ? &tval : nullptr);
 				if (ret > 0) {
-					address_len = address_remote->address_size;
+					address_len = (socklen_t)sizeof(struct sockaddr_storage);
 					fd = (int)accept(sock->fd, &address_ip->saddr, &address_len);
 				}
 			}
@@ -152,7 +210,19 @@ tcp_socket_accept(socket_t* sock, unsigned int timeoutms) {
 		return 0;
 	}
 
-	accepted = tcp_socket_allocate();
+	// Size of unix domain peer addresses varies with path length
+	address_remote->address_size = (network_address_size_t)address_len;
+
+	if (sock->filter && !socket_filter_allow(sock, address_remote)) {
+		socket_close_fd(fd);
+		memory_deallocate(address_remote);
+		return 0;
+	}
+
+	if (sock->type == NETWORK_SOCKETTYPE_UNIX_STREAM)
+		accepted = unix_socket_allocate(NETWORK_SOCKETTYPE_UNIX_STREAM);
+	else
+		accepted = tcp_socket_allocate();
 	if (!accepted) {
 		log_debugf(HASH_NETWORK, STRING_CONST("Unable to allocate socket for accepted fd: %d"), fd);
 		socket_close_fd(fd);
@@ -163,6 +233,10 @@ tcp_socket_accept(socket_t* sock, unsigned int timeoutms) {
 	accepted->family = address_ip->family;
 	accepted->address_remote = (network_address_t*)address_remote;
 
+	// Options are inherited from the listening socket by the system, keep stored values in sync
+	accepted->options_set = sock->options_set;
+	memcpy(accepted->options, sock->options, sizeof(accepted->options));
+
 	socket_set_state(accepted, SOCKETSTATE_CONNECTED);
 	socket_store_address_local(accepted, (int)address_ip->family);
 
@@ -185,6 +259,305 @@ tcp_socket_accept(socket_t* sock, unsigned int timeoutms) {
 	return accepted;
 }
 
+// Interleave address families, starting with the family of the first (preferred) address
+static void
+tcp_socket_connect_order(network_address_t** addresses, size_t count, size_t* order) {
+	network_address_family_t first = addresses[0]->family;
+	size_t ifirst = 0, iother = 0, iorder = 0;
+	while (iorder < count) {
+		while ((ifirst < count) && (addresses[ifirst]->family != first))
+			++ifirst;
+		if (ifirst < count)
+			order[iorder++] = ifirst++;
+		while ((iother < count) && (addresses[iother]->family == first))
+			++iother;
+		if (iother < count)
+			order[iorder++] = iother++;
+	}
+}
+
+static unsigned int
+tcp_socket_ticks_to_ms(tick_t ticks) {
+	return (unsigned int)(((ticks * 1000) + time_ticks_per_second() - 1) / time_ticks_per_second());
+}
+
+socket_t*
+tcp_socket_connect_any(network_address_t** addresses, unsigned int delayms, unsigned int timeoutms) {
+	size_t count = array_size(addresses);
+	network_poll_event_t events[16];
+	network_poll_t* poll;
+	socket_t* connected = nullptr;
+	socket_t** pending;
+	size_t* order;
+	size_t inext = 0;
+	tick_t start, next_attempt, delay, deadline = 0;
+
+	if (!count)
+		return nullptr;
+
+	if (!delayms)
+		delayms = NETWORK_CONNECT_ATTEMPT_DELAY;
+
+	order = memory_allocate(HASH_NETWORK, sizeof(size_t) * count, 0, MEMORY_TEMPORARY);
+	NETWORK_COUNT_ALLOCATION(NETWORK_ALLOCATION_CONNECT, sizeof(size_t) * count);
+	tcp_socket_connect_order(addresses, count, order);
+
+	poll = network_poll_allocate((unsigned int)count);
+	delay = ((tick_t)delayms * time_ticks_per_second()) / 1000;
+	start = time_current();
+	next_attempt = start;
+	if (timeoutms != NETWORK_TIMEOUT_INFINITE)
+		deadline = start + (((tick_t)timeoutms * time_ticks_per_second()) / 1000);
+
+	while (!connected) {
+		tick_t now = time_current();
+		unsigned int waitms = NETWORK_TIMEOUT_INFINITE;
+		size_t num_events;
+
+		if (deadline && (now >= deadline))
+			break;
+
+		// Start next attempt when the attempt delay has passed, or directly if no attempt is in flight
+		if ((inext < count) && ((now >= next_attempt) || !network_poll_sockets_count(poll))) {
+			socket_t* sock = tcp_socket_allocate();
+			if (socket_connect(sock, addresses[order[inext++]], 0)) {
+				if (sock->state == SOCKETSTATE_CONNECTED) {
+					connected = sock;
+					break;
+				}
+				network_poll_add_socket(poll, sock);
+				next_attempt = now + delay;
+			} else {
+				socket_deallocate(sock);
+			}
+			continue;
+		}
+
+		if (!network_poll_sockets_count(poll))
+			break;
+
+		if (inext < count)
+			waitms = tcp_socket_ticks_to_ms(next_attempt - now);
+		if (deadline) {
+			unsigned int remainms = tcp_socket_ticks_to_ms(deadline - now);
+			if (remainms < waitms)
+				waitms = remainms;
+		}
+
+		num_events = network_poll(poll, events, sizeof(events) / sizeof(events[0]), waitms);
+		for (size_t ievt = 0; ievt < num_events; ++ievt) {
+			socket_t* sock = events[ievt].socket;
+			if ((events[ievt].event == NETWORKEVENT_CONNECTED) && !connected) {
+				network_poll_remove_socket(poll, sock);
+				connected = sock;
+			} else if ((events[ievt].event == NETWORKEVENT_ERROR) || (events[ievt].event == NETWORKEVENT_HANGUP)) {
+				// A failed attempt can report both error and hangup, only release it once
+				if (ievt && (events[ievt - 1].socket == sock))
+					continue;
+				network_poll_remove_socket(poll, sock);
+				socket_deallocate(sock);
+			}
+		}
+	}
+
+	// Close the attempts that lost the race
+	count = network_poll_sockets_count(poll);
+	pending = memory_allocate(HASH_NETWORK, sizeof(socket_t*) * (count + 1), 0, MEMORY_TEMPORARY);
+	NETWORK_COUNT_ALLOCATION(NETWORK_ALLOCATION_CONNECT, sizeof(socket_t*) * (count + 1));
+	network_poll_sockets(poll, pending, count);
+	for (size_t isock = 0; isock < count; ++isock)
+		socket_deallocate(pending[isock]);
+	memory_deallocate(pending);
+
+	network_poll_deallocate(poll);
+	memory_deallocate(order);
+
+	return connected;
+}
+
+size_t
+tcp_socket_connect_bulk(network_poll_t* poll, network_address_t** addresses, socket_t** sockets,
+                        unsigned int timeoutms) {
+	size_t added = 0;
+	for (size_t iaddr = 0, count = array_size(addresses); iaddr < count; ++iaddr) {
+		socket_t* sock = tcp_socket_allocate();
+		socket_set_blocking(sock, false);
+		if (!socket_connect(sock, addresses[iaddr], 0) || !network_poll_add_socket(poll, sock)) {
+			socket_deallocate(sock);
+			sockets[iaddr] = nullptr;
+			continue;
+		}
+		if (sock->state == SOCKETSTATE_CONNECTING)
+			network_poll_set_connect_timeout(poll, sock, timeoutms);
+		sockets[iaddr] = sock;
+		++added;
+	}
+	return added;
+}
+
+size_t
+tcp_socket_connect_data(socket_t* sock, const network_address_t* address, const void* buffer, size_t size,
+                        unsigned int timeoutms) {
+	size_t written = 0;
+
+	FOUNDATION_ASSERT(address);
+
+#if defined(MSG_FASTOPEN)
+	if (socket_create_fd(sock, address->family) == NETWORK_SOCKET_INVALID)
+		return 0;
+
+	if (sock->state == SOCKETSTATE_NOTCONNECTED) {
+		const network_address_ip_t* address_ip = (const network_address_ip_t*)address;
+		bool blocking = ((sock->flags & SOCKETFLAG_BLOCKING) != 0);
+		bool failed = false;
+		int err = 0;
+		long res;
+
+		if ((timeoutms != NETWORK_TIMEOUT_INFINITE) && blocking)
+			socket_set_blocking(sock, false);
+
+		socket_set_state(sock, SOCKETSTATE_CONNECTING);
+
+		// Implicit connect, data goes out in the SYN if a cookie for the remote host is cached. Otherwise
+		// the SYN carries a cookie request and the call fails with EINPROGRESS without queueing any data
+		NETWORK_COUNT_SYSCALL(NETWORK_SYSCALL_SENDTO);
+		res = sendto(sock->fd, buffer, (network_send_size_t)size, MSG_FASTOPEN, &address_ip->saddr,
+		             (socklen_t)address_ip->address_size);
+		if (res < 0)
+			err = NETWORK_SOCKET_ERROR;
+
+		if ((res < 0) && (err == EOPNOTSUPP)) {
+			// Fast Open disabled for clients, use regular connect
+			socket_set_state(sock, SOCKETSTATE_NOTCONNECTED);
+			if ((timeoutms != NETWORK_TIMEOUT_INFINITE) && blocking)
+				socket_set_blocking(sock, true);
+		} else {
+			if (res >= 0) {
+				written = (size_t)res;
+				sock->bytes_written += written;
+			} else if (err != EINPROGRESS) {
+				failed = true;
+			}
+
+			if (!failed && timeoutms) {
+				int ret = socket_wait_fd(sock->fd, true, timeoutms);
+				if (ret > 0)
+					err = socket_error_fd(sock->fd);
+				else
+					err = (ret < 0) ? NETWORK_SOCKET_ERROR : ETIMEDOUT;
+				failed = (ret <= 0) || (err != 0);
+				if (!failed)
+					socket_set_state(sock, SOCKETSTATE_CONNECTED);
+			}
+
+			if ((timeoutms != NETWORK_TIMEOUT_INFINITE) && blocking)
+				socket_set_blocking(sock, true);
+
+			if (failed) {
+#if BUILD_ENABLE_LOG
+				char addrbuffer[NETWORK_ADDRESS_NUMERIC_MAX_LENGTH];
+				string_const_t errmsg = system_error_message(err);
+				string_t address_str = network_address_to_string(addrbuffer, sizeof(addrbuffer), address, true);
+				log_warnf(HASH_NETWORK, WARNING_SYSTEM_CALL_FAIL,
+				          STRING_CONST("Unable to fast open connect socket (0x%" PRIfixPTR
+				                       " : %d) to remote address %.*s: %.*s (%d)"),
+				          (uintptr_t)sock, sock->fd, STRING_FORMAT(address_str), STRING_FORMAT(errmsg), err);
+#endif
+				socket_set_state(sock, SOCKETSTATE_NOTCONNECTED);
+				return 0;
+			}
+
+			memory_deallocate(sock->address_remote);
+			sock->address_remote = network_address_clone(address);
+			if (!sock->address_local)
+				socket_store_address_local(sock, (int)address->family);
+
+			if ((written < size) && (sock->state == SOCKETSTATE_CONNECTED))
+				written += socket_send(sock, pointer_offset_const(buffer, written), size - written, 0);
+			return written;
+		}
+	}
+#endif
+
+	if (!socket_connect(sock, address, timeoutms))
+		return 0;
+	if (sock->state == SOCKETSTATE_CONNECTED)
+		written = socket_send(sock, buffer, size, 0);
+	return written;
+}
+
+bool
+tcp_socket_set_fastopen(socket_t* sock, unsigned int queue) {
+#if defined(TCP_FASTOPEN)
+#if FOUNDATION_PLATFORM_WINDOWS
+	DWORD optval = 1;
+	FOUNDATION_UNUSED(queue);
+#elif FOUNDATION_PLATFORM_APPLE
+	int optval = 1;
+	FOUNDATION_UNUSED(queue);
+#else
+	int optval = (int)queue;
+#endif
+	if (sock->fd == NETWORK_SOCKET_INVALID)
+		return false;
+	if (setsockopt(sock->fd, IPPROTO_TCP, TCP_FASTOPEN, (const char*)&optval, sizeof(optval)) != 0) {
+		int sockerr = NETWORK_SOCKET_ERROR;
+		string_const_t errmsg = system_error_message(sockerr);
+		log_warnf(HASH_NETWORK, WARNING_SYSTEM_CALL_FAIL,
+		          STRING_CONST("Unable to enable fast open on socket (0x%" PRIfixPTR " : %d): %.*s (%d)"),
+		          (uintptr_t)sock, sock->fd, STRING_FORMAT(errmsg), sockerr);
+		return false;
+	}
+	return true;
+#else
+	FOUNDATION_UNUSED(sock);
+	FOUNDATION_UNUSED(queue);
+	return false;
+#endif
+}
+
+bool
+tcp_socket_info(socket_t* sock, network_tcp_info_t* info) {
+	memset(info, 0, sizeof(network_tcp_info_t));
+#if (FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID) && defined(TCP_INFO)
+	tcp_info_kernel_t kinfo;
+	socklen_t length = sizeof(kinfo);
+
+	if ((sock->fd == NETWORK_SOCKET_INVALID) || (sock->type != NETWORK_SOCKETTYPE_TCP))
+		return false;
+
+	memset(&kinfo, 0, sizeof(kinfo));
+	NETWORK_COUNT_SYSCALL(NETWORK_SYSCALL_GETSOCKOPT);
+	if (getsockopt(sock->fd, IPPROTO_TCP, TCP_INFO, &kinfo, &length) != 0)
+		return false;
+
+	info->rtt = kinfo.rtt;
+	info->rtt_variance = kinfo.rttvar;
+	info->congestion_window = kinfo.snd_cwnd;
+	info->slow_start_threshold = kinfo.snd_ssthresh;
+	info->mss = kinfo.snd_mss;
+	info->unacked = kinfo.unacked;
+	info->lost = kinfo.lost;
+	info->retransmits = kinfo.total_retrans;
+	if (TCP_INFO_HAS(length, pacing_rate))
+		info->pacing_rate = kinfo.pacing_rate;
+	if (TCP_INFO_HAS(length, bytes_received)) {
+		info->bytes_acked = kinfo.bytes_acked;
+		info->bytes_received = kinfo.bytes_received;
+	}
+	if (TCP_INFO_HAS(length, min_rtt)) {
+		info->notsent_bytes = kinfo.notsent_bytes;
+		info->rtt_min = kinfo.min_rtt;
+	}
+	if (TCP_INFO_HAS(length, delivery_rate))
+		info->delivery_rate = kinfo.delivery_rate;
+	return true;
+#else
+	FOUNDATION_UNUSED(sock);
+	return false;
+#endif
+}
+
 bool
 tcp_socket_delay(socket_t* sock) {
 	return ((sock->flags & SOCKETFLAG_TCPDELAY) != 0);
@@ -224,4 +597,5 @@ tcp_stream_initialize(socket_t* sock, stream_t* stream) {
 	stream->inorder = 1;
 	stream->reliable = 1;
 	stream->path = string_allocate_format(STRING_CONST("tcp://%" PRIfixPTR), (uintptr_t)sock);
+	NETWORK_COUNT_ALLOCATION(NETWORK_ALLOCATION_STREAM_PATH, stream->path.length + 1);
 }
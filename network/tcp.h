@@ -28,9 +28,68 @@ tcp_socket_initialize(socket_t* sock);
 NETWORK_API socket_t*
 tcp_socket_accept(socket_t* sock, unsigned int timeoutms);
 
+/*! Connect to the first reachable address in a list of addresses, racing staggered non-blocking
+connection attempts (Happy Eyeballs, RFC 8305). Address families are interleaved starting with the
+family of the first address. A new attempt is started each time the attempt delay passes without a
+connection being established, or directly when all attempts in flight have failed. The first socket
+to connect is returned and all other attempts are closed.
+\param addresses Array of addresses, for example the result of #network_address_resolve
+\param delayms Delay in milliseconds between attempts, 0 for default #NETWORK_CONNECT_ATTEMPT_DELAY
+\param timeoutms Total timeout in milliseconds
+\return Connected socket, null if no address could be connected within the timeout */
+NETWORK_API socket_t*
+tcp_socket_connect_any(network_address_t** addresses, unsigned int delayms, unsigned int timeoutms);
+
+/*! Start non-blocking connects to all addresses in a list and add the sockets to a poll object,
+each pending connect with a deadline (see #network_poll_set_connect_timeout). Completion is
+reported by the poll as NETWORKEVENT_CONNECTED, failure as NETWORKEVENT_ERROR or NETWORKEVENT_HANGUP
+and expired deadline as NETWORKEVENT_TIMEOUT. A connect that completes directly (which can happen
+for local addresses) leaves the socket in connected state without generating an event. Sockets are
+left in non-blocking mode and are owned by the caller.
+\param poll Poll object, must have capacity for all sockets
+\param addresses Array of addresses
+\param sockets Destination array receiving one socket per address, null for connects that failed to start
+\param timeoutms Connect timeout in milliseconds for each socket
+\return Number of sockets added to the poll */
+NETWORK_API size_t
+tcp_socket_connect_bulk(network_poll_t* poll, network_address_t** addresses, socket_t** sockets,
+                        unsigned int timeoutms);
+
+/*! Connect socket and send initial data, using TCP Fast Open where supported to carry the data
+in the SYN and save a round trip. Without a cached Fast Open cookie for the remote host (or if
+Fast Open is disabled) this falls back to sending the data after a regular handshake, and the
+cookie obtained during the handshake is used on the next connection. If timeout is zero the
+connect is not waited for, and if the data could not go out with the SYN the returned count is
+less than the data size and the caller must write the remainder once the socket is connected.
+\param sock Socket
+\param address Remote address
+\param buffer Initial data
+\param size Size of initial data
+\param timeoutms Connect timeout in milliseconds, 0 to not wait
+\return Number of bytes of initial data written, socket state tells if connect failed */
+NETWORK_API size_t
+tcp_socket_connect_data(socket_t* sock, const network_address_t* address, const void* buffer, size_t size,
+                        unsigned int timeoutms);
+
+/*! Enable TCP Fast Open on a bound socket before calling #tcp_socket_listen, allowing clients
+with a valid cookie to send data in the SYN (see #tcp_socket_connect_data)
+\param sock Socket
+\param queue Maximum number of pending Fast Open requests not yet accepted
+\return true if enabled, false if not supported */
+NETWORK_API bool
+tcp_socket_set_fastopen(socket_t* sock, unsigned int queue);
+
 NETWORK_API bool
 tcp_socket_listen(socket_t* sock);
 
+/*! Get TCP connection statistics of a socket (TCP_INFO). Fields not supported by the running
+kernel are zero. Only available on Linux.
+\param sock Socket
+\param info Destination statistics
+\return true if successful, false if socket is not connected or statistics are not available */
+NETWORK_API bool
+tcp_socket_info(socket_t* sock, network_tcp_info_t* info);
+
 NETWORK_API bool
 tcp_socket_delay(socket_t* sock);
 
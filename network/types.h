@@ -23,6 +23,7 @@
 #include <foundation/windows.h>
 #elif FOUNDATION_PLATFORM_POSIX
 #include <sys/socket.h>
+#include <sys/un.h>
 #include <netinet/in.h>
 #endif
 
@@ -50,12 +51,33 @@
 /*! Infinite timeout */
 #define NETWORK_TIMEOUT_INFINITE 0xFFFFFFFF
 
+/*! Default delay in milliseconds between staggered connection attempts, see #tcp_socket_connect_any */
+#define NETWORK_CONNECT_ATTEMPT_DELAY 250
+
 /*! Invalid socket fd */
 #define NETWORK_SOCKET_INVALID -1
 
-typedef enum { NETWORK_ADDRESSFAMILY_IPV4 = 0, NETWORK_ADDRESSFAMILY_IPV6 } network_address_family_t;
+typedef enum {
+	NETWORK_ADDRESSFAMILY_IPV4 = 0,
+	NETWORK_ADDRESSFAMILY_IPV6,
+	//! Unix domain socket path or abstract name, see #network_address_unix_initialize
+	NETWORK_ADDRESSFAMILY_UNIX
+} network_address_family_t;
 
-typedef enum { NETWORK_SOCKETTYPE_TCP = 0, NETWORK_SOCKETTYPE_UDP } network_socket_type_t;
+typedef enum {
+	NETWORK_SOCKETTYPE_TCP = 0,
+	NETWORK_SOCKETTYPE_UDP,
+	//! Local address change monitor, see #network_address_local_monitor
+	NETWORK_SOCKETTYPE_MONITOR,
+	//! Unix domain stream socket, see #unix_socket_allocate
+	NETWORK_SOCKETTYPE_UNIX_STREAM,
+	//! Unix domain datagram socket, see #unix_socket_allocate
+	NETWORK_SOCKETTYPE_UNIX_DGRAM,
+	//! Shared memory ring stream socket, see #shm_socket_allocate
+	NETWORK_SOCKETTYPE_SHM,
+	//! In-process shared memory datagram socket, see #shm_socket_pair
+	NETWORK_SOCKETTYPE_SHM_DGRAM
+} network_socket_type_t;
 
 typedef enum {
 	SOCKETSTATE_NOTCONNECTED = 0,
@@ -70,9 +92,71 @@ typedef enum {
 	NETWORKEVENT_CONNECTED,
 	NETWORKEVENT_DATAIN,
 	NETWORKEVENT_ERROR,
-	NETWORKEVENT_HANGUP
+	NETWORKEVENT_HANGUP,
+	//! Local address list changed, see #network_address_local_monitor
+	NETWORKEVENT_ADDRESS,
+	//! Pending connect timed out and socket was closed, see #network_poll_set_connect_timeout
+	NETWORKEVENT_TIMEOUT
 } network_event_id;
 
+typedef enum {
+	//! Send buffer size in bytes (SO_SNDBUF)
+	NETWORK_SOCKETOPTION_SEND_BUFFER = 0,
+	//! Receive buffer size in bytes (SO_RCVBUF)
+	NETWORK_SOCKETOPTION_RECEIVE_BUFFER,
+	//! Minimum number of bytes available before a read is signalled (SO_RCVLOWAT)
+	NETWORK_SOCKETOPTION_RECEIVE_LOWAT,
+	//! Protocol defined priority of outgoing packets (SO_PRIORITY, Linux only)
+	NETWORK_SOCKETOPTION_PRIORITY,
+	//! Busy poll time in microseconds for blocking reads (SO_BUSY_POLL, Linux only)
+	NETWORK_SOCKETOPTION_BUSY_POLL,
+	//! Type of service / traffic class of outgoing packets (IP_TOS or IPV6_TCLASS)
+	NETWORK_SOCKETOPTION_TOS,
+	//! Send acknowledgements immediately, TCP only (TCP_QUICKACK, Linux only)
+	NETWORK_SOCKETOPTION_TCP_QUICKACK,
+	//! Limit of unsent bytes in the send queue before writes block, TCP only (TCP_NOTSENT_LOWAT)
+	NETWORK_SOCKETOPTION_TCP_NOTSENT_LOWAT,
+	//! Milliseconds unacknowledged data may remain before the connection is dropped, TCP only (TCP_USER_TIMEOUT)
+	NETWORK_SOCKETOPTION_TCP_USER_TIMEOUT,
+	NETWORK_SOCKETOPTION_COUNT
+} network_socket_option_t;
+
+typedef enum {
+	NETWORK_SYSCALL_RECV = 0,
+	NETWORK_SYSCALL_SEND,
+	NETWORK_SYSCALL_RECVFROM,
+	NETWORK_SYSCALL_SENDTO,
+	NETWORK_SYSCALL_GETSOCKOPT,
+	NETWORK_SYSCALL_IOCTL,
+	NETWORK_SYSCALL_SELECT,
+	NETWORK_SYSCALL_POLL,
+	NETWORK_SYSCALL_COUNT
+} network_syscall_t;
+
+typedef enum {
+	//! Socket objects (tcp/udp/unix/shm socket allocate, accepted sockets)
+	NETWORK_ALLOCATION_SOCKET = 0,
+	//! Address clones (remote addresses on connect, accept and receive)
+	NETWORK_ALLOCATION_ADDRESS_CLONE,
+	//! Local socket addresses stored after bind, connect and accept
+	NETWORK_ALLOCATION_ADDRESS_LOCAL,
+	//! Addresses and temporary strings from address resolution and local address enumeration
+	NETWORK_ALLOCATION_ADDRESS_RESOLVE,
+	//! Socket streams and their buffers
+	NETWORK_ALLOCATION_STREAM,
+	//! Stream path strings
+	NETWORK_ALLOCATION_STREAM_PATH,
+	//! Poll objects
+	NETWORK_ALLOCATION_POLL,
+	//! Temporary arrays when connecting to multiple addresses
+	NETWORK_ALLOCATION_CONNECT,
+	//! Shared memory and simulated network transport state
+	NETWORK_ALLOCATION_TRANSPORT,
+	//! Address maps, CIDR tables, samplers, resolver and monitor state
+	NETWORK_ALLOCATION_OTHER,
+	NETWORK_ALLOCATION_COUNT
+} network_allocation_t;
+
 #if FOUNDATION_PLATFORM_POSIX
 typedef socklen_t network_address_size_t;
 typedef size_t network_send_size_t;
@@ -83,9 +167,21 @@ typedef int network_send_size_t;
 
 typedef struct network_config_t network_config_t;
 typedef struct network_address_t network_address_t;
+typedef struct network_address_compact_t network_address_compact_t;
+typedef struct network_address_map_t network_address_map_t;
+typedef struct network_cidr_node_t network_cidr_node_t;
+typedef struct network_cidr_t network_cidr_t;
 typedef struct network_poll_slot_t network_poll_slot_t;
 typedef struct network_poll_event_t network_poll_event_t;
 typedef struct network_poll_t network_poll_t;
+typedef struct network_tcp_info_t network_tcp_info_t;
+typedef struct network_tcp_sample_t network_tcp_sample_t;
+typedef struct network_sampler_t network_sampler_t;
+typedef struct network_sim_link_t network_sim_link_t;
+typedef struct network_sim_route_t network_sim_route_t;
+typedef struct network_sim_datagram_t network_sim_datagram_t;
+typedef struct network_sim_statistics_t network_sim_statistics_t;
+typedef struct network_sim_t network_sim_t;
 typedef struct socket_t socket_t;
 typedef struct socket_stream_t socket_stream_t;
 typedef struct socket_header_t socket_header_t;
@@ -93,9 +189,24 @@ typedef union socket_data_t socket_data_t;
 
 typedef void (*socket_open_fn)(socket_t*, unsigned int);
 typedef void (*socket_stream_initialize_fn)(socket_t*, stream_t*);
+typedef struct socket_vtable_t socket_vtable_t;
+typedef void (*network_resolve_fn)(const char* address, size_t length, network_address_t** addresses,
+                                   void* userdata);
 
 struct network_config_t {
-	size_t unused;
+	//! Number of resolver worker threads (0 for default, 2)
+	size_t resolver_threads;
+	//! Maximum number of cached resolve results (0 for default, 256)
+	size_t resolver_cache_size;
+	//! Time to live for cached resolve results in milliseconds (0 for default, 60 seconds)
+	unsigned int resolver_cache_ttl;
+	//! Time to live for cached failed resolves in milliseconds (0 for default, 5 seconds)
+	unsigned int resolver_negative_ttl;
+	//! Default value of socket options applied to new sockets, indexed by network_socket_option_t
+	//! (0 to keep system default)
+	int socket_options[NETWORK_SOCKETOPTION_COUNT];
+	//! Size in bytes of each direction ring in shared memory transports (0 for default, 256KiB)
+	size_t shm_ring_size;
 };
 
 #define NETWORK_DECLARE_NETWORK_ADDRESS \
@@ -133,9 +244,167 @@ typedef struct network_address_ipv6_t {
 	};
 } network_address_ipv6_t;
 
+/*! Unix domain socket address. On Linux an address can be in the abstract namespace, denoted by
+a leading zero byte in the path, which has no file system presence. */
+typedef struct network_address_unix_t {
+	NETWORK_DECLARE_NETWORK_ADDRESS;
+	union {
+#if FOUNDATION_PLATFORM_POSIX
+		struct sockaddr_un saddr;
+#endif
+		struct sockaddr_storage saddr_storage;
+	};
+} network_address_unix_t;
+
+/*! Compact fixed size representation of an IPv4 or IPv6 address, converted to and from socket
+addresses only when passed to system calls. IP is stored in network byte order (IPv4 addresses
+in the first four bytes), port and scope in host byte order. Structure has no padding and can
+be compared and hashed bytewise. */
+struct network_address_compact_t {
+	/*! IP address, network byte order */
+	uint8_t ip[16];
+	/*! IPv6 scope id, zero for IPv4 */
+	uint32_t scope;
+	/*! Port, host byte order */
+	uint16_t port;
+	/*! Address family (network_address_family_t) */
+	uint16_t family;
+};
+
+struct network_address_map_t {
+	size_t capacity;
+	size_t count;
+	uint32_t* hashes;
+	network_address_compact_t* keys;
+	void** values;
+};
+
+struct network_cidr_node_t {
+	uint64_t key[2];
+	uint32_t child[2];
+	void* value;
+	unsigned int bits;
+};
+
+struct network_cidr_t {
+	network_cidr_node_t* nodes;
+	uint32_t* nodes_free;
+	uint32_t root[2];
+	size_t count;
+};
+
+/*! TCP connection statistics, see #tcp_socket_info. Fields not provided by the system are zero. */
+struct network_tcp_info_t {
+	/*! Smoothed round trip time in microseconds */
+	uint32_t rtt;
+	/*! Round trip time variance in microseconds */
+	uint32_t rtt_variance;
+	/*! Minimum observed round trip time in microseconds */
+	uint32_t rtt_min;
+	/*! Congestion window in segments */
+	uint32_t congestion_window;
+	/*! Slow start threshold in segments */
+	uint32_t slow_start_threshold;
+	/*! Maximum segment size for sending in bytes */
+	uint32_t mss;
+	/*! Number of segments sent but not yet acknowledged */
+	uint32_t unacked;
+	/*! Number of segments considered lost */
+	uint32_t lost;
+	/*! Total number of retransmitted segments */
+	uint32_t retransmits;
+	/*! Number of bytes in send queue not yet sent */
+	uint32_t notsent_bytes;
+	/*! Pacing rate in bytes per second */
+	uint64_t pacing_rate;
+	/*! Most recent delivery rate estimate in bytes per second */
+	uint64_t delivery_rate;
+	/*! Total number of bytes acknowledged by peer */
+	uint64_t bytes_acked;
+	/*! Total number of bytes received */
+	uint64_t bytes_received;
+};
+
+/*! Snapshot of TCP statistics of a socket, see #network_sampler_read */
+struct network_tcp_sample_t {
+	/*! Time of snapshot */
+	tick_t timestamp;
+	/*! Socket the snapshot was taken on, used for identification only as the socket might no
+	    longer be valid when the sample is read */
+	const socket_t* socket;
+	/*! Remote address of socket */
+	network_address_compact_t remote;
+	/*! Statistics */
+	network_tcp_info_t info;
+};
+
+struct network_sampler_t {
+	network_poll_t* poll;
+	tick_t interval;
+	tick_t next;
+	size_t capacity;
+	size_t read;
+	size_t write;
+	network_tcp_sample_t* samples;
+};
+
+struct network_sim_link_t {
+	//! One way latency in microseconds
+	unsigned int latency;
+	//! Maximum additional random latency in microseconds
+	unsigned int jitter;
+	//! Bandwidth in bytes per second, 0 for unlimited
+	uint64_t bandwidth;
+	//! Maximum number of bytes waiting for transmission, datagrams exceeding it are dropped (0 for unlimited)
+	size_t queue_limit;
+	//! Probability of a datagram being lost, in range [0,1]
+	real loss;
+	//! Probability of a datagram being delayed by an additional latency, in range [0,1]
+	real reorder;
+};
+
+struct network_sim_statistics_t {
+	//! Number of datagrams sent
+	uint64_t sent;
+	//! Number of datagrams delivered to a socket
+	uint64_t delivered;
+	//! Number of datagrams lost on a link
+	uint64_t lost;
+	//! Number of datagrams dropped by a full link queue
+	uint64_t dropped;
+	//! Number of datagrams discarded since no socket was bound to the destination address
+	uint64_t unreachable;
+	//! Number of bytes delivered to a socket
+	uint64_t bytes_delivered;
+};
+
+struct network_sim_t {
+	//! Virtual time
+	tick_t time;
+	//! Random generator state
+	uint64_t random;
+	//! Send counter, orders datagrams with equal delivery time
+	uint64_t sequence;
+	//! Next candidate ephemeral port
+	unsigned int port_next;
+	//! Next socket handle
+	int handle_next;
+	//! Link characteristics of host pairs without an explicit link
+	network_sim_link_t link_default;
+	//! Directed host pair links
+	network_sim_route_t* routes;
+	//! Datagrams in flight, binary heap ordered by delivery time
+	network_sim_datagram_t** flight;
+	//! Bound sockets by local address
+	network_address_map_t sockets;
+	//! Statistics counters
+	network_sim_statistics_t statistics;
+};
+
 struct network_poll_slot_t {
 	socket_t* sock;
 	int fd;
+	tick_t deadline;
 };
 
 FOUNDATION_ALIGNED_STRUCT(socket_stream_t, 8) {
@@ -151,6 +420,13 @@ FOUNDATION_ALIGNED_STRUCT(socket_stream_t, 8) {
 
 	uint8_t* buffer_in;
 	uint8_t* buffer_out;
+
+	network_poll_t* cork_poll;
+	bool corked;
+	bool dirty;
+
+	unsigned int timeout_read;
+	unsigned int timeout_write;
 };
 
 struct socket_header_t {
@@ -158,6 +434,27 @@ struct socket_header_t {
 	size_t size;
 };
 
+/*! Socket I/O functions for transports not backed by a kernel socket. The socket file descriptor
+is then a notification handle signalled when the transport has data or space available, which is
+what network poll and beacons wait on. */
+struct socket_vtable_t {
+	//! Read available data without blocking, return number of bytes read
+	size_t (*read)(socket_t* sock, void* buffer, size_t size);
+	//! Write data without blocking, return number of bytes written
+	size_t (*send)(socket_t* sock, const void* buffer, size_t size, int flags);
+	//! Number of bytes available to read, -1 if nothing available and peer closed
+	int (*available)(const socket_t* sock);
+	//! Wait for data or space, return -1 on error, 0 if timed out and 1 if ready
+	int (*wait)(socket_t* sock, bool write, unsigned int timeoutms);
+	//! Receive a datagram and its source address without blocking, null if not a datagram transport
+	size_t (*recvfrom)(socket_t* sock, void* buffer, size_t capacity, const network_address_t** address);
+	//! Send a datagram without blocking, null if not a datagram transport
+	size_t (*sendto)(socket_t* sock, const void* buffer, size_t size, const network_address_t* address);
+	//! Release transport resources, called before the notification handle is closed. A transport without
+	//! a system handle sets the socket handle invalid
+	void (*close)(socket_t* sock);
+};
+
 union socket_data_t {
 	void* client;
 	socket_header_t header;
@@ -184,9 +481,17 @@ struct socket_t {
 	socket_open_fn open_fn;
 	socket_stream_initialize_fn stream_initialize_fn;
 
+	const socket_vtable_t* vtable;
+	void* transport;
+
 	beacon_t* beacon;
 	socket_data_t data;
 
+	const network_cidr_t* filter;
+
+	uint32_t options_set;
+	int options[NETWORK_SOCKETOPTION_COUNT];
+
 #if FOUNDATION_PLATFORM_WINDOWS
 	void* event;
 #endif
@@ -195,7 +500,11 @@ struct socket_t {
 #define NETWORK_DECLARE_POLL_BASE \
 	unsigned int timeout;         \
 	size_t sockets_max;           \
-	size_t sockets_count
+	size_t sockets_count;         \
+	tick_t deadline_next;         \
+	network_sampler_t* sampler;   \
+	network_sim_t* sim;           \
+	socket_stream_t** streams_dirty
 
 #if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
 #define NETWORK_DECLARE_POLL_PLATFORM \
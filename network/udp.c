@@ -24,6 +24,7 @@ udp_stream_initialize(socket_t*, stream_t*);
 socket_t*
 udp_socket_allocate(void) {
 	socket_t* sock = memory_allocate(HASH_NETWORK, sizeof(socket_t), 0, MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	NETWORK_COUNT_ALLOCATION(NETWORK_ALLOCATION_SOCKET, sizeof(socket_t));
 	udp_socket_initialize(sock);
 	return sock;
 }
@@ -60,6 +61,7 @@ udp_stream_initialize(socket_t* sock, stream_t* stream) {
 	stream->inorder = 0;
 	stream->reliable = 0;
 	stream->path = string_allocate_format(STRING_CONST("udp://%" PRIfixPTR), (uintptr_t)sock);
+	NETWORK_COUNT_ALLOCATION(NETWORK_ALLOCATION_STREAM_PATH, stream->path.length + 1);
 }
 
 size_t
@@ -73,6 +75,9 @@ udp_socket_recvfrom(socket_t* sock, void* buffer, size_t capacity, network_addre
 	if ((sock->fd == NETWORK_SOCKET_INVALID) || !sock->address_local)
 		return 0;
 
+	if (sock->vtable)
+		return sock->vtable->recvfrom ? sock->vtable->recvfrom(sock, buffer, capacity, address) : 0;
+
 	if (sock->state != SOCKETSTATE_NOTCONNECTED) {
 		FOUNDATION_ASSERT_FAILFORMAT_LOG(
 		    HASH_NETWORK, "Trying to datagram read from a connected UDP socket (0x%" PRIfixPTR " : %d) in state %u",
@@ -87,7 +92,16 @@ udp_socket_recvfrom(socket_t* sock, void* buffer, size_t capacity, network_addre
 	}
 	addr_ip = (network_address_ip_t*)sock->address_remote;
 
-	ret = recvfrom(sock->fd, (char*)buffer, (network_send_size_t)capacity, 0, &addr_ip->saddr, &addr_ip->address_size);
+	// Datagrams from peers rejected by the address filter are dropped
+	do {
+		// Size of unix domain peer addresses varies with path length, receive with full capacity and
+		// only store the size on success so a failed call leaves the previous address intact
+		network_address_size_t address_size = (network_address_size_t)sizeof(struct sockaddr_storage);
+		NETWORK_COUNT_SYSCALL(NETWORK_SYSCALL_RECVFROM);
+		ret = recvfrom(sock->fd, (char*)buffer, (network_send_size_t)capacity, 0, &addr_ip->saddr, &address_size);
+		if (ret >= 0)
+			addr_ip->address_size = address_size;
+	} while ((ret > 0) && sock->filter && !socket_filter_allow(sock, sock->address_remote));
 	if (ret > 0) {
 #if BUILD_ENABLE_NETWORK_DUMP_TRAFFIC > 1
 		const unsigned char* src = (const unsigned char*)buffer;
@@ -128,22 +142,14 @@ udp_socket_recvfrom(socket_t* sock, void* buffer, size_t capacity, network_addre
 
 	int sockerr = NETWORK_SOCKET_ERROR;
 
-#if FOUNDATION_PLATFORM_WINDOWS
-	int serr = 0;
-	int slen = sizeof(int);
-	getsockopt(sock->fd, SOL_SOCKET, SO_ERROR, (char*)&serr, &slen);
-#else
-	int serr = 0;
-	socklen_t slen = sizeof(int);
-	getsockopt(sock->fd, SOL_SOCKET, SO_ERROR, (void*)&serr, &slen);
-#endif
-
+	// Only query pending socket error on real errors, would block is a fast exit
 #if FOUNDATION_PLATFORM_WINDOWS
 	if (sockerr != WSAEWOULDBLOCK)
 #else
 	if (sockerr != EAGAIN)
 #endif
 	{
+		int serr = socket_error_fd(sock->fd);
 		string_const_t errmsg = system_error_message(sockerr);
 		log_warnf(
 		    HASH_NETWORK, WARNING_SYSTEM_CALL_FAIL,
@@ -162,6 +168,12 @@ udp_socket_sendto(socket_t* sock, const void* buffer, size_t size, const network
 	if (!address)
 		return 0;
 
+	if (sock->vtable) {
+		if ((sock->fd == NETWORK_SOCKET_INVALID) || !sock->vtable->sendto)
+			return 0;
+		return sock->vtable->sendto(sock, buffer, size, address);
+	}
+
 	if (sock->state != SOCKETSTATE_NOTCONNECTED) {
 		FOUNDATION_ASSERT_FAILFORMAT_LOG(
 		    HASH_NETWORK, "Trying to datagram send from a connected UDP socket (0x%" PRIfixPTR " : %d) in state %u",
@@ -176,6 +188,7 @@ udp_socket_sendto(socket_t* sock, const void* buffer, size_t size, const network
 	}
 	addr_ip = (const network_address_ip_t*)address;
 
+	NETWORK_COUNT_SYSCALL(NETWORK_SYSCALL_SENDTO);
 	ret = sendto(sock->fd, buffer, (network_send_size_t)size, 0, &addr_ip->saddr, addr_ip->address_size);
 	if (ret > 0) {
 #if BUILD_ENABLE_NETWORK_DUMP_TRAFFIC > 1
@@ -222,22 +235,14 @@ udp_socket_sendto(socket_t* sock, const void* buffer, size_t size, const network
 
 	int sockerr = NETWORK_SOCKET_ERROR;
 
-#if FOUNDATION_PLATFORM_WINDOWS
-	int serr = 0;
-	int slen = sizeof(int);
-	getsockopt(sock->fd, SOL_SOCKET, SO_ERROR, (char*)&serr, &slen);
-#else
-	int serr = 0;
-	socklen_t slen = sizeof(int);
-	getsockopt(sock->fd, SOL_SOCKET, SO_ERROR, (void*)&serr, &slen);
-#endif
-
+	// Only query pending socket error on real errors, would block is a fast exit
 #if FOUNDATION_PLATFORM_WINDOWS
 	if (sockerr != WSAEWOULDBLOCK)
 #else
 	if (sockerr != EAGAIN)
 #endif
 	{
+		int serr = socket_error_fd(sock->fd);
 		string_const_t errmsg = system_error_message(sockerr);
 		log_warnf(HASH_NETWORK, WARNING_SYSTEM_CALL_FAIL,
 		          STRING_CONST("Socket sendto() failed on UDP socket (0x%" PRIfixPTR " : %d): %.*s (%d) (SO_ERROR %d)"),
@@ -246,3 +251,20 @@ udp_socket_sendto(socket_t* sock, const void* buffer, size_t size, const network
 
 	return 0;
 }
+
+size_t
+udp_socket_recvfrom_compact(socket_t* sock, void* buffer, size_t capacity, network_address_compact_t* address) {
+	const network_address_t* source = nullptr;
+	size_t size = udp_socket_recvfrom(sock, buffer, capacity, &source);
+	if (size && address)
+		network_address_to_compact(source, address);
+	return size;
+}
+
+size_t
+udp_socket_sendto_compact(socket_t* sock, const void* buffer, size_t size, const network_address_compact_t* address) {
+	network_address_ipv6_t expanded;
+	if (!address)
+		return 0;
+	return udp_socket_sendto(sock, buffer, size, network_address_from_compact((network_address_t*)&expanded, address));
+}
@@ -30,3 +30,22 @@ udp_socket_recvfrom(socket_t* sock, void* buffer, size_t capacity, network_addre
 
 NETWORK_API size_t
 udp_socket_sendto(socket_t* sock, const void* buffer, size_t size, const network_address_t* address);
+
+/*! Receive a datagram and store the source as a compact address, see #udp_socket_recvfrom
+\param sock Socket
+\param buffer Destination buffer
+\param capacity Capacity of destination buffer
+\param address Destination compact source address
+\return Number of bytes received, 0 if no datagram was available */
+NETWORK_API size_t
+udp_socket_recvfrom_compact(socket_t* sock, void* buffer, size_t capacity, network_address_compact_t* address);
+
+/*! Send a datagram to a compact address, see #udp_socket_sendto. The address is expanded
+on the stack for the system call.
+\param sock Socket
+\param buffer Datagram data
+\param size Size of datagram
+\param address Destination compact address
+\return Number of bytes sent */
+NETWORK_API size_t
+udp_socket_sendto_compact(socket_t* sock, const void* buffer, size_t size, const network_address_compact_t* address);
@@ -0,0 +1,84 @@
+/* unix.c  -  Network library  -  Public Domain  -  2013 Mattias Jansson
+ *
+ * This library provides a network abstraction built on foundation streams. The latest source code is
+ * always available at
+ *
+ * https://github.com/mjansson/network_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any restrictions.
+ *
+ */
+
+#include <network/unix.h>
+#include <network/socket.h>
+#include <network/internal.h>
+
+#include <foundation/foundation.h>
+
+static void
+unix_socket_open(socket_t*, unsigned int);
+
+static void
+unix_stream_initialize(socket_t*, stream_t*);
+
+socket_t*
+unix_socket_allocate(network_socket_type_t type) {
+	socket_t* sock = memory_allocate(HASH_NETWORK, sizeof(socket_t), 0, MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	NETWORK_COUNT_ALLOCATION(NETWORK_ALLOCATION_SOCKET, sizeof(socket_t));
+	unix_socket_initialize(sock, type);
+	return sock;
+}
+
+void
+unix_socket_initialize(socket_t* sock, network_socket_type_t type) {
+	FOUNDATION_ASSERT((type == NETWORK_SOCKETTYPE_UNIX_STREAM) || (type == NETWORK_SOCKETTYPE_UNIX_DGRAM));
+
+	socket_initialize(sock);
+
+	sock->type = type;
+	sock->family = NETWORK_ADDRESSFAMILY_UNIX;
+	sock->open_fn = unix_socket_open;
+	sock->stream_initialize_fn = unix_stream_initialize;
+}
+
+static void
+unix_socket_open(socket_t* sock, unsigned int family) {
+	if (sock->fd != NETWORK_SOCKET_INVALID)
+		return;
+
+	if (family != NETWORK_ADDRESSFAMILY_UNIX) {
+		log_errorf(HASH_NETWORK, ERROR_INVALID_VALUE,
+		           STRING_CONST("Unable to open unix socket (0x%" PRIfixPTR "): Invalid address family %u"),
+		           (uintptr_t)sock, family);
+		return;
+	}
+
+#if FOUNDATION_PLATFORM_POSIX
+	sock->fd = (int)socket(AF_UNIX, (sock->type == NETWORK_SOCKETTYPE_UNIX_DGRAM) ? SOCK_DGRAM : SOCK_STREAM, 0);
+	if (sock->fd < 0) {
+		int err = NETWORK_SOCKET_ERROR;
+		string_const_t errmsg = system_error_message(err);
+		log_errorf(HASH_NETWORK, ERROR_SYSTEM_CALL_FAIL,
+		           STRING_CONST("Unable to open unix socket (0x%" PRIfixPTR " : %d): %.*s (%d)"), (uintptr_t)sock,
+		           sock->fd, STRING_FORMAT(errmsg), err);
+		sock->fd = NETWORK_SOCKET_INVALID;
+	} else {
+		log_debugf(HASH_NETWORK, STRING_CONST("Opened unix socket (0x%" PRIfixPTR " : %d)"), (uintptr_t)sock,
+		           sock->fd);
+	}
+#else
+	log_errorf(HASH_NETWORK, ERROR_UNSUPPORTED,
+	           STRING_CONST("Unable to open unix socket (0x%" PRIfixPTR "): Not supported on platform"),
+	           (uintptr_t)sock);
+#endif
+}
+
+static void
+unix_stream_initialize(socket_t* sock, stream_t* stream) {
+	bool datagram = (sock->type == NETWORK_SOCKETTYPE_UNIX_DGRAM);
+	stream->inorder = 1;
+	stream->reliable = 1;
+	stream->path = string_allocate_format(STRING_CONST("%s://%" PRIfixPTR), datagram ? "unixgram" : "unix",
+	                                      (uintptr_t)sock);
+	NETWORK_COUNT_ALLOCATION(NETWORK_ALLOCATION_STREAM_PATH, stream->path.length + 1);
+}
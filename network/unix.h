@@ -0,0 +1,37 @@
+/* unix.h  -  Network library  -  Public Domain  -  2013 Mattias Jansson
+ *
+ * This library provides a network abstraction built on foundation streams. The latest source code is
+ * always available at
+ *
+ * https://github.com/mjansson/network_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any restrictions.
+ *
+ */
+
+#pragma once
+
+/*! \file unix.h
+    Unix domain socket abstraction for communication between processes on the same host. Unix
+    sockets use the generic socket API with unix addresses (see #network_address_unix_initialize),
+    stream sockets are listened on and accepted with #tcp_socket_listen and #tcp_socket_accept,
+    datagram sockets are used with #udp_socket_recvfrom and #udp_socket_sendto. Both types can be
+    added to a poll object and stream sockets can be used with socket streams. A socket file
+    created by binding to a file system path is not removed when the socket is closed. */
+
+#include <foundation/platform.h>
+
+#include <network/types.h>
+#include <network/socket.h>
+
+/*! Allocate a unix domain socket
+\param type Socket type, NETWORK_SOCKETTYPE_UNIX_STREAM or NETWORK_SOCKETTYPE_UNIX_DGRAM
+\return New socket */
+NETWORK_API socket_t*
+unix_socket_allocate(network_socket_type_t type);
+
+/*! Initialize a unix domain socket
+\param sock Socket
+\param type Socket type, NETWORK_SOCKETTYPE_UNIX_STREAM or NETWORK_SOCKETTYPE_UNIX_DGRAM */
+NETWORK_API void
+unix_socket_initialize(socket_t* sock, network_socket_type_t type);
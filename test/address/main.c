@@ -13,6 +13,10 @@
 #include <foundation/foundation.h>
 #include <test/test.h>
 
+#if FOUNDATION_PLATFORM_POSIX
+#include <netdb.h>
+#endif
+
 static application_t
 test_address_application(void) {
 	application_t app;
@@ -315,10 +319,487 @@ DECLARE_TEST(address, family) {
 	return 0;
 }
 
+static bool
+address_system_parse(network_address_t* address, const char* host, const char* service) {
+	struct addrinfo hints;
+	struct addrinfo* result = 0;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = AI_NUMERICHOST;
+	if (getaddrinfo(host, service, &hints, &result) || !result)
+		return false;
+	if (result->ai_family == AF_INET) {
+		network_address_ipv4_initialize((network_address_ipv4_t*)address);
+		memcpy(&((network_address_ipv4_t*)address)->saddr, result->ai_addr, sizeof(struct sockaddr_in));
+	} else {
+		network_address_ipv6_initialize((network_address_ipv6_t*)address);
+		memcpy(&((network_address_ipv6_t*)address)->saddr, result->ai_addr, sizeof(struct sockaddr_in6));
+	}
+	freeaddrinfo(result);
+	return true;
+}
+
+DECLARE_TEST(address, parse) {
+	network_address_ipv6_t parsed;
+	network_address_ipv6_t system;
+	network_address_t* address = (network_address_t*)&parsed;
+	const char* valid[][3] = {{"10.0.0.1:80", "10.0.0.1", "80"},
+	                          {"255.255.255.255", "255.255.255.255", 0},
+	                          {"0.0.0.0:65535", "0.0.0.0", "65535"},
+	                          {"::", "::", 0},
+	                          {"::1", "::1", 0},
+	                          {"[::1]:443", "::1", "443"},
+	                          {"1::", "1::", 0},
+	                          {"2001:db8::ff00:42:8329", "2001:db8::ff00:42:8329", 0},
+	                          {"2001:0DB8:0000:0000:0000:FF00:0042:8329", "2001:db8::ff00:42:8329", 0},
+	                          {"1:2:3:4:5:6:7:8", "1:2:3:4:5:6:7:8", 0},
+	                          {"::ffff:192.168.0.1", "::ffff:192.168.0.1", 0},
+	                          {"[64:ff9b::10.0.0.1]:8080", "64:ff9b::10.0.0.1", "8080"},
+	                          {"fe80::1%3", "fe80::1%3", 0}};
+	const char* invalid[] = {"",
+	                         "1.2.3",
+	                         "1.2.3.4.5",
+	                         "256.0.0.1",
+	                         "01.2.3.4",
+	                         "1.2.3.4:",
+	                         "1.2.3.4:65536",
+	                         "1.2..4",
+	                         ":::",
+	                         "1:2:3:4:5:6:7:8:9",
+	                         "1::2::3",
+	                         ":1",
+	                         "1:",
+	                         "12345::",
+	                         "[::1",
+	                         "[::1]80",
+	                         "::1.2.3.4.5",
+	                         "1:2:3:4:5:6:7:1.2.3.4",
+	                         "fe80::1%eth0",
+	                         "localhost"};
+	size_t itest;
+
+	for (itest = 0; itest < sizeof(valid) / sizeof(valid[0]); ++itest) {
+		EXPECT_TRUE(network_address_parse(address, valid[itest][0], string_length(valid[itest][0])));
+		EXPECT_TRUE(address_system_parse((network_address_t*)&system, valid[itest][1], valid[itest][2]));
+		EXPECT_TRUE(network_address_equal(address, (network_address_t*)&system));
+		EXPECT_UINTEQ(network_address_ip_port(address), network_address_ip_port((network_address_t*)&system));
+	}
+	EXPECT_EQ(network_address_family(address), NETWORK_ADDRESSFAMILY_IPV6);
+	EXPECT_UINTEQ(parsed.saddr.sin6_scope_id, 3);
+
+	for (itest = 0; itest < sizeof(invalid) / sizeof(invalid[0]); ++itest)
+		EXPECT_FALSE(network_address_parse(address, invalid[itest], string_length(invalid[itest])));
+
+	return 0;
+}
+
+static string_t
+address_system_format(char* buffer, size_t capacity, const network_address_t* address) {
+	char host[NI_MAXHOST] = {0};
+	char service[NI_MAXSERV] = {0};
+	const network_address_ip_t* address_ip = (const network_address_ip_t*)address;
+	unsigned int port = network_address_ip_port(address);
+	getnameinfo(&address_ip->saddr, address_ip->address_size, host, NI_MAXHOST, service, NI_MAXSERV,
+	            NI_NUMERICHOST | NI_NUMERICSERV);
+	if (!port)
+		return string_copy(buffer, capacity, host, string_length(host));
+	if (network_address_family(address) == NETWORK_ADDRESSFAMILY_IPV6)
+		return string_format(buffer, capacity, STRING_CONST("[%s]:%s"), host, service);
+	return string_format(buffer, capacity, STRING_CONST("%s:%s"), host, service);
+}
+
+DECLARE_TEST(address, to_string) {
+	network_address_ipv6_t parsed;
+	network_address_t* address = (network_address_t*)&parsed;
+	char buffer[64];
+	char system_buffer[64];
+	string_t formatted, system;
+	const char* addresses[] = {"10.0.0.1:80",
+	                           "0.0.0.0",
+	                           "255.255.255.255:65535",
+	                           "::",
+	                           "::1",
+	                           "[::1]:443",
+	                           "1::",
+	                           "2001:db8::ff00:42:8329",
+	                           "2001:db8:0:0:1:0:0:1",
+	                           "2001:0:0:1:0:0:0:1",
+	                           "2001:db8:0:1:1:1:1:1",
+	                           "1:2:3:4:5:6:7:8",
+	                           "[::ffff:192.168.0.1]:8080",
+	                           "fe80::1%3"};
+	size_t itest;
+
+	for (itest = 0; itest < sizeof(addresses) / sizeof(addresses[0]); ++itest) {
+		EXPECT_TRUE(network_address_parse(address, addresses[itest], string_length(addresses[itest])));
+		formatted = network_address_to_string(buffer, sizeof(buffer), address, true);
+		system = address_system_format(system_buffer, sizeof(system_buffer), address);
+		if (itest < sizeof(addresses) / sizeof(addresses[0]) - 1)
+			EXPECT_STRINGEQ(formatted, system);
+	}
+	// Scope is always numeric, the system formatter may use the interface name
+	EXPECT_CONSTSTRINGEQ(string_to_const(formatted), string_const(STRING_CONST("fe80::1%3")));
+
+	// RFC 5952 zero compression of longest run, leftmost when tied, never a single group
+	network_address_parse(address, STRING_CONST("2001:db8:0:0:1:0:0:1"));
+	formatted = network_address_to_string(buffer, sizeof(buffer), address, true);
+	EXPECT_CONSTSTRINGEQ(string_to_const(formatted), string_const(STRING_CONST("2001:db8::1:0:0:1")));
+	network_address_parse(address, STRING_CONST("2001:db8:0:1:1:1:1:1"));
+	formatted = network_address_to_string(buffer, sizeof(buffer), address, true);
+	EXPECT_CONSTSTRINGEQ(string_to_const(formatted), string_const(STRING_CONST("2001:db8:0:1:1:1:1:1")));
+
+	// Truncated to buffer capacity
+	network_address_parse(address, STRING_CONST("10.0.0.1:80"));
+	formatted = network_address_to_string(buffer, 5, address, true);
+	EXPECT_CONSTSTRINGEQ(string_to_const(formatted), string_const(STRING_CONST("10.0")));
+
+	return 0;
+}
+
+DECLARE_TEST(address, hash_map) {
+	const size_t count = 100000;
+	network_address_ipv6_t* addresses;
+	network_address_ipv6_t other;
+	network_address_map_t map;
+	size_t iaddr;
+
+	addresses = memory_allocate(HASH_NETWORK, sizeof(network_address_ipv6_t) * count, 0, MEMORY_PERSISTENT);
+	for (iaddr = 0; iaddr < count; ++iaddr) {
+		network_address_t* address = (network_address_t*)(addresses + iaddr);
+		if (iaddr & 1) {
+			struct in6_addr ip;
+			memset(&ip, 0, sizeof(ip));
+			ip.s6_addr[0] = 0x20;
+			ip.s6_addr[1] = 0x01;
+			ip.s6_addr[13] = (uint8_t)(iaddr >> 16);
+			ip.s6_addr[14] = (uint8_t)(iaddr >> 8);
+			ip.s6_addr[15] = (uint8_t)iaddr;
+			network_address_ipv6_initialize(addresses + iaddr);
+			network_address_ipv6_set_ip(address, ip);
+		} else {
+			network_address_ipv4_initialize((network_address_ipv4_t*)address);
+			network_address_ipv4_set_ip(address, network_address_ipv4_make_ip(10, (unsigned char)(iaddr >> 16),
+			                                                                  (unsigned char)(iaddr >> 8), 1));
+		}
+		network_address_ip_set_port(address, 1024 + (unsigned int)(iaddr & 0xFF));
+	}
+
+	// Equal addresses hash equal, port and family are part of the hash
+	network_address_parse((network_address_t*)&other, STRING_CONST("10.0.0.1:1024"));
+	EXPECT_EQ(network_address_hash((network_address_t*)&other), network_address_hash((network_address_t*)addresses));
+	network_address_ip_set_port((network_address_t*)&other, 1025);
+	EXPECT_NE(network_address_hash((network_address_t*)&other), network_address_hash((network_address_t*)addresses));
+	network_address_parse((network_address_t*)&other, STRING_CONST("[::ffff:10.0.0.1]:1024"));
+	EXPECT_NE(network_address_hash((network_address_t*)&other), network_address_hash((network_address_t*)addresses));
+
+	network_address_map_initialize(&map, 0);
+	for (iaddr = 0; iaddr < count; ++iaddr)
+		EXPECT_EQ(network_address_map_insert(&map, (network_address_t*)(addresses + iaddr), (void*)(iaddr + 1)),
+		          nullptr);
+	EXPECT_SIZEEQ(network_address_map_size(&map), count);
+	EXPECT_EQ(network_address_map_lookup(&map, (network_address_t*)&other), nullptr);
+
+	for (iaddr = 0; iaddr < count; ++iaddr)
+		EXPECT_EQ(network_address_map_lookup(&map, (network_address_t*)(addresses + iaddr)), (void*)(iaddr + 1));
+
+	// Replace returns previous value
+	EXPECT_EQ(network_address_map_insert(&map, (network_address_t*)addresses, (void*)(count + 1)), (void*)1);
+	EXPECT_SIZEEQ(network_address_map_size(&map), count);
+
+	for (iaddr = 0; iaddr < count; iaddr += 3)
+		EXPECT_NE(network_address_map_erase(&map, (network_address_t*)(addresses + iaddr)), nullptr);
+	EXPECT_EQ(network_address_map_erase(&map, (network_address_t*)addresses), nullptr);
+
+	for (iaddr = 0; iaddr < count; ++iaddr) {
+		void* value = network_address_map_lookup(&map, (network_address_t*)(addresses + iaddr));
+		if (iaddr % 3)
+			EXPECT_EQ(value, (void*)(iaddr + 1));
+		else
+			EXPECT_EQ(value, nullptr);
+	}
+	EXPECT_SIZEEQ(network_address_map_size(&map), count - ((count + 2) / 3));
+
+	network_address_map_clear(&map);
+	EXPECT_SIZEEQ(network_address_map_size(&map), 0);
+	EXPECT_EQ(network_address_map_lookup(&map, (network_address_t*)(addresses + 1)), nullptr);
+
+	network_address_map_finalize(&map);
+	memory_deallocate(addresses);
+
+	return 0;
+}
+
+DECLARE_TEST(address, compact) {
+	network_address_ipv6_t parsed;
+	network_address_ipv6_t expanded;
+	network_address_t* address = (network_address_t*)&parsed;
+	network_address_compact_t compact, other;
+	network_address_compact_t* compacts;
+	network_address_t** addresses;
+	const char* strings[] = {"10.0.0.1:80", "0.0.0.0", "[::1]:443", "2001:db8::ff00:42:8329", "fe80::1%3",
+	                         "[::ffff:192.168.0.1]:8080"};
+	size_t itest, iaddr;
+
+	EXPECT_SIZEEQ(sizeof(network_address_compact_t), 24);
+
+	for (itest = 0; itest < sizeof(strings) / sizeof(strings[0]); ++itest) {
+		EXPECT_TRUE(network_address_parse(address, strings[itest], string_length(strings[itest])));
+		EXPECT_TRUE(network_address_to_compact(address, &compact));
+		EXPECT_INTEQ(compact.family, network_address_family(address));
+		EXPECT_UINTEQ(compact.port, network_address_ip_port(address));
+		EXPECT_EQ(network_address_compact_hash(&compact), network_address_hash(address));
+		EXPECT_TRUE(
+		    network_address_equal(network_address_from_compact((network_address_t*)&expanded, &compact), address));
+		EXPECT_TRUE(network_address_to_compact((network_address_t*)&expanded, &other));
+		EXPECT_TRUE(network_address_compact_equal(&compact, &other));
+	}
+	other.port = 1;
+	EXPECT_FALSE(network_address_compact_equal(&compact, &other));
+	EXPECT_FALSE(network_address_to_compact(nullptr, &compact));
+
+	compacts = network_address_resolve_compact(STRING_CONST("10.0.0.1:80"));
+	EXPECT_SIZEEQ(array_size(compacts), 1);
+	EXPECT_INTEQ(compacts[0].family, NETWORK_ADDRESSFAMILY_IPV4);
+	EXPECT_UINTEQ(compacts[0].port, 80);
+	array_deallocate(compacts);
+
+	addresses = network_address_resolve(STRING_CONST("localhost:80"));
+	compacts = network_address_resolve_compact(STRING_CONST("localhost:80"));
+	EXPECT_SIZEEQ(array_size(compacts), array_size(addresses));
+	for (iaddr = 0; iaddr < array_size(compacts); ++iaddr) {
+		network_address_from_compact((network_address_t*)&expanded, compacts + iaddr);
+		EXPECT_TRUE(network_address_equal((network_address_t*)&expanded, addresses[iaddr]));
+	}
+	array_deallocate(compacts);
+	network_address_array_deallocate(addresses);
+
+	addresses = network_address_local();
+	compacts = network_address_local_compact();
+	EXPECT_SIZEEQ(array_size(compacts), array_size(addresses));
+	array_deallocate(compacts);
+	network_address_array_deallocate(addresses);
+
+	return 0;
+}
+
+DECLARE_TEST(address, cidr) {
+	network_cidr_t* table = network_cidr_allocate();
+	network_address_compact_t prefix;
+	network_address_compact_t* addresses;
+	network_address_ipv6_t parsed;
+	network_address_t* address = (network_address_t*)&parsed;
+	void** values;
+	unsigned int bits;
+	const size_t count = 100000;
+	size_t iaddr;
+	tick_t start, batch_ticks, single_ticks;
+
+	EXPECT_TRUE(network_cidr_parse(&prefix, &bits, STRING_CONST("10.1.2.3/16")));
+	EXPECT_UINTEQ(bits, 16);
+	network_address_from_compact(address, &prefix);
+	EXPECT_UINTEQ(network_address_ipv4_ip(address), network_address_ipv4_make_ip(10, 1, 0, 0));
+	EXPECT_TRUE(network_cidr_parse(&prefix, &bits, STRING_CONST("2001:db8::")));
+	EXPECT_UINTEQ(bits, 128);
+	EXPECT_FALSE(network_cidr_parse(&prefix, &bits, STRING_CONST("10.0.0.0/33")));
+	EXPECT_FALSE(network_cidr_parse(&prefix, &bits, STRING_CONST("10.0.0.0/")));
+	EXPECT_FALSE(network_cidr_parse(&prefix, &bits, STRING_CONST("10.0.0.0:80/8")));
+	EXPECT_FALSE(network_cidr_parse(&prefix, &bits, STRING_CONST("localhost/8")));
+	EXPECT_FALSE(network_cidr_parse(&prefix, &bits, STRING_CONST("unix:foo/8")));
+
+	EXPECT_TRUE(network_cidr_insert(table, STRING_CONST("10.0.0.0/8"), (void*)1));
+	EXPECT_TRUE(network_cidr_insert(table, STRING_CONST("10.1.0.0/16"), (void*)2));
+	EXPECT_TRUE(network_cidr_insert(table, STRING_CONST("10.1.2.0/24"), (void*)3));
+	EXPECT_TRUE(network_cidr_insert(table, STRING_CONST("10.1.2.3"), (void*)4));
+	EXPECT_TRUE(network_cidr_insert(table, STRING_CONST("2001:db8::/32"), (void*)5));
+	EXPECT_TRUE(network_cidr_insert(table, STRING_CONST("2001:db8:1::/48"), (void*)6));
+	EXPECT_SIZEEQ(network_cidr_size(table), 6);
+
+	network_address_parse(address, STRING_CONST("10.1.2.3:80"));
+	EXPECT_EQ(network_cidr_lookup(table, address), (void*)4);
+	network_address_parse(address, STRING_CONST("10.1.2.4"));
+	EXPECT_EQ(network_cidr_lookup(table, address), (void*)3);
+	network_address_parse(address, STRING_CONST("10.1.3.4"));
+	EXPECT_EQ(network_cidr_lookup(table, address), (void*)2);
+	network_address_parse(address, STRING_CONST("10.2.3.4"));
+	EXPECT_EQ(network_cidr_lookup(table, address), (void*)1);
+	network_address_parse(address, STRING_CONST("11.0.0.1"));
+	EXPECT_EQ(network_cidr_lookup(table, address), nullptr);
+	network_address_parse(address, STRING_CONST("::ffff:10.1.2.4"));
+	EXPECT_EQ(network_cidr_lookup(table, address), (void*)3);
+	network_address_parse(address, STRING_CONST("[2001:db8:1:2::1]:443"));
+	EXPECT_EQ(network_cidr_lookup(table, address), (void*)6);
+	network_address_parse(address, STRING_CONST("2001:db8:2::1"));
+	EXPECT_EQ(network_cidr_lookup(table, address), (void*)5);
+	network_address_parse(address, STRING_CONST("2001:db9::1"));
+	EXPECT_EQ(network_cidr_lookup(table, address), nullptr);
+
+	EXPECT_EQ(network_cidr_remove(table, STRING_CONST("10.1.0.0/16")), (void*)2);
+	EXPECT_EQ(network_cidr_remove(table, STRING_CONST("10.1.0.0/16")), nullptr);
+	network_address_parse(address, STRING_CONST("10.1.3.4"));
+	EXPECT_EQ(network_cidr_lookup(table, address), (void*)1);
+	network_address_parse(address, STRING_CONST("10.1.2.4"));
+	EXPECT_EQ(network_cidr_lookup(table, address), (void*)3);
+	EXPECT_SIZEEQ(network_cidr_size(table), 5);
+
+	// Large table of /24 prefixes, batched and individual lookups must agree
+	network_cidr_clear(table);
+	network_address_ipv4_initialize((network_address_ipv4_t*)address);
+	for (iaddr = 0; iaddr < count; ++iaddr) {
+		network_address_ipv4_set_ip(address, (uint32_t)(0x0A000000 + (iaddr << 8)));
+		network_address_to_compact(address, &prefix);
+		EXPECT_EQ(network_cidr_insert_prefix(table, &prefix, 24, (void*)(iaddr + 1)), nullptr);
+	}
+	EXPECT_SIZEEQ(network_cidr_size(table), count);
+
+	addresses = memory_allocate(HASH_NETWORK, sizeof(network_address_compact_t) * count, 0, MEMORY_PERSISTENT);
+	values = memory_allocate(HASH_NETWORK, sizeof(void*) * count, 0, MEMORY_PERSISTENT);
+	for (iaddr = 0; iaddr < count; ++iaddr) {
+		uint32_t ip = (uint32_t)(0x0A000000 + (((iaddr * 7919) % (count * 2)) << 8) + (iaddr & 0xFF));
+		network_address_ipv4_set_ip(address, ip);
+		network_address_to_compact(address, addresses + iaddr);
+	}
+
+	start = time_current();
+	network_cidr_lookup_batch(table, addresses, count, values);
+	batch_ticks = time_elapsed_ticks(start);
+
+	start = time_current();
+	for (iaddr = 0; iaddr < count; ++iaddr) {
+		void* value = network_cidr_lookup_compact(table, addresses + iaddr);
+		size_t index = ((iaddr * 7919) % (count * 2));
+		EXPECT_EQ(value, values[iaddr]);
+		EXPECT_EQ(value, (index < count) ? (void*)(index + 1) : nullptr);
+	}
+	single_ticks = time_elapsed_ticks(start);
+
+	log_infof(HASH_NETWORK, STRING_CONST("CIDR lookup: %.1fns batched, %.1fns single (%" PRIsize " prefixes)"),
+	          (double)time_ticks_to_seconds(batch_ticks) * 1000000000.0 / (double)count,
+	          (double)time_ticks_to_seconds(single_ticks) * 1000000000.0 / (double)count, count);
+
+	memory_deallocate(addresses);
+	memory_deallocate(values);
+	network_cidr_deallocate(table);
+
+	return 0;
+}
+
+DECLARE_TEST(address, local_cached) {
+	network_address_compact_t cached[64];
+	network_address_t** addresses;
+	network_address_compact_t compact;
+	network_poll_event_t events[4];
+	network_poll_t* poll;
+	socket_t* monitor;
+	size_t count, iaddr, icached;
+	unsigned int generation;
+
+	count = network_address_local_cached(cached, sizeof(cached) / sizeof(cached[0]));
+	generation = network_address_local_generation();
+	addresses = network_address_local();
+	EXPECT_SIZEEQ(count, array_size(addresses));
+	for (iaddr = 0; iaddr < array_size(addresses); ++iaddr) {
+		bool found = false;
+		EXPECT_TRUE(network_address_to_compact(addresses[iaddr], &compact));
+		for (icached = 0; icached < count; ++icached)
+			found |= network_address_compact_equal(&compact, cached + icached);
+		EXPECT_TRUE(found);
+	}
+	network_address_array_deallocate(addresses);
+
+	// Unchanged address set does not bump generation
+	EXPECT_FALSE(network_address_local_refresh());
+	EXPECT_EQ(network_address_local_generation(), generation);
+	EXPECT_SIZEEQ(network_address_local_cached(cached, 1), count);
+
+	monitor = network_address_local_monitor();
+#if FOUNDATION_PLATFORM_LINUX
+	EXPECT_NE(monitor, nullptr);
+#endif
+	if (monitor) {
+		poll = network_poll_allocate(4);
+		EXPECT_TRUE(network_poll_add_socket(poll, monitor));
+		EXPECT_SIZEEQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), 0), 0);
+		EXPECT_FALSE(network_address_local_update());
+		network_poll_remove_socket(poll, monitor);
+		network_poll_deallocate(poll);
+	}
+
+	return 0;
+}
+
+static atomic32_t resolve_callback_count;
+static atomic32_t resolve_callback_found;
+static semaphore_t resolve_callback_done;
+
+static void
+resolve_callback(const char* address, size_t length, network_address_t** addresses, void* userdata) {
+	FOUNDATION_UNUSED(address);
+	FOUNDATION_UNUSED(length);
+	FOUNDATION_UNUSED(userdata);
+	if (array_size(addresses))
+		atomic_incr32(&resolve_callback_found, memory_order_relaxed);
+	network_address_array_deallocate(addresses);
+	atomic_incr32(&resolve_callback_count, memory_order_release);
+	semaphore_post(&resolve_callback_done);
+}
+
+DECLARE_TEST(address, resolve_cache) {
+	network_address_t** first;
+	network_address_t** second;
+	tick_t start;
+	tick_t uncached, cached;
+	int icallback;
+
+	network_resolver_cache_clear();
+
+	start = time_current();
+	first = network_address_resolve(STRING_CONST("localhost:80"));
+	uncached = time_elapsed_ticks(start);
+	EXPECT_GT(array_size(first), 0);
+
+	start = time_current();
+	second = network_address_resolve(STRING_CONST("localhost:80"));
+	cached = time_elapsed_ticks(start);
+	EXPECT_UINTEQ(array_size(second), array_size(first));
+	for (unsigned int iaddr = 0; iaddr < array_size(first); ++iaddr)
+		EXPECT_TRUE(network_address_equal(first[iaddr], second[iaddr]));
+	EXPECT_LE(cached, uncached);
+
+	network_address_array_deallocate(first);
+	network_address_array_deallocate(second);
+
+	// Concurrent asynchronous resolves of the same address merge into one lookup
+	network_resolver_cache_clear();
+	semaphore_initialize(&resolve_callback_done, 0);
+	atomic_store32(&resolve_callback_count, 0, memory_order_release);
+	atomic_store32(&resolve_callback_found, 0, memory_order_release);
+	for (icallback = 0; icallback < 4; ++icallback)
+		EXPECT_TRUE(network_address_resolve_async(STRING_CONST("localhost:8080"), resolve_callback, nullptr));
+	for (icallback = 0; icallback < 4; ++icallback)
+		EXPECT_TRUE(semaphore_try_wait(&resolve_callback_done, 5000));
+	EXPECT_INTEQ(atomic_load32(&resolve_callback_count, memory_order_acquire), 4);
+	EXPECT_INTEQ(atomic_load32(&resolve_callback_found, memory_order_acquire), 4);
+
+	// Cached result is delivered directly on the calling thread
+	EXPECT_TRUE(network_address_resolve_async(STRING_CONST("localhost:8080"), resolve_callback, nullptr));
+	EXPECT_INTEQ(atomic_load32(&resolve_callback_count, memory_order_acquire), 5);
+	semaphore_finalize(&resolve_callback_done);
+
+	return 0;
+}
+
 static void
 test_address_declare(void) {
 	ADD_TEST(address, local);
 	ADD_TEST(address, resolve);
+	ADD_TEST(address, resolve_cache);
+	ADD_TEST(address, parse);
+	ADD_TEST(address, to_string);
+	ADD_TEST(address, hash_map);
+	ADD_TEST(address, compact);
+	ADD_TEST(address, cidr);
+	ADD_TEST(address, local_cached);
 	ADD_TEST(address, any);
 	ADD_TEST(address, port);
 	ADD_TEST(address, family);
@@ -26,9 +26,31 @@ test_poll_application(void) {
 	return app;
 }
 
+static memory_system_t test_poll_memory_base;
+static atomic64_t test_poll_memory_allocations;
+static bool test_poll_memory_counted;
+
+static void*
+test_poll_memory_allocate(hash_t context, size_t size, unsigned int align, unsigned int hint) {
+	atomic_incr64(&test_poll_memory_allocations, memory_order_relaxed);
+	return test_poll_memory_base.allocate(context, size, align, hint);
+}
+
+static void*
+test_poll_memory_reallocate(void* p, size_t size, unsigned int align, size_t oldsize, unsigned int hint) {
+	atomic_incr64(&test_poll_memory_allocations, memory_order_relaxed);
+	return test_poll_memory_base.reallocate(p, size, align, oldsize, hint);
+}
+
 static memory_system_t
 test_poll_memory_system(void) {
-	return memory_system_malloc();
+	// Count every allocation made through foundation, including array growth, for the allocation tests
+	memory_system_t memory_system = memory_system_malloc();
+	test_poll_memory_base = memory_system;
+	test_poll_memory_counted = true;
+	memory_system.allocate = test_poll_memory_allocate;
+	memory_system.reallocate = test_poll_memory_reallocate;
+	return memory_system;
 }
 
 static foundation_config_t
@@ -140,9 +162,261 @@ DECLARE_TEST(poll, poll) {
 	return 0;
 }
 
+DECLARE_TEST(poll, cork) {
+	network_poll_event_t event[64];
+	size_t event_capacity = sizeof(event) / sizeof(event[0]);
+	socket_t* sock_listen = tcp_socket_allocate();
+	socket_t* sock_client = tcp_socket_allocate();
+	socket_t* sock_server = 0;
+	network_address_ipv4_t address;
+	char buffer[64];
+	size_t ipart;
+
+	network_address_ipv4_initialize(&address);
+	network_address_ipv4_set_ip((network_address_t*)&address, network_address_ipv4_make_ip(127, 0, 0, 1));
+	EXPECT_TRUE(socket_bind(sock_listen, (network_address_t*)&address));
+	EXPECT_TRUE(tcp_socket_listen(sock_listen));
+	socket_set_blocking(sock_client, true);
+	EXPECT_TRUE(socket_connect(sock_client, socket_address_local(sock_listen), 2000));
+	sock_server = tcp_socket_accept(sock_listen, 2000);
+	EXPECT_NE(sock_server, 0);
+	socket_deallocate(sock_listen);
+	socket_set_blocking(sock_server, true);
+
+	network_poll_t* poll = network_poll_allocate(16);
+	stream_t* writer = socket_stream_allocate(sock_client, 64, 64);
+	stream_t* reader = socket_stream_allocate(sock_server, 64, 64);
+
+	socket_stream_cork(writer, poll);
+	EXPECT_TRUE(socket_stream_is_corked(writer));
+
+	// Small writes accumulate until the end of the event loop iteration
+	for (ipart = 0; ipart < 4; ++ipart)
+		EXPECT_SIZEEQ(stream_write(writer, "part", 4), 4);
+	thread_sleep(50);
+	EXPECT_SIZEEQ(socket_available_read(sock_server), 0);
+
+	network_poll(poll, event, event_capacity, 0);
+	EXPECT_SIZEEQ(stream_read(reader, buffer, 16), 16);
+	EXPECT_EQ(memcmp(buffer, "partpartpartpart", 16), 0);
+
+	// Nothing pending, flush is a no-op
+	EXPECT_SIZEEQ(network_poll_flush(poll), 0);
+
+	// Writes exceeding the buffer are pushed out as they fill up
+	memset(buffer, 'x', sizeof(buffer));
+	for (ipart = 0; ipart < 3; ++ipart)
+		EXPECT_SIZEEQ(stream_write(writer, buffer, sizeof(buffer)), sizeof(buffer));
+	EXPECT_SIZEEQ(network_poll_flush(poll), 1);
+	for (ipart = 0; ipart < 3; ++ipart) {
+		memset(buffer, 0, sizeof(buffer));
+		EXPECT_SIZEEQ(stream_read(reader, buffer, sizeof(buffer)), sizeof(buffer));
+		EXPECT_EQ(buffer[0], 'x');
+		EXPECT_EQ(buffer[sizeof(buffer) - 1], 'x');
+	}
+
+	// Uncorking flushes immediately
+	EXPECT_SIZEEQ(stream_write(writer, "tail", 4), 4);
+	socket_stream_uncork(writer);
+	EXPECT_FALSE(socket_stream_is_corked(writer));
+	EXPECT_SIZEEQ(stream_read(reader, buffer, 4), 4);
+	EXPECT_EQ(memcmp(buffer, "tail", 4), 0);
+	EXPECT_SIZEEQ(network_poll_flush(poll), 0);
+
+	stream_deallocate(writer);
+	stream_deallocate(reader);
+	network_poll_deallocate(poll);
+	socket_deallocate(sock_client);
+	socket_deallocate(sock_server);
+
+	return 0;
+}
+
+// Send a numbered burst over a lossy, reordering link and record the order of arrival
+static size_t
+test_poll_sim_burst(uint64_t seed, uint32_t* order, size_t capacity) {
+	network_sim_t* sim = network_sim_allocate(seed);
+	network_poll_t* poll = network_poll_allocate(4);
+	network_poll_event_t events[4];
+	network_address_ipv4_t address;
+	network_sim_link_t link;
+	size_t received = 0;
+	uint32_t value;
+
+	memset(&link, 0, sizeof(link));
+	link.latency = 20000;
+	link.jitter = 5000;
+	link.loss = REAL_C(0.1);
+	link.reorder = REAL_C(0.2);
+	network_sim_set_default_link(sim, &link);
+
+	network_address_ipv4_initialize(&address);
+	network_address_ipv4_set_ip((network_address_t*)&address, network_address_ipv4_make_ip(10, 0, 0, 1));
+	socket_t* sender = network_sim_socket_allocate(sim, (network_address_t*)&address);
+	network_address_ipv4_set_ip((network_address_t*)&address, network_address_ipv4_make_ip(10, 0, 0, 2));
+	network_address_ip_set_port((network_address_t*)&address, 4000);
+	socket_t* receiver = network_sim_socket_allocate(sim, (network_address_t*)&address);
+
+	network_sim_attach_poll(sim, poll);
+	network_poll_add_socket(poll, receiver);
+
+	for (value = 0; value < 100; ++value) {
+		udp_socket_sendto(sender, &value, sizeof(value), socket_address_local(receiver));
+		network_sim_advance(sim, time_ticks_per_second() / 1000);
+	}
+	while (network_poll(poll, events, sizeof(events) / sizeof(events[0]), NETWORK_TIMEOUT_INFINITE)) {
+		while (udp_socket_recvfrom(receiver, &value, sizeof(value), nullptr) == sizeof(value)) {
+			if (received < capacity)
+				order[received] = value;
+			++received;
+		}
+	}
+
+	network_poll_deallocate(poll);
+	socket_deallocate(sender);
+	socket_deallocate(receiver);
+	network_sim_deallocate(sim);
+	return received;
+}
+
+DECLARE_TEST(poll, sim) {
+	network_sim_t* sim = network_sim_allocate(1);
+	network_poll_t* poll = network_poll_allocate(4);
+	network_poll_event_t events[4];
+	network_address_ipv4_t address;
+	const network_address_t* address_from = nullptr;
+	network_sim_link_t link;
+	uint32_t order[2][100];
+	size_t received[2];
+	char payload[100];
+	char buffer[16];
+
+	memset(payload, 0, sizeof(payload));
+	memset(&link, 0, sizeof(link));
+	link.latency = 50000;
+	link.bandwidth = 1000;
+	link.queue_limit = 150;
+
+	network_address_ipv4_initialize(&address);
+	network_address_ipv4_set_ip((network_address_t*)&address, network_address_ipv4_make_ip(10, 0, 0, 1));
+	socket_t* first = network_sim_socket_allocate(sim, (network_address_t*)&address);
+	EXPECT_NE(first, nullptr);
+	EXPECT_NE(network_address_ip_port(socket_address_local(first)), 0);
+	network_address_ipv4_set_ip((network_address_t*)&address, network_address_ipv4_make_ip(10, 0, 0, 2));
+	network_address_ip_set_port((network_address_t*)&address, 4000);
+	socket_t* second = network_sim_socket_allocate(sim, (network_address_t*)&address);
+	EXPECT_NE(second, nullptr);
+	EXPECT_EQ(network_sim_socket_allocate(sim, (network_address_t*)&address), nullptr);
+	network_sim_set_link(sim, socket_address_local(first), socket_address_local(second), &link);
+
+	network_sim_attach_poll(sim, poll);
+	network_poll_add_socket(poll, second);
+
+	// Latency and serialization at 1000 bytes/s, the third datagram exceeds the queue limit
+	EXPECT_SIZEEQ(udp_socket_sendto(first, "0123456789", 10, socket_address_local(second)), 10);
+	EXPECT_SIZEEQ(udp_socket_sendto(first, payload, 100, socket_address_local(second)), 100);
+	EXPECT_SIZEEQ(udp_socket_sendto(first, payload, 100, socket_address_local(second)), 100);
+	EXPECT_SIZEEQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), 0), 0);
+	EXPECT_SIZEEQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), 10), 0);
+	EXPECT_EQ(network_sim_time(sim), time_ticks_per_second() / 100);
+	EXPECT_SIZEEQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), NETWORK_TIMEOUT_INFINITE), 1);
+	EXPECT_EQ(events[0].event, NETWORKEVENT_DATAIN);
+	EXPECT_EQ(events[0].socket, second);
+	EXPECT_EQ(network_sim_time(sim), (time_ticks_per_second() * 60) / 1000);
+	EXPECT_SIZEEQ(udp_socket_recvfrom(second, buffer, sizeof(buffer), &address_from), 10);
+	EXPECT_MEMEQ(buffer, "0123456789", 10);
+	EXPECT_TRUE(network_address_equal(address_from, socket_address_local(first)));
+	EXPECT_SIZEEQ(udp_socket_recvfrom(second, buffer, sizeof(buffer), &address_from), 0);
+	EXPECT_SIZEEQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), NETWORK_TIMEOUT_INFINITE), 1);
+	EXPECT_EQ(network_sim_time(sim), (time_ticks_per_second() * 160) / 1000);
+	EXPECT_SIZEEQ(udp_socket_recvfrom(second, buffer, sizeof(buffer), &address_from), sizeof(buffer));
+	EXPECT_SIZEEQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), NETWORK_TIMEOUT_INFINITE), 0);
+	EXPECT_EQ(network_sim_statistics(sim)->sent, 3);
+	EXPECT_EQ(network_sim_statistics(sim)->delivered, 2);
+	EXPECT_EQ(network_sim_statistics(sim)->dropped, 1);
+
+	// Reverse direction uses the default link without latency
+	EXPECT_SIZEEQ(udp_socket_sendto(second, "pong", 4, socket_address_local(first)), 4);
+	EXPECT_SIZEEQ(network_sim_advance(sim, 0), 1);
+	EXPECT_SIZEEQ(udp_socket_recvfrom(first, buffer, sizeof(buffer), &address_from), 4);
+	EXPECT_MEMEQ(buffer, "pong", 4);
+
+	// Closed sockets are unreachable
+	network_poll_deallocate(poll);
+	socket_deallocate(second);
+	EXPECT_SIZEEQ(udp_socket_sendto(first, "void", 4, (network_address_t*)&address), 4);
+	EXPECT_SIZEEQ(network_sim_advance(sim, time_ticks_per_second()), 0);
+	EXPECT_EQ(network_sim_statistics(sim)->unreachable, 1);
+	socket_deallocate(first);
+	network_sim_deallocate(sim);
+
+	// Loss and reordering replay identically from the same seed
+	received[0] = test_poll_sim_burst(0x1234, order[0], 100);
+	received[1] = test_poll_sim_burst(0x1234, order[1], 100);
+	EXPECT_SIZEEQ(received[0], received[1]);
+	EXPECT_SIZELT(received[0], 100);
+	EXPECT_GT(received[0], 50);
+	EXPECT_EQ(memcmp(order[0], order[1], sizeof(uint32_t) * received[0]), 0);
+	bool reordered = false;
+	for (size_t iorder = 1; iorder < received[0]; ++iorder)
+		reordered |= (order[0][iorder] < order[0][iorder - 1]);
+	EXPECT_TRUE(reordered);
+
+	return 0;
+}
+
+DECLARE_TEST(poll, allocation_count) {
+	network_poll_event_t event[64];
+	size_t event_capacity = sizeof(event) / sizeof(event[0]);
+	socket_t* sock_udp[2];
+	network_poll_t* poll;
+	network_address_ipv4_t address;
+	const network_address_t* address_remote;
+	uint64_t data = HASH_NETWORK;
+	unsigned int iloop;
+
+	// Monolithic builds run with the memory system of the combined test binary
+	if (!test_poll_memory_counted)
+		return 0;
+
+	sock_udp[0] = udp_socket_allocate();
+	sock_udp[1] = udp_socket_allocate();
+	poll = network_poll_allocate(1024);
+	network_address_ipv4_initialize(&address);
+	network_address_ipv4_set_ip((network_address_t*)&address, network_address_ipv4_make_ip(127, 0, 0, 1));
+	EXPECT_TRUE(socket_bind(sock_udp[0], (network_address_t*)&address));
+	EXPECT_TRUE(socket_bind(sock_udp[1], (network_address_t*)&address));
+	EXPECT_TRUE(network_poll_add_socket(poll, sock_udp[0]));
+	EXPECT_TRUE(network_poll_add_socket(poll, sock_udp[1]));
+
+	// Warm up to allocate the lazy remote address storage
+	udp_socket_sendto(sock_udp[0], &data, sizeof(data), socket_address_local(sock_udp[1]));
+	EXPECT_EQ(network_poll(poll, event, event_capacity, NETWORK_TIMEOUT_INFINITE), 1);
+	EXPECT_SIZEEQ(udp_socket_recvfrom(sock_udp[1], &data, sizeof(data), &address_remote), sizeof(data));
+
+	// Steady state poll, receive and send performs no allocations
+	atomic_store64(&test_poll_memory_allocations, 0, memory_order_relaxed);
+	for (iloop = 0; iloop < 64; ++iloop) {
+		udp_socket_sendto(sock_udp[0], &data, sizeof(data), socket_address_local(sock_udp[1]));
+		EXPECT_EQ(network_poll(poll, event, event_capacity, NETWORK_TIMEOUT_INFINITE), 1);
+		EXPECT_EQ(event[0].event, NETWORKEVENT_DATAIN);
+		EXPECT_EQ(event[0].socket, sock_udp[1]);
+		EXPECT_SIZEEQ(udp_socket_recvfrom(sock_udp[1], &data, sizeof(data), &address_remote), sizeof(data));
+	}
+	EXPECT_EQ(atomic_load64(&test_poll_memory_allocations, memory_order_relaxed), 0);
+
+	network_poll_deallocate(poll);
+	socket_deallocate(sock_udp[0]);
+	socket_deallocate(sock_udp[1]);
+	return 0;
+}
+
 static void
 test_poll_declare(void) {
 	ADD_TEST(poll, poll);
+	ADD_TEST(poll, cork);
+	ADD_TEST(poll, sim);
+	ADD_TEST(poll, allocation_count);
 }
 
 static test_suite_t test_poll_suite = {test_poll_application,
@@ -211,6 +211,355 @@ DECLARE_TEST(udp, bind) {
 	return 0;
 }
 
+#if FOUNDATION_PLATFORM_POSIX
+
+static network_address_t*
+unix_test_address(network_address_unix_t* address, const char* name) {
+	char buffer[128];
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+	string_t path = string_format(buffer, sizeof(buffer), STRING_CONST("@network_test_%s_%u"), name,
+	                              (unsigned int)process_id());
+#else
+	string_t path = string_format(buffer, sizeof(buffer), STRING_CONST("/tmp/network_test_%s_%u"), name,
+	                              (unsigned int)process_id());
+	fs_remove_file(STRING_ARGS(path));
+#endif
+	return network_address_unix_initialize(address, STRING_ARGS(path));
+}
+
+#endif
+
+DECLARE_TEST(unix, address) {
+#if FOUNDATION_PLATFORM_POSIX
+	network_address_unix_t address;
+	network_address_unix_t other;
+	network_address_ipv6_t parsed;
+	char buffer[128];
+	string_t str;
+
+	EXPECT_NE(network_address_unix_initialize(&address, STRING_CONST("/tmp/peer.sock")), nullptr);
+	EXPECT_EQ(network_address_family((network_address_t*)&address), NETWORK_ADDRESSFAMILY_UNIX);
+	EXPECT_CONSTSTRINGEQ(network_address_unix_path((network_address_t*)&address),
+	                     string_const(STRING_CONST("/tmp/peer.sock")));
+	EXPECT_FALSE(network_address_unix_is_abstract((network_address_t*)&address));
+
+	str = network_address_to_string(buffer, sizeof(buffer), (network_address_t*)&address, true);
+	EXPECT_STRINGEQ(str, string_const(STRING_CONST("unix:/tmp/peer.sock")));
+
+	// Configured addresses can switch transport by prefix
+	EXPECT_TRUE(network_address_parse((network_address_t*)&parsed, STRING_CONST("unix:/tmp/peer.sock")));
+	EXPECT_TRUE(network_address_equal((network_address_t*)&parsed, (network_address_t*)&address));
+	EXPECT_EQ(network_address_hash((network_address_t*)&parsed), network_address_hash((network_address_t*)&address));
+
+	EXPECT_NE(network_address_unix_initialize(&other, STRING_CONST("/tmp/peer2.sock")), nullptr);
+	EXPECT_FALSE(network_address_equal((network_address_t*)&other, (network_address_t*)&address));
+
+	EXPECT_EQ(network_address_unix_initialize(&other, STRING_CONST("")), nullptr);
+	memset(buffer, 'a', sizeof(buffer));
+	EXPECT_EQ(network_address_unix_initialize(&other, buffer, sizeof(buffer)), nullptr);
+
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+	EXPECT_NE(network_address_unix_initialize(&address, STRING_CONST("@peer")), nullptr);
+	EXPECT_TRUE(network_address_unix_is_abstract((network_address_t*)&address));
+	EXPECT_CONSTSTRINGEQ(network_address_unix_path((network_address_t*)&address), string_const(STRING_CONST("peer")));
+	str = network_address_to_string(buffer, sizeof(buffer), (network_address_t*)&address, true);
+	EXPECT_STRINGEQ(str, string_const(STRING_CONST("unix:@peer")));
+#endif
+#endif
+	return 0;
+}
+
+DECLARE_TEST(unix, stream) {
+#if FOUNDATION_PLATFORM_POSIX
+	socket_t* sock_listen = unix_socket_allocate(NETWORK_SOCKETTYPE_UNIX_STREAM);
+	socket_t* sock_client = unix_socket_allocate(NETWORK_SOCKETTYPE_UNIX_STREAM);
+	socket_t* sock_server;
+	network_address_unix_t address;
+	network_poll_event_t events[8];
+	network_poll_t* poll;
+	stream_t* reader;
+	stream_t* writer;
+	char buffer[32];
+	size_t num_events;
+
+	EXPECT_NE(unix_test_address(&address, "stream"), nullptr);
+	EXPECT_TRUE(socket_bind(sock_listen, (network_address_t*)&address));
+	EXPECT_TRUE(network_address_equal(socket_address_local(sock_listen), (network_address_t*)&address));
+	EXPECT_TRUE(tcp_socket_listen(sock_listen));
+
+	poll = network_poll_allocate(4);
+	network_poll_add_socket(poll, sock_listen);
+
+	socket_set_blocking(sock_client, true);
+	EXPECT_TRUE(socket_connect(sock_client, (network_address_t*)&address, 2000));
+	EXPECT_EQ(socket_state(sock_client), SOCKETSTATE_CONNECTED);
+
+	num_events = network_poll(poll, events, sizeof(events) / sizeof(events[0]), 2000);
+	EXPECT_SIZEEQ(num_events, 1);
+	EXPECT_EQ(events[0].event, NETWORKEVENT_CONNECTION);
+	EXPECT_EQ(events[0].socket, sock_listen);
+
+	sock_server = tcp_socket_accept(sock_listen, 0);
+	EXPECT_NE(sock_server, nullptr);
+	EXPECT_EQ(socket_type(sock_server), NETWORK_SOCKETTYPE_UNIX_STREAM);
+	EXPECT_EQ(socket_state(sock_server), SOCKETSTATE_CONNECTED);
+	socket_set_blocking(sock_server, true);
+
+	writer = socket_stream_allocate(sock_client, 64, 64);
+	reader = socket_stream_allocate(sock_server, 64, 64);
+	stream_write(writer, STRING_CONST("unix stream"));
+	stream_flush(writer);
+	EXPECT_SIZEEQ(stream_read(reader, buffer, 11), 11);
+	EXPECT_MEMEQ(buffer, "unix stream", 11);
+
+	network_poll_add_socket(poll, sock_server);
+	EXPECT_SIZEEQ(socket_write(sock_client, "x", 1), 1);
+	num_events = network_poll(poll, events, sizeof(events) / sizeof(events[0]), 2000);
+	EXPECT_SIZEEQ(num_events, 1);
+	EXPECT_EQ(events[0].event, NETWORKEVENT_DATAIN);
+	EXPECT_EQ(events[0].socket, sock_server);
+
+	network_poll_deallocate(poll);
+	stream_deallocate(reader);
+	stream_deallocate(writer);
+	socket_deallocate(sock_server);
+	socket_deallocate(sock_client);
+	socket_deallocate(sock_listen);
+#if !FOUNDATION_PLATFORM_LINUX && !FOUNDATION_PLATFORM_ANDROID
+	fs_remove_file(STRING_ARGS(network_address_unix_path((network_address_t*)&address)));
+#endif
+#endif
+	return 0;
+}
+
+DECLARE_TEST(unix, datagram) {
+#if FOUNDATION_PLATFORM_POSIX
+	socket_t* sock_server = unix_socket_allocate(NETWORK_SOCKETTYPE_UNIX_DGRAM);
+	socket_t* sock_client = unix_socket_allocate(NETWORK_SOCKETTYPE_UNIX_DGRAM);
+	network_address_unix_t address_server;
+	network_address_unix_t address_client;
+	const network_address_t* address_from = nullptr;
+	char buffer[32];
+
+	EXPECT_NE(unix_test_address(&address_server, "dgram_server"), nullptr);
+	EXPECT_NE(unix_test_address(&address_client, "dgram_client"), nullptr);
+	EXPECT_TRUE(socket_bind(sock_server, (network_address_t*)&address_server));
+	EXPECT_TRUE(socket_bind(sock_client, (network_address_t*)&address_client));
+	socket_set_blocking(sock_server, true);
+	socket_set_blocking(sock_client, true);
+
+	EXPECT_SIZEEQ(udp_socket_sendto(sock_client, "ping", 4, (network_address_t*)&address_server), 4);
+	EXPECT_SIZEEQ(udp_socket_recvfrom(sock_server, buffer, sizeof(buffer), &address_from), 4);
+	EXPECT_MEMEQ(buffer, "ping", 4);
+	EXPECT_TRUE(network_address_equal(address_from, (network_address_t*)&address_client));
+
+	// Reply to the sender address
+	EXPECT_SIZEEQ(udp_socket_sendto(sock_server, "pong", 4, address_from), 4);
+	EXPECT_SIZEEQ(udp_socket_recvfrom(sock_client, buffer, sizeof(buffer), &address_from), 4);
+	EXPECT_MEMEQ(buffer, "pong", 4);
+	EXPECT_TRUE(network_address_equal(address_from, (network_address_t*)&address_server));
+
+	socket_deallocate(sock_client);
+	socket_deallocate(sock_server);
+#if !FOUNDATION_PLATFORM_LINUX && !FOUNDATION_PLATFORM_ANDROID
+	fs_remove_file(STRING_ARGS(network_address_unix_path((network_address_t*)&address_server)));
+	fs_remove_file(STRING_ARGS(network_address_unix_path((network_address_t*)&address_client)));
+#endif
+#endif
+	return 0;
+}
+
+static socket_t* shm_accepted;
+
+static void*
+shm_accept_thread(void* arg) {
+	shm_accepted = shm_socket_accept((socket_t*)arg, 2000);
+	return 0;
+}
+
+static size_t shm_drain_size;
+
+static void*
+shm_drain_thread(void* arg) {
+	char buffer[4096];
+	size_t read = 0;
+	// Let the writer wait for space, then free exactly the space it needs
+	thread_sleep(50);
+	while (read < shm_drain_size) {
+		size_t remain = shm_drain_size - read;
+		size_t chunk = socket_read((socket_t*)arg, buffer, (remain < sizeof(buffer)) ? remain : sizeof(buffer));
+		if (!chunk)
+			break;
+		read += chunk;
+	}
+	return 0;
+}
+
+DECLARE_TEST(shm, stream) {
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+	socket_t* sock_listen = unix_socket_allocate(NETWORK_SOCKETTYPE_UNIX_STREAM);
+	socket_t* sock_client = shm_socket_allocate();
+	socket_t* sock_server;
+	network_address_unix_t address;
+	network_poll_event_t events[8];
+	network_poll_t* poll;
+	stream_t* reader;
+	stream_t* writer;
+	thread_t thread;
+	char* buffer_out;
+	char* buffer_in;
+	size_t size = 300 * 1024;
+	size_t written, read, chunk, num_events;
+
+	EXPECT_NE(unix_test_address(&address, "shm"), nullptr);
+	EXPECT_TRUE(socket_bind(sock_listen, (network_address_t*)&address));
+	EXPECT_TRUE(tcp_socket_listen(sock_listen));
+
+	shm_accepted = nullptr;
+	thread_initialize(&thread, shm_accept_thread, sock_listen, STRING_CONST("shm_accept"), THREAD_PRIORITY_NORMAL, 0);
+	thread_start(&thread);
+	EXPECT_TRUE(shm_socket_connect(sock_client, (network_address_t*)&address, 2000));
+	thread_finalize(&thread);
+
+	sock_server = shm_accepted;
+	EXPECT_NE(sock_server, nullptr);
+	EXPECT_EQ(socket_type(sock_server), NETWORK_SOCKETTYPE_SHM);
+	EXPECT_EQ(socket_state(sock_server), SOCKETSTATE_CONNECTED);
+	EXPECT_EQ(socket_state(sock_client), SOCKETSTATE_CONNECTED);
+
+	// Data written to a waiting end signals the poll
+	poll = network_poll_allocate(4);
+	network_poll_add_socket(poll, sock_server);
+	EXPECT_SIZEEQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), 0), 0);
+	EXPECT_SIZEEQ(socket_read(sock_server, events, 1), 0);
+	EXPECT_SIZEEQ(socket_write(sock_client, "shm", 3), 3);
+	num_events = network_poll(poll, events, sizeof(events) / sizeof(events[0]), 2000);
+	EXPECT_SIZEEQ(num_events, 1);
+	EXPECT_EQ(events[0].event, NETWORKEVENT_DATAIN);
+	EXPECT_EQ(events[0].socket, sock_server);
+	EXPECT_SIZEEQ(socket_available_read(sock_server), 3);
+
+	// Non-blocking writes larger than the ring are partial, wrapping around the end of the ring
+	buffer_out = memory_allocate(HASH_NETWORK, size, 0, MEMORY_PERSISTENT);
+	buffer_in = memory_allocate(HASH_NETWORK, size + 3, 0, MEMORY_PERSISTENT);
+	for (size_t ibyte = 0; ibyte < size; ++ibyte)
+		buffer_out[ibyte] = (char)(ibyte * 7);
+	written = socket_write(sock_client, buffer_out, size);
+	EXPECT_SIZELT(written, size);
+	read = socket_read(sock_server, buffer_in, size + 3);
+	EXPECT_SIZEEQ(read, written + 3);
+	written += socket_write(sock_client, buffer_out + written, size - written);
+	EXPECT_SIZEEQ(written, size);
+	read += socket_read(sock_server, buffer_in + read, size + 3 - read);
+	EXPECT_SIZEEQ(read, size + 3);
+	EXPECT_MEMEQ(buffer_in, "shm", 3);
+	EXPECT_MEMEQ(buffer_in + 3, buffer_out, size);
+
+	EXPECT_TRUE(socket_set_option(sock_server, NETWORK_SOCKETOPTION_BUSY_POLL, 50));
+	EXPECT_INTEQ(socket_option(sock_server, NETWORK_SOCKETOPTION_BUSY_POLL), 50);
+	EXPECT_FALSE(socket_set_option(sock_server, NETWORK_SOCKETOPTION_SEND_BUFFER, 4096));
+
+	// A blocking write waiting for space after a read that did not empty the ring must keep data signals
+	// armed, otherwise later data never reaches the poll
+	EXPECT_SIZEEQ(socket_read(sock_server, buffer_in, 1), 0);
+	EXPECT_SIZEEQ(socket_write(sock_client, "partial", 7), 7);
+	EXPECT_SIZEEQ(socket_read(sock_server, buffer_in, 7), 7);
+	written = socket_write(sock_server, buffer_out, size);
+	EXPECT_SIZELT(written, size);
+	socket_set_blocking(sock_server, true);
+	shm_drain_size = 4096;
+	thread_initialize(&thread, shm_drain_thread, sock_client, STRING_CONST("shm_drain"), THREAD_PRIORITY_NORMAL, 0);
+	thread_start(&thread);
+	EXPECT_SIZEEQ(socket_write(sock_server, buffer_out, shm_drain_size), shm_drain_size);
+	thread_finalize(&thread);
+	EXPECT_SIZEEQ(socket_write(sock_client, "x", 1), 1);
+	num_events = network_poll(poll, events, sizeof(events) / sizeof(events[0]), 2000);
+	EXPECT_SIZEEQ(num_events, 1);
+	EXPECT_EQ(events[0].event, NETWORKEVENT_DATAIN);
+	EXPECT_EQ(events[0].socket, sock_server);
+	EXPECT_SIZEEQ(socket_read(sock_server, buffer_in, 1), 1);
+	for (read = 0; read < written; read += chunk) {
+		chunk = socket_read(sock_client, buffer_in, size);
+		EXPECT_NE(chunk, 0);
+	}
+	EXPECT_SIZEEQ(read, written);
+
+	writer = socket_stream_allocate(sock_client, 64, 64);
+	reader = socket_stream_allocate(sock_server, 64, 64);
+	stream_write(writer, STRING_CONST("shm stream"));
+	stream_flush(writer);
+	EXPECT_SIZEEQ(stream_read(reader, buffer_in, 10), 10);
+	EXPECT_MEMEQ(buffer_in, "shm stream", 10);
+	stream_deallocate(writer);
+
+	// Closing one end is seen as end of stream by the other
+	socket_close(sock_client);
+	EXPECT_SIZEEQ(socket_read(sock_server, buffer_in, 1), 0);
+	EXPECT_EQ(socket_state(sock_server), SOCKETSTATE_NOTCONNECTED);
+
+	memory_deallocate(buffer_out);
+	memory_deallocate(buffer_in);
+	network_poll_deallocate(poll);
+	stream_deallocate(reader);
+	socket_deallocate(sock_server);
+	socket_deallocate(sock_client);
+	socket_deallocate(sock_listen);
+#endif
+	return 0;
+}
+
+DECLARE_TEST(shm, pair) {
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+	socket_t* first;
+	socket_t* second;
+	const network_address_t* address_from = nullptr;
+	network_poll_event_t events[8];
+	network_poll_t* poll;
+	char buffer[32];
+
+	EXPECT_TRUE(shm_socket_pair(&first, &second, false));
+	EXPECT_EQ(socket_type(first), NETWORK_SOCKETTYPE_SHM);
+	EXPECT_EQ(socket_state(first), SOCKETSTATE_CONNECTED);
+	EXPECT_EQ(socket_state(second), SOCKETSTATE_CONNECTED);
+	EXPECT_TRUE(network_address_equal(socket_address_remote(first), socket_address_local(second)));
+	EXPECT_TRUE(network_address_equal(socket_address_remote(second), socket_address_local(first)));
+	EXPECT_FALSE(network_address_equal(socket_address_local(first), socket_address_local(second)));
+
+	poll = network_poll_allocate(4);
+	network_poll_add_socket(poll, second);
+	EXPECT_SIZEEQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), 0), 0);
+	EXPECT_SIZEEQ(socket_write(first, "loopback", 8), 8);
+	EXPECT_SIZEEQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), 0), 1);
+	EXPECT_EQ(events[0].event, NETWORKEVENT_DATAIN);
+	EXPECT_EQ(events[0].socket, second);
+	EXPECT_SIZEEQ(socket_read(second, buffer, sizeof(buffer)), 8);
+	EXPECT_MEMEQ(buffer, "loopback", 8);
+	network_poll_deallocate(poll);
+
+	socket_deallocate(first);
+	EXPECT_SIZEEQ(socket_read(second, buffer, sizeof(buffer)), 0);
+	EXPECT_EQ(socket_state(second), SOCKETSTATE_NOTCONNECTED);
+	socket_deallocate(second);
+
+	// Datagrams keep their boundaries and are only delivered to the other end
+	EXPECT_TRUE(shm_socket_pair(&first, &second, true));
+	EXPECT_EQ(socket_type(first), NETWORK_SOCKETTYPE_SHM_DGRAM);
+	EXPECT_SIZEEQ(udp_socket_sendto(first, "ping", 4, socket_address_remote(first)), 4);
+	EXPECT_SIZEEQ(udp_socket_sendto(first, "pong", 4, socket_address_remote(first)), 4);
+	EXPECT_SIZEEQ(udp_socket_sendto(first, "lost", 4, socket_address_local(first)), 0);
+	EXPECT_SIZEEQ(udp_socket_recvfrom(second, buffer, sizeof(buffer), &address_from), 4);
+	EXPECT_MEMEQ(buffer, "ping", 4);
+	EXPECT_TRUE(network_address_equal(address_from, socket_address_local(first)));
+	EXPECT_SIZEEQ(udp_socket_recvfrom(second, buffer, 2, &address_from), 2);
+	EXPECT_MEMEQ(buffer, "po", 2);
+	EXPECT_SIZEEQ(udp_socket_recvfrom(second, buffer, sizeof(buffer), &address_from), 0);
+
+	socket_deallocate(first);
+	socket_deallocate(second);
+#endif
+	return 0;
+}
+
 static void
 test_socket_declare(void) {
 	ADD_TEST(tcp, create);
@@ -220,6 +569,13 @@ test_socket_declare(void) {
 	ADD_TEST(udp, create);
 	ADD_TEST(udp, blocking);
 	ADD_TEST(udp, bind);
+
+	ADD_TEST(unix, address);
+	ADD_TEST(unix, stream);
+	ADD_TEST(unix, datagram);
+
+	ADD_TEST(shm, stream);
+	ADD_TEST(shm, pair);
 }
 
 static test_suite_t test_socket_suite = {test_socket_application,
@@ -26,9 +26,31 @@ test_tcp_application(void) {
 	return app;
 }
 
+static memory_system_t test_tcp_memory_base;
+static atomic64_t test_tcp_memory_allocations;
+static bool test_tcp_memory_counted;
+
+static void*
+test_tcp_memory_allocate(hash_t context, size_t size, unsigned int align, unsigned int hint) {
+	atomic_incr64(&test_tcp_memory_allocations, memory_order_relaxed);
+	return test_tcp_memory_base.allocate(context, size, align, hint);
+}
+
+static void*
+test_tcp_memory_reallocate(void* p, size_t size, unsigned int align, size_t oldsize, unsigned int hint) {
+	atomic_incr64(&test_tcp_memory_allocations, memory_order_relaxed);
+	return test_tcp_memory_base.reallocate(p, size, align, oldsize, hint);
+}
+
 static memory_system_t
 test_tcp_memory_system(void) {
-	return memory_system_malloc();
+	// Count every allocation made through foundation, including array growth, for the allocation tests
+	memory_system_t memory_system = memory_system_malloc();
+	test_tcp_memory_base = memory_system;
+	test_tcp_memory_counted = true;
+	memory_system.allocate = test_tcp_memory_allocate;
+	memory_system.reallocate = test_tcp_memory_reallocate;
+	return memory_system;
 }
 
 static foundation_config_t
@@ -115,6 +137,36 @@ stream_blocking_thread(void* arg) {
 	return 0;
 }
 
+static bool
+tcp_connect_loopback_pair(socket_t** server, socket_t** client) {
+	socket_t* sock_listen = tcp_socket_allocate();
+	socket_t* sock_client = tcp_socket_allocate();
+	socket_t* sock_server = 0;
+	network_address_ipv4_t address;
+
+	network_address_ipv4_initialize(&address);
+	network_address_ipv4_set_ip((network_address_t*)&address, network_address_ipv4_make_ip(127, 0, 0, 1));
+	if (socket_bind(sock_listen, (network_address_t*)&address) && tcp_socket_listen(sock_listen)) {
+		socket_set_blocking(sock_client, true);
+		if (socket_connect(sock_client, socket_address_local(sock_listen), 2000))
+			sock_server = tcp_socket_accept(sock_listen, 2000);
+	}
+	socket_deallocate(sock_listen);
+
+	if (!sock_server) {
+		socket_deallocate(sock_client);
+		return false;
+	}
+
+	socket_set_blocking(sock_server, true);
+	tcp_socket_set_delay(sock_client, false);
+	tcp_socket_set_delay(sock_server, false);
+
+	*server = sock_server;
+	*client = sock_client;
+	return true;
+}
+
 DECLARE_TEST(tcp, connect_ipv4) {
 	unsigned int iaddr;
 	bool success;
@@ -718,6 +770,717 @@ DECLARE_TEST(tcp, stream_ipv6) {
 	return 0;
 }
 
+DECLARE_TEST(tcp, stream_bulk) {
+	socket_t* sock_server = 0;
+	socket_t* sock_client = 0;
+	int16_t int16_out[133], int16_in[133];
+	int32_t int32_out[517], int32_in[517];
+	int64_t int64_out[71], int64_in[71];
+	float32_t float32_out[37], float32_in[37];
+	uint64_t varint_out[1031], varint_in[1031];
+	size_t ival;
+
+	if (!network_supports_ipv4())
+		return 0;
+
+	EXPECT_TRUE(tcp_connect_loopback_pair(&sock_server, &sock_client));
+
+	for (ival = 0; ival < sizeof(int16_out) / sizeof(int16_out[0]); ++ival)
+		int16_out[ival] = (int16_t)(ival * 0x0102);
+	for (ival = 0; ival < sizeof(int32_out) / sizeof(int32_out[0]); ++ival)
+		int32_out[ival] = (int32_t)(ival * 0x01020304);
+	for (ival = 0; ival < sizeof(int64_out) / sizeof(int64_out[0]); ++ival)
+		int64_out[ival] = (int64_t)(ival * 0x0102030405060708LL);
+	for (ival = 0; ival < sizeof(float32_out) / sizeof(float32_out[0]); ++ival)
+		float32_out[ival] = (float32_t)ival * 1.5f;
+	for (ival = 0; ival < sizeof(varint_out) / sizeof(varint_out[0]); ++ival)
+		varint_out[ival] = (ival & 1) ? ((uint64_t)1 << (ival % 64)) - 1 : ival;
+
+	// Buffer sizes not aligned to element sizes to force partial buffers and flushes
+	stream_t* writer = socket_stream_allocate(sock_client, 61, 53);
+	stream_t* reader = socket_stream_allocate(sock_server, 61, 53);
+
+	// Swapped byte order
+	stream_set_byteorder(writer, BYTEORDER_BIGENDIAN);
+	stream_set_byteorder(reader, BYTEORDER_BIGENDIAN);
+
+	EXPECT_SIZEEQ(socket_stream_write_int16_array(writer, int16_out, 133), 133);
+	EXPECT_SIZEEQ(socket_stream_write_int32_array(writer, int32_out, 517), 517);
+	EXPECT_SIZEEQ(socket_stream_write_int64_array(writer, int64_out, 71), 71);
+	EXPECT_SIZEEQ(socket_stream_write_float32_array(writer, float32_out, 37), 37);
+	EXPECT_SIZEEQ(socket_stream_write_varint_array(writer, varint_out, 1031), 1031);
+	stream_write_int32(writer, 0x12345678);
+	stream_flush(writer);
+
+	EXPECT_SIZEEQ(socket_stream_read_int16_array(reader, int16_in, 133), 133);
+	EXPECT_SIZEEQ(socket_stream_read_int32_array(reader, int32_in, 517), 517);
+	EXPECT_SIZEEQ(socket_stream_read_int64_array(reader, int64_in, 71), 71);
+	EXPECT_SIZEEQ(socket_stream_read_float32_array(reader, float32_in, 37), 37);
+	EXPECT_SIZEEQ(socket_stream_read_varint_array(reader, varint_in, 1031), 1031);
+	EXPECT_INTEQ(stream_read_int32(reader), 0x12345678);
+
+	EXPECT_EQ(memcmp(int16_in, int16_out, sizeof(int16_out)), 0);
+	EXPECT_EQ(memcmp(int32_in, int32_out, sizeof(int32_out)), 0);
+	EXPECT_EQ(memcmp(int64_in, int64_out, sizeof(int64_out)), 0);
+	EXPECT_EQ(memcmp(float32_in, float32_out, sizeof(float32_out)), 0);
+	EXPECT_EQ(memcmp(varint_in, varint_out, sizeof(varint_out)), 0);
+
+	// Native byte order on both ends
+	stream_set_byteorder(writer, system_byteorder());
+	stream_set_byteorder(reader, system_byteorder());
+
+	EXPECT_SIZEEQ(socket_stream_write_int32_array(writer, int32_out, 517), 517);
+	stream_flush(writer);
+	memset(int32_in, 0, sizeof(int32_in));
+	EXPECT_SIZEEQ(socket_stream_read_int32_array(reader, int32_in, 517), 517);
+	EXPECT_EQ(memcmp(int32_in, int32_out, sizeof(int32_out)), 0);
+
+	// Mismatched byte order must produce swapped values
+	stream_set_byteorder(writer, BYTEORDER_BIGENDIAN);
+	stream_set_byteorder(reader, BYTEORDER_LITTLEENDIAN);
+
+	EXPECT_SIZEEQ(socket_stream_write_int32_array(writer, int32_out, 2), 2);
+	stream_flush(writer);
+	EXPECT_SIZEEQ(socket_stream_read_int32_array(reader, int32_in, 2), 2);
+	EXPECT_EQ((uint32_t)int32_in[1], byteorder_swap32((uint32_t)int32_out[1]));
+
+	stream_deallocate(writer);
+	stream_deallocate(reader);
+
+	socket_deallocate(sock_server);
+	socket_deallocate(sock_client);
+
+	return 0;
+}
+
+DECLARE_TEST(tcp, stream_partial_element) {
+	socket_t* sock_server;
+	socket_t* sock_client;
+	int32_t values_out[3] = {0x01020304, 0x05060708, 0x090a0b0c};
+	int32_t values_in[3] = {0};
+
+	EXPECT_TRUE(tcp_connect_loopback_pair(&sock_server, &sock_client));
+	socket_set_blocking(sock_server, false);
+
+	stream_t* reader = socket_stream_allocate(sock_server, 64, 64);
+	stream_set_byteorder(reader, system_byteorder());
+
+	// Short read ending in a partial element only consumes the whole elements
+	EXPECT_SIZEEQ(socket_write(sock_client, values_out, 6), 6);
+	thread_sleep(50);
+	EXPECT_SIZEEQ(socket_stream_read_int32_array(reader, values_in, 3), 1);
+	EXPECT_INTEQ(values_in[0], values_out[0]);
+
+	// Remainder of the partial element is joined with the buffered bytes
+	EXPECT_SIZEEQ(socket_write(sock_client, pointer_offset(values_out, 6), sizeof(values_out) - 6),
+	              sizeof(values_out) - 6);
+	thread_sleep(50);
+	EXPECT_SIZEEQ(socket_stream_read_int32_array(reader, values_in + 1, 2), 2);
+	EXPECT_EQ(memcmp(values_in, values_out, sizeof(values_out)), 0);
+	EXPECT_SIZEEQ(socket_stream_read_int32_array(reader, values_in, 1), 0);
+
+	stream_deallocate(reader);
+	socket_deallocate(sock_server);
+	socket_deallocate(sock_client);
+
+	return 0;
+}
+
+DECLARE_TEST(tcp, stream_partial_varint) {
+	socket_t* sock_server;
+	socket_t* sock_client;
+	uint64_t values_out[3] = {(uint64_t)1 << 62, (uint64_t)1 << 62, 1};
+	uint64_t values_in[3] = {0};
+	char buffer[16384] = {0};
+	size_t pending = 0;
+	size_t chunk, written;
+
+	EXPECT_TRUE(tcp_connect_loopback_pair(&sock_server, &sock_client));
+	socket_set_blocking(sock_client, false);
+
+	stream_t* writer = socket_stream_allocate(sock_client, 0, 16);
+	stream_t* reader = socket_stream_allocate(sock_server, 64, 0);
+
+	// Fill the socket buffers so the stream is unable to flush
+	while ((chunk = socket_write(sock_client, buffer, sizeof(buffer))) > 0)
+		pending += chunk;
+
+	// Second value does not fit whole in the output buffer and must not be partially buffered
+	written = socket_stream_write_varint_array(writer, values_out, 3);
+	EXPECT_SIZEEQ(written, 1);
+
+	for (; pending; pending -= chunk) {
+		chunk = socket_read(sock_server, buffer, (pending < sizeof(buffer)) ? pending : sizeof(buffer));
+		EXPECT_NE(chunk, 0);
+	}
+
+	// Retrying from the returned count yields the exact sequence on the other end
+	socket_set_blocking(sock_client, true);
+	EXPECT_SIZEEQ(socket_stream_write_varint_array(writer, values_out + written, 3 - written), 3 - written);
+	stream_flush(writer);
+	EXPECT_SIZEEQ(socket_stream_read_varint_array(reader, values_in, 3), 3);
+	EXPECT_EQ(memcmp(values_in, values_out, sizeof(values_out)), 0);
+
+	stream_deallocate(reader);
+	stream_deallocate(writer);
+	socket_deallocate(sock_server);
+	socket_deallocate(sock_client);
+
+	return 0;
+}
+
+DECLARE_TEST(tcp, stream_read_until) {
+	socket_t* sock_server;
+	socket_t* sock_client;
+	string_const_t line;
+	char buffer[128];
+	size_t ichar;
+
+	EXPECT_TRUE(tcp_connect_loopback_pair(&sock_server, &sock_client));
+
+	stream_t* writer = socket_stream_allocate(sock_client, 64, 64);
+	stream_t* reader = socket_stream_allocate(sock_server, 64, 64);
+
+	stream_write(writer, STRING_CONST("GET key\r\n\r\nVALUE 1234567890abcdefghijklmnopqrstuvwxyz 0\r\nEND"));
+	stream_flush(writer);
+
+	line = socket_stream_read_until(reader, STRING_CONST("\r\n"));
+	EXPECT_CONSTSTRINGEQ(line, string_const(STRING_CONST("GET key")));
+	line = socket_stream_read_until(reader, STRING_CONST("\r\n"));
+	EXPECT_NE(line.str, 0);
+	EXPECT_SIZEEQ(line.length, 0);
+	line = socket_stream_read_until(reader, STRING_CONST("\r\n"));
+	EXPECT_CONSTSTRINGEQ(line, string_const(STRING_CONST("VALUE 1234567890abcdefghijklmnopqrstuvwxyz 0")));
+
+	// Delimiter split across two sends and refills
+	EXPECT_SIZEEQ(socket_stream_find(reader, STRING_CONST("\r\n")), STRING_NPOS);
+	stream_write(writer, STRING_CONST("\r"));
+	stream_flush(writer);
+	thread_sleep(50);
+	stream_write(writer, STRING_CONST("\nnext:"));
+	stream_flush(writer);
+	line = socket_stream_read_until(reader, STRING_CONST("\r\n"));
+	EXPECT_CONSTSTRINGEQ(line, string_const(STRING_CONST("END")));
+	line = socket_stream_read_until(reader, STRING_CONST(":"));
+	EXPECT_CONSTSTRINGEQ(line, string_const(STRING_CONST("next")));
+
+	// Lines exceeding the input buffer are not returned
+	for (ichar = 0; ichar < sizeof(buffer); ++ichar)
+		buffer[ichar] = (char)('a' + (ichar % 26));
+	stream_write(writer, buffer, sizeof(buffer));
+	stream_write(writer, STRING_CONST("\r\n"));
+	stream_flush(writer);
+	line = socket_stream_read_until(reader, STRING_CONST("\r\n"));
+	EXPECT_EQ(line.str, 0);
+	EXPECT_SIZEEQ(stream_read(reader, buffer, sizeof(buffer)), sizeof(buffer));
+	line = socket_stream_read_until(reader, STRING_CONST("\r\n"));
+	EXPECT_NE(line.str, 0);
+	EXPECT_SIZEEQ(line.length, 0);
+
+	stream_deallocate(writer);
+	stream_deallocate(reader);
+	socket_deallocate(sock_client);
+	socket_deallocate(sock_server);
+
+	return 0;
+}
+
+DECLARE_TEST(tcp, stream_timeout) {
+	socket_t* sock_server;
+	socket_t* sock_client;
+	char buffer[256];
+	char* block;
+	size_t block_size = 64 * 1024;
+	size_t iblock, written;
+	tick_t start;
+	real elapsed;
+
+	EXPECT_TRUE(tcp_connect_loopback_pair(&sock_server, &sock_client));
+
+	stream_t* writer = socket_stream_allocate(sock_client, 256, 256);
+	stream_t* reader = socket_stream_allocate(sock_server, 256, 256);
+
+	// Blocking socket with read deadline returns when deadline passes
+	socket_stream_set_timeout(reader, 100, 0);
+	start = time_current();
+	EXPECT_SIZEEQ(stream_read(reader, buffer, 4), 0);
+	elapsed = time_elapsed(start);
+	EXPECT_REALGE(elapsed, REAL_C(0.09));
+	EXPECT_REALLE(elapsed, REAL_C(2.0));
+	EXPECT_EQ(socket_state(sock_server), SOCKETSTATE_CONNECTED);
+
+	stream_write(writer, "data", 4);
+	stream_flush(writer);
+	EXPECT_SIZEEQ(stream_read(reader, buffer, 4), 4);
+	EXPECT_EQ(memcmp(buffer, "data", 4), 0);
+
+	// Partial data within deadline
+	stream_write(writer, "da", 2);
+	stream_flush(writer);
+	EXPECT_SIZEEQ(stream_read(reader, buffer, 4), 2);
+
+	// Write deadline stops writing when the peer does not read
+	block = memory_allocate(HASH_NETWORK, block_size, 0, MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	socket_stream_set_timeout(writer, 0, 100);
+	for (iblock = 0, written = block_size; (iblock < 1024) && (written == block_size); ++iblock)
+		written = stream_write(writer, block, block_size);
+	EXPECT_SIZELT(written, block_size);
+	EXPECT_EQ(socket_state(sock_client), SOCKETSTATE_CONNECTED);
+	memory_deallocate(block);
+
+	stream_deallocate(writer);
+	stream_deallocate(reader);
+	socket_deallocate(sock_client);
+	socket_deallocate(sock_server);
+
+	return 0;
+}
+
+DECLARE_TEST(tcp, syscall_count) {
+#if BUILD_ENABLE_NETWORK_SYSCALL_COUNT
+	socket_t* sock_server;
+	socket_t* sock_client;
+	char buffer[64];
+	unsigned int icall;
+
+	EXPECT_TRUE(tcp_connect_loopback_pair(&sock_server, &sock_client));
+	socket_set_blocking(sock_server, false);
+	stream_t* reader = socket_stream_allocate(sock_server, 64, 64);
+
+	// A read that would block is exactly one recv call
+	network_syscall_count_reset();
+	EXPECT_SIZEEQ(socket_read(sock_server, buffer, sizeof(buffer)), 0);
+	EXPECT_EQ(network_syscall_count(NETWORK_SYSCALL_RECV), 1);
+	for (icall = NETWORK_SYSCALL_SEND; icall < NETWORK_SYSCALL_COUNT; ++icall)
+		EXPECT_EQ(network_syscall_count((network_syscall_t)icall), 0);
+
+	// Same through the socket stream, no state polling on a short read
+	network_syscall_count_reset();
+	EXPECT_SIZEEQ(stream_read(reader, buffer, sizeof(buffer)), 0);
+	EXPECT_EQ(network_syscall_count(NETWORK_SYSCALL_RECV), 1);
+	for (icall = NETWORK_SYSCALL_SEND; icall < NETWORK_SYSCALL_COUNT; ++icall)
+		EXPECT_EQ(network_syscall_count((network_syscall_t)icall), 0);
+
+	EXPECT_SIZEEQ(socket_write(sock_client, "data", 4), 4);
+	thread_sleep(50);
+
+	network_syscall_count_reset();
+	EXPECT_SIZEEQ(socket_read(sock_server, buffer, sizeof(buffer)), 4);
+	EXPECT_SIZEEQ(socket_read(sock_server, buffer, sizeof(buffer)), 0);
+	EXPECT_EQ(network_syscall_count(NETWORK_SYSCALL_RECV), 2);
+	EXPECT_EQ(network_syscall_count(NETWORK_SYSCALL_GETSOCKOPT), 0);
+	EXPECT_EQ(network_syscall_count(NETWORK_SYSCALL_IOCTL), 0);
+	EXPECT_EQ(socket_state(sock_server), SOCKETSTATE_CONNECTED);
+
+	stream_deallocate(reader);
+	socket_deallocate(sock_client);
+	socket_deallocate(sock_server);
+#else
+	log_warn(HASH_NETWORK, WARNING_UNSUPPORTED,
+	         STRING_CONST("System call counting not built (BUILD_ENABLE_NETWORK_SYSCALL_COUNT), test skipped"));
+#endif
+	return 0;
+}
+
+DECLARE_TEST(tcp, allocation_count) {
+	socket_t* sock_listen;
+	socket_t* sock_client;
+	socket_t* sock_server;
+	network_address_ipv4_t address;
+	stream_t* reader;
+	stream_t* writer;
+	char buffer[64] = {0};
+	unsigned int iloop;
+	size_t read;
+
+	// Monolithic builds run with the memory system of the combined test binary
+	if (!test_tcp_memory_counted)
+		return 0;
+
+	sock_listen = tcp_socket_allocate();
+	sock_client = tcp_socket_allocate();
+	network_address_ipv4_initialize(&address);
+	network_address_ipv4_set_ip((network_address_t*)&address, network_address_ipv4_make_ip(127, 0, 0, 1));
+	EXPECT_TRUE(socket_bind(sock_listen, (network_address_t*)&address));
+	EXPECT_TRUE(tcp_socket_listen(sock_listen));
+	socket_set_blocking(sock_client, true);
+	EXPECT_TRUE(socket_connect(sock_client, socket_address_local(sock_listen), 2000));
+
+	// Accepting allocates the socket, the remote address and the local address
+	network_allocation_count_reset();
+	sock_server = tcp_socket_accept(sock_listen, 2000);
+	EXPECT_NE(sock_server, 0);
+#if BUILD_ENABLE_NETWORK_ALLOCATION_COUNT
+	EXPECT_EQ(network_allocation_count(NETWORK_ALLOCATION_SOCKET), 1);
+	EXPECT_EQ(network_allocation_count(NETWORK_ALLOCATION_ADDRESS_CLONE), 1);
+	EXPECT_EQ(network_allocation_count(NETWORK_ALLOCATION_ADDRESS_LOCAL), 1);
+#else
+	log_warn(HASH_NETWORK, WARNING_UNSUPPORTED,
+	         STRING_CONST("Allocation counting not built (BUILD_ENABLE_NETWORK_ALLOCATION_COUNT), checks skipped"));
+#endif
+	socket_deallocate(sock_listen);
+	socket_set_blocking(sock_server, true);
+
+	// Steady state socket write and read performs no allocations
+	atomic_store64(&test_tcp_memory_allocations, 0, memory_order_relaxed);
+	for (iloop = 0; iloop < 64; ++iloop) {
+		EXPECT_SIZEEQ(socket_write(sock_client, buffer, sizeof(buffer)), sizeof(buffer));
+		for (read = 0; read < sizeof(buffer);) {
+			size_t chunk = socket_read(sock_server, buffer + read, sizeof(buffer) - read);
+			EXPECT_NE(chunk, 0);
+			read += chunk;
+		}
+	}
+	EXPECT_EQ(atomic_load64(&test_tcp_memory_allocations, memory_order_relaxed), 0);
+
+	// Stream allocation includes the buffers and the stream path
+	network_allocation_count_reset();
+	writer = socket_stream_allocate(sock_client, 0, 256);
+	reader = socket_stream_allocate(sock_server, 256, 0);
+#if BUILD_ENABLE_NETWORK_ALLOCATION_COUNT
+	EXPECT_EQ(network_allocation_count(NETWORK_ALLOCATION_STREAM), 2);
+	EXPECT_EQ(network_allocation_count(NETWORK_ALLOCATION_STREAM_PATH), 2);
+#endif
+
+	// Steady state stream write and read performs no allocations
+	atomic_store64(&test_tcp_memory_allocations, 0, memory_order_relaxed);
+	for (iloop = 0; iloop < 64; ++iloop) {
+		EXPECT_SIZEEQ(stream_write(writer, buffer, sizeof(buffer)), sizeof(buffer));
+		stream_flush(writer);
+		EXPECT_SIZEEQ(stream_read(reader, buffer, sizeof(buffer)), sizeof(buffer));
+	}
+	EXPECT_EQ(atomic_load64(&test_tcp_memory_allocations, memory_order_relaxed), 0);
+
+	stream_deallocate(reader);
+	stream_deallocate(writer);
+	socket_deallocate(sock_client);
+	socket_deallocate(sock_server);
+	return 0;
+}
+
+DECLARE_TEST(tcp, connect_any) {
+	socket_t* sock_listen = tcp_socket_allocate();
+	socket_t* sock_closed = tcp_socket_allocate();
+	socket_t* sock_client;
+	socket_t* sock_server;
+	network_address_t** addresses = nullptr;
+	network_address_ipv4_t address;
+	network_address_t* address_listen;
+	tick_t start;
+
+	network_address_ipv4_initialize(&address);
+	network_address_ipv4_set_ip((network_address_t*)&address, network_address_ipv4_make_ip(127, 0, 0, 1));
+	EXPECT_TRUE(socket_bind(sock_listen, (network_address_t*)&address));
+	EXPECT_TRUE(tcp_socket_listen(sock_listen));
+
+	// Bind a socket without listening to get a local port that refuses connections
+	EXPECT_TRUE(socket_bind(sock_closed, (network_address_t*)&address));
+	address_listen = network_address_clone(socket_address_local(sock_listen));
+
+	array_push(addresses, network_address_clone(socket_address_local(sock_closed)));
+	array_push(addresses, address_listen);
+
+	start = time_current();
+	sock_client = tcp_socket_connect_any(addresses, 5000, 2000);
+	EXPECT_NE(sock_client, nullptr);
+	EXPECT_REALLE(time_elapsed(start), REAL_C(1.0));
+	EXPECT_EQ(socket_state(sock_client), SOCKETSTATE_CONNECTED);
+	EXPECT_TRUE(network_address_equal(socket_address_remote(sock_client), address_listen));
+
+	sock_server = tcp_socket_accept(sock_listen, 2000);
+	EXPECT_NE(sock_server, nullptr);
+
+	socket_deallocate(sock_server);
+	socket_deallocate(sock_client);
+
+	// No reachable address
+	array_pop(addresses);
+	memory_deallocate(address_listen);
+	EXPECT_EQ(tcp_socket_connect_any(addresses, 0, 2000), nullptr);
+
+	network_address_array_deallocate(addresses);
+	socket_deallocate(sock_closed);
+	socket_deallocate(sock_listen);
+
+	return 0;
+}
+
+DECLARE_TEST(tcp, connect_bulk) {
+	socket_t* sock_listen = tcp_socket_allocate();
+	socket_t* sock_closed = tcp_socket_allocate();
+	socket_t* sockets[9];
+	network_poll_event_t events[32];
+	network_address_t** addresses = nullptr;
+	network_address_ipv4_t address;
+	network_poll_t* poll;
+	size_t connected = 0, failed = 0, pending, isock;
+	tick_t start;
+
+	network_address_ipv4_initialize(&address);
+	network_address_ipv4_set_ip((network_address_t*)&address, network_address_ipv4_make_ip(127, 0, 0, 1));
+	EXPECT_TRUE(socket_bind(sock_listen, (network_address_t*)&address));
+	EXPECT_TRUE(tcp_socket_listen(sock_listen));
+	EXPECT_TRUE(socket_bind(sock_closed, (network_address_t*)&address));
+
+	for (isock = 0; isock < 8; ++isock)
+		array_push(addresses, network_address_clone(socket_address_local(sock_listen)));
+	array_push(addresses, network_address_clone(socket_address_local(sock_closed)));
+
+	poll = network_poll_allocate(16);
+	pending = tcp_socket_connect_bulk(poll, addresses, sockets, 2000);
+	EXPECT_SIZEEQ(pending, 9);
+	EXPECT_SIZEEQ(network_poll_sockets_count(poll), 9);
+
+	for (isock = 0; isock < 9; ++isock) {
+		EXPECT_NE(sockets[isock], nullptr);
+		if (socket_state(sockets[isock]) == SOCKETSTATE_CONNECTED) {
+			++connected;
+			--pending;
+		}
+	}
+
+	start = time_current();
+	while (pending && (time_elapsed(start) < REAL_C(2.5))) {
+		size_t ievt, num_events = network_poll(poll, events, sizeof(events) / sizeof(events[0]), 100);
+		for (ievt = 0; ievt < num_events; ++ievt) {
+			if (events[ievt].event == NETWORKEVENT_CONNECTED) {
+				++connected;
+				--pending;
+			} else if ((events[ievt].event == NETWORKEVENT_ERROR) || (events[ievt].event == NETWORKEVENT_HANGUP) ||
+			           (events[ievt].event == NETWORKEVENT_TIMEOUT)) {
+				// Refused connect can report both error and hangup
+				if (!ievt || (events[ievt - 1].socket != events[ievt].socket)) {
+					++failed;
+					--pending;
+				}
+			}
+		}
+	}
+	EXPECT_SIZEEQ(connected, 8);
+	EXPECT_SIZEEQ(failed, 1);
+	EXPECT_EQ(socket_state(sockets[8]), SOCKETSTATE_NOTCONNECTED);
+
+	network_poll_deallocate(poll);
+	for (isock = 0; isock < 9; ++isock)
+		socket_deallocate(sockets[isock]);
+	network_address_array_deallocate(addresses);
+	socket_deallocate(sock_closed);
+	socket_deallocate(sock_listen);
+
+	return 0;
+}
+
+DECLARE_TEST(tcp, connect_bulk_timeout) {
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+	socket_t* sock_listen = tcp_socket_allocate();
+	socket_t* sockets[4];
+	network_poll_event_t event;
+	network_address_t** addresses = nullptr;
+	network_address_ipv4_t address;
+	network_poll_t* poll;
+	size_t connected = 0, timedout = 0, pending, isock;
+	tick_t start;
+
+	network_address_ipv4_initialize(&address);
+	network_address_ipv4_set_ip((network_address_t*)&address, network_address_ipv4_make_ip(127, 0, 0, 1));
+	EXPECT_TRUE(socket_bind(sock_listen, (network_address_t*)&address));
+	// Accept queue holds a single connection which is never accepted, the handshake of further
+	// connects is dropped and they stay pending until the deadline
+	EXPECT_INTEQ(listen(socket_fd(sock_listen), 0), 0);
+
+	for (isock = 0; isock < 4; ++isock)
+		array_push(addresses, network_address_clone(socket_address_local(sock_listen)));
+
+	poll = network_poll_allocate(8);
+	pending = tcp_socket_connect_bulk(poll, addresses, sockets, 200);
+	EXPECT_SIZEEQ(pending, 4);
+	for (isock = 0; isock < 4; ++isock) {
+		if (socket_state(sockets[isock]) == SOCKETSTATE_CONNECTED) {
+			++connected;
+			--pending;
+		}
+	}
+
+	// Room for a single event, expired deadlines that do not fit are reported by the following polls
+	start = time_current();
+	while (pending && (time_elapsed(start) < REAL_C(2.0))) {
+		if (!network_poll(poll, &event, 1, 100))
+			continue;
+		if (event.event == NETWORKEVENT_CONNECTED) {
+			++connected;
+			--pending;
+		} else if (event.event == NETWORKEVENT_TIMEOUT) {
+			EXPECT_EQ(socket_state(event.socket), SOCKETSTATE_NOTCONNECTED);
+			EXPECT_INTEQ(socket_fd(event.socket), NETWORK_SOCKET_INVALID);
+			++timedout;
+			--pending;
+		}
+	}
+	EXPECT_SIZEEQ(connected, 1);
+	EXPECT_SIZEEQ(timedout, 3);
+
+	network_poll_deallocate(poll);
+	for (isock = 0; isock < 4; ++isock)
+		socket_deallocate(sockets[isock]);
+	network_address_array_deallocate(addresses);
+	socket_deallocate(sock_listen);
+#endif
+	return 0;
+}
+
+DECLARE_TEST(tcp, fastopen) {
+	socket_t* sock_listen = tcp_socket_allocate();
+	network_address_ipv4_t address;
+	const char request[] = "fast open request";
+	char buffer[64];
+	int iconn;
+
+	network_address_ipv4_initialize(&address);
+	network_address_ipv4_set_ip((network_address_t*)&address, network_address_ipv4_make_ip(127, 0, 0, 1));
+	EXPECT_TRUE(socket_bind(sock_listen, (network_address_t*)&address));
+	tcp_socket_set_fastopen(sock_listen, 16);
+	EXPECT_TRUE(tcp_socket_listen(sock_listen));
+
+	// First connection obtains a cookie if fast open is enabled, second sends data in the SYN.
+	// Either way the data must arrive, with fallback to a regular handshake
+	for (iconn = 0; iconn < 2; ++iconn) {
+		socket_t* sock_client = tcp_socket_allocate();
+		socket_t* sock_server;
+		size_t read = 0;
+		tick_t start;
+
+		socket_set_blocking(sock_client, true);
+		EXPECT_SIZEEQ(tcp_socket_connect_data(sock_client, socket_address_local(sock_listen), request,
+		                                      sizeof(request), 2000),
+		              sizeof(request));
+		EXPECT_EQ(socket_state(sock_client), SOCKETSTATE_CONNECTED);
+
+		sock_server = tcp_socket_accept(sock_listen, 2000);
+		EXPECT_NE(sock_server, nullptr);
+		socket_set_blocking(sock_server, false);
+
+		start = time_current();
+		while ((read < sizeof(request)) && (time_elapsed(start) < REAL_C(2.0))) {
+			read += socket_read(sock_server, buffer + read, sizeof(buffer) - read);
+			thread_yield();
+		}
+		EXPECT_SIZEEQ(read, sizeof(request));
+		EXPECT_MEMEQ(buffer, request, sizeof(request));
+
+		socket_deallocate(sock_server);
+		socket_deallocate(sock_client);
+	}
+
+	socket_deallocate(sock_listen);
+
+	return 0;
+}
+
+DECLARE_TEST(tcp, options) {
+	socket_t* sock = tcp_socket_allocate();
+	network_address_ipv4_t address;
+
+	// Options set before the socket is created are stored and applied on creation
+	EXPECT_EQ(socket_option(sock, NETWORK_SOCKETOPTION_SEND_BUFFER), -1);
+	EXPECT_TRUE(socket_set_option(sock, NETWORK_SOCKETOPTION_SEND_BUFFER, 64 * 1024));
+	EXPECT_TRUE(socket_set_option(sock, NETWORK_SOCKETOPTION_RECEIVE_BUFFER, 128 * 1024));
+	EXPECT_TRUE(socket_set_option(sock, NETWORK_SOCKETOPTION_TOS, 0x10));
+	EXPECT_EQ(socket_option(sock, NETWORK_SOCKETOPTION_SEND_BUFFER), 64 * 1024);
+	EXPECT_FALSE(socket_set_option(sock, NETWORK_SOCKETOPTION_COUNT, 1));
+
+	network_address_ipv4_initialize(&address);
+	network_address_ipv4_set_ip((network_address_t*)&address, network_address_ipv4_make_ip(127, 0, 0, 1));
+	EXPECT_TRUE(socket_bind(sock, (network_address_t*)&address));
+
+	// System can round or double requested buffer sizes
+	EXPECT_GE(socket_option(sock, NETWORK_SOCKETOPTION_SEND_BUFFER), 64 * 1024);
+	EXPECT_GE(socket_option(sock, NETWORK_SOCKETOPTION_RECEIVE_BUFFER), 128 * 1024);
+	EXPECT_EQ(socket_option(sock, NETWORK_SOCKETOPTION_TOS), 0x10);
+
+#if FOUNDATION_PLATFORM_LINUX
+	EXPECT_TRUE(socket_set_option(sock, NETWORK_SOCKETOPTION_TCP_USER_TIMEOUT, 5000));
+	EXPECT_EQ(socket_option(sock, NETWORK_SOCKETOPTION_TCP_USER_TIMEOUT), 5000);
+	EXPECT_TRUE(socket_set_option(sock, NETWORK_SOCKETOPTION_TCP_NOTSENT_LOWAT, 16 * 1024));
+	EXPECT_EQ(socket_option(sock, NETWORK_SOCKETOPTION_TCP_NOTSENT_LOWAT), 16 * 1024);
+	EXPECT_TRUE(socket_set_option(sock, NETWORK_SOCKETOPTION_PRIORITY, 3));
+	EXPECT_EQ(socket_option(sock, NETWORK_SOCKETOPTION_PRIORITY), 3);
+#endif
+
+	// Stored values are reapplied when the socket is recreated
+	socket_close(sock);
+	EXPECT_TRUE(socket_bind(sock, (network_address_t*)&address));
+	EXPECT_EQ(socket_option(sock, NETWORK_SOCKETOPTION_TOS), 0x10);
+#if FOUNDATION_PLATFORM_LINUX
+	EXPECT_EQ(socket_option(sock, NETWORK_SOCKETOPTION_TCP_USER_TIMEOUT), 5000);
+#endif
+
+	socket_deallocate(sock);
+
+	return 0;
+}
+
+DECLARE_TEST(tcp, info) {
+#if FOUNDATION_PLATFORM_LINUX
+	socket_t* sock_server;
+	socket_t* sock_client;
+	network_tcp_info_t info;
+	network_tcp_sample_t samples[64];
+	network_poll_event_t events[8];
+	network_address_compact_t remote;
+	network_sampler_t* sampler;
+	network_poll_t* poll;
+	char buffer[256];
+	size_t isample, count;
+	tick_t start;
+
+	EXPECT_TRUE(tcp_connect_loopback_pair(&sock_server, &sock_client));
+
+	memset(buffer, 0x5a, sizeof(buffer));
+	EXPECT_SIZEEQ(socket_write(sock_client, buffer, sizeof(buffer)), sizeof(buffer));
+	EXPECT_SIZEEQ(socket_read(sock_server, buffer, sizeof(buffer)), sizeof(buffer));
+
+	EXPECT_TRUE(tcp_socket_info(sock_client, &info));
+	EXPECT_UINTEQ(info.rtt > 0, 1);
+	EXPECT_UINTEQ(info.mss > 0, 1);
+	EXPECT_UINTEQ(info.congestion_window > 0, 1);
+	EXPECT_UINTEQ(info.bytes_acked >= sizeof(buffer), 1);
+
+	EXPECT_TRUE(tcp_socket_info(sock_server, &info));
+	EXPECT_UINTEQ(info.bytes_received >= sizeof(buffer), 1);
+
+	// Sampler attached to poll takes samples of connected sockets at the given interval
+	poll = network_poll_allocate(4);
+	network_poll_add_socket(poll, sock_client);
+	sampler = network_sampler_allocate(poll, 10, 8);
+
+	start = time_current();
+	while (time_elapsed(start) < REAL_C(0.2))
+		network_poll(poll, events, sizeof(events) / sizeof(events[0]), 100);
+
+	// Ring buffer keeps the latest samples
+	EXPECT_SIZEEQ(network_sampler_available(sampler), 8);
+	count = network_sampler_read(sampler, samples, sizeof(samples) / sizeof(samples[0]));
+	EXPECT_SIZEEQ(count, 8);
+	EXPECT_SIZEEQ(network_sampler_available(sampler), 0);
+
+	network_address_to_compact(socket_address_remote(sock_client), &remote);
+	for (isample = 0; isample < count; ++isample) {
+		EXPECT_EQ(samples[isample].socket, sock_client);
+		EXPECT_TRUE(network_address_compact_equal(&samples[isample].remote, &remote));
+		EXPECT_UINTEQ(samples[isample].info.rtt > 0, 1);
+		if (isample)
+			EXPECT_GT(samples[isample].timestamp, samples[isample - 1].timestamp);
+	}
+
+	network_sampler_deallocate(sampler);
+	network_poll_deallocate(poll);
+
+	socket_deallocate(sock_client);
+	socket_deallocate(sock_server);
+#endif
+	return 0;
+}
+
 static void
 test_tcp_declare(void) {
 	ADD_TEST(tcp, connect_ipv4);
@@ -726,6 +1489,19 @@ test_tcp_declare(void) {
 	ADD_TEST(tcp, io_ipv6);
 	ADD_TEST(tcp, stream_ipv4);
 	ADD_TEST(tcp, stream_ipv6);
+	ADD_TEST(tcp, stream_bulk);
+	ADD_TEST(tcp, stream_partial_element);
+	ADD_TEST(tcp, stream_partial_varint);
+	ADD_TEST(tcp, stream_read_until);
+	ADD_TEST(tcp, stream_timeout);
+	ADD_TEST(tcp, syscall_count);
+	ADD_TEST(tcp, allocation_count);
+	ADD_TEST(tcp, connect_any);
+	ADD_TEST(tcp, connect_bulk);
+	ADD_TEST(tcp, connect_bulk_timeout);
+	ADD_TEST(tcp, fastopen);
+	ADD_TEST(tcp, options);
+	ADD_TEST(tcp, info);
 }
 
 static test_suite_t test_tcp_suite = {test_tcp_application,
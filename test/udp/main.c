@@ -31,9 +31,31 @@ test_udp_application(void) {
 	return app;
 }
 
+static memory_system_t test_udp_memory_base;
+static atomic64_t test_udp_memory_allocations;
+static bool test_udp_memory_counted;
+
+static void*
+test_udp_memory_allocate(hash_t context, size_t size, unsigned int align, unsigned int hint) {
+	atomic_incr64(&test_udp_memory_allocations, memory_order_relaxed);
+	return test_udp_memory_base.allocate(context, size, align, hint);
+}
+
+static void*
+test_udp_memory_reallocate(void* p, size_t size, unsigned int align, size_t oldsize, unsigned int hint) {
+	atomic_incr64(&test_udp_memory_allocations, memory_order_relaxed);
+	return test_udp_memory_base.reallocate(p, size, align, oldsize, hint);
+}
+
 static memory_system_t
 test_udp_memory_system(void) {
-	return memory_system_malloc();
+	// Count every allocation made through foundation, including array growth, for the allocation tests
+	memory_system_t memory_system = memory_system_malloc();
+	test_udp_memory_base = memory_system;
+	test_udp_memory_counted = true;
+	memory_system.allocate = test_udp_memory_allocate;
+	memory_system.reallocate = test_udp_memory_reallocate;
+	return memory_system;
 }
 
 static foundation_config_t
@@ -511,12 +533,137 @@ DECLARE_TEST(udp, datagram_ipv6) {
 	return 0;
 }
 
+DECLARE_TEST(udp, syscall_count) {
+#if BUILD_ENABLE_NETWORK_SYSCALL_COUNT
+	socket_t* sock = udp_socket_allocate();
+	network_address_ipv4_t address;
+	const network_address_t* address_remote;
+	char buffer[64];
+
+	network_address_ipv4_initialize(&address);
+	network_address_ipv4_set_ip((network_address_t*)&address, network_address_ipv4_make_ip(127, 0, 0, 1));
+	EXPECT_TRUE(socket_bind(sock, (network_address_t*)&address));
+	socket_set_blocking(sock, false);
+
+	// A datagram read that would block is exactly one recvfrom call
+	network_syscall_count_reset();
+	EXPECT_SIZEEQ(udp_socket_recvfrom(sock, buffer, sizeof(buffer), &address_remote), 0);
+	EXPECT_EQ(network_syscall_count(NETWORK_SYSCALL_RECVFROM), 1);
+	EXPECT_EQ(network_syscall_count(NETWORK_SYSCALL_GETSOCKOPT), 0);
+	EXPECT_EQ(network_syscall_count(NETWORK_SYSCALL_IOCTL), 0);
+
+	network_syscall_count_reset();
+	EXPECT_SIZEEQ(udp_socket_sendto(sock, "data", 4, socket_address_local(sock)), 4);
+	EXPECT_EQ(network_syscall_count(NETWORK_SYSCALL_SENDTO), 1);
+	EXPECT_EQ(network_syscall_count(NETWORK_SYSCALL_GETSOCKOPT), 0);
+
+	socket_deallocate(sock);
+#else
+	log_warn(HASH_NETWORK, WARNING_UNSUPPORTED,
+	         STRING_CONST("System call counting not built (BUILD_ENABLE_NETWORK_SYSCALL_COUNT), test skipped"));
+#endif
+	return 0;
+}
+
+DECLARE_TEST(udp, allocation_count) {
+	socket_t* sock_send;
+	socket_t* sock_recv;
+	network_address_ipv4_t address;
+	const network_address_t* address_remote;
+	char buffer[64] = {0};
+	unsigned int iloop;
+
+	// Monolithic builds run with the memory system of the combined test binary
+	if (!test_udp_memory_counted)
+		return 0;
+
+	sock_send = udp_socket_allocate();
+	sock_recv = udp_socket_allocate();
+	network_address_ipv4_initialize(&address);
+	network_address_ipv4_set_ip((network_address_t*)&address, network_address_ipv4_make_ip(127, 0, 0, 1));
+	EXPECT_TRUE(socket_bind(sock_send, (network_address_t*)&address));
+	EXPECT_TRUE(socket_bind(sock_recv, (network_address_t*)&address));
+	socket_set_blocking(sock_recv, true);
+
+	// First datagram lazily allocates the remote address storage
+	network_allocation_count_reset();
+	EXPECT_SIZEEQ(udp_socket_sendto(sock_send, "data", 4, socket_address_local(sock_recv)), 4);
+	EXPECT_SIZEEQ(udp_socket_recvfrom(sock_recv, buffer, sizeof(buffer), &address_remote), 4);
+#if BUILD_ENABLE_NETWORK_ALLOCATION_COUNT
+	EXPECT_EQ(network_allocation_count(NETWORK_ALLOCATION_ADDRESS_CLONE), 1);
+#else
+	log_warn(HASH_NETWORK, WARNING_UNSUPPORTED,
+	         STRING_CONST("Allocation counting not built (BUILD_ENABLE_NETWORK_ALLOCATION_COUNT), checks skipped"));
+#endif
+
+	// Steady state send and receive performs no allocations
+	atomic_store64(&test_udp_memory_allocations, 0, memory_order_relaxed);
+	for (iloop = 0; iloop < 64; ++iloop) {
+		EXPECT_SIZEEQ(udp_socket_sendto(sock_send, buffer, sizeof(buffer), socket_address_local(sock_recv)),
+		              sizeof(buffer));
+		EXPECT_SIZEEQ(udp_socket_recvfrom(sock_recv, buffer, sizeof(buffer), &address_remote), sizeof(buffer));
+		EXPECT_TRUE(network_address_equal(address_remote, socket_address_local(sock_send)));
+	}
+	EXPECT_EQ(atomic_load64(&test_udp_memory_allocations, memory_order_relaxed), 0);
+
+	socket_deallocate(sock_send);
+	socket_deallocate(sock_recv);
+	return 0;
+}
+
+DECLARE_TEST(udp, address_filter) {
+	socket_t* sock_server = udp_socket_allocate();
+	socket_t* sock_client = udp_socket_allocate();
+	network_cidr_t* filter = network_cidr_allocate();
+	network_address_ipv4_t address;
+	const network_address_t* address_server;
+	const network_address_t* address_remote;
+	char buffer[64];
+
+	network_address_ipv4_initialize(&address);
+	network_address_ipv4_set_ip((network_address_t*)&address, network_address_ipv4_make_ip(127, 0, 0, 1));
+	EXPECT_TRUE(socket_bind(sock_server, (network_address_t*)&address));
+	socket_set_blocking(sock_server, false);
+	address_server = socket_address_local(sock_server);
+
+	EXPECT_TRUE(network_cidr_insert(filter, STRING_CONST("127.0.0.0/8"), (void*)1));
+
+	// Deny list drops all datagrams from loopback
+	socket_set_address_filter(sock_server, filter, false);
+	EXPECT_SIZEEQ(udp_socket_sendto(sock_client, "first", 5, address_server), 5);
+	EXPECT_SIZEEQ(udp_socket_sendto(sock_client, "second", 6, address_server), 6);
+	thread_sleep(10);
+	EXPECT_SIZEEQ(udp_socket_recvfrom(sock_server, buffer, sizeof(buffer), &address_remote), 0);
+
+	// Allow list accepts datagrams from loopback
+	socket_set_address_filter(sock_server, filter, true);
+	EXPECT_SIZEEQ(udp_socket_sendto(sock_client, "third", 5, address_server), 5);
+	thread_sleep(10);
+	EXPECT_SIZEEQ(udp_socket_recvfrom(sock_server, buffer, sizeof(buffer), &address_remote), 5);
+	EXPECT_UINTEQ(network_address_ip_port(address_remote), network_address_ip_port(socket_address_local(sock_client)));
+
+	network_cidr_clear(filter);
+	EXPECT_SIZEEQ(udp_socket_sendto(sock_client, "fourth", 6, address_server), 6);
+	thread_sleep(10);
+	EXPECT_SIZEEQ(udp_socket_recvfrom(sock_server, buffer, sizeof(buffer), &address_remote), 0);
+
+	socket_set_address_filter(sock_server, nullptr, false);
+	socket_deallocate(sock_server);
+	socket_deallocate(sock_client);
+	network_cidr_deallocate(filter);
+
+	return 0;
+}
+
 static void
 test_udp_declare(void) {
 	ADD_TEST(udp, stream_ipv4);
 	ADD_TEST(udp, stream_ipv6);
 	ADD_TEST(udp, datagram_ipv4);
 	ADD_TEST(udp, datagram_ipv6);
+	ADD_TEST(udp, syscall_count);
+	ADD_TEST(udp, allocation_count);
+	ADD_TEST(udp, address_filter);
 }
 
 static test_suite_t test_udp_suite = {test_udp_application,
@@ -30,6 +30,7 @@ typedef struct blast_server_source_t {
 
 typedef struct blast_server_t {
 	blast_server_source_t** sources;
+	network_address_map_t source_map;
 	uint64_t token_counter;
 } blast_server_t;
 
@@ -134,7 +135,6 @@ blast_server_process_handshake(blast_server_t* server, socket_t* sock, void* dat
                                const network_address_t* address) {
 	packet_handshake_t* handshake = data;
 	blast_server_source_t* source = 0;
-	unsigned int isrc, ssize;
 	char addrbuf[NETWORK_ADDRESS_NUMERIC_MAX_LENGTH];
 
 	string_t addr = network_address_to_string(addrbuf, sizeof(addrbuf), address, true);
@@ -154,13 +154,7 @@ blast_server_process_handshake(blast_server_t* server, socket_t* sock, void* dat
 	log_infof(HASH_BLAST, STRING_CONST("Got handshake packet from %.*s (seq %d, timestamp %" PRItick ")"),
 	          STRING_FORMAT(addr), (int)handshake->seq, (tick_t)handshake->timestamp);
 
-	for (isrc = 0, ssize = array_size(server->sources); isrc < ssize; ++isrc) {
-		if (network_address_equal(server->sources[isrc]->address, address)) {
-			source = server->sources[isrc];
-			break;
-		}
-	}
-
+	source = network_address_map_lookup(&server->source_map, address);
 	if (source) {
 		if (source->writer && !string_equal(STRING_ARGS(source->writer->name), handshake->name, handshake->namesize)) {
 			log_infof(HASH_BLAST, STRING_CONST("Source re-initializing with new writer"));
@@ -172,6 +166,7 @@ blast_server_process_handshake(blast_server_t* server, socket_t* sock, void* dat
 		source->sock = sock;
 		source->address = network_address_clone(address);
 		array_push(server->sources, source);
+		network_address_map_insert(&server->source_map, source->address, source);
 	}
 
 	if (!source->writer) {
@@ -194,18 +189,11 @@ blast_server_process_payload(blast_server_t* server, socket_t* sock, void* data,
                              const network_address_t* address) {
 	packet_payload_t* packet = (packet_payload_t*)data;
 	blast_server_source_t* source = 0;
-	unsigned int isrc, ssize;
 	void* buffer;
 	uint64_t offset;
 
-	for (isrc = 0, ssize = array_size(server->sources); isrc < ssize; ++isrc) {
-		if ((server->sources[isrc]->sock == sock) && (network_address_equal(server->sources[isrc]->address, address))) {
-			source = server->sources[isrc];
-			break;
-		}
-	}
-
-	if (!source) {
+	source = network_address_map_lookup(&server->source_map, address);
+	if (!source || (source->sock != sock)) {
 		log_warnf(HASH_BLAST, WARNING_SUSPICIOUS, STRING_CONST("Got payload from unknown source"));
 		return;
 	}
@@ -286,6 +274,7 @@ blast_server_tick(blast_server_t* server) {
 			string_t addr = network_address_to_string(addrbuf, sizeof(addrbuf), server->sources[isrc]->address, true);
 			log_infof(HASH_BLAST, STRING_CONST("Deleting inactive source from %.*s"), STRING_FORMAT(addr));
 
+			network_address_map_erase(&server->source_map, server->sources[isrc]->address);
 			blast_server_source_deallocate(server->sources[isrc]);
 
 			array_erase(server->sources, isrc);
@@ -346,6 +335,8 @@ blast_server_deallocate(blast_server_t* server) {
 	unsigned int isrc, ssize;
 	for (isrc = 0, ssize = array_size(server->sources); isrc < ssize; ++isrc)
 		blast_server_source_deallocate(server->sources[isrc]);
+	array_deallocate(server->sources);
+	network_address_map_finalize(&server->source_map);
 	memory_deallocate(server);
 }
 
@@ -0,0 +1,18 @@
+/* errorcodes.h  -  Network impair tool  -  Public Domain  -  2013 Mattias Jansson
+ *
+ * This library provides a network abstraction built on foundation streams. The latest source code is
+ * always available at
+ *
+ * https://github.com/mjansson/network_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any restrictions.
+ *
+ */
+
+#pragma once
+
+// Error codes returned by impair tool
+#define IMPAIR_RESULT_OK 0
+
+#define IMPAIR_ERROR_UNABLE_TO_CREATE_SOCKET -1
+#define IMPAIR_ERROR_INVALID_ARGUMENT -2
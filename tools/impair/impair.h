@@ -0,0 +1,41 @@
+/* impair.h  -  Network impair tool  -  Public Domain  -  2013 Mattias Jansson
+ *
+ * This library provides a network abstraction built on foundation streams. The latest source code is
+ * always available at
+ *
+ * https://github.com/mjansson/network_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any restrictions.
+ *
+ */
+
+#pragma once
+
+#include <foundation/foundation.h>
+#include <network/network.h>
+
+#include "errorcodes.h"
+
+typedef enum { IMPAIR_UPSTREAM = 0, IMPAIR_DOWNSTREAM, IMPAIR_DIRECTIONS } impair_direction_t;
+
+//! Traffic counters of one relay direction
+typedef struct impair_stats_t {
+	uint64_t packets_in;
+	uint64_t packets_out;
+	uint64_t bytes_in;
+	uint64_t bytes_out;
+	uint64_t lost;
+	uint64_t dropped;
+	uint64_t duplicated;
+	uint64_t reordered;
+	//! Time between receiving and forwarding, in ticks
+	tick_t latency_sum;
+	tick_t latency_min;
+	tick_t latency_max;
+} impair_stats_t;
+
+extern bool
+impair_should_exit(void);
+
+extern void
+impair_process_system_events(void);
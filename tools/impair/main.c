@@ -0,0 +1,276 @@
+/* main.c  -  Network impair tool  -  Public Domain  -  2013 Mattias Jansson
+ *
+ * This library provides a network abstraction built on foundation streams. The latest source code is
+ * always available at
+ *
+ * https://github.com/mjansson/network_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any restrictions.
+ *
+ */
+
+#include "impair.h"
+#include "relay.h"
+
+typedef struct {
+	impair_config_t config;
+	bool valid;
+} impair_input_t;
+
+static bool should_exit;
+
+static impair_input_t
+impair_parse_command_line(const string_const_t* cmdline);
+
+static void
+impair_print_usage(void);
+
+int
+main_initialize(void) {
+	int ret = 0;
+	foundation_config_t config;
+	network_config_t network_config;
+	application_t application;
+
+	memset(&config, 0, sizeof(config));
+	memset(&network_config, 0, sizeof(network_config));
+
+	memset(&application, 0, sizeof(application));
+	application.name = string_const(STRING_CONST("impair"));
+	application.short_name = string_const(STRING_CONST("impair"));
+	application.company = string_const(STRING_CONST(""));
+	application.flags = APPLICATION_UTILITY;
+
+	log_enable_prefix(false);
+	log_set_suppress(0, ERRORLEVEL_DEBUG);
+
+	if ((ret = foundation_initialize(memory_system_malloc(), application, config)) < 0)
+		return ret;
+
+	log_set_suppress(HASH_NETWORK, ERRORLEVEL_INFO);
+
+	if ((ret = network_module_initialize(network_config)) < 0)
+		return ret;
+
+	return 0;
+}
+
+int
+main_run(void* main_arg) {
+	int result = IMPAIR_RESULT_OK;
+
+	FOUNDATION_UNUSED(main_arg);
+
+	impair_input_t input = impair_parse_command_line(environment_command_line());
+
+	if (input.valid) {
+		result = impair_relay(&input.config);
+	} else {
+		impair_print_usage();
+		result = IMPAIR_ERROR_INVALID_ARGUMENT;
+	}
+
+	memory_deallocate(input.config.listen);
+	memory_deallocate(input.config.target);
+
+	return result;
+}
+
+void
+main_finalize(void) {
+	network_module_finalize();
+	foundation_finalize();
+}
+
+static network_address_t*
+impair_parse_address(string_const_t arg) {
+	network_address_t* address = nullptr;
+	network_address_t** resolved = network_address_resolve(STRING_ARGS(arg));
+	if (array_size(resolved))
+		address = network_address_clone(resolved[0]);
+	network_address_array_deallocate(resolved);
+	return address;
+}
+
+// Parse a percentage argument to a probability
+static real
+impair_parse_percent(const char* str, size_t length) {
+	real value = string_to_real(str, length) / REAL_C(100.0);
+	return (value < 0) ? 0 : ((value > 1) ? 1 : value);
+}
+
+impair_input_t
+impair_parse_command_line(const string_const_t* cmdline) {
+	impair_input_t input;
+	unsigned int arg, asize;
+	// Impairment options apply to the directions selected by a preceding --up, --down or --both
+	bool direction[IMPAIR_DIRECTIONS] = {true, true};
+
+	error_context_push(STRING_CONST("parsing command line"), STRING_CONST(""));
+	memset(&input, 0, sizeof(input));
+	input.config.interval = 1;
+	input.config.sessions = 64;
+	input.config.timeout = 30;
+	for (arg = 1, asize = array_size(cmdline); arg < asize; ++arg) {
+		const string_const_t* option = cmdline + arg;
+		const string_const_t* value = (arg + 1 < asize) ? cmdline + arg + 1 : nullptr;
+		impair_profile_t* profile = input.config.profile;
+
+#define IMPAIR_OPTION(name) string_equal(STRING_ARGS(*option), STRING_CONST(name))
+#define IMPAIR_FOREACH_DIRECTION(statement)                     \
+	for (int idir = 0; idir < IMPAIR_DIRECTIONS; ++idir) {      \
+		if (direction[idir])                                    \
+			profile[idir].statement;                            \
+	}
+
+		if (IMPAIR_OPTION("-h") || IMPAIR_OPTION("--help")) {
+			input.valid = false;
+			error_context_pop();
+			return input;
+		} else if (IMPAIR_OPTION("--tcp")) {
+			input.config.tcp = true;
+		} else if (IMPAIR_OPTION("--udp")) {
+			input.config.tcp = false;
+		} else if (IMPAIR_OPTION("--up")) {
+			direction[IMPAIR_UPSTREAM] = true;
+			direction[IMPAIR_DOWNSTREAM] = false;
+		} else if (IMPAIR_OPTION("--down")) {
+			direction[IMPAIR_UPSTREAM] = false;
+			direction[IMPAIR_DOWNSTREAM] = true;
+		} else if (IMPAIR_OPTION("--both")) {
+			direction[IMPAIR_UPSTREAM] = direction[IMPAIR_DOWNSTREAM] = true;
+		} else if (!value) {
+			continue;
+		} else if (IMPAIR_OPTION("-l") || IMPAIR_OPTION("--listen")) {
+			memory_deallocate(input.config.listen);
+			input.config.listen = impair_parse_address(*value);
+			++arg;
+		} else if (IMPAIR_OPTION("-t") || IMPAIR_OPTION("--target")) {
+			memory_deallocate(input.config.target);
+			input.config.target = impair_parse_address(*value);
+			++arg;
+		} else if (IMPAIR_OPTION("-p") || IMPAIR_OPTION("--profile")) {
+			for (int idir = 0; idir < IMPAIR_DIRECTIONS; ++idir) {
+				if (direction[idir] && !impair_profile_preset(profile + idir, STRING_ARGS(*value))) {
+					log_warnf(0, WARNING_INVALID_VALUE, STRING_CONST("Unknown profile: %.*s"), STRING_FORMAT(*value));
+					error_context_pop();
+					return input;
+				}
+			}
+			++arg;
+		} else if (IMPAIR_OPTION("--delay")) {
+			IMPAIR_FOREACH_DIRECTION(delay = (unsigned int)(string_to_real(STRING_ARGS(*value)) * REAL_C(1000.0)));
+			++arg;
+		} else if (IMPAIR_OPTION("--jitter")) {
+			IMPAIR_FOREACH_DIRECTION(jitter = (unsigned int)(string_to_real(STRING_ARGS(*value)) * REAL_C(1000.0)));
+			++arg;
+		} else if (IMPAIR_OPTION("--rate")) {
+			IMPAIR_FOREACH_DIRECTION(rate = (uint64_t)string_to_uint(STRING_ARGS(*value), false) * 1000 / 8);
+			++arg;
+		} else if (IMPAIR_OPTION("--queue")) {
+			IMPAIR_FOREACH_DIRECTION(queue_limit = string_to_uint(STRING_ARGS(*value), false));
+			++arg;
+		} else if (IMPAIR_OPTION("--loss")) {
+			IMPAIR_FOREACH_DIRECTION(loss = impair_parse_percent(STRING_ARGS(*value)));
+			++arg;
+		} else if (IMPAIR_OPTION("--duplicate")) {
+			IMPAIR_FOREACH_DIRECTION(duplicate = impair_parse_percent(STRING_ARGS(*value)));
+			++arg;
+		} else if (IMPAIR_OPTION("--reorder")) {
+			IMPAIR_FOREACH_DIRECTION(reorder = impair_parse_percent(STRING_ARGS(*value)));
+			++arg;
+		} else if (IMPAIR_OPTION("--burst")) {
+			// Gilbert-Elliott parameters p,r[,h] as percentages
+			size_t first = string_find(STRING_ARGS(*value), ',', 0);
+			size_t second = (first != STRING_NPOS) ? string_find(STRING_ARGS(*value), ',', first + 1) : STRING_NPOS;
+			real enter = impair_parse_percent(value->str, (first != STRING_NPOS) ? first : value->length);
+			real leave = (first != STRING_NPOS) ?
+			                 impair_parse_percent(value->str + first + 1,
+			                                      ((second != STRING_NPOS) ? second : value->length) - (first + 1)) :
+			                 REAL_C(0.25);
+			real loss = (second != STRING_NPOS) ?
+			                impair_parse_percent(value->str + second + 1, value->length - (second + 1)) :
+			                REAL_C(1.0);
+			IMPAIR_FOREACH_DIRECTION(burst_enter = enter);
+			IMPAIR_FOREACH_DIRECTION(burst_exit = leave);
+			IMPAIR_FOREACH_DIRECTION(burst_loss = loss);
+			++arg;
+		} else if (IMPAIR_OPTION("-i") || IMPAIR_OPTION("--interval")) {
+			input.config.interval = string_to_uint(STRING_ARGS(*value), false);
+			++arg;
+		} else if (IMPAIR_OPTION("--sessions")) {
+			input.config.sessions = string_to_uint(STRING_ARGS(*value), false);
+			++arg;
+		} else if (IMPAIR_OPTION("--timeout")) {
+			input.config.timeout = string_to_uint(STRING_ARGS(*value), false);
+			++arg;
+		}
+
+#undef IMPAIR_FOREACH_DIRECTION
+#undef IMPAIR_OPTION
+	}
+	error_context_pop();
+
+	input.valid = input.config.listen && input.config.target && input.config.sessions;
+	return input;
+}
+
+void
+impair_print_usage(void) {
+	log_info(0, STRING_CONST(
+	                "impair usage:\n"
+	                "  impair -l|--listen host:port -t|--target host:port [--udp|--tcp] [options]\n"
+	                "    Relays traffic from clients sending or connecting to the listen address to the target\n"
+	                "    address and back, applying impairments to each direction.\n"
+	                "    Required arguments:\n"
+	                "      -l|--listen host:port    Address to listen on\n"
+	                "      -t|--target host:port    Address to relay to\n"
+	                "    Optional arguments:\n"
+	                "      --udp                    Relay UDP datagrams (default)\n"
+	                "      --tcp                    Relay TCP connections, only delay, jitter and rate apply\n"
+	                "      --up|--down|--both       Apply following impairments to client to target, target to\n"
+	                "                               client or both directions (default both)\n"
+	                "      -p|--profile name        Start from a preset profile\n"
+	                "      --delay ms               Delay\n"
+	                "      --jitter ms              Maximum additional random delay, can reorder datagrams\n"
+	                "      --rate kbit/s            Bandwidth cap\n"
+	                "      --queue bytes            Queue limit of the bandwidth cap, excess datagrams are dropped\n"
+	                "      --loss percent           Random loss\n"
+	                "      --duplicate percent      Duplicated datagrams\n"
+	                "      --reorder percent        Datagrams delayed past following ones\n"
+	                "      --burst p,r[,h]          Gilbert-Elliott burst loss, percent chance of entering (p) and\n"
+	                "                               leaving (r) the bad state and loss in the bad state (h, default\n"
+	                "                               100), --loss is the loss in the good state\n"
+	                "      -i|--interval seconds    Statistics report interval, 0 to only report on exit (default 1)\n"
+	                "      --sessions count         Maximum concurrent clients (default 64)\n"
+	                "      --timeout seconds        Idle time before a UDP client is forgotten (default 30)\n"
+	                "    Profiles:"));
+	impair_profile_print_presets();
+}
+
+void
+impair_process_system_events(void) {
+	event_block_t* block;
+	event_t* event = 0;
+
+	system_process_events();
+
+	block = event_stream_process(system_event_stream());
+
+	while ((event = event_next(block, event))) {
+		switch (event->id) {
+			case FOUNDATIONEVENT_TERMINATE:
+				log_debug(0, STRING_CONST("Terminating due to event"));
+				should_exit = true;
+				break;
+
+			default:
+				break;
+		}
+	}
+}
+
+bool
+impair_should_exit(void) {
+	return should_exit;
+}
@@ -0,0 +1,141 @@
+/* profile.c  -  Network impair tool  -  Public Domain  -  2013 Mattias Jansson
+ *
+ * This library provides a network abstraction built on foundation streams. The latest source code is
+ * always available at
+ *
+ * https://github.com/mjansson/network_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any restrictions.
+ *
+ */
+
+#include "impair.h"
+#include "profile.h"
+
+typedef struct impair_preset_t {
+	const char* name;
+	const char* description;
+	impair_profile_t profile;
+} impair_preset_t;
+
+// Rough characteristics of common access networks, applied to each direction
+static const impair_preset_t impair_presets[] = {
+    {"none", "no impairment", {0, 0, 0, 0, 0, 0, 0, 0, 0, 0}},
+    {"lan", "1ms delay, 0.2ms jitter", {1000, 200, 0, 0, 0, 0, 0, 0, 0, 0}},
+    {"wifi", "5ms delay, 5ms jitter, 54Mbit/s, burst loss",
+     {5000, 5000, 6750000, 256 * 1024, REAL_C(0.002), 0, REAL_C(0.005), REAL_C(0.01), REAL_C(0.3), REAL_C(0.5)}},
+    {"dsl", "20ms delay, 2ms jitter, 8Mbit/s, 0.1% loss",
+     {20000, 2000, 1000000, 64 * 1024, REAL_C(0.001), 0, 0, 0, 0, 0}},
+    {"mobile", "100ms delay, 40ms jitter, 2Mbit/s, burst loss, reordering and duplicates",
+     {100000, 40000, 250000, 128 * 1024, REAL_C(0.005), REAL_C(0.001), REAL_C(0.01), REAL_C(0.02), REAL_C(0.2),
+      REAL_C(0.6)}},
+    {"satellite", "300ms delay, 10ms jitter, 10Mbit/s, 0.5% loss",
+     {300000, 10000, 1250000, 512 * 1024, REAL_C(0.005), 0, 0, 0, 0, 0}}};
+
+bool
+impair_profile_preset(impair_profile_t* profile, const char* name, size_t length) {
+	for (size_t ipreset = 0; ipreset < sizeof(impair_presets) / sizeof(impair_presets[0]); ++ipreset) {
+		if (string_equal(name, length, impair_presets[ipreset].name, string_length(impair_presets[ipreset].name))) {
+			*profile = impair_presets[ipreset].profile;
+			return true;
+		}
+	}
+	return false;
+}
+
+void
+impair_profile_print_presets(void) {
+	for (size_t ipreset = 0; ipreset < sizeof(impair_presets) / sizeof(impair_presets[0]); ++ipreset)
+		log_infof(0, STRING_CONST("      %-24s %s"), impair_presets[ipreset].name, impair_presets[ipreset].description);
+}
+
+void
+impair_profile_log(const impair_profile_t* profile) {
+	log_infof(0,
+	          STRING_CONST("Delay %.1fms jitter %.1fms rate %.2fMbit/s queue %" PRIsize
+	                       " bytes loss %.2f%% duplicate %.2f%% reorder %.2f%%"),
+	          (double)profile->delay / 1000.0, (double)profile->jitter / 1000.0,
+	          (double)(profile->rate * 8) / 1000000.0, profile->queue_limit, (double)profile->loss * 100.0,
+	          (double)profile->duplicate * 100.0, (double)profile->reorder * 100.0);
+	if (profile->burst_enter > 0)
+		log_infof(0, STRING_CONST("Burst loss enter %.2f%% exit %.2f%% loss %.2f%%"),
+		          (double)profile->burst_enter * 100.0, (double)profile->burst_exit * 100.0,
+		          (double)profile->burst_loss * 100.0);
+}
+
+void
+impair_link_initialize(impair_link_t* link, const impair_profile_t* profile) {
+	memset(link, 0, sizeof(impair_link_t));
+	link->profile = profile;
+}
+
+static bool
+impair_roll(real probability) {
+	return (probability > 0) && (random_normalized() < probability);
+}
+
+static tick_t
+impair_ticks(uint64_t usec) {
+	return (tick_t)((usec * (uint64_t)time_ticks_per_second()) / 1000000ULL);
+}
+
+size_t
+impair_link_schedule(impair_link_t* link, tick_t now, size_t size, bool stream, tick_t deliver[2],
+                     impair_stats_t* stats) {
+	const impair_profile_t* profile = link->profile;
+	tick_t start = (link->busy_until > now) ? link->busy_until : now;
+	size_t copies = 1;
+
+	++stats->packets_in;
+	stats->bytes_in += size;
+
+	// Bandwidth cap, packets wait for the ones ahead of them and are tail dropped if the queue is full
+	if (profile->rate) {
+		uint64_t queued = (uint64_t)(((double)(start - now) * (double)profile->rate) / (double)time_ticks_per_second());
+		if (!stream && profile->queue_limit && ((queued + size) > profile->queue_limit)) {
+			++stats->dropped;
+			return 0;
+		}
+		start += (tick_t)(((uint64_t)size * (uint64_t)time_ticks_per_second()) / profile->rate);
+	}
+	link->busy_until = start;
+
+	if (!stream) {
+		// Gilbert-Elliott two state model, state transitions once per packet and each state has its
+		// own loss probability, giving correlated bursts of loss
+		if (profile->burst_enter > 0) {
+			if (link->burst)
+				link->burst = !impair_roll(profile->burst_exit);
+			else
+				link->burst = impair_roll(profile->burst_enter);
+		}
+		if (impair_roll(link->burst ? profile->burst_loss : profile->loss)) {
+			++stats->lost;
+			return 0;
+		}
+		if (impair_roll(profile->duplicate)) {
+			++stats->duplicated;
+			copies = 2;
+		}
+	}
+
+	for (size_t icopy = 0; icopy < copies; ++icopy) {
+		tick_t time = start + impair_ticks(profile->delay);
+		if (profile->jitter)
+			time += impair_ticks(random32_range(0, profile->jitter + 1));
+		if (stream) {
+			// Streams keep their byte order, jitter only delays
+			if (time < link->last_deliver)
+				time = link->last_deliver;
+		} else if (impair_roll(profile->reorder)) {
+			unsigned int extra = profile->delay + profile->jitter;
+			time += impair_ticks((extra > 1000) ? extra : 1000);
+		}
+		if (time < link->last_deliver)
+			++stats->reordered;
+		else
+			link->last_deliver = time;
+		deliver[icopy] = time;
+	}
+	return copies;
+}
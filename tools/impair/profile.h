@@ -0,0 +1,71 @@
+/* profile.h  -  Network impair tool  -  Public Domain  -  2013 Mattias Jansson
+ *
+ * This library provides a network abstraction built on foundation streams. The latest source code is
+ * always available at
+ *
+ * https://github.com/mjansson/network_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any restrictions.
+ *
+ */
+
+#pragma once
+
+//! Impairment applied to traffic in one direction
+typedef struct impair_profile_t {
+	//! Delay in microseconds
+	unsigned int delay;
+	//! Maximum additional random delay in microseconds
+	unsigned int jitter;
+	//! Bandwidth cap in bytes per second, 0 for unlimited
+	uint64_t rate;
+	//! Maximum number of bytes waiting for the bandwidth cap, 0 for unlimited
+	size_t queue_limit;
+	//! Probability of random loss (loss in the good state if burst loss is enabled)
+	real loss;
+	//! Probability of a packet being duplicated
+	real duplicate;
+	//! Probability of a packet being delayed past packets sent after it
+	real reorder;
+	//! Gilbert-Elliott burst loss, probability of going from the good to the bad state
+	real burst_enter;
+	//! Gilbert-Elliott burst loss, probability of going from the bad to the good state
+	real burst_exit;
+	//! Gilbert-Elliott burst loss, probability of loss in the bad state
+	real burst_loss;
+} impair_profile_t;
+
+//! Impairment state of one direction
+typedef struct impair_link_t {
+	const impair_profile_t* profile;
+	//! Flag set while in the bad state of the burst loss model
+	bool burst;
+	//! Time when the bandwidth cap has passed all queued packets
+	tick_t busy_until;
+	//! Latest scheduled forward time
+	tick_t last_deliver;
+} impair_link_t;
+
+extern bool
+impair_profile_preset(impair_profile_t* profile, const char* name, size_t length);
+
+extern void
+impair_profile_print_presets(void);
+
+extern void
+impair_profile_log(const impair_profile_t* profile);
+
+extern void
+impair_link_initialize(impair_link_t* link, const impair_profile_t* profile);
+
+/*! Schedule a received packet on the link
+\param link Link
+\param now Time the packet was received
+\param size Packet size in bytes
+\param stream Flag for stream traffic, which is never lost, duplicated or reordered
+\param deliver Destination array of forward times
+\param stats Statistics counters
+\return Number of copies to forward, 0 if lost or dropped and 2 if duplicated */
+extern size_t
+impair_link_schedule(impair_link_t* link, tick_t now, size_t size, bool stream, tick_t deliver[2],
+                     impair_stats_t* stats);
@@ -0,0 +1,510 @@
+/* relay.c  -  Network impair tool  -  Public Domain  -  2013 Mattias Jansson
+ *
+ * This library provides a network abstraction built on foundation streams. The latest source code is
+ * always available at
+ *
+ * https://github.com/mjansson/network_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any restrictions.
+ *
+ */
+
+#include "impair.h"
+#include "relay.h"
+
+#define IMPAIR_DATAGRAM_SIZE 65536
+#define IMPAIR_STREAM_CHUNK 16384
+#define IMPAIR_POLL_MAX_MS 100
+
+typedef struct impair_session_t {
+	//! UDP client address
+	network_address_t* client;
+	//! TCP client connection
+	socket_t* downstream;
+	//! Socket connected or sending to the target
+	socket_t* upstream;
+	tick_t last_activity;
+	//! Number of scheduled packets referencing the session
+	size_t pending;
+	//! Flag set once a TCP connection hung up, session is removed when pending data is flushed
+	bool closed;
+	//! TCP data forwarded but not yet accepted by the socket send buffer
+	uint8_t* backlog[IMPAIR_DIRECTIONS];
+} impair_session_t;
+
+typedef struct impair_packet_t {
+	tick_t deliver;
+	tick_t received;
+	uint64_t sequence;
+	impair_session_t* session;
+	impair_direction_t direction;
+	size_t size;
+	uint8_t data[FOUNDATION_FLEXIBLE_ARRAY];
+} impair_packet_t;
+
+typedef struct impair_relay_t {
+	const impair_config_t* config;
+	network_poll_t* poll;
+	socket_t* listener;
+	impair_session_t** sessions;
+	network_address_map_t session_map;
+	//! Scheduled packets, binary heap ordered by forward time
+	impair_packet_t** queue;
+	uint64_t sequence;
+	impair_link_t link[IMPAIR_DIRECTIONS];
+	impair_stats_t stats[IMPAIR_DIRECTIONS];
+	impair_stats_t total[IMPAIR_DIRECTIONS];
+	tick_t start;
+	tick_t interval_start;
+	uint8_t* buffer;
+} impair_relay_t;
+
+static const char* impair_direction_name[IMPAIR_DIRECTIONS] = {"up  ", "down"};
+
+static bool
+impair_packet_before(const impair_packet_t* first, const impair_packet_t* second) {
+	return (first->deliver < second->deliver) ||
+	       ((first->deliver == second->deliver) && (first->sequence < second->sequence));
+}
+
+static void
+impair_queue_push(impair_relay_t* relay, impair_packet_t* packet) {
+	size_t index = array_size(relay->queue);
+	array_push(relay->queue, packet);
+	while (index) {
+		size_t parent = (index - 1) / 2;
+		if (!impair_packet_before(packet, relay->queue[parent]))
+			break;
+		relay->queue[index] = relay->queue[parent];
+		index = parent;
+	}
+	relay->queue[index] = packet;
+}
+
+static impair_packet_t*
+impair_queue_pop(impair_relay_t* relay) {
+	impair_packet_t* top = relay->queue[0];
+	size_t count = array_size(relay->queue) - 1;
+	impair_packet_t* last = relay->queue[count];
+	size_t index = 0;
+	array_pop(relay->queue);
+	while (count) {
+		size_t child = (2 * index) + 1;
+		if (child >= count)
+			break;
+		if ((child + 1 < count) && impair_packet_before(relay->queue[child + 1], relay->queue[child]))
+			++child;
+		if (!impair_packet_before(relay->queue[child], last))
+			break;
+		relay->queue[index] = relay->queue[child];
+		index = child;
+	}
+	if (count)
+		relay->queue[index] = last;
+	return top;
+}
+
+static void
+impair_stats_accumulate(impair_stats_t* total, const impair_stats_t* stats) {
+	if (stats->packets_out) {
+		if (!total->packets_out || (stats->latency_min < total->latency_min))
+			total->latency_min = stats->latency_min;
+		if (stats->latency_max > total->latency_max)
+			total->latency_max = stats->latency_max;
+	}
+	total->packets_in += stats->packets_in;
+	total->packets_out += stats->packets_out;
+	total->bytes_in += stats->bytes_in;
+	total->bytes_out += stats->bytes_out;
+	total->lost += stats->lost;
+	total->dropped += stats->dropped;
+	total->duplicated += stats->duplicated;
+	total->reordered += stats->reordered;
+	total->latency_sum += stats->latency_sum;
+}
+
+static void
+impair_stats_log(impair_direction_t direction, const impair_stats_t* stats, tick_t elapsed) {
+	double seconds = (elapsed > 0) ? (double)elapsed / (double)time_ticks_per_second() : 1.0;
+	double ticks_per_ms = (double)time_ticks_per_second() / 1000.0;
+	double loss = stats->packets_in ? (double)(stats->lost + stats->dropped) * 100.0 / (double)stats->packets_in : 0;
+	double latency = stats->packets_out ? (double)stats->latency_sum / (double)stats->packets_out : 0;
+	log_infof(0,
+	          STRING_CONST("%s %8.3fMbit/s %8.0fpkt/s in %" PRIu64 " out %" PRIu64 " lost %" PRIu64 " dropped %" PRIu64
+	                       " (%.2f%%) dup %" PRIu64 " reorder %" PRIu64 " latency avg %.2fms min %.2fms max %.2fms"),
+	          impair_direction_name[direction], ((double)stats->bytes_out * 8.0) / (seconds * 1000000.0),
+	          (double)stats->packets_out / seconds, stats->packets_in, stats->packets_out, stats->lost, stats->dropped,
+	          loss, stats->duplicated, stats->reordered, latency / ticks_per_ms,
+	          (double)stats->latency_min / ticks_per_ms, (double)stats->latency_max / ticks_per_ms);
+}
+
+static void
+impair_relay_report(impair_relay_t* relay, tick_t now, bool final) {
+	for (int idir = 0; idir < IMPAIR_DIRECTIONS; ++idir) {
+		impair_stats_accumulate(relay->total + idir, relay->stats + idir);
+		if (!final && relay->config->interval)
+			impair_stats_log((impair_direction_t)idir, relay->stats + idir, now - relay->interval_start);
+		memset(relay->stats + idir, 0, sizeof(impair_stats_t));
+	}
+	relay->interval_start = now;
+	if (final) {
+		log_infof(0, STRING_CONST("Total over %.1fs:"),
+		          (double)(now - relay->start) / (double)time_ticks_per_second());
+		for (int idir = 0; idir < IMPAIR_DIRECTIONS; ++idir)
+			impair_stats_log((impair_direction_t)idir, relay->total + idir, now - relay->start);
+	}
+}
+
+static impair_session_t*
+impair_session_find(impair_relay_t* relay, const socket_t* sock) {
+	for (size_t isession = 0, ssize = array_size(relay->sessions); isession < ssize; ++isession) {
+		impair_session_t* session = relay->sessions[isession];
+		if ((session->upstream == sock) || (session->downstream == sock))
+			return session;
+	}
+	return nullptr;
+}
+
+static void
+impair_session_deallocate(impair_relay_t* relay, impair_session_t* session) {
+	if (session->upstream) {
+		network_poll_remove_socket(relay->poll, session->upstream);
+		socket_deallocate(session->upstream);
+	}
+	if (session->downstream) {
+		network_poll_remove_socket(relay->poll, session->downstream);
+		socket_deallocate(session->downstream);
+	}
+	if (session->client) {
+		network_address_map_erase(&relay->session_map, session->client);
+		memory_deallocate(session->client);
+	}
+	for (int idir = 0; idir < IMPAIR_DIRECTIONS; ++idir)
+		array_deallocate(session->backlog[idir]);
+	memory_deallocate(session);
+}
+
+static socket_t*
+impair_session_open_upstream(impair_relay_t* relay) {
+	const network_address_t* target = relay->config->target;
+	socket_t* sock;
+	if (relay->config->tcp) {
+		// Connect without blocking the relay loop, the poll completes the connection with a
+		// connected or error event and forwarded data waits in the session backlog until then
+		sock = tcp_socket_allocate();
+		socket_set_blocking(sock, false);
+		if (!socket_connect(sock, target, 0)) {
+			socket_deallocate(sock);
+			return nullptr;
+		}
+	} else {
+		// Bind to the target interface so relayed traffic stays on loopback
+		network_address_t* local = network_address_clone(target);
+		sock = udp_socket_allocate();
+		network_address_ip_set_port(local, 0);
+		bool bound = socket_bind(sock, local);
+		memory_deallocate(local);
+		if (!bound) {
+			socket_deallocate(sock);
+			return nullptr;
+		}
+	}
+	socket_set_blocking(sock, false);
+	return sock;
+}
+
+static impair_session_t*
+impair_session_allocate(impair_relay_t* relay, const network_address_t* client, socket_t* downstream) {
+	impair_session_t* session;
+	socket_t* upstream;
+
+	if (array_size(relay->sessions) >= relay->config->sessions) {
+		log_warnf(0, WARNING_SUSPICIOUS, STRING_CONST("Session limit %u reached, ignoring new client"),
+		          relay->config->sessions);
+		return nullptr;
+	}
+	upstream = impair_session_open_upstream(relay);
+	if (!upstream) {
+		log_warnf(0, WARNING_SUSPICIOUS, STRING_CONST("Unable to open connection to target"));
+		return nullptr;
+	}
+
+	session = memory_allocate(0, sizeof(impair_session_t), 0, MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	session->upstream = upstream;
+	session->downstream = downstream;
+	session->last_activity = time_current();
+	network_poll_add_socket(relay->poll, upstream);
+	if (downstream) {
+		socket_set_blocking(downstream, false);
+		network_poll_add_socket(relay->poll, downstream);
+	}
+	if (client) {
+		session->client = network_address_clone(client);
+		network_address_map_insert(&relay->session_map, session->client, session);
+	}
+	array_push(relay->sessions, session);
+
+	{
+		char buffer[NETWORK_ADDRESS_NUMERIC_MAX_LENGTH];
+		const network_address_t* address = client ? client : socket_address_remote(downstream);
+		string_t address_str = network_address_to_string(buffer, sizeof(buffer), address, true);
+		log_infof(0, STRING_CONST("New client %.*s"), STRING_FORMAT(address_str));
+	}
+	return session;
+}
+
+static void
+impair_relay_schedule(impair_relay_t* relay, impair_session_t* session, impair_direction_t direction, size_t size,
+                      tick_t now) {
+	tick_t deliver[2];
+	size_t copies =
+	    impair_link_schedule(relay->link + direction, now, size, relay->config->tcp, deliver, relay->stats + direction);
+	for (size_t icopy = 0; icopy < copies; ++icopy) {
+		impair_packet_t* packet = memory_allocate(0, sizeof(impair_packet_t) + size, 0, MEMORY_PERSISTENT);
+		packet->deliver = deliver[icopy];
+		packet->received = now;
+		packet->sequence = relay->sequence++;
+		packet->session = session;
+		packet->direction = direction;
+		packet->size = size;
+		memcpy(packet->data, relay->buffer, size);
+		impair_queue_push(relay, packet);
+		++session->pending;
+	}
+	session->last_activity = now;
+}
+
+static void
+impair_relay_read(impair_relay_t* relay, socket_t* sock, tick_t now) {
+	if (sock == relay->listener) {
+		const network_address_t* address;
+		size_t size;
+		while ((size = udp_socket_recvfrom(sock, relay->buffer, IMPAIR_DATAGRAM_SIZE, &address)) > 0) {
+			impair_session_t* session = network_address_map_lookup(&relay->session_map, address);
+			if (!session)
+				session = impair_session_allocate(relay, address, nullptr);
+			if (session)
+				impair_relay_schedule(relay, session, IMPAIR_UPSTREAM, size, now);
+		}
+		return;
+	}
+
+	impair_session_t* session = impair_session_find(relay, sock);
+	if (!session || session->closed)
+		return;
+	impair_direction_t direction = (sock == session->upstream) ? IMPAIR_DOWNSTREAM : IMPAIR_UPSTREAM;
+	if (relay->config->tcp) {
+		size_t size;
+		while ((size = socket_read(sock, relay->buffer, IMPAIR_STREAM_CHUNK)) > 0)
+			impair_relay_schedule(relay, session, direction, size, now);
+		if (socket_state(sock) != SOCKETSTATE_CONNECTED)
+			session->closed = true;
+	} else {
+		size_t size;
+		while ((size = udp_socket_recvfrom(sock, relay->buffer, IMPAIR_DATAGRAM_SIZE, nullptr)) > 0)
+			impair_relay_schedule(relay, session, direction, size, now);
+	}
+}
+
+static bool
+impair_session_flush(impair_session_t* session, impair_direction_t direction) {
+	socket_t* sock = (direction == IMPAIR_UPSTREAM) ? session->upstream : session->downstream;
+	uint8_t* backlog = session->backlog[direction];
+	size_t size = array_size(backlog);
+	if (!size)
+		return true;
+	if (socket_state(sock) == SOCKETSTATE_CONNECTING)
+		return false;
+	size_t written = socket_write(sock, backlog, size);
+	if (written == size) {
+		array_clear(session->backlog[direction]);
+		return true;
+	}
+	if (socket_state(sock) != SOCKETSTATE_CONNECTED) {
+		// Peer is gone, discard what it will never receive
+		array_clear(session->backlog[direction]);
+		session->closed = true;
+		return true;
+	}
+	memmove(backlog, backlog + written, size - written);
+	array_resize(session->backlog[direction], size - written);
+	return false;
+}
+
+static void
+impair_relay_forward(impair_relay_t* relay, impair_packet_t* packet, tick_t now) {
+	impair_session_t* session = packet->session;
+	impair_stats_t* stats = relay->stats + packet->direction;
+	tick_t latency = now - packet->received;
+
+	if (relay->config->tcp) {
+		size_t offset = array_size(session->backlog[packet->direction]);
+		array_resize(session->backlog[packet->direction], offset + packet->size);
+		memcpy(session->backlog[packet->direction] + offset, packet->data, packet->size);
+		impair_session_flush(session, packet->direction);
+	} else if (packet->direction == IMPAIR_UPSTREAM) {
+		udp_socket_sendto(session->upstream, packet->data, packet->size, relay->config->target);
+	} else {
+		udp_socket_sendto(relay->listener, packet->data, packet->size, session->client);
+	}
+
+	if (!stats->packets_out || (latency < stats->latency_min))
+		stats->latency_min = latency;
+	if (latency > stats->latency_max)
+		stats->latency_max = latency;
+	stats->latency_sum += latency;
+	++stats->packets_out;
+	stats->bytes_out += packet->size;
+}
+
+// Forward due packets, flush stream backlogs and remove finished sessions. Returns the poll
+// timeout in milliseconds until the next scheduled packet
+static unsigned int
+impair_relay_tick(impair_relay_t* relay, tick_t now) {
+	unsigned int timeout = IMPAIR_POLL_MAX_MS;
+	tick_t idle = (tick_t)relay->config->timeout * time_ticks_per_second();
+	bool backlog = false;
+
+	while (array_size(relay->queue) && (relay->queue[0]->deliver <= now)) {
+		impair_packet_t* packet = impair_queue_pop(relay);
+		// Data received before a hangup is still forwarded to the other end
+		--packet->session->pending;
+		impair_relay_forward(relay, packet, now);
+		memory_deallocate(packet);
+	}
+
+	for (size_t isession = 0; isession < array_size(relay->sessions);) {
+		impair_session_t* session = relay->sessions[isession];
+		bool flushed = impair_session_flush(session, IMPAIR_UPSTREAM);
+		flushed = impair_session_flush(session, IMPAIR_DOWNSTREAM) && flushed;
+		backlog |= !flushed;
+		bool expired = relay->config->tcp ? session->closed : ((now - session->last_activity) > idle);
+		if (expired && flushed && !session->pending) {
+			log_info(0, STRING_CONST("Client session ended"));
+			impair_session_deallocate(relay, session);
+			array_erase(relay->sessions, isession);
+		} else {
+			++isession;
+		}
+	}
+
+	if (backlog)
+		timeout = 1;
+	if (array_size(relay->queue)) {
+		tick_t next = relay->queue[0]->deliver;
+		unsigned int nextms =
+		    (unsigned int)((((next - now) * 1000) + time_ticks_per_second() - 1) / time_ticks_per_second());
+		if (nextms < timeout)
+			timeout = nextms;
+	}
+	return timeout;
+}
+
+static int
+impair_relay_run(impair_relay_t* relay) {
+	network_poll_event_t events[64];
+	tick_t interval = (tick_t)relay->config->interval * time_ticks_per_second();
+	unsigned int timeout = IMPAIR_POLL_MAX_MS;
+
+	relay->start = relay->interval_start = time_current();
+	while (!impair_should_exit()) {
+		size_t num_events = network_poll(relay->poll, events, sizeof(events) / sizeof(events[0]), timeout);
+		tick_t now = time_current();
+
+		for (size_t ievt = 0; ievt < num_events; ++ievt) {
+			socket_t* sock = events[ievt].socket;
+			switch (events[ievt].event) {
+				case NETWORKEVENT_CONNECTION: {
+					socket_t* accepted = tcp_socket_accept(sock, 0);
+					if (accepted && !impair_session_allocate(relay, nullptr, accepted))
+						socket_deallocate(accepted);
+					break;
+				}
+				case NETWORKEVENT_CONNECTED: {
+					impair_session_t* session = impair_session_find(relay, sock);
+					if (session)
+						impair_session_flush(session, IMPAIR_UPSTREAM);
+					break;
+				}
+				case NETWORKEVENT_DATAIN:
+					impair_relay_read(relay, sock, now);
+					break;
+				case NETWORKEVENT_ERROR:
+				case NETWORKEVENT_HANGUP: {
+					// The poll closes the socket before reporting the event, so data still queued in the
+					// socket at hangup is lost. Packets already scheduled are forwarded before the session ends
+					impair_session_t* session = impair_session_find(relay, sock);
+					if (session)
+						session->closed = true;
+					break;
+				}
+				default:
+					break;
+			}
+		}
+
+		timeout = impair_relay_tick(relay, now);
+		if (interval && ((now - relay->interval_start) >= interval))
+			impair_relay_report(relay, now, false);
+
+		impair_process_system_events();
+	}
+
+	impair_relay_report(relay, time_current(), true);
+	return IMPAIR_RESULT_OK;
+}
+
+int
+impair_relay(const impair_config_t* config) {
+	impair_relay_t relay;
+	int result = IMPAIR_RESULT_OK;
+
+	memset(&relay, 0, sizeof(relay));
+	relay.config = config;
+	for (int idir = 0; idir < IMPAIR_DIRECTIONS; ++idir)
+		impair_link_initialize(relay.link + idir, config->profile + idir);
+	network_address_map_initialize(&relay.session_map, config->sessions);
+
+	relay.listener = config->tcp ? tcp_socket_allocate() : udp_socket_allocate();
+	socket_set_reuse_address(relay.listener, true);
+	if (!socket_bind(relay.listener, config->listen) || (config->tcp && !tcp_socket_listen(relay.listener))) {
+		log_error(0, ERROR_SYSTEM_CALL_FAIL, STRING_CONST("Unable to listen on given address"));
+		socket_deallocate(relay.listener);
+		network_address_map_finalize(&relay.session_map);
+		return IMPAIR_ERROR_UNABLE_TO_CREATE_SOCKET;
+	}
+	socket_set_blocking(relay.listener, false);
+
+	{
+		char listenbuf[NETWORK_ADDRESS_NUMERIC_MAX_LENGTH];
+		char targetbuf[NETWORK_ADDRESS_NUMERIC_MAX_LENGTH];
+		string_t listen_str =
+		    network_address_to_string(listenbuf, sizeof(listenbuf), socket_address_local(relay.listener), true);
+		string_t target_str = network_address_to_string(targetbuf, sizeof(targetbuf), config->target, true);
+		log_infof(0, STRING_CONST("Relaying %s %.*s -> %.*s"), config->tcp ? "TCP" : "UDP", STRING_FORMAT(listen_str),
+		          STRING_FORMAT(target_str));
+		for (int idir = 0; idir < IMPAIR_DIRECTIONS; ++idir) {
+			log_infof(0, STRING_CONST("Impairment %s:"), impair_direction_name[idir]);
+			impair_profile_log(config->profile + idir);
+		}
+	}
+
+	relay.poll = network_poll_allocate(1 + (2 * config->sessions));
+	network_poll_add_socket(relay.poll, relay.listener);
+	relay.buffer = memory_allocate(0, IMPAIR_DATAGRAM_SIZE, 0, MEMORY_PERSISTENT);
+
+	result = impair_relay_run(&relay);
+
+	for (size_t ipacket = 0, psize = array_size(relay.queue); ipacket < psize; ++ipacket)
+		memory_deallocate(relay.queue[ipacket]);
+	array_deallocate(relay.queue);
+	for (size_t isession = 0, ssize = array_size(relay.sessions); isession < ssize; ++isession)
+		impair_session_deallocate(&relay, relay.sessions[isession]);
+	array_deallocate(relay.sessions);
+	network_poll_deallocate(relay.poll);
+	socket_deallocate(relay.listener);
+	network_address_map_finalize(&relay.session_map);
+	memory_deallocate(relay.buffer);
+
+	return result;
+}
@@ -0,0 +1,34 @@
+/* relay.h  -  Network impair tool  -  Public Domain  -  2013 Mattias Jansson
+ *
+ * This library provides a network abstraction built on foundation streams. The latest source code is
+ * always available at
+ *
+ * https://github.com/mjansson/network_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any restrictions.
+ *
+ */
+
+#pragma once
+
+#include "profile.h"
+
+typedef struct impair_config_t {
+	//! Relay TCP connections instead of UDP datagrams
+	bool tcp;
+	//! Address clients connect or send to
+	network_address_t* listen;
+	//! Address traffic is relayed to
+	network_address_t* target;
+	//! Impairment of client to target and target to client traffic
+	impair_profile_t profile[IMPAIR_DIRECTIONS];
+	//! Seconds between statistics reports, 0 to only report on exit
+	unsigned int interval;
+	//! Maximum number of concurrent clients
+	unsigned int sessions;
+	//! Seconds of inactivity before a UDP client is forgotten
+	unsigned int timeout;
+} impair_config_t;
+
+extern int
+impair_relay(const impair_config_t* config);